@@ -0,0 +1,109 @@
+/*
+* Vulkan asset loader
+*
+* Collects model and texture loads and runs them in parallel on the workers of a thread pool
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+
+#include "threadpool.hpp"
+
+namespace vks
+{
+	/**
+	* @brief Runs a set of asset loads across the workers of a thread pool
+	*
+	* Loads are plain functions that usually call vks::Model::loadFromFile or one of the texture loaders. File reading, decoding and
+	* mesh processing run in parallel, the staging copies are recorded into the device's upload queue and submitted as batches
+	* (at the latest when the example calls prepareFinished).
+	*
+	* Loads may use everything the vks::VulkanDevice offers: the upload queue and the memory allocator are internally synchronized,
+	* command buffers are allocated from a command pool owned by the calling thread and queue submissions lock the device's queue mutex.
+	*
+	* @note Loads must not write to shared containers, resize them up front and let every load write to its own element
+	* @note Loads submit to the device's queues under its queue mutex, so submissions of other threads while loads are running must lock it too (VulkanExampleBase::submitFrame and flushCommandBuffer and the swap chain do, examples submitting their own command buffers have to)
+	*/
+	class AssetLoader
+	{
+	private:
+		std::vector<std::function<void()>> loads;
+
+	public:
+		/** @brief Number of loads run by the last call to load() */
+		uint32_t loadedCount = 0;
+		/** @brief Number of workers used by the last call to load() */
+		uint32_t workerCount = 0;
+		/** @brief Time in milliseconds taken by the last call to load() */
+		double loadTime = 0.0;
+
+		/**
+		* Add a load to the batch
+		*
+		* @param load Function that loads one or more assets, referenced objects must stay valid until load() returns
+		*
+		* @note Loads are started in the order they have been added, adding the largest assets first gives the best balance between the workers
+		*/
+		void add(std::function<void()> load)
+		{
+			loads.push_back(std::move(load));
+		}
+
+		/** @brief Number of loads waiting to be run */
+		uint32_t size()
+		{
+			return static_cast<uint32_t>(loads.size());
+		}
+
+		/**
+		* Run all loads of the batch, wait for them to finish and clear the batch
+		*
+		* @param threadPool Thread pool whose workers run the loads, loads are run on the calling thread if it has no threads
+		*/
+		void load(vks::ThreadPool &threadPool)
+		{
+			auto tStart = std::chrono::high_resolution_clock::now();
+			loadedCount = static_cast<uint32_t>(loads.size());
+			workerCount = std::min(static_cast<uint32_t>(threadPool.threads.size()), loadedCount);
+
+			if (workerCount <= 1)
+			{
+				for (auto &load : loads)
+				{
+					load();
+				}
+				workerCount = std::min(loadedCount, 1u);
+			}
+			else
+			{
+				// Loads are fetched from a shared counter, so a worker that got small assets picks up more of them
+				std::atomic<uint32_t> nextLoad(0);
+				for (uint32_t i = 0; i < workerCount; i++)
+				{
+					threadPool.threads[i]->addJob([this, &nextLoad]
+					{
+						uint32_t index;
+						while ((index = nextLoad.fetch_add(1)) < loadedCount)
+						{
+							loads[index]();
+						}
+					});
+				}
+				threadPool.wait();
+			}
+
+			loads.clear();
+			auto tEnd = std::chrono::high_resolution_clock::now();
+			loadTime = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+		}
+	};
+}
@@ -0,0 +1,270 @@
+/*
+* Vulkan asset streamer
+*
+* Loads models and textures in the background while the example is already rendering with placeholder resources
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <algorithm>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+#include "VulkanDevice.hpp"
+#include "VulkanTexture.hpp"
+#include "VulkanTextureFile.hpp"
+#include "threadpool.hpp"
+
+namespace vks
+{
+	/**
+	* @brief Streams assets in the background and hands them over to the render thread once they can be used
+	*
+	* Each request consists of a load function that is run on the job system of a thread pool and an apply function that is
+	* run on the render thread by update() once the load has finished and all uploads it recorded have been executed.
+	* Loads should write to objects of their own (e.g. a model or texture allocated for the request), apply then moves
+	* the result into place, updates descriptors and marks command buffers for rebuilding.
+	*
+	* Until an asset has arrived the example renders with the placeholder textures or skips the asset. Textures added with
+	* addTexture() arrive progressively, their smallest mip levels first.
+	*
+	* @note Loads submit to the device's queues under its queue mutex, so all submissions of the render thread must lock it too (VulkanExampleBase::submitFrame and flushCommandBuffer and the swap chain's acquire and present do, examples submitting their own command buffers have to lock it themselves)
+	*/
+	class AssetStreamer
+	{
+	private:
+		struct Request
+		{
+			std::function<void()> load;
+			std::function<void()> apply;
+			// Uploads recorded up to the end of the load
+			vks::UploadToken token;
+			std::atomic<bool> loaded;
+			bool applied = false;
+			vks::JobHandle job;
+		};
+
+		struct LoadJob
+		{
+			vks::VulkanDevice *device;
+			Request *request;
+
+			void operator()()
+			{
+				request->load();
+				// Release what the load captured (e.g. the mapping of a texture file) as soon as it's done
+				request->load = nullptr;
+				request->token = device->uploadQueue.recordedToken();
+				request->loaded.store(true, std::memory_order_release);
+			}
+		};
+
+		vks::VulkanDevice *device = nullptr;
+		VkQueue queue = VK_NULL_HANDLE;
+		vks::JobSystem *jobSystem = nullptr;
+		std::vector<std::unique_ptr<Request>> requests;
+
+		void applyRequests(bool waitForUploads)
+		{
+			// Descriptor sets and command buffers of the frames in flight may still reference the resources that are replaced
+			{
+				std::lock_guard<std::mutex> lock(device->queueMutex);
+				VK_CHECK_RESULT(vkQueueWaitIdle(queue));
+			}
+			for (auto &request : requests)
+			{
+				if (request->applied || !request->loaded.load(std::memory_order_acquire))
+				{
+					continue;
+				}
+				if (waitForUploads)
+				{
+					device->uploadQueue.wait(request->token);
+				}
+				else if (!device->uploadQueue.isComplete(request->token))
+				{
+					continue;
+				}
+				request->apply();
+				request->applied = true;
+				appliedCount++;
+			}
+		}
+
+	public:
+		/** @brief 1x1 texture to use for 2D textures that haven't arrived yet */
+		vks::Texture2D placeholder2D;
+		/** @brief 1x1 cube map to use for cube maps that haven't arrived yet */
+		vks::TextureCubeMap placeholderCube;
+
+		/** @brief Number of requests added */
+		uint32_t requestCount = 0;
+		/** @brief Number of requests that have been applied */
+		uint32_t appliedCount = 0;
+
+		/**
+		* Create the placeholder textures
+		*
+		* @param device Vulkan device the assets are created on
+		* @param queue Graphics queue the example renders with
+		* @param threadPool Thread pool whose job system runs the loads
+		* @param (Optional) color RGBA color of the placeholder textures (defaults to mid grey)
+		*/
+		void create(vks::VulkanDevice *device, VkQueue queue, vks::ThreadPool &threadPool, std::array<uint8_t, 4> color = {{ 128, 128, 128, 255 }})
+		{
+			this->device = device;
+			this->queue = queue;
+			this->jobSystem = threadPool.jobSystem.get();
+			placeholder2D.fromBuffer(color.data(), color.size(), VK_FORMAT_R8G8B8A8_UNORM, 1, 1, device, queue);
+			std::vector<uint8_t> faces;
+			for (uint32_t face = 0; face < 6; face++)
+			{
+				faces.insert(faces.end(), color.begin(), color.end());
+			}
+			placeholderCube.fromBuffer(faces.data(), faces.size(), VK_FORMAT_R8G8B8A8_UNORM, 1, device, queue);
+		}
+
+		/**
+		* Add a request and start loading it in the background
+		*
+		* @param load Function that loads the asset, run on a worker of the job system
+		* @param apply Function that makes the loaded asset available to the renderer, run by update() on the render thread
+		*/
+		void add(std::function<void()> load, std::function<void()> apply)
+		{
+			assert(jobSystem);
+			std::unique_ptr<Request> request(new Request);
+			request->load = std::move(load);
+			request->apply = std::move(apply);
+			request->loaded.store(false);
+			LoadJob job = { device, request.get() };
+			request->job = jobSystem->run(job);
+			requests.push_back(std::move(request));
+			requestCount++;
+		}
+
+		/**
+		* Apply all requests that have been loaded and whose uploads have finished executing, call once per frame before building command buffers
+		*
+		* @return True if at least one request has been applied, command buffers referencing the replaced resources need to be rebuilt
+		*
+		* @note Waits for the queue to become idle before applying requests, so arrivals cause a short stall
+		*/
+		bool update()
+		{
+			bool ready = false;
+			for (auto &request : requests)
+			{
+				if (!request->applied && request->loaded.load(std::memory_order_acquire) && device->uploadQueue.isComplete(request->token))
+				{
+					ready = true;
+					break;
+				}
+			}
+			if (!ready)
+			{
+				return false;
+			}
+			uint32_t previousCount = appliedCount;
+			applyRequests(false);
+			return appliedCount > previousCount;
+		}
+
+		/**
+		* Stream a 2D texture or cube map from a file, starting with its smallest mip levels
+		*
+		* The image is created right away, the mip tail (all levels up to tailSize) and each larger level are then loaded by
+		* requests of their own, from the smallest to the largest one. Once a level and all smaller ones have arrived the
+		* texture's view is recreated to start at it, so sampling is clamped to the levels that have been uploaded.
+		*
+		* @param texture Texture to stream into, must stay alive until the streamer has been destroyed
+		* @param filename File to load (KTX files are read level by level through a memory mapping)
+		* @param format Vulkan format of the image data stored in the file
+		* @param viewType VK_IMAGE_VIEW_TYPE_2D or VK_IMAGE_VIEW_TYPE_CUBE
+		* @param apply Called on the render thread each time more detailed levels have become visible, e.g. to copy the texture into place and update descriptors
+		* @param (Optional) tailSize Levels whose width and height are at most this size are loaded together by the first request (defaults to 64)
+		*/
+		void addTexture(std::shared_ptr<vks::Texture> texture, const std::string &filename, VkFormat format, VkImageViewType viewType, std::function<void()> apply, uint32_t tailSize = 64)
+		{
+			std::shared_ptr<vks::TextureFile> file(new vks::TextureFile);
+			if (!file->open(filename, format))
+			{
+				vks::tools::exitFatal("Could not load texture from " + filename, "File not found");
+			}
+			texture->createForStreaming(*file, format, viewType, device);
+
+			// Levels that have arrived, shared by the requests of this texture
+			std::shared_ptr<std::vector<bool>> resident(new std::vector<bool>(texture->mipLevels, false));
+			auto makeVisible = [texture, resident, apply](uint32_t baseLevel, uint32_t levelCount)
+			{
+				std::fill(resident->begin() + baseLevel, resident->begin() + baseLevel + levelCount, true);
+				// Levels may arrive out of order, the view can only start at a level if all smaller ones are there too
+				uint32_t level = texture->mipLevels;
+				while ((level > 0) && (*resident)[level - 1])
+				{
+					level--;
+				}
+				if (level < texture->baseMipLevel)
+				{
+					texture->setBaseMipLevel(level);
+					apply();
+				}
+			};
+
+			uint32_t tailLevel = texture->mipLevels - 1;
+			while ((tailLevel > 0) && (std::max(texture->width >> (tailLevel - 1), texture->height >> (tailLevel - 1)) <= tailSize))
+			{
+				tailLevel--;
+			}
+			uint32_t tailCount = texture->mipLevels - tailLevel;
+			add(
+				[texture, file, tailLevel, tailCount] { texture->uploadLevels(*file, tailLevel, tailCount); },
+				[makeVisible, tailLevel, tailCount] { makeVisible(tailLevel, tailCount); });
+			for (uint32_t level = tailLevel; level-- > 0;)
+			{
+				add(
+					[texture, file, level] { texture->uploadLevels(*file, level, 1); },
+					[makeVisible, level] { makeVisible(level, 1); });
+			}
+		}
+
+		/** @brief Returns true if all requests have been applied */
+		bool finished()
+		{
+			return appliedCount == requestCount;
+		}
+
+		/**
+		* Wait for all loads, apply the remaining requests and release the placeholders
+		*
+		* @note Call before destroying the streamed assets, so requests that arrived after the last update() are owned by the example
+		*/
+		void destroy()
+		{
+			if (!device)
+			{
+				return;
+			}
+			for (auto &request : requests)
+			{
+				jobSystem->wait(request->job);
+			}
+			applyRequests(true);
+			requests.clear();
+			placeholder2D.destroy();
+			placeholderCube.destroy();
+			device = nullptr;
+		}
+	};
+}
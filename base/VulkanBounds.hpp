@@ -0,0 +1,129 @@
+/*
+* Bounding volumes
+*
+* Axis aligned bounding boxes and bounding spheres of vertex positions
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+#include <string.h>
+
+#include <glm/glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define VKS_BOUNDS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace vks
+{
+	namespace bounds
+	{
+		/** @brief Axis aligned bounding box and bounding sphere, padded to vec4s so arrays of them can be read with SIMD loads or uploaded to the GPU */
+		struct Bounds
+		{
+			// xyz = minimum corner
+			glm::vec4 min = glm::vec4(0.0f);
+			// xyz = maximum corner
+			glm::vec4 max = glm::vec4(0.0f);
+			// xyz = center, w = radius
+			glm::vec4 sphere = glm::vec4(0.0f);
+		};
+
+		/**
+		* Calculate the bounding box of count positions
+		*
+		* @param positions Pointer to the first position (3 floats)
+		* @param count Number of positions
+		* @param stride Distance in bytes between two positions, at least 3 floats
+		* @param min Receives the minimum corner, FLT_MAX if count is zero
+		* @param max Receives the maximum corner, -FLT_MAX if count is zero
+		*/
+		inline void computeBox(const uint8_t *positions, uint32_t count, uint32_t stride, glm::vec3 &min, glm::vec3 &max)
+		{
+			min = glm::vec3(FLT_MAX);
+			max = glm::vec3(-FLT_MAX);
+			uint32_t i = 0;
+#if defined(VKS_BOUNDS_SSE)
+			// Running minimum and maximum of whole positions, the fourth lane is ignored
+			// It reads the first float after a position, which is still inside of the next position for all but the last one
+			if (count > 1)
+			{
+				__m128 vmin = _mm_set1_ps(FLT_MAX);
+				__m128 vmax = _mm_set1_ps(-FLT_MAX);
+				for (; i + 1 < count; i++)
+				{
+					__m128 p = _mm_loadu_ps(reinterpret_cast<const float*>(positions + static_cast<size_t>(i) * stride));
+					vmin = _mm_min_ps(vmin, p);
+					vmax = _mm_max_ps(vmax, p);
+				}
+				float lanes[4];
+				_mm_storeu_ps(lanes, vmin);
+				min = glm::vec3(lanes[0], lanes[1], lanes[2]);
+				_mm_storeu_ps(lanes, vmax);
+				max = glm::vec3(lanes[0], lanes[1], lanes[2]);
+			}
+#endif
+			for (; i < count; i++)
+			{
+				float p[3];
+				memcpy(p, positions + static_cast<size_t>(i) * stride, sizeof(p));
+				min = glm::min(min, glm::vec3(p[0], p[1], p[2]));
+				max = glm::max(max, glm::vec3(p[0], p[1], p[2]));
+			}
+		}
+
+		/**
+		* Calculate the bounding box and a bounding sphere around its center
+		*
+		* @param positions Pointer to the first position (3 floats)
+		* @param count Number of positions
+		* @param stride Distance in bytes between two positions, at least 3 floats
+		*/
+		inline Bounds compute(const uint8_t *positions, uint32_t count, uint32_t stride)
+		{
+			Bounds bounds;
+			if (count == 0)
+			{
+				return bounds;
+			}
+			glm::vec3 min, max;
+			computeBox(positions, count, stride, min, max);
+			glm::vec3 center = (min + max) * 0.5f;
+			// Tighter than half of the box diagonal for most meshes
+			float radiusSquared = 0.0f;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				float p[3];
+				memcpy(p, positions + static_cast<size_t>(i) * stride, sizeof(p));
+				glm::vec3 d = glm::vec3(p[0], p[1], p[2]) - center;
+				radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+			}
+			bounds.min = glm::vec4(min, 1.0f);
+			bounds.max = glm::vec4(max, 1.0f);
+			bounds.sphere = glm::vec4(center, sqrtf(radiusSquared));
+			return bounds;
+		}
+
+		/** @brief Bounds of positions transformed by position * scale + offset, without transforming the positions */
+		inline Bounds transform(const Bounds &bounds, glm::vec3 scale, glm::vec3 offset)
+		{
+			Bounds result;
+			glm::vec3 a = glm::vec3(bounds.min) * scale + offset;
+			glm::vec3 b = glm::vec3(bounds.max) * scale + offset;
+			// Negative scales swap the corners
+			result.min = glm::vec4(glm::min(a, b), 1.0f);
+			result.max = glm::vec4(glm::max(a, b), 1.0f);
+			glm::vec3 absScale = glm::abs(scale);
+			result.sphere = glm::vec4(glm::vec3(bounds.sphere) * scale + offset, bounds.sphere.w * std::max(absScale.x, std::max(absScale.y, absScale.z)));
+			return result;
+		}
+	}
+}
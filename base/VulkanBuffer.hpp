@@ -14,6 +14,7 @@
 
 #include "vulkan/vulkan.h"
 #include "VulkanTools.h"
+#include "VulkanMemoryAllocator.hpp"
 
 namespace vks
 {	
@@ -23,9 +24,10 @@ namespace vks
 	*/
 	struct Buffer
 	{
-		VkBuffer buffer;
+		VkBuffer buffer = VK_NULL_HANDLE;
 		VkDevice device;
-		VkDeviceMemory memory;
+		/** @brief Device memory range (memory object and offset) the buffer is bound to */
+		vks::Allocation allocation;
 		VkDescriptorBufferInfo descriptor;
 		VkDeviceSize size = 0;
 		VkDeviceSize alignment = 0;
@@ -42,11 +44,19 @@ namespace vks
 		* @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete buffer range.
 		* @param offset (Optional) Byte offset from beginning
 		* 
-		* @return VkResult of the buffer mapping call
+		* @return VK_SUCCESS if the buffer's memory is host visible
+		*
+		* @note Host visible memory blocks stay mapped for their whole lifetime, so this only returns a pointer into the existing mapping
 		*/
 		VkResult map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0)
 		{
-			return vkMapMemory(device, memory, offset, size, 0, &mapped);
+			if (allocation.mapped == nullptr)
+			{
+				return VK_ERROR_MEMORY_MAP_FAILED;
+			}
+			assert((size == VK_WHOLE_SIZE) || (offset + size <= allocation.size));
+			mapped = static_cast<uint8_t*>(allocation.mapped) + offset;
+			return VK_SUCCESS;
 		}
 
 		/**
@@ -56,11 +66,7 @@ namespace vks
 		*/
 		void unmap()
 		{
-			if (mapped)
-			{
-				vkUnmapMemory(device, memory);
-				mapped = nullptr;
-			}
+			mapped = nullptr;
 		}
 
 		/** 
@@ -72,7 +78,7 @@ namespace vks
 		*/
 		VkResult bind(VkDeviceSize offset = 0)
 		{
-			return vkBindBufferMemory(device, buffer, memory, offset);
+			return vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset + offset);
 		}
 
 		/**
@@ -114,12 +120,7 @@ namespace vks
 		*/
 		VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0)
 		{
-			VkMappedMemoryRange mappedRange = {};
-			mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-			mappedRange.memory = memory;
-			mappedRange.offset = offset;
-			mappedRange.size = size;
-			return vkFlushMappedMemoryRanges(device, 1, &mappedRange);
+			return allocation.flush(size, offset);
 		}
 
 		/**
@@ -134,12 +135,7 @@ namespace vks
 		*/
 		VkResult invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0)
 		{
-			VkMappedMemoryRange mappedRange = {};
-			mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-			mappedRange.memory = memory;
-			mappedRange.offset = offset;
-			mappedRange.size = size;
-			return vkInvalidateMappedMemoryRanges(device, 1, &mappedRange);
+			return allocation.invalidate(size, offset);
 		}
 
 		/** 
@@ -150,11 +146,10 @@ namespace vks
 			if (buffer)
 			{
 				vkDestroyBuffer(device, buffer, nullptr);
+				buffer = VK_NULL_HANDLE;
 			}
-			if (memory)
-			{
-				vkFreeMemory(device, memory, nullptr);
-			}
+			mapped = nullptr;
+			allocation.free();
 		}
 
 	};
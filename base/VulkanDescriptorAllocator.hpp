@@ -0,0 +1,554 @@
+/*
+* Vulkan descriptor allocation helpers
+*
+* Descriptor set layout cache, growable descriptor set allocator and descriptor update templates
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+#include <mutex>
+#include <assert.h>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+
+namespace vks
+{
+	/**
+	* @brief Cache of descriptor set layouts, keyed by their bindings
+	*
+	* Requesting a layout with the same bindings (in any order) returns the same layout object, so layouts can be
+	* requested wherever they are needed without creating duplicates. All layouts are owned by the cache and destroyed with it.
+	*
+	* @note Thread safe
+	*/
+	class DescriptorLayoutCache
+	{
+	private:
+		struct Key
+		{
+			VkDescriptorSetLayoutCreateFlags flags;
+			std::vector<VkDescriptorSetLayoutBinding> bindings;
+			// Immutable samplers of all bindings, in binding order
+			std::vector<VkSampler> immutableSamplers;
+
+			bool operator==(const Key &other) const
+			{
+				if ((flags != other.flags) || (bindings.size() != other.bindings.size()) || (immutableSamplers != other.immutableSamplers))
+				{
+					return false;
+				}
+				for (size_t i = 0; i < bindings.size(); i++)
+				{
+					if ((bindings[i].binding != other.bindings[i].binding) ||
+						(bindings[i].descriptorType != other.bindings[i].descriptorType) ||
+						(bindings[i].descriptorCount != other.bindings[i].descriptorCount) ||
+						(bindings[i].stageFlags != other.bindings[i].stageFlags))
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+		};
+
+		struct KeyHash
+		{
+			static void combine(uint64_t &hash, uint64_t value)
+			{
+				// FNV-1a over 64 bit words
+				hash ^= value;
+				hash *= 1099511628211ULL;
+			}
+
+			size_t operator()(const Key &key) const
+			{
+				uint64_t hash = 14695981039346656037ULL;
+				combine(hash, key.flags);
+				for (auto &binding : key.bindings)
+				{
+					combine(hash, (static_cast<uint64_t>(binding.binding) << 32) | static_cast<uint64_t>(binding.descriptorType));
+					combine(hash, (static_cast<uint64_t>(binding.descriptorCount) << 32) | static_cast<uint64_t>(binding.stageFlags));
+				}
+				for (auto sampler : key.immutableSamplers)
+				{
+					combine(hash, (uint64_t)sampler);
+				}
+				return static_cast<size_t>(hash);
+			}
+		};
+
+		VkDevice device = VK_NULL_HANDLE;
+		std::unordered_map<Key, VkDescriptorSetLayout, KeyHash> layouts;
+		uint32_t requestCount = 0;
+		std::mutex mutex;
+
+	public:
+		/**
+		* Prepare the cache for use
+		*
+		* @param device Logical device the layouts are created on
+		*/
+		void create(VkDevice device)
+		{
+			this->device = device;
+		}
+
+		/**
+		* Get a descriptor set layout, creating it if no layout with the same bindings exists yet
+		*
+		* @param createInfo Layout create info
+		* @param layout Pointer to the layout handle that receives the (shared) layout
+		*
+		* @note Create infos with a pNext chain always get a layout of their own, as the chained structures aren't part of the key
+		*
+		* @return VkResult of the layout creation, VK_SUCCESS if an existing layout has been returned
+		*/
+		VkResult get(const VkDescriptorSetLayoutCreateInfo &createInfo, VkDescriptorSetLayout *layout)
+		{
+			assert(device);
+			Key key;
+			key.flags = createInfo.flags;
+			key.bindings.assign(createInfo.pBindings, createInfo.pBindings + createInfo.bindingCount);
+			std::sort(key.bindings.begin(), key.bindings.end(), [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b) { return a.binding < b.binding; });
+			for (auto &binding : key.bindings)
+			{
+				if (binding.pImmutableSamplers)
+				{
+					key.immutableSamplers.insert(key.immutableSamplers.end(), binding.pImmutableSamplers, binding.pImmutableSamplers + binding.descriptorCount);
+				}
+				// Bindings with and without immutable samplers must not compare equal
+				key.immutableSamplers.push_back(VK_NULL_HANDLE);
+				binding.pImmutableSamplers = nullptr;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			requestCount++;
+			if (!createInfo.pNext)
+			{
+				auto cached = layouts.find(key);
+				if (cached != layouts.end())
+				{
+					*layout = cached->second;
+					return VK_SUCCESS;
+				}
+			}
+			VkResult result = vkCreateDescriptorSetLayout(device, &createInfo, nullptr, layout);
+			if ((result == VK_SUCCESS) && !createInfo.pNext)
+			{
+				layouts[key] = *layout;
+			}
+			return result;
+		}
+
+		/**
+		* Get a descriptor set layout for a list of bindings
+		*
+		* @param bindings Bindings of the layout
+		* @param layout Pointer to the layout handle that receives the (shared) layout
+		*
+		* @return VkResult of the layout creation, VK_SUCCESS if an existing layout has been returned
+		*/
+		VkResult get(const std::vector<VkDescriptorSetLayoutBinding> &bindings, VkDescriptorSetLayout *layout)
+		{
+			VkDescriptorSetLayoutCreateInfo createInfo{};
+			createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			createInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+			createInfo.pBindings = bindings.data();
+			return get(createInfo, layout);
+		}
+
+		/** @brief Number of distinct layouts in the cache */
+		uint32_t size()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return static_cast<uint32_t>(layouts.size());
+		}
+
+		/** @brief Destroy all layouts of the cache */
+		void destroy()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (auto &layout : layouts)
+			{
+				vkDestroyDescriptorSetLayout(device, layout.second, nullptr);
+			}
+			layouts.clear();
+		}
+	};
+
+	/**
+	* @brief Descriptor set allocator that creates descriptor pools on demand
+	*
+	* Sets are allocated from the current pool until it runs out, then the next pool is taken from the list of free pools
+	* or created with twice the size of the previous one (up to maxSetsPerPool). Pools are sized with a number of descriptors
+	* of each type per set, so there is no need to count the descriptors an example uses up front.
+	*
+	* Individual sets are never freed. reset() returns all sets at once by resetting the pools, which is much cheaper than freeing
+	* or updating sets one by one. For sets that change every frame use one allocator per frame in flight and reset it once
+	* the frame's fence has been signaled.
+	*
+	* @note Not thread safe, use one allocator per thread
+	*/
+	class DescriptorAllocator
+	{
+	public:
+		/** @brief Number of descriptors of a type reserved per set in each pool */
+		typedef std::vector<std::pair<VkDescriptorType, float>> PoolSizeFactors;
+
+		/** @brief Allocation statistics */
+		struct Stats
+		{
+			uint32_t poolCount = 0;
+			/** @brief Sets allocated since the last reset */
+			uint32_t setCount = 0;
+			uint32_t resetCount = 0;
+		};
+
+		/** @brief Upper limit for the set count of a single pool */
+		uint32_t maxSetsPerPool = 4096;
+
+	private:
+		VkDevice device = VK_NULL_HANDLE;
+		PoolSizeFactors poolSizeFactors;
+		VkDescriptorPoolCreateFlags flags = 0;
+		uint32_t setsPerPool = 0;
+		VkDescriptorPool currentPool = VK_NULL_HANDLE;
+		// Sets left in the current pool
+		uint32_t currentPoolSets = 0;
+		std::vector<std::pair<VkDescriptorPool, uint32_t>> usedPools;
+		std::vector<std::pair<VkDescriptorPool, uint32_t>> freePools;
+		Stats stats;
+
+		VkResult nextPool()
+		{
+			if (!freePools.empty())
+			{
+				usedPools.push_back(freePools.back());
+				freePools.pop_back();
+			}
+			else
+			{
+				std::vector<VkDescriptorPoolSize> poolSizes;
+				for (auto &factor : poolSizeFactors)
+				{
+					poolSizes.push_back({ factor.first, std::max(static_cast<uint32_t>(factor.second * setsPerPool), 1u) });
+				}
+				VkDescriptorPoolCreateInfo poolInfo{};
+				poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+				poolInfo.flags = flags;
+				poolInfo.maxSets = setsPerPool;
+				poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+				poolInfo.pPoolSizes = poolSizes.data();
+				VkDescriptorPool pool;
+				VkResult result = vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool);
+				if (result != VK_SUCCESS)
+				{
+					return result;
+				}
+				usedPools.push_back(std::make_pair(pool, setsPerPool));
+				stats.poolCount++;
+				// Scenes that needed one more pool are likely to need even more
+				setsPerPool = std::min(setsPerPool * 2, maxSetsPerPool);
+			}
+			currentPool = usedPools.back().first;
+			currentPoolSets = usedPools.back().second;
+			return VK_SUCCESS;
+		}
+
+	public:
+		/** @brief Pool size factors that fit most of the examples */
+		static PoolSizeFactors defaultPoolSizeFactors()
+		{
+			return {
+				{ VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f },
+				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+				{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1.0f },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+				{ VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 0.5f },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 0.5f },
+				{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.0f },
+				{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 0.5f },
+				{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f }
+			};
+		}
+
+		/**
+		* Prepare the allocator for use, pools are created with the first allocation
+		*
+		* @param device Logical device the pools are created on
+		* @param (Optional) setsPerPool Set count of the first pool (defaults to 64)
+		* @param (Optional) poolSizeFactors Descriptors of each type per set (defaults to defaultPoolSizeFactors())
+		* @param (Optional) flags Create flags of the pools
+		*/
+		void create(VkDevice device, uint32_t setsPerPool = 64, const PoolSizeFactors &poolSizeFactors = defaultPoolSizeFactors(), VkDescriptorPoolCreateFlags flags = 0)
+		{
+			this->device = device;
+			this->setsPerPool = setsPerPool;
+			this->poolSizeFactors = poolSizeFactors;
+			this->flags = flags;
+		}
+
+		/**
+		* Allocate a descriptor set, taking a new pool if the current one is exhausted
+		*
+		* @param layout Layout of the set
+		* @param set Pointer to the handle that receives the set
+		*
+		* @return VkResult of the allocation
+		*/
+		VkResult allocate(VkDescriptorSetLayout layout, VkDescriptorSet *set)
+		{
+			assert(device);
+			VkResult result = VK_SUCCESS;
+			if (currentPoolSets == 0)
+			{
+				result = nextPool();
+				if (result != VK_SUCCESS)
+				{
+					return result;
+				}
+			}
+
+			VkDescriptorSetAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocInfo.descriptorPool = currentPool;
+			allocInfo.descriptorSetCount = 1;
+			allocInfo.pSetLayouts = &layout;
+			result = vkAllocateDescriptorSets(device, &allocInfo, set);
+			if ((result == VK_ERROR_OUT_OF_POOL_MEMORY_KHR) || (result == VK_ERROR_FRAGMENTED_POOL))
+			{
+				// The pool ran out of descriptors of a type before running out of sets, retry once with a fresh pool
+				result = nextPool();
+				if (result != VK_SUCCESS)
+				{
+					return result;
+				}
+				allocInfo.descriptorPool = currentPool;
+				result = vkAllocateDescriptorSets(device, &allocInfo, set);
+			}
+			if (result == VK_SUCCESS)
+			{
+				currentPoolSets--;
+				stats.setCount++;
+			}
+			return result;
+		}
+
+		/**
+		* Return all sets allocated since the last reset to the pools
+		*
+		* @note The sets must not be in use by the device anymore
+		*/
+		void reset()
+		{
+			for (auto &pool : usedPools)
+			{
+				VK_CHECK_RESULT(vkResetDescriptorPool(device, pool.first, 0));
+				freePools.push_back(pool);
+			}
+			usedPools.clear();
+			currentPool = VK_NULL_HANDLE;
+			currentPoolSets = 0;
+			stats.setCount = 0;
+			stats.resetCount++;
+		}
+
+		/** @brief Get the allocation statistics */
+		Stats getStats()
+		{
+			return stats;
+		}
+
+		/** @brief Destroy all pools, which frees all sets allocated from them */
+		void destroy()
+		{
+			for (auto &pool : usedPools)
+			{
+				vkDestroyDescriptorPool(device, pool.first, nullptr);
+			}
+			for (auto &pool : freePools)
+			{
+				vkDestroyDescriptorPool(device, pool.first, nullptr);
+			}
+			usedPools.clear();
+			freePools.clear();
+			currentPool = VK_NULL_HANDLE;
+			currentPoolSets = 0;
+			stats = Stats();
+		}
+	};
+
+	/**
+	* @brief Updates all descriptors of a set from a single application defined structure
+	*
+	* The template entries describe where the descriptor infos of each binding are located in the structure. With VK_KHR_descriptor_update_template
+	* the driver reads the descriptors straight from the structure, without the application filling VkWriteDescriptorSet arrays for every update.
+	* On devices without the extension the entries are turned into descriptor writes instead.
+	*
+	* @note update() is not thread safe, as the descriptor writes of the fallback path are kept for reuse
+	*/
+	class DescriptorUpdateTemplate
+	{
+	private:
+		VkDevice device = VK_NULL_HANDLE;
+		VkDescriptorUpdateTemplateKHR updateTemplate = VK_NULL_HANDLE;
+		std::vector<VkDescriptorUpdateTemplateEntryKHR> entries;
+		PFN_vkDestroyDescriptorUpdateTemplateKHR pfnDestroyDescriptorUpdateTemplate = nullptr;
+		PFN_vkUpdateDescriptorSetWithTemplateKHR pfnUpdateDescriptorSetWithTemplate = nullptr;
+
+		// Fallback
+		std::vector<VkWriteDescriptorSet> writeDescriptorSets;
+		std::vector<VkDescriptorImageInfo> imageInfos;
+		std::vector<VkDescriptorBufferInfo> bufferInfos;
+		std::vector<VkBufferView> texelBufferViews;
+
+		static bool isImage(VkDescriptorType type)
+		{
+			return (type == VK_DESCRIPTOR_TYPE_SAMPLER) || (type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) || (type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE) ||
+				(type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE) || (type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT);
+		}
+
+		static bool isTexelBuffer(VkDescriptorType type)
+		{
+			return (type == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER) || (type == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER);
+		}
+
+	public:
+		/**
+		* Create the update template for a descriptor set layout
+		*
+		* @param device Logical device
+		* @param useTemplate True if VK_KHR_descriptor_update_template has been enabled on the device (see vks::VulkanDevice::enableDescriptorUpdateTemplates)
+		* @param layout Descriptor set layout of the sets that are updated
+		* @param entries Bindings to update and the offsets (and strides for arrays) of their descriptor infos in the application's structure
+		*
+		* @return VkResult of the template creation
+		*/
+		VkResult create(VkDevice device, bool useTemplate, VkDescriptorSetLayout layout, const std::vector<VkDescriptorUpdateTemplateEntryKHR> &entries)
+		{
+			this->device = device;
+			this->entries = entries;
+			if (useTemplate)
+			{
+				PFN_vkCreateDescriptorUpdateTemplateKHR pfnCreateDescriptorUpdateTemplate = reinterpret_cast<PFN_vkCreateDescriptorUpdateTemplateKHR>(vkGetDeviceProcAddr(device, "vkCreateDescriptorUpdateTemplateKHR"));
+				pfnDestroyDescriptorUpdateTemplate = reinterpret_cast<PFN_vkDestroyDescriptorUpdateTemplateKHR>(vkGetDeviceProcAddr(device, "vkDestroyDescriptorUpdateTemplateKHR"));
+				pfnUpdateDescriptorSetWithTemplate = reinterpret_cast<PFN_vkUpdateDescriptorSetWithTemplateKHR>(vkGetDeviceProcAddr(device, "vkUpdateDescriptorSetWithTemplateKHR"));
+				if (pfnCreateDescriptorUpdateTemplate && pfnDestroyDescriptorUpdateTemplate && pfnUpdateDescriptorSetWithTemplate)
+				{
+					VkDescriptorUpdateTemplateCreateInfoKHR createInfo{};
+					createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
+					createInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+					createInfo.pDescriptorUpdateEntries = entries.data();
+					createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+					createInfo.descriptorSetLayout = layout;
+					return pfnCreateDescriptorUpdateTemplate(device, &createInfo, nullptr, &updateTemplate);
+				}
+			}
+
+			// Prepare the descriptor writes, only the destination set and the infos change with each update
+			uint32_t imageCount = 0, bufferCount = 0, texelBufferCount = 0;
+			for (auto &entry : entries)
+			{
+				uint32_t &count = isImage(entry.descriptorType) ? imageCount : (isTexelBuffer(entry.descriptorType) ? texelBufferCount : bufferCount);
+				count += entry.descriptorCount;
+			}
+			imageInfos.resize(imageCount);
+			bufferInfos.resize(bufferCount);
+			texelBufferViews.resize(texelBufferCount);
+			imageCount = bufferCount = texelBufferCount = 0;
+			writeDescriptorSets.clear();
+			for (auto &entry : entries)
+			{
+				VkWriteDescriptorSet writeDescriptorSet{};
+				writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writeDescriptorSet.dstBinding = entry.dstBinding;
+				writeDescriptorSet.dstArrayElement = entry.dstArrayElement;
+				writeDescriptorSet.descriptorCount = entry.descriptorCount;
+				writeDescriptorSet.descriptorType = entry.descriptorType;
+				if (isImage(entry.descriptorType))
+				{
+					writeDescriptorSet.pImageInfo = &imageInfos[imageCount];
+					imageCount += entry.descriptorCount;
+				}
+				else if (isTexelBuffer(entry.descriptorType))
+				{
+					writeDescriptorSet.pTexelBufferView = &texelBufferViews[texelBufferCount];
+					texelBufferCount += entry.descriptorCount;
+				}
+				else
+				{
+					writeDescriptorSet.pBufferInfo = &bufferInfos[bufferCount];
+					bufferCount += entry.descriptorCount;
+				}
+				writeDescriptorSets.push_back(writeDescriptorSet);
+			}
+			return VK_SUCCESS;
+		}
+
+		/** @brief Returns true if the updates are done by the driver through VK_KHR_descriptor_update_template */
+		bool usesTemplate() const
+		{
+			return updateTemplate != VK_NULL_HANDLE;
+		}
+
+		/**
+		* Update all bindings of a descriptor set
+		*
+		* @param set Descriptor set to update
+		* @param data Structure that contains the descriptor infos at the offsets of the template entries
+		*/
+		void update(VkDescriptorSet set, const void *data)
+		{
+			if (updateTemplate)
+			{
+				pfnUpdateDescriptorSetWithTemplate(device, set, updateTemplate, data);
+				return;
+			}
+			const uint8_t *bytes = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < entries.size(); i++)
+			{
+				VkWriteDescriptorSet &writeDescriptorSet = writeDescriptorSets[i];
+				writeDescriptorSet.dstSet = set;
+				for (uint32_t j = 0; j < entries[i].descriptorCount; j++)
+				{
+					const uint8_t *info = bytes + entries[i].offset + j * entries[i].stride;
+					if (writeDescriptorSet.pImageInfo)
+					{
+						const_cast<VkDescriptorImageInfo*>(writeDescriptorSet.pImageInfo)[j] = *reinterpret_cast<const VkDescriptorImageInfo*>(info);
+					}
+					else if (writeDescriptorSet.pTexelBufferView)
+					{
+						const_cast<VkBufferView*>(writeDescriptorSet.pTexelBufferView)[j] = *reinterpret_cast<const VkBufferView*>(info);
+					}
+					else
+					{
+						const_cast<VkDescriptorBufferInfo*>(writeDescriptorSet.pBufferInfo)[j] = *reinterpret_cast<const VkDescriptorBufferInfo*>(info);
+					}
+				}
+			}
+			vkUpdateDescriptorSets(device, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+		}
+
+		/** @brief Destroy the update template */
+		void destroy()
+		{
+			if (updateTemplate)
+			{
+				pfnDestroyDescriptorUpdateTemplate(device, updateTemplate, nullptr);
+				updateTemplate = VK_NULL_HANDLE;
+			}
+			writeDescriptorSets.clear();
+		}
+	};
+}
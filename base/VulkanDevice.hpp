@@ -13,9 +13,16 @@
 #include <exception>
 #include <assert.h>
 #include <algorithm>
+#include <map>
+#include <mutex>
+#include <thread>
 #include "vulkan/vulkan.h"
 #include "VulkanTools.h"
 #include "VulkanBuffer.hpp"
+#include "VulkanMemoryAllocator.hpp"
+#include "VulkanUploadQueue.hpp"
+#include "VulkanSamplerCache.hpp"
+#include "VulkanDescriptorAllocator.hpp"
 
 namespace vks
 {	
@@ -36,12 +43,35 @@ namespace vks
 		/** @brief List of extensions supported by the device */
 		std::vector<std::string> supportedExtensions;
 
-		/** @brief Default command pool for the graphics queue family index */
+		/** @brief Default command pool for the graphics queue family index, used by the thread that created the logical device */
 		VkCommandPool commandPool = VK_NULL_HANDLE;
 
+		/** @brief Command pools for the graphics queue family index used by other threads (see getCommandPool) */
+		std::map<std::thread::id, VkCommandPool> threadCommandPools;
+		std::thread::id commandPoolThread;
+		std::mutex commandPoolMutex;
+
+		/** @brief Locked around all submissions to the device's queues that may happen concurrently, e.g. while loading assets on the thread pool */
+		std::mutex queueMutex;
+
+		/** @brief Sub-allocator used for the memory of buffers and textures created through the device */
+		vks::MemoryAllocator memoryAllocator;
+
+		/** @brief Batches staging uploads for buffers and textures, uses a dedicated transfer queue if available */
+		vks::UploadQueue uploadQueue;
+
+		/** @brief Shares samplers between all textures and framebuffers created with the same sampler state */
+		vks::SamplerCache samplerCache;
+
+		/** @brief Shares descriptor set layouts with the same bindings */
+		vks::DescriptorLayoutCache descriptorLayoutCache;
+
 		/** @brief Set to true when the debug marker extension is detected */
 		bool enableDebugMarkers = false;
 
+		/** @brief Set to true when the descriptor update template extension is detected (see vks::DescriptorUpdateTemplate) */
+		bool enableDescriptorUpdateTemplates = false;
+
 		/** @brief Contains queue family indices */
 		struct
 		{
@@ -100,10 +130,18 @@ namespace vks
 		*/
 		~VulkanDevice()
 		{
+			uploadQueue.destroy();
+			samplerCache.destroy();
+			descriptorLayoutCache.destroy();
 			if (commandPool)
 			{
 				vkDestroyCommandPool(logicalDevice, commandPool, nullptr);
 			}
+			for (auto& threadCommandPool : threadCommandPools)
+			{
+				vkDestroyCommandPool(logicalDevice, threadCommandPool.second, nullptr);
+			}
+			memoryAllocator.destroy();
 			if (logicalDevice)
 			{
 				vkDestroyDevice(logicalDevice, nullptr);
@@ -223,9 +261,11 @@ namespace vks
 		* @param useSwapChain Set to false for headless rendering to omit the swapchain device extensions
 		* @param requestedQueueTypes Bit flags specifying the queue types to be requested from the device  
 		*
+		* @note If a transfer queue is requested and the device has a dedicated transfer queue family, uploads are executed on that queue
+		*
 		* @return VkResult of the device creation call
 		*/
-		VkResult createLogicalDevice(VkPhysicalDeviceFeatures enabledFeatures, std::vector<const char*> enabledExtensions, bool useSwapChain = true, VkQueueFlags requestedQueueTypes = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)
+		VkResult createLogicalDevice(VkPhysicalDeviceFeatures enabledFeatures, std::vector<const char*> enabledExtensions, bool useSwapChain = true, VkQueueFlags requestedQueueTypes = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT)
 		{			
 			// Desired queues need to be requested upon logical device creation
 			// Due to differing queue family configurations of Vulkan implementations this can be a bit tricky, especially if the application
@@ -317,6 +357,19 @@ namespace vks
 				enableDebugMarkers = true;
 			}
 
+			// Descriptor pools report running out of descriptors with VK_ERROR_OUT_OF_POOL_MEMORY_KHR (used by vks::DescriptorAllocator)
+			if (extensionSupported(VK_KHR_MAINTENANCE1_EXTENSION_NAME))
+			{
+				deviceExtensions.push_back(VK_KHR_MAINTENANCE1_EXTENSION_NAME);
+			}
+
+			// Update descriptor sets from application defined structures
+			if (extensionSupported(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME))
+			{
+				deviceExtensions.push_back(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+				enableDescriptorUpdateTemplates = true;
+			}
+
 			if (deviceExtensions.size() > 0)
 			{
 				deviceCreateInfo.enabledExtensionCount = (uint32_t)deviceExtensions.size();
@@ -329,11 +382,31 @@ namespace vks
 			{
 				// Create a default command pool for graphics command buffers
 				commandPool = createCommandPool(queueFamilyIndices.graphics);
+				commandPoolThread = std::this_thread::get_id();
+				memoryAllocator.create(logicalDevice, physicalDevice);
+				samplerCache.create(logicalDevice);
+				descriptorLayoutCache.create(logicalDevice);
+				uploadQueue.create(physicalDevice, logicalDevice, &memoryAllocator, queueFamilyIndices.graphics, queueFamilyIndices.transfer, 32 * 1024 * 1024, &queueMutex);
 			}
 
 			return result;
 		}
 
+		/**
+		* Allocate device memory for a resource from the device's memory allocator
+		*
+		* @param memReqs Memory requirements of the resource
+		* @param memoryPropertyFlags Memory properties for the allocation (i.e. device local, host visible, coherent)
+		* @param linear True for buffers and linear tiled images, false for optimal tiled images
+		* @param allocation Pointer to the allocation filled by the function, bind the resource using its memory and offset
+		*
+		* @return VK_SUCCESS if the memory has been allocated
+		*/
+		VkResult allocateMemory(VkMemoryRequirements memReqs, VkMemoryPropertyFlags memoryPropertyFlags, bool linear, vks::Allocation *allocation)
+		{
+			return memoryAllocator.allocate(memReqs, getMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags), linear, allocation);
+		}
+
 		/**
 		* Create a buffer on the device
 		*
@@ -341,47 +414,39 @@ namespace vks
 		* @param memoryPropertyFlags Memory properties for this buffer (i.e. device local, host visible, coherent)
 		* @param size Size of the buffer in byes
 		* @param buffer Pointer to the buffer handle acquired by the function
-		* @param memory Pointer to the memory handle acquired by the function
+		* @param allocation Pointer to the allocation acquired by the function, sub-allocated from the device's memory allocator
 		* @param data Pointer to the data that should be copied to the buffer after creation (optional, if not set, no data is copied over)
 		*
+		* @note The caller destroys the buffer and returns the allocation with vks::Allocation::free
+		*
 		* @return VK_SUCCESS if buffer handle and memory have been created and (optionally passed) data has been copied
 		*/
-		VkResult createBuffer(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize size, VkBuffer *buffer, VkDeviceMemory *memory, void *data = nullptr)
+		VkResult createBuffer(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize size, VkBuffer *buffer, vks::Allocation *allocation, void *data = nullptr)
 		{
 			// Create the buffer handle
 			VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo(usageFlags, size);
 			bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 			VK_CHECK_RESULT(vkCreateBuffer(logicalDevice, &bufferCreateInfo, nullptr, buffer));
 
-			// Create the memory backing up the buffer handle
+			// Sub-allocate the memory backing up the buffer handle
 			VkMemoryRequirements memReqs;
-			VkMemoryAllocateInfo memAlloc = vks::initializers::memoryAllocateInfo();
 			vkGetBufferMemoryRequirements(logicalDevice, *buffer, &memReqs);
-			memAlloc.allocationSize = memReqs.size;
-			// Find a memory type index that fits the properties of the buffer
-			memAlloc.memoryTypeIndex = getMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
-			VK_CHECK_RESULT(vkAllocateMemory(logicalDevice, &memAlloc, nullptr, memory));
-			
-			// If a pointer to the buffer data has been passed, map the buffer and copy over the data
+			VK_CHECK_RESULT(allocateMemory(memReqs, memoryPropertyFlags, true, allocation));
+
+			// If a pointer to the buffer data has been passed, copy it over using the persistent mapping of the memory block
 			if (data != nullptr)
 			{
-				void *mapped;
-				VK_CHECK_RESULT(vkMapMemory(logicalDevice, *memory, 0, size, 0, &mapped));
-				memcpy(mapped, data, size);
+				assert(allocation->mapped);
+				memcpy(allocation->mapped, data, size);
 				// If host coherency hasn't been requested, do a manual flush to make writes visible
 				if ((memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0)
 				{
-					VkMappedMemoryRange mappedRange = vks::initializers::mappedMemoryRange();
-					mappedRange.memory = *memory;
-					mappedRange.offset = 0;
-					mappedRange.size = size;
-					vkFlushMappedMemoryRanges(logicalDevice, 1, &mappedRange);
+					allocation->flush(size);
 				}
-				vkUnmapMemory(logicalDevice, *memory);
 			}
 
 			// Attach the memory to the buffer object
-			VK_CHECK_RESULT(vkBindBufferMemory(logicalDevice, *buffer, *memory, 0));
+			VK_CHECK_RESULT(vkBindBufferMemory(logicalDevice, *buffer, allocation->memory, allocation->offset));
 
 			return VK_SUCCESS;
 		}
@@ -405,17 +470,13 @@ namespace vks
 			VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo(usageFlags, size);
 			VK_CHECK_RESULT(vkCreateBuffer(logicalDevice, &bufferCreateInfo, nullptr, &buffer->buffer));
 
-			// Create the memory backing up the buffer handle
+			// Sub-allocate the memory backing up the buffer handle
 			VkMemoryRequirements memReqs;
-			VkMemoryAllocateInfo memAlloc = vks::initializers::memoryAllocateInfo();
 			vkGetBufferMemoryRequirements(logicalDevice, buffer->buffer, &memReqs);
-			memAlloc.allocationSize = memReqs.size;
-			// Find a memory type index that fits the properties of the buffer
-			memAlloc.memoryTypeIndex = getMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
-			VK_CHECK_RESULT(vkAllocateMemory(logicalDevice, &memAlloc, nullptr, &buffer->memory));
+			VK_CHECK_RESULT(allocateMemory(memReqs, memoryPropertyFlags, true, &buffer->allocation));
 
 			buffer->alignment = memReqs.alignment;
-			buffer->size = memAlloc.allocationSize;
+			buffer->size = size;
 			buffer->usageFlags = usageFlags;
 			buffer->memoryPropertyFlags = memoryPropertyFlags;
 
@@ -424,6 +485,11 @@ namespace vks
 			{
 				VK_CHECK_RESULT(buffer->map());
 				memcpy(buffer->mapped, data, size);
+				// If host coherency hasn't been requested, do a manual flush to make writes visible
+				if ((memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0)
+				{
+					buffer->flush();
+				}
 				buffer->unmap();
 			}
 
@@ -439,16 +505,18 @@ namespace vks
 		* 
 		* @param src Pointer to the source buffer to copy from
 		* @param dst Pointer to the destination buffer to copy tp
-		* @param queue Pointer
 		* @param copyRegion (Optional) Pointer to a copy region, if NULL, the whole buffer is copied
+		* @param dstQueueFamily (Optional) Queue family the destination buffer is used on, ownership is transferred to it if it differs from the upload queue's family (defaults to the graphics queue family)
 		*
 		* @note Source and destionation pointers must have the approriate transfer usage flags set (TRANSFER_SRC / TRANSFER_DST)
+		* @note The copy is recorded into the upload queue's current batch, the source buffer must be kept alive until the returned token has completed
+		*
+		* @return Token of the upload batch the copy has been recorded into
 		*/
-		void copyBuffer(vks::Buffer *src, vks::Buffer *dst, VkQueue queue, VkBufferCopy *copyRegion = nullptr)
+		vks::UploadToken copyBuffer(vks::Buffer *src, vks::Buffer *dst, VkBufferCopy *copyRegion = nullptr, uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED)
 		{
 			assert(dst->size <= src->size);
-			assert(src->buffer && src->buffer);
-			VkCommandBuffer copyCmd = createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+			assert(src->buffer && dst->buffer);
 			VkBufferCopy bufferCopy{};
 			if (copyRegion == nullptr)
 			{
@@ -458,10 +526,7 @@ namespace vks
 			{
 				bufferCopy = *copyRegion;
 			}
-
-			vkCmdCopyBuffer(copyCmd, src->buffer, dst->buffer, 1, &bufferCopy);
-
-			flushCommandBuffer(copyCmd, queue);
+			return uploadQueue.copyBuffer(src->buffer, dst->buffer, bufferCopy, dstQueueFamily);
 		}
 
 		/** 
@@ -486,7 +551,32 @@ namespace vks
 		}
 
 		/**
-		* Allocate a command buffer from the command pool
+		* Get the graphics command pool of the calling thread
+		*
+		* @return The default command pool for the thread that created the device, a command pool owned by the calling thread for all other threads
+		*
+		* @note Command pools must be externally synchronized, so every thread that records command buffers needs its own pool
+		*/
+		VkCommandPool getCommandPool()
+		{
+			std::thread::id threadId = std::this_thread::get_id();
+			if (threadId == commandPoolThread)
+			{
+				return commandPool;
+			}
+			std::lock_guard<std::mutex> lock(commandPoolMutex);
+			auto it = threadCommandPools.find(threadId);
+			if (it != threadCommandPools.end())
+			{
+				return it->second;
+			}
+			VkCommandPool threadCommandPool = createCommandPool(queueFamilyIndices.graphics);
+			threadCommandPools[threadId] = threadCommandPool;
+			return threadCommandPool;
+		}
+
+		/**
+		* Allocate a command buffer from the calling thread's command pool
 		*
 		* @param level Level of the new command buffer (primary or secondary)
 		* @param (Optional) begin If true, recording on the new command buffer will be started (vkBeginCommandBuffer) (Defaults to false)
@@ -495,7 +585,7 @@ namespace vks
 		*/
 		VkCommandBuffer createCommandBuffer(VkCommandBufferLevel level, bool begin = false)
 		{
-			VkCommandBufferAllocateInfo cmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(commandPool, level, 1);
+			VkCommandBufferAllocateInfo cmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(getCommandPool(), level, 1);
 
 			VkCommandBuffer cmdBuffer;
 			VK_CHECK_RESULT(vkAllocateCommandBuffers(logicalDevice, &cmdBufAllocateInfo, &cmdBuffer));
@@ -519,6 +609,8 @@ namespace vks
 		*
 		* @note The queue that the command buffer is submitted to must be from the same family index as the pool it was allocated from
 		* @note Uses a fence to ensure command buffer has finished executing
+		* @note Pending uploads are flushed first, as the command buffer may use the uploaded resources
+		* @note Must be called from the thread that created the command buffer, the submission is guarded by the queue mutex
 		*/
 		void flushCommandBuffer(VkCommandBuffer commandBuffer, VkQueue queue, bool free = true)
 		{
@@ -527,6 +619,8 @@ namespace vks
 				return;
 			}
 
+			uploadQueue.flush();
+
 			VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffer));
 
 			VkSubmitInfo submitInfo = vks::initializers::submitInfo();
@@ -539,7 +633,10 @@ namespace vks
 			VK_CHECK_RESULT(vkCreateFence(logicalDevice, &fenceInfo, nullptr, &fence));
 			
 			// Submit to the queue
-			VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, fence));
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, fence));
+			}
 			// Wait for the fence to signal that command buffer has finished executing
 			VK_CHECK_RESULT(vkWaitForFences(logicalDevice, 1, &fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
 
@@ -547,7 +644,7 @@ namespace vks
 
 			if (free)
 			{
-				vkFreeCommandBuffers(logicalDevice, commandPool, 1, &commandBuffer);
+				vkFreeCommandBuffers(logicalDevice, getCommandPool(), 1, &commandBuffer);
 			}
 		}
 
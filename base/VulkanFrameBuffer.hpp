@@ -93,7 +93,7 @@ namespace vks
 		uint32_t width, height;
 		VkFramebuffer framebuffer;
 		VkRenderPass renderPass;
-		VkSampler sampler;
+		VkSampler sampler = VK_NULL_HANDLE;
 		std::vector<vks::FramebufferAttachment> attachments;
 
 		/**
@@ -119,7 +119,7 @@ namespace vks
 				vkDestroyImageView(vulkanDevice->logicalDevice, attachment.view, nullptr);
 				vkFreeMemory(vulkanDevice->logicalDevice, attachment.memory, nullptr);
 			}
-			vkDestroySampler(vulkanDevice->logicalDevice, sampler, nullptr);
+			vulkanDevice->samplerCache.release(sampler);
 			vkDestroyRenderPass(vulkanDevice->logicalDevice, renderPass, nullptr);
 			vkDestroyFramebuffer(vulkanDevice->logicalDevice, framebuffer, nullptr);
 		}
@@ -226,6 +226,7 @@ namespace vks
 
 		/**
 		* Creates a default sampler for sampling from any of the framebuffer attachments
+		* The sampler is shared through the device's sampler cache with all other users of the same state
 		* Applications are free to create their own samplers for different use cases 
 		*
 		* @param magFilter Magnification filter for lookups
@@ -248,7 +249,7 @@ namespace vks
 			samplerInfo.minLod = 0.0f;
 			samplerInfo.maxLod = 1.0f;
 			samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-			return vkCreateSampler(vulkanDevice->logicalDevice, &samplerInfo, nullptr, &sampler);
+			return vulkanDevice->samplerCache.acquire(samplerInfo, &sampler);
 		}
 
 		/**
@@ -0,0 +1,368 @@
+/*
+* Vulkan GPU profiler class
+*
+* Measures GPU execution times of command buffer regions using timestamp queries
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <assert.h>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+#include "VulkanDebug.h"
+#include "VulkanDevice.hpp"
+
+namespace vks
+{
+	/**
+	* @brief Timestamp query based GPU profiler
+	*
+	* Each profiled command buffer gets its own timestamp query pool, so pre-recorded per swap chain image command buffers
+	* and command buffers recorded once per frame in flight can be used alike. Scopes are also inserted as debug marker regions
+	* using the same name, so they show up identically in graphics debuggers.
+	* Results are fetched without waiting on the GPU (no VK_QUERY_RESULT_WAIT_BIT), queries that are not yet available are picked up on a later frame.
+	*/
+	class GpuProfiler
+	{
+	public:
+		/** @brief Averaged GPU time of a named scope */
+		struct Timing
+		{
+			std::string name;
+			double ms;
+		};
+
+	private:
+		struct Scope
+		{
+			uint32_t timingIndex;
+			uint32_t query;
+		};
+
+		struct CommandBufferQueries
+		{
+			VkQueryPool queryPool = VK_NULL_HANDLE;
+			// Scopes recorded into the command buffer, in order of their begin calls
+			std::vector<Scope> scopes;
+			// Currently open scopes (for nesting)
+			std::vector<uint32_t> scopeStack;
+			uint32_t queryCount = 0;
+			// Raw timestamps of the last resolve, used to detect new executions of pre-recorded command buffers
+			std::vector<uint64_t> lastResults;
+			// Set once a frame that submitted the command buffer has finished, so the reset recorded into it has been executed
+			bool executed = false;
+		};
+
+		struct TimingAccumulator
+		{
+			std::string name;
+			double sum = 0.0;
+			uint32_t count = 0;
+		};
+
+		vks::VulkanDevice *vulkanDevice = nullptr;
+		std::unordered_map<VkCommandBuffer, CommandBufferQueries> commandBufferQueries;
+		std::vector<TimingAccumulator> timings;
+		// Command buffers submitted in the frame being prepared and in each frame in flight
+		std::vector<VkCommandBuffer> pendingSubmissions;
+		std::vector<std::vector<VkCommandBuffer>> frameSubmissions;
+		uint64_t timestampMask = ~0ULL;
+
+		uint32_t getTimingIndex(const char* name)
+		{
+			for (uint32_t i = 0; i < timings.size(); i++)
+			{
+				if (timings[i].name == name)
+				{
+					return i;
+				}
+			}
+			TimingAccumulator timing;
+			timing.name = name;
+			timings.push_back(timing);
+			return static_cast<uint32_t>(timings.size() - 1);
+		}
+
+	public:
+		/** @brief Maximum number of scopes per command buffer, additional scopes only get a debug marker region */
+		uint32_t maxScopes = 32;
+		/** @brief Set to false if the graphics queue does not support timestamps, all calls turn into debug marker regions only */
+		bool supported = false;
+		/** @brief Nanoseconds per timestamp tick */
+		float timestampPeriod = 1.0f;
+
+		/**
+		* Set up the profiler for the given device
+		*
+		* @param vulkanDevice Device the command buffers are recorded on
+		*/
+		void create(vks::VulkanDevice *vulkanDevice)
+		{
+			this->vulkanDevice = vulkanDevice;
+			uint32_t validBits = vulkanDevice->queueFamilyProperties[vulkanDevice->queueFamilyIndices.graphics].timestampValidBits;
+			supported = (validBits > 0) && (vulkanDevice->properties.limits.timestampPeriod > 0.0f);
+			timestampPeriod = vulkanDevice->properties.limits.timestampPeriod;
+			if (validBits > 0 && validBits < 64)
+			{
+				timestampMask = (1ULL << validBits) - 1;
+			}
+		}
+
+		/** @brief Release all query pools */
+		void destroy()
+		{
+			for (auto& cbq : commandBufferQueries)
+			{
+				vkDestroyQueryPool(vulkanDevice->logicalDevice, cbq.second.queryPool, nullptr);
+			}
+			commandBufferQueries.clear();
+			pendingSubmissions.clear();
+			frameSubmissions.clear();
+		}
+
+		/**
+		* Release the query pool of a command buffer that is about to be freed
+		*
+		* @param commandBuffer Command buffer the queries were recorded into
+		*/
+		void release(VkCommandBuffer commandBuffer)
+		{
+			auto it = commandBufferQueries.find(commandBuffer);
+			if (it != commandBufferQueries.end())
+			{
+				vkDestroyQueryPool(vulkanDevice->logicalDevice, it->second.queryPool, nullptr);
+				commandBufferQueries.erase(it);
+			}
+			// A new command buffer may get the same handle, so forget pending submissions of this one
+			pendingSubmissions.erase(std::remove(pendingSubmissions.begin(), pendingSubmissions.end(), commandBuffer), pendingSubmissions.end());
+			for (auto& submissions : frameSubmissions)
+			{
+				submissions.erase(std::remove(submissions.begin(), submissions.end(), commandBuffer), submissions.end());
+			}
+		}
+
+		/**
+		* Reset the queries of a command buffer, must be called outside of a render pass before recording any scope into it
+		*
+		* @param commandBuffer Command buffer in recording state
+		*
+		* @note The reset is recorded into the command buffer itself, its results are read once it has been executed (see submitted)
+		*/
+		void reset(VkCommandBuffer commandBuffer)
+		{
+			if (!supported)
+			{
+				return;
+			}
+			CommandBufferQueries &cbq = commandBufferQueries[commandBuffer];
+			if (cbq.queryPool == VK_NULL_HANDLE)
+			{
+				VkQueryPoolCreateInfo queryPoolInfo = {};
+				queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+				queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+				queryPoolInfo.queryCount = maxScopes * 2;
+				VK_CHECK_RESULT(vkCreateQueryPool(vulkanDevice->logicalDevice, &queryPoolInfo, nullptr, &cbq.queryPool));
+			}
+			cbq.scopes.clear();
+			cbq.scopeStack.clear();
+			cbq.queryCount = 0;
+			vkCmdResetQueryPool(commandBuffer, cbq.queryPool, 0, maxScopes * 2);
+		}
+
+		/**
+		* Begin a named scope, also starts a debug marker region with the same name
+		*
+		* @param commandBuffer Command buffer the queries have been reset for
+		* @param name Name of the scope, scopes with the same name are accumulated
+		* @param color Color of the debug marker region
+		*/
+		void beginScope(VkCommandBuffer commandBuffer, const char* name, glm::vec4 color = glm::vec4(1.0f))
+		{
+			vks::debugmarker::beginRegion(commandBuffer, name, color);
+			if (!supported)
+			{
+				return;
+			}
+			auto it = commandBufferQueries.find(commandBuffer);
+			assert(it != commandBufferQueries.end());
+			CommandBufferQueries &cbq = it->second;
+			if (cbq.queryCount + 2 > maxScopes * 2)
+			{
+				// Out of queries, keep the stack balanced
+				cbq.scopeStack.push_back(UINT32_MAX);
+				return;
+			}
+			Scope scope;
+			scope.timingIndex = getTimingIndex(name);
+			scope.query = cbq.queryCount;
+			cbq.queryCount += 2;
+			cbq.scopeStack.push_back(static_cast<uint32_t>(cbq.scopes.size()));
+			cbq.scopes.push_back(scope);
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, cbq.queryPool, scope.query);
+		}
+
+		/**
+		* End the last scope started in the command buffer
+		*
+		* @param commandBuffer Command buffer the scope has been started in
+		*/
+		void endScope(VkCommandBuffer commandBuffer)
+		{
+			if (supported)
+			{
+				auto it = commandBufferQueries.find(commandBuffer);
+				assert(it != commandBufferQueries.end());
+				CommandBufferQueries &cbq = it->second;
+				assert(!cbq.scopeStack.empty());
+				uint32_t scopeIndex = cbq.scopeStack.back();
+				cbq.scopeStack.pop_back();
+				if (scopeIndex != UINT32_MAX)
+				{
+					vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, cbq.queryPool, cbq.scopes[scopeIndex].query + 1);
+				}
+			}
+			vks::debugmarker::endRegion(commandBuffer);
+		}
+
+		/**
+		* Mark a profiled command buffer as submitted in the frame that is currently being prepared
+		*
+		* @param commandBuffer Command buffer that has been or will be submitted before the frame's fence
+		*
+		* @note Queries of new query pools can't be read before their first reset has been executed on the GPU, so pools are only read once a frame that submitted their command buffer has finished
+		*/
+		void submitted(VkCommandBuffer commandBuffer)
+		{
+			auto it = commandBufferQueries.find(commandBuffer);
+			if ((it != commandBufferQueries.end()) && !it->second.executed)
+			{
+				pendingSubmissions.push_back(commandBuffer);
+			}
+		}
+
+		/**
+		* Assign the command buffers marked as submitted since the last call to a frame in flight
+		*
+		* @param frameIndex Index of the frame in flight whose fence covers the submissions
+		*/
+		void frameSubmitted(uint32_t frameIndex)
+		{
+			if (frameSubmissions.size() <= frameIndex)
+			{
+				frameSubmissions.resize(frameIndex + 1);
+			}
+			frameSubmissions[frameIndex].insert(frameSubmissions[frameIndex].end(), pendingSubmissions.begin(), pendingSubmissions.end());
+			pendingSubmissions.clear();
+		}
+
+		/**
+		* Mark the command buffers submitted in a frame in flight as executed, call after its fence has been waited on
+		*
+		* @param frameIndex Index of the finished frame in flight
+		*/
+		void frameFinished(uint32_t frameIndex)
+		{
+			if (frameSubmissions.size() <= frameIndex)
+			{
+				return;
+			}
+			for (auto commandBuffer : frameSubmissions[frameIndex])
+			{
+				auto it = commandBufferQueries.find(commandBuffer);
+				if (it != commandBufferQueries.end())
+				{
+					it->second.executed = true;
+				}
+			}
+			frameSubmissions[frameIndex].clear();
+		}
+
+		/**
+		* Fetch the results of all command buffers that have finished executing since the last call
+		* @note Does not wait on the GPU, call once per frame (e.g. after the frame fence has been waited on)
+		*/
+		void resolve()
+		{
+			if (!supported)
+			{
+				return;
+			}
+			std::vector<uint64_t> results;
+			for (auto& it : commandBufferQueries)
+			{
+				CommandBufferQueries &cbq = it.second;
+				if ((cbq.queryCount == 0) || !cbq.executed)
+				{
+					continue;
+				}
+				// Each query gets its timestamp followed by an availability value
+				results.resize(cbq.queryCount * 2);
+				VkResult res = vkGetQueryPoolResults(
+					vulkanDevice->logicalDevice,
+					cbq.queryPool,
+					0,
+					cbq.queryCount,
+					results.size() * sizeof(uint64_t),
+					results.data(),
+					2 * sizeof(uint64_t),
+					VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+				if ((res != VK_SUCCESS) && (res != VK_NOT_READY))
+				{
+					VK_CHECK_RESULT(res);
+				}
+				bool available = true;
+				for (uint32_t i = 0; i < cbq.queryCount; i++)
+				{
+					available &= (results[i * 2 + 1] != 0);
+				}
+				// Pre-recorded command buffers keep their last results until they are executed again, so skip results that have already been accumulated
+				if (!available || (results == cbq.lastResults))
+				{
+					continue;
+				}
+				cbq.lastResults = results;
+				for (auto& scope : cbq.scopes)
+				{
+					uint64_t begin = results[scope.query * 2] & timestampMask;
+					uint64_t end = results[(scope.query + 1) * 2] & timestampMask;
+					uint64_t ticks = (end - begin) & timestampMask;
+					timings[scope.timingIndex].sum += (double)ticks * timestampPeriod / 1000000.0;
+					timings[scope.timingIndex].count++;
+				}
+			}
+		}
+
+		/** @brief Average GPU time in milliseconds per execution for each scope since the last call to resetStatistics() */
+		std::vector<Timing> getTimings()
+		{
+			std::vector<Timing> averages;
+			for (auto& timing : timings)
+			{
+				if (timing.count > 0)
+				{
+					averages.push_back({ timing.name, timing.sum / timing.count });
+				}
+			}
+			return averages;
+		}
+
+		/** @brief Start a new averaging interval */
+		void resetStatistics()
+		{
+			for (auto& timing : timings)
+			{
+				timing.sum = 0.0;
+				timing.count = 0;
+			}
+		}
+	};
+}
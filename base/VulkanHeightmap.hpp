@@ -6,6 +6,8 @@
 * This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
 */
 
+#include <vector>
+
 #include <glm/glm.hpp>
 #include <glm/glm.hpp>
 #include <gli/gli.hpp>
@@ -13,6 +15,7 @@
 #include "vulkan/vulkan.h"
 #include "VulkanDevice.hpp"
 #include "VulkanBuffer.hpp"
+#include "VulkanIndexBuffer.hpp"
 
 namespace vks 
 {
@@ -40,9 +43,15 @@ namespace vks
 			glm::vec2 uv;
 		};
 
+		/** @brief CPU copy of the patch's vertices (patchSize * patchSize), e.g. for visibility or texture feedback on the CPU */
+		std::vector<Vertex> vertices;
+		uint32_t patchSize = 0;
+
 		size_t vertexBufferSize = 0;
 		size_t indexBufferSize = 0;
 		uint32_t indexCount = 0;
+		/** @brief Type of the indices, 16 bit if the patch's vertices can be addressed with them */
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32;
 
 		HeightMap(vks::VulkanDevice *device, VkQueue copyQueue)
 		{
@@ -96,7 +105,8 @@ namespace vks
 
 			// Generate vertices
 
-			Vertex * vertices = new Vertex[patchsize * patchsize * 4];
+			patchSize = patchsize;
+			vertices.resize(patchsize * patchsize);
 
 			const float wx = 2.0f;
 			const float wy = 2.0f;
@@ -188,26 +198,16 @@ namespace vks
 
 			assert(indexBufferSize > 0);
 
-			vertexBufferSize = (patchsize * patchsize * 4) * sizeof(Vertex);
-
-			// Generate Vulkan buffers
-
-			vks::Buffer vertexStaging, indexStaging;
+			// Use 16 bit indices if the patch's vertices can be addressed with them
+			indexType = vks::indexbuffer::getIndexType(patchsize * patchsize);
+			std::vector<uint8_t> packedIndices;
+			vks::indexbuffer::pack(indices, indexCount, indexType, packedIndices);
+			delete[] indices;
+			indexBufferSize = packedIndices.size();
 
-			// Create staging buffers
-			device->createBuffer(
-				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				&vertexStaging,
-				vertexBufferSize,
-				vertices);
+			vertexBufferSize = vertices.size() * sizeof(Vertex);
 
-			device->createBuffer(
-				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				&indexStaging,
-				indexBufferSize,
-				indices);
+			// Generate Vulkan buffers
 
 			// Device local (target) buffer
 			device->createBuffer(
@@ -222,33 +222,9 @@ namespace vks
 				&indexBuffer,
 				indexBufferSize);
 
-			// Copy from staging buffers
-			VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-			VkBufferCopy copyRegion = {};
-
-			copyRegion.size = vertexBufferSize;
-			vkCmdCopyBuffer(
-				copyCmd,
-				vertexStaging.buffer,
-				vertexBuffer.buffer,
-				1,
-				&copyRegion);
-
-			copyRegion.size = indexBufferSize;
-			vkCmdCopyBuffer(
-				copyCmd,
-				indexStaging.buffer,
-				indexBuffer.buffer,
-				1,
-				&copyRegion);
-
-			device->flushCommandBuffer(copyCmd, copyQueue, true);
-
-			vkDestroyBuffer(device->logicalDevice, vertexStaging.buffer, nullptr);
-			vkFreeMemory(device->logicalDevice, vertexStaging.memory, nullptr);
-			vkDestroyBuffer(device->logicalDevice, indexStaging.buffer, nullptr);
-			vkFreeMemory(device->logicalDevice, indexStaging.memory, nullptr);
+			// Stage vertex and index data through the upload queue (batched, submitted before the first frame)
+			device->uploadQueue.uploadBuffer(vertexBuffer.buffer, vertices.data(), vertexBufferSize);
+			device->uploadQueue.uploadBuffer(indexBuffer.buffer, packedIndices.data(), indexBufferSize);
 		}
 	};
 }
@@ -0,0 +1,140 @@
+/*
+* Index buffer helpers
+*
+* Selects 16 bit indices where the referenced vertices allow it and splits large meshes into ranges of at most 64K vertices
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string.h>
+#include <assert.h>
+
+#include "vulkan/vulkan.h"
+
+namespace vks
+{
+	namespace indexbuffer
+	{
+		/** @brief Maximum number of vertices that can be addressed with 16 bit indices */
+		const uint32_t maxShortVertexCount = 65536;
+
+		/** @brief Smallest index type that can address the given number of vertices */
+		inline VkIndexType getIndexType(uint32_t vertexCount)
+		{
+			return (vertexCount <= maxShortVertexCount) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+		}
+
+		/** @brief Size of a single index in bytes */
+		inline uint32_t getIndexSize(VkIndexType indexType)
+		{
+			return (indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t);
+		}
+
+		/**
+		* Convert 32 bit indices to the given index type
+		*
+		* @param indices 32 bit indices, all must be representable with the index type
+		* @param indexCount Number of indices
+		* @param indexType Target index type
+		* @param dst Receives the converted indices (indexCount * getIndexSize(indexType) bytes)
+		*/
+		inline void pack(const uint32_t *indices, size_t indexCount, VkIndexType indexType, std::vector<uint8_t> &dst)
+		{
+			dst.resize(indexCount * getIndexSize(indexType));
+			if (indexType == VK_INDEX_TYPE_UINT32)
+			{
+				memcpy(dst.data(), indices, dst.size());
+				return;
+			}
+			uint16_t *dstIndex = reinterpret_cast<uint16_t*>(dst.data());
+			for (size_t i = 0; i < indexCount; i++)
+			{
+				assert(indices[i] < maxShortVertexCount);
+				dstIndex[i] = static_cast<uint16_t>(indices[i]);
+			}
+		}
+
+		/** @brief Consecutive indices that only reference vertices inside of a 64K vertex window, drawn with the window's first vertex as the vertex offset */
+		struct Range
+		{
+			uint32_t vertexBase;
+			uint32_t vertexCount;
+			uint32_t indexBase;
+			uint32_t indexCount;
+		};
+
+		/**
+		* Split a triangle list into ranges that each reference at most maxShortVertexCount vertices
+		*
+		* @param vertices Vertex data
+		* @param stride Size of a vertex in bytes
+		* @param indices Triangle list indices into vertices
+		* @param indexCount Number of indices
+		* @param dstVertices Vertex data of all ranges is appended to this, vertices used by multiple ranges are duplicated
+		* @param dstIndices Indices relative to the first vertex of their range are appended to this
+		* @param ranges Receives the ranges, with vertex and index bases relative to the sizes of dstVertices and dstIndices on entry
+		*
+		* @note Triangles keep their order, so an index order optimized for the vertex cache is preserved within each range
+		*/
+		inline void split(const uint8_t *vertices, uint32_t stride, const uint32_t *indices, uint32_t indexCount, std::vector<uint8_t> &dstVertices, std::vector<uint32_t> &dstIndices, std::vector<Range> &ranges)
+		{
+			const uint32_t vertexBase = static_cast<uint32_t>(dstVertices.size() / stride);
+			const uint32_t indexBase = static_cast<uint32_t>(dstIndices.size());
+			// Maps source vertices to their index inside of the current range, entries from older ranges are detected by the range tag
+			std::vector<uint32_t> remap;
+			std::vector<uint32_t> remapRange;
+			Range range = { vertexBase, 0, indexBase, 0 };
+			uint32_t rangeTag = 1;
+
+			for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+			{
+				// Count the vertices of this triangle not yet in the current range
+				uint32_t newVertices = 0;
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					uint32_t index = indices[i + k];
+					if (index >= remap.size())
+					{
+						remap.resize(index + 1, 0);
+						remapRange.resize(index + 1, 0);
+					}
+					if (remapRange[index] != rangeTag)
+					{
+						newVertices++;
+					}
+				}
+				if (range.vertexCount + newVertices > maxShortVertexCount)
+				{
+					ranges.push_back(range);
+					range.vertexBase += range.vertexCount;
+					range.indexBase += range.indexCount;
+					range.vertexCount = 0;
+					range.indexCount = 0;
+					rangeTag++;
+				}
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					uint32_t index = indices[i + k];
+					if (remapRange[index] != rangeTag)
+					{
+						remapRange[index] = rangeTag;
+						remap[index] = range.vertexCount++;
+						const uint8_t *vertex = vertices + static_cast<size_t>(index) * stride;
+						dstVertices.insert(dstVertices.end(), vertex, vertex + stride);
+					}
+					dstIndices.push_back(remap[index]);
+				}
+				range.indexCount += 3;
+			}
+			if (range.indexCount > 0)
+			{
+				ranges.push_back(range);
+			}
+		}
+	}
+}
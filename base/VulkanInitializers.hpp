@@ -356,6 +356,22 @@ namespace vks
 			return writeDescriptorSet;
 		}
 
+		inline VkDescriptorUpdateTemplateEntryKHR descriptorUpdateTemplateEntry(
+			VkDescriptorType type,
+			uint32_t binding,
+			size_t offset,
+			uint32_t descriptorCount = 1,
+			size_t stride = 0)
+		{
+			VkDescriptorUpdateTemplateEntryKHR descriptorUpdateTemplateEntry {};
+			descriptorUpdateTemplateEntry.dstBinding = binding;
+			descriptorUpdateTemplateEntry.descriptorCount = descriptorCount;
+			descriptorUpdateTemplateEntry.descriptorType = type;
+			descriptorUpdateTemplateEntry.offset = offset;
+			descriptorUpdateTemplateEntry.stride = stride;
+			return descriptorUpdateTemplateEntry;
+		}
+
 		inline VkVertexInputBindingDescription vertexInputBindingDescription(
 			uint32_t binding,
 			uint32_t stride,
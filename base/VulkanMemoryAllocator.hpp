@@ -0,0 +1,479 @@
+/*
+* Vulkan device memory allocator
+*
+* Sub-allocates buffers and images from large device memory blocks
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <iostream>
+#include <iomanip>
+#include <assert.h>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+
+namespace vks
+{
+	class MemoryAllocator;
+	struct MemoryBlock;
+
+	/**
+	* @brief Range of device memory handed out by the memory allocator
+	* @note Several allocations may share the same VkDeviceMemory, so resources must always be bound (and mapped) using the offset
+	*/
+	struct Allocation
+	{
+		/** @brief Memory object the allocation lives in */
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		/** @brief Byte offset of the allocation inside the memory object */
+		VkDeviceSize offset = 0;
+		/** @brief Size of the allocation in bytes */
+		VkDeviceSize size = 0;
+		/** @brief Memory type index of the memory object */
+		uint32_t memoryTypeIndex = 0;
+		/** @brief Host address of the allocation for host visible memory (blocks stay mapped for their whole lifetime), nullptr otherwise */
+		void* mapped = nullptr;
+		/** @brief Allocator and block the allocation has been taken from */
+		MemoryAllocator* allocator = nullptr;
+		MemoryBlock* block = nullptr;
+
+		/** @brief Returns true if the allocation is backed by device memory */
+		bool valid() const { return memory != VK_NULL_HANDLE; }
+
+		/** @brief Return the allocation to the allocator it was taken from */
+		void free();
+
+		/**
+		* Flush a range of the allocation to make host writes visible to the device
+		*
+		* @param size (Optional) Size of the range to flush. Pass VK_WHOLE_SIZE to flush the complete allocation.
+		* @param offset (Optional) Byte offset from the beginning of the allocation
+		*
+		* @note Only required for non-coherent memory, the range is expanded to the device's nonCoherentAtomSize
+		*/
+		VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+		/**
+		* Invalidate a range of the allocation to make device writes visible to the host
+		*
+		* @param size (Optional) Size of the range to invalidate. Pass VK_WHOLE_SIZE to invalidate the complete allocation.
+		* @param offset (Optional) Byte offset from the beginning of the allocation
+		*
+		* @note Only required for non-coherent memory, the range is expanded to the device's nonCoherentAtomSize
+		*/
+		VkResult invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+	};
+
+	/** @brief Single VkDeviceMemory object with a list of free ranges */
+	struct MemoryBlock
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		uint32_t memoryTypeIndex = 0;
+		/** @brief Block only holds linear resources (buffers, linear images) or only optimal tiled images */
+		bool linear = true;
+		/** @brief Block has been allocated for a single large resource */
+		bool dedicated = false;
+		void* mapped = nullptr;
+		uint32_t allocationCount = 0;
+		VkDeviceSize usedSize = 0;
+		/** @brief Free ranges sorted by offset (offset -> size) */
+		std::map<VkDeviceSize, VkDeviceSize> freeRanges;
+
+		/**
+		* Find a free range that fits the requested size and alignment (first fit)
+		*
+		* @return True if a range has been found, offset contains the aligned start of the range
+		*/
+		bool allocate(VkDeviceSize allocSize, VkDeviceSize alignment, VkDeviceSize *offset)
+		{
+			for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+			{
+				VkDeviceSize rangeStart = it->first;
+				VkDeviceSize rangeSize = it->second;
+				VkDeviceSize alignedStart = (rangeStart + alignment - 1) / alignment * alignment;
+				if (alignedStart + allocSize > rangeStart + rangeSize)
+				{
+					continue;
+				}
+				freeRanges.erase(it);
+				// Keep the padding in front of the aligned start and the remainder as separate free ranges
+				if (alignedStart > rangeStart)
+				{
+					freeRanges[rangeStart] = alignedStart - rangeStart;
+				}
+				VkDeviceSize end = alignedStart + allocSize;
+				if (end < rangeStart + rangeSize)
+				{
+					freeRanges[end] = rangeStart + rangeSize - end;
+				}
+				allocationCount++;
+				usedSize += allocSize;
+				*offset = alignedStart;
+				return true;
+			}
+			return false;
+		}
+
+		/** @brief Return a range to the free list and merge it with adjacent free ranges */
+		void free(VkDeviceSize offset, VkDeviceSize allocSize)
+		{
+			assert(allocationCount > 0);
+			allocationCount--;
+			usedSize -= allocSize;
+			auto it = freeRanges.insert(std::make_pair(offset, allocSize)).first;
+			// Merge with the following range
+			auto next = std::next(it);
+			if ((next != freeRanges.end()) && (it->first + it->second == next->first))
+			{
+				it->second += next->second;
+				freeRanges.erase(next);
+			}
+			// Merge with the preceding range
+			if (it != freeRanges.begin())
+			{
+				auto prev = std::prev(it);
+				if (prev->first + prev->second == it->first)
+				{
+					prev->second += it->second;
+					freeRanges.erase(it);
+				}
+			}
+		}
+	};
+
+	/**
+	* @brief Block based device memory sub-allocator
+	*
+	* Keeps a list of memory blocks per memory type. Requests are served from the free ranges of existing blocks,
+	* new blocks are only allocated if no block has enough space left. Buffers and linear images are placed in different
+	* blocks than optimal tiled images if the device's bufferImageGranularity requires it, so neighbouring resources
+	* never alias on the same granularity page.
+	* Allocations that are larger than half the block size get a dedicated memory object.
+	*/
+	class MemoryAllocator
+	{
+	public:
+		/** @brief Allocation statistics for a memory type (or all memory types) */
+		struct Stats
+		{
+			uint32_t blockCount = 0;
+			uint32_t allocationCount = 0;
+			/** @brief Bytes of device memory allocated by blocks */
+			VkDeviceSize blockBytes = 0;
+			/** @brief Bytes handed out to resources */
+			VkDeviceSize usedBytes = 0;
+		};
+
+	private:
+		VkDevice device = VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		VkDeviceSize bufferImageGranularity = 1;
+		VkDeviceSize nonCoherentAtomSize = 1;
+		uint32_t maxAllocationCount = 4096;
+		std::vector<MemoryBlock*> blocks;
+		std::mutex mutex;
+
+		VkDeviceSize getBlockSize(uint32_t memoryTypeIndex)
+		{
+			// Use smaller blocks on small heaps (e.g. host visible device local memory on some discrete GPUs)
+			VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+			return std::min(preferredBlockSize, heapSize / 8);
+		}
+
+		bool isHostVisible(uint32_t memoryTypeIndex)
+		{
+			return (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+		}
+
+		bool isHostCoherent(uint32_t memoryTypeIndex)
+		{
+			return (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+		}
+
+		MemoryBlock* createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool linear, bool dedicated)
+		{
+			if (blocks.size() >= maxAllocationCount)
+			{
+				std::cerr << "Memory allocator: maxMemoryAllocationCount (" << maxAllocationCount << ") reached" << std::endl;
+				return nullptr;
+			}
+			VkMemoryAllocateInfo memAlloc = {};
+			memAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			memAlloc.allocationSize = size;
+			memAlloc.memoryTypeIndex = memoryTypeIndex;
+			VkDeviceMemory memory;
+			if (vkAllocateMemory(device, &memAlloc, nullptr, &memory) != VK_SUCCESS)
+			{
+				return nullptr;
+			}
+			MemoryBlock* block = new MemoryBlock();
+			block->memory = memory;
+			block->size = size;
+			block->memoryTypeIndex = memoryTypeIndex;
+			block->linear = linear;
+			block->dedicated = dedicated;
+			block->freeRanges[0] = size;
+			// Host visible blocks are mapped once for their whole lifetime, as a memory object can't be mapped more than once at a time
+			if (isHostVisible(memoryTypeIndex))
+			{
+				VK_CHECK_RESULT(vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &block->mapped));
+			}
+			blocks.push_back(block);
+			return block;
+		}
+
+		void destroyBlock(MemoryBlock* block)
+		{
+			if (block->mapped)
+			{
+				vkUnmapMemory(device, block->memory);
+			}
+			vkFreeMemory(device, block->memory, nullptr);
+			blocks.erase(std::find(blocks.begin(), blocks.end(), block));
+			delete block;
+		}
+
+		VkMappedMemoryRange getMappedRange(const Allocation &allocation, VkDeviceSize size, VkDeviceSize offset)
+		{
+			VkDeviceSize start = allocation.offset + offset;
+			VkDeviceSize end = (size == VK_WHOLE_SIZE) ? allocation.offset + allocation.size : start + size;
+			// Expand to nonCoherentAtomSize, allocations in non-coherent memory are aligned to it so this never leaves the allocation
+			start = start / nonCoherentAtomSize * nonCoherentAtomSize;
+			end = std::min((end + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize, allocation.block->size);
+			VkMappedMemoryRange mappedRange = {};
+			mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+			mappedRange.memory = allocation.memory;
+			mappedRange.offset = start;
+			mappedRange.size = end - start;
+			return mappedRange;
+		}
+
+	public:
+		/** @brief Size of the memory blocks allocated from large heaps */
+		VkDeviceSize preferredBlockSize = 64 * 1024 * 1024;
+
+		/**
+		* Set up the allocator for a logical device
+		*
+		* @param device Logical device to allocate memory from
+		* @param physicalDevice Physical device the logical device has been created from (memory properties and limits)
+		*/
+		void create(VkDevice device, VkPhysicalDevice physicalDevice)
+		{
+			this->device = device;
+			vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+			bufferImageGranularity = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1);
+			nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+			maxAllocationCount = properties.limits.maxMemoryAllocationCount;
+		}
+
+		/** @brief Free all memory blocks, all allocations must have been freed (or their resources destroyed) before */
+		void destroy()
+		{
+			while (!blocks.empty())
+			{
+				destroyBlock(blocks.back());
+			}
+		}
+
+		/**
+		* Allocate memory for a resource
+		*
+		* @param memReqs Memory requirements of the resource (size, alignment and supported memory types)
+		* @param memoryTypeIndex Memory type to allocate from (must be set in memReqs.memoryTypeBits)
+		* @param linear True for buffers and linear tiled images, false for optimal tiled images
+		* @param allocation Pointer to the allocation that is filled by this function
+		*
+		* @return VK_SUCCESS if the allocation succeeded, VK_ERROR_OUT_OF_DEVICE_MEMORY otherwise
+		*/
+		VkResult allocate(VkMemoryRequirements memReqs, uint32_t memoryTypeIndex, bool linear, Allocation *allocation)
+		{
+			assert(memReqs.memoryTypeBits & (1 << memoryTypeIndex));
+			std::lock_guard<std::mutex> lock(mutex);
+
+			VkDeviceSize alignment = std::max<VkDeviceSize>(memReqs.alignment, 1);
+			VkDeviceSize size = memReqs.size;
+			if (isHostVisible(memoryTypeIndex) && !isHostCoherent(memoryTypeIndex))
+			{
+				// Keep flush and invalidate ranges of neighbouring allocations apart
+				alignment = std::max(alignment, nonCoherentAtomSize);
+				size = (size + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
+			}
+			// Only separate linear and optimal resources if the device requires it
+			bool separateLinear = (bufferImageGranularity > 1) ? linear : true;
+
+			MemoryBlock* block = nullptr;
+			VkDeviceSize offset = 0;
+			VkDeviceSize blockSize = getBlockSize(memoryTypeIndex);
+			if (size > blockSize / 2)
+			{
+				// Large resources get their own memory object
+				block = createBlock(memoryTypeIndex, size, separateLinear, true);
+				if (block)
+				{
+					block->allocate(size, alignment, &offset);
+				}
+			}
+			else
+			{
+				for (auto b : blocks)
+				{
+					if ((b->memoryTypeIndex == memoryTypeIndex) && (b->linear == separateLinear) && !b->dedicated && b->allocate(size, alignment, &offset))
+					{
+						block = b;
+						break;
+					}
+				}
+				if (!block)
+				{
+					block = createBlock(memoryTypeIndex, blockSize, separateLinear, false);
+					if (block)
+					{
+						block->allocate(size, alignment, &offset);
+					}
+				}
+			}
+			if (!block)
+			{
+				return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+			}
+
+			allocation->memory = block->memory;
+			allocation->offset = offset;
+			allocation->size = size;
+			allocation->memoryTypeIndex = memoryTypeIndex;
+			allocation->mapped = block->mapped ? static_cast<uint8_t*>(block->mapped) + offset : nullptr;
+			allocation->allocator = this;
+			allocation->block = block;
+			return VK_SUCCESS;
+		}
+
+		/**
+		* Return an allocation to its block, empty blocks are released
+		*
+		* @param allocation Allocation to free, reset to an empty allocation afterwards
+		*/
+		void free(Allocation &allocation)
+		{
+			if (!allocation.valid())
+			{
+				return;
+			}
+			assert(allocation.allocator == this);
+			std::lock_guard<std::mutex> lock(mutex);
+			MemoryBlock* block = allocation.block;
+			block->free(allocation.offset, allocation.size);
+			if (block->allocationCount == 0)
+			{
+				// Keep one empty block per memory type around to avoid allocation ping-pong
+				bool keep = !block->dedicated;
+				if (keep)
+				{
+					for (auto b : blocks)
+					{
+						if ((b != block) && (b->memoryTypeIndex == block->memoryTypeIndex) && (b->linear == block->linear) && !b->dedicated && (b->allocationCount == 0))
+						{
+							keep = false;
+							break;
+						}
+					}
+				}
+				if (!keep)
+				{
+					destroyBlock(block);
+				}
+			}
+			allocation = Allocation();
+		}
+
+		/** @brief Flush a (sub) range of a host visible allocation */
+		VkResult flush(const Allocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0)
+		{
+			VkMappedMemoryRange mappedRange = getMappedRange(allocation, size, offset);
+			return vkFlushMappedMemoryRanges(device, 1, &mappedRange);
+		}
+
+		/** @brief Invalidate a (sub) range of a host visible allocation */
+		VkResult invalidate(const Allocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0)
+		{
+			VkMappedMemoryRange mappedRange = getMappedRange(allocation, size, offset);
+			return vkInvalidateMappedMemoryRanges(device, 1, &mappedRange);
+		}
+
+		/**
+		* Get allocation statistics
+		*
+		* @param memoryTypeIndex Memory type to get statistics for, UINT32_MAX for the sum of all memory types
+		*/
+		Stats getStats(uint32_t memoryTypeIndex = UINT32_MAX)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			Stats stats;
+			for (auto block : blocks)
+			{
+				if ((memoryTypeIndex != UINT32_MAX) && (block->memoryTypeIndex != memoryTypeIndex))
+				{
+					continue;
+				}
+				stats.blockCount++;
+				stats.allocationCount += block->allocationCount;
+				stats.blockBytes += block->size;
+				stats.usedBytes += block->usedSize;
+			}
+			return stats;
+		}
+
+		/** @brief Print allocation statistics for all memory types in use */
+		void printStats()
+		{
+			std::cout << "Device memory allocator statistics:" << std::endl;
+			for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+			{
+				Stats stats = getStats(i);
+				if (stats.blockCount == 0)
+				{
+					continue;
+				}
+				std::cout << "\tMemory type " << i << " (heap " << memoryProperties.memoryTypes[i].heapIndex << "): "
+					<< stats.allocationCount << " allocations in " << stats.blockCount << " blocks, "
+					<< std::fixed << std::setprecision(2) << (double)stats.usedBytes / (1024.0 * 1024.0) << " of "
+					<< (double)stats.blockBytes / (1024.0 * 1024.0) << " MB used" << std::endl;
+			}
+			Stats total = getStats();
+			std::cout << "\tTotal: " << total.allocationCount << " allocations in " << total.blockCount << " device memory objects" << std::endl;
+		}
+	};
+
+	inline void Allocation::free()
+	{
+		if (allocator)
+		{
+			allocator->free(*this);
+		}
+	}
+
+	inline VkResult Allocation::flush(VkDeviceSize size, VkDeviceSize offset)
+	{
+		assert(allocator);
+		return allocator->flush(*this, size, offset);
+	}
+
+	inline VkResult Allocation::invalidate(VkDeviceSize size, VkDeviceSize offset)
+	{
+		assert(allocator);
+		return allocator->invalidate(*this, size, offset);
+	}
+}
@@ -0,0 +1,355 @@
+/*
+* Binary mesh cache
+*
+* Stores the vertex and index data generated from a model file so later runs can map it into memory instead of importing the model again
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <string.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "VulkanTools.h"
+
+namespace vks
+{
+	namespace meshcache
+	{
+		/**
+		* @brief Header at the start of a mesh cache file
+		* @note The header is followed by the parts table (partCount entries of four uint32_t: vertexBase, vertexCount, indexBase, indexCount), the index ranges table (rangeCount entries of four uint32_t: part, indexBase, indexCount, vertexOffset), the position dequantization table (partCount entries of eight floats: scale, offset), the part bounds table (partCount entries of twelve floats: box minimum, box maximum, sphere), the clusters table (clusterCount entries of vks::meshlets::Cluster), the levels of detail table (lodCount entries of vks::Model::LodLevel) and the vertex and index data, each starting at the offset stored in the header
+		*/
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			// Hash of everything that changes the generated data (vertex layout, load time scale and center, import flags)
+			uint64_t key;
+			// Size and modification time of the source file, the cache is rebuilt if the source file changes
+			uint64_t sourceSize;
+			int64_t sourceTime;
+			uint32_t partCount;
+			uint32_t vertexCount;
+			// Number of indices in the index data, including the indices of all levels of detail
+			uint32_t indexCount;
+			uint32_t vertexStride;
+			// VkIndexType of the index data
+			uint32_t indexType;
+			uint32_t rangeCount;
+			uint32_t clusterCount;
+			uint32_t clusterSize;
+			uint32_t lodCount;
+			uint32_t lodSize;
+			float dimMin[3];
+			float dimMax[3];
+			uint64_t partsOffset;
+			uint64_t rangesOffset;
+			uint64_t dequantizationOffset;
+			uint64_t boundsOffset;
+			uint64_t clustersOffset;
+			uint64_t lodsOffset;
+			uint64_t vertexOffset;
+			uint64_t vertexSize;
+			uint64_t indexOffset;
+			uint64_t indexSize;
+		};
+
+		const uint32_t fileMagic = 0x434d4b56; // "VKMC"
+		const uint32_t fileVersion = 7;
+		// Data blobs start at multiples of this, so they can be copied efficiently straight from the mapped file
+		const uint64_t dataAlignment = 16;
+
+		/** @brief 64 bit FNV-1a hash, used to build cache keys */
+		inline uint64_t hash(const void *data, size_t size, uint64_t hash = 14695981039346656037ULL)
+		{
+			const uint8_t *bytes = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ULL;
+			}
+			return hash;
+		}
+
+		/**
+		* Get size and modification time of a source file
+		*
+		* @return False if the file doesn't exist
+		*/
+		inline bool getFileInfo(const std::string &filename, uint64_t &size, int64_t &time)
+		{
+			struct stat info;
+			if (stat(filename.c_str(), &info) != 0)
+			{
+				return false;
+			}
+			size = static_cast<uint64_t>(info.st_size);
+			time = static_cast<int64_t>(info.st_mtime);
+			return true;
+		}
+
+		/**
+		* Get the name of the cache file for a source file
+		*
+		* @param filename Source model file
+		* @param key Cache key, each key gets its own cache file so models loaded with different layouts don't replace each other's cache
+		* @param (Optional) extension Extension of the cache file
+		*
+		* @note The cache is stored next to the source file, on Android it's stored in the app's internal data path as the assets are read-only
+		*/
+		inline std::string getCacheFilename(const std::string &filename, uint64_t key, const std::string &extension = "meshcache")
+		{
+			std::stringstream ss;
+#if defined(__ANDROID__)
+			size_t separator = filename.find_last_of("/\\");
+			ss << androidApp->activity->internalDataPath << "/" << ((separator != std::string::npos) ? filename.substr(separator + 1) : filename);
+#else
+			ss << filename;
+#endif
+			ss << "." << std::hex << std::setw(16) << std::setfill('0') << key << "." << extension;
+			return ss.str();
+		}
+
+		/** @brief Read-only memory mapping of a whole file */
+		class MappedFile
+		{
+		private:
+#if defined(_WIN32)
+			HANDLE file = INVALID_HANDLE_VALUE;
+			HANDLE mapping = NULL;
+#endif
+		public:
+			const uint8_t *data = nullptr;
+			size_t size = 0;
+
+			/** @brief Map the file into memory, returns false if the file doesn't exist or can't be mapped */
+			bool open(const std::string &filename)
+			{
+				close();
+#if defined(_WIN32)
+				file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+				if (file == INVALID_HANDLE_VALUE)
+				{
+					return false;
+				}
+				LARGE_INTEGER fileSize;
+				if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart == 0))
+				{
+					close();
+					return false;
+				}
+				mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+				if (!mapping)
+				{
+					close();
+					return false;
+				}
+				data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				if (!data)
+				{
+					close();
+					return false;
+				}
+				size = static_cast<size_t>(fileSize.QuadPart);
+#else
+				int fd = ::open(filename.c_str(), O_RDONLY);
+				if (fd < 0)
+				{
+					return false;
+				}
+				struct stat info;
+				if ((fstat(fd, &info) != 0) || (info.st_size == 0))
+				{
+					::close(fd);
+					return false;
+				}
+				void *mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				// The mapping stays valid after closing the descriptor
+				::close(fd);
+				if (mapped == MAP_FAILED)
+				{
+					return false;
+				}
+				data = static_cast<const uint8_t*>(mapped);
+				size = static_cast<size_t>(info.st_size);
+				// Start reading the whole file ahead, all of it is copied to the staging buffer right away
+				madvise(mapped, size, MADV_WILLNEED);
+#endif
+				return true;
+			}
+
+			void close()
+			{
+#if defined(_WIN32)
+				if (data)
+				{
+					UnmapViewOfFile(data);
+				}
+				if (mapping)
+				{
+					CloseHandle(mapping);
+					mapping = NULL;
+				}
+				if (file != INVALID_HANDLE_VALUE)
+				{
+					CloseHandle(file);
+					file = INVALID_HANDLE_VALUE;
+				}
+#else
+				if (data)
+				{
+					munmap(const_cast<uint8_t*>(data), size);
+				}
+#endif
+				data = nullptr;
+				size = 0;
+			}
+
+			~MappedFile()
+			{
+				close();
+			}
+		};
+
+		/**
+		* Validate a mapped cache file
+		*
+		* @param file Mapped cache file
+		* @param key Expected cache key
+		* @param sourceSize Size of the source file
+		* @param sourceTime Modification time of the source file
+		*
+		* @return Pointer to the header inside of the mapping, nullptr if the cache doesn't match or is damaged
+		*/
+		inline const FileHeader* validate(const MappedFile &file, uint64_t key, uint64_t sourceSize, int64_t sourceTime)
+		{
+			if (!file.data || (file.size < sizeof(FileHeader)))
+			{
+				return nullptr;
+			}
+			const FileHeader *header = reinterpret_cast<const FileHeader*>(file.data);
+			if ((header->magic != fileMagic) || (header->version != fileVersion) || (header->key != key))
+			{
+				return nullptr;
+			}
+			if ((header->sourceSize != sourceSize) || (header->sourceTime != sourceTime))
+			{
+				return nullptr;
+			}
+			// All blobs must be inside of the file, this also catches truncated files
+			uint64_t partsSize = static_cast<uint64_t>(header->partCount) * 4 * sizeof(uint32_t);
+			uint64_t rangesSize = static_cast<uint64_t>(header->rangeCount) * 4 * sizeof(uint32_t);
+			uint64_t indexSize = (header->indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t);
+			if ((header->partsOffset + partsSize > file.size) ||
+				(header->rangesOffset + rangesSize > file.size) ||
+				(header->dequantizationOffset + static_cast<uint64_t>(header->partCount) * 8 * sizeof(float) > file.size) ||
+				(header->boundsOffset + static_cast<uint64_t>(header->partCount) * 12 * sizeof(float) > file.size) ||
+				(header->clustersOffset + static_cast<uint64_t>(header->clusterCount) * header->clusterSize > file.size) ||
+				(header->lodsOffset + static_cast<uint64_t>(header->lodCount) * header->lodSize > file.size) ||
+				(header->vertexOffset + header->vertexSize > file.size) ||
+				(header->indexOffset + header->indexSize > file.size) ||
+				(header->vertexSize != static_cast<uint64_t>(header->vertexCount) * header->vertexStride) ||
+				(header->indexSize != static_cast<uint64_t>(header->indexCount) * indexSize))
+			{
+				return nullptr;
+			}
+			return header;
+		}
+
+		/**
+		* Write a cache file
+		*
+		* @param filename Cache file to write
+		* @param header Header with all fields except the offsets and sizes filled in
+		* @param parts Parts table (four uint32_t per part)
+		* @param ranges Index ranges table (four uint32_t per range)
+		* @param dequantization Position dequantization table (eight floats per part)
+		* @param bounds Part bounds table (twelve floats per part)
+		* @param clusters Clusters table (header.clusterSize bytes per cluster)
+		* @param lods Levels of detail table (header.lodSize bytes per level)
+		* @param vertexData Vertex data (header.vertexCount * header.vertexStride bytes)
+		* @param indexData Index data (header.indexCount indices of header.indexType)
+		*
+		* @note The data is written to a temporary file first that then replaces the target file, so an interrupted write never leaves a partial cache file behind
+		*
+		* @return True if the file has been written
+		*/
+		inline bool save(const std::string &filename, FileHeader header, const void *parts, const void *ranges, const void *dequantization, const void *bounds, const void *clusters, const void *lods, const void *vertexData, const void *indexData)
+		{
+			auto align = [](uint64_t offset) { return (offset + dataAlignment - 1) & ~(dataAlignment - 1); };
+			header.magic = fileMagic;
+			header.version = fileVersion;
+			header.partsOffset = align(sizeof(FileHeader));
+			header.rangesOffset = align(header.partsOffset + static_cast<uint64_t>(header.partCount) * 4 * sizeof(uint32_t));
+			header.vertexSize = static_cast<uint64_t>(header.vertexCount) * header.vertexStride;
+			header.dequantizationOffset = align(header.rangesOffset + static_cast<uint64_t>(header.rangeCount) * 4 * sizeof(uint32_t));
+			header.boundsOffset = align(header.dequantizationOffset + static_cast<uint64_t>(header.partCount) * 8 * sizeof(float));
+			header.clustersOffset = align(header.boundsOffset + static_cast<uint64_t>(header.partCount) * 12 * sizeof(float));
+			header.lodsOffset = align(header.clustersOffset + static_cast<uint64_t>(header.clusterCount) * header.clusterSize);
+			header.vertexOffset = align(header.lodsOffset + static_cast<uint64_t>(header.lodCount) * header.lodSize);
+			header.indexSize = static_cast<uint64_t>(header.indexCount) * ((header.indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t));
+			header.indexOffset = align(header.vertexOffset + header.vertexSize);
+
+			// Loader threads and processes saving the same mesh concurrently must not share a temporary file
+			std::string tempFilename = vks::tools::getTemporaryFilename(filename);
+			{
+				std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+				if (!file.is_open())
+				{
+					return false;
+				}
+				const char padding[dataAlignment] = {};
+				auto writeAt = [&](uint64_t offset, const void *data, uint64_t size)
+				{
+					uint64_t position = static_cast<uint64_t>(file.tellp());
+					file.write(padding, static_cast<std::streamsize>(offset - position));
+					file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+				};
+				file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+				writeAt(header.partsOffset, parts, static_cast<uint64_t>(header.partCount) * 4 * sizeof(uint32_t));
+				writeAt(header.rangesOffset, ranges, static_cast<uint64_t>(header.rangeCount) * 4 * sizeof(uint32_t));
+				writeAt(header.dequantizationOffset, dequantization, static_cast<uint64_t>(header.partCount) * 8 * sizeof(float));
+				writeAt(header.boundsOffset, bounds, static_cast<uint64_t>(header.partCount) * 12 * sizeof(float));
+				writeAt(header.clustersOffset, clusters, static_cast<uint64_t>(header.clusterCount) * header.clusterSize);
+				writeAt(header.lodsOffset, lods, static_cast<uint64_t>(header.lodCount) * header.lodSize);
+				writeAt(header.vertexOffset, vertexData, header.vertexSize);
+				writeAt(header.indexOffset, indexData, header.indexSize);
+				file.flush();
+				if (!file.good())
+				{
+					file.close();
+					std::remove(tempFilename.c_str());
+					return false;
+				}
+			}
+#if defined(_WIN32)
+			bool replaced = MoveFileExA(tempFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+			bool replaced = std::rename(tempFilename.c_str(), filename.c_str()) == 0;
+#endif
+			if (!replaced)
+			{
+				std::remove(tempFilename.c_str());
+			}
+			return replaced;
+		}
+	}
+}
@@ -0,0 +1,404 @@
+/*
+* Mesh optimization
+*
+* Vertex welding, vertex cache and overdraw optimization (Tipsify) and vertex fetch optimization for indexed triangle lists
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <assert.h>
+
+#include <glm/glm.hpp>
+
+namespace vks
+{
+	namespace meshoptimizer
+	{
+		/** @brief Size of the FIFO post transform cache used for optimization and statistics */
+		const uint32_t cacheSize = 16;
+
+		/** @brief Vertex cache statistics of an index list */
+		struct CacheStatistics
+		{
+			/** @brief Average cache miss ratio, transformed vertices per triangle (0.5 is optimal for large meshes, 3.0 is the worst case) */
+			float acmr = 0.0f;
+			/** @brief Average transform to vertex ratio, transformed vertices per vertex (1.0 is optimal) */
+			float atvr = 0.0f;
+		};
+
+		/**
+		* Simulate a FIFO post transform cache
+		*
+		* @param indices Triangle list indices
+		* @param vertexCount Number of vertices referenced by the indices
+		*/
+		inline CacheStatistics analyzeVertexCache(const std::vector<uint32_t> &indices, uint32_t vertexCount)
+		{
+			CacheStatistics stats;
+			if (indices.empty() || (vertexCount == 0))
+			{
+				return stats;
+			}
+			// A vertex is in the cache if it has been transformed within the last cacheSize misses
+			std::vector<uint32_t> cacheTime(vertexCount, 0);
+			uint32_t misses = 0;
+			for (auto index : indices)
+			{
+				if ((cacheTime[index] == 0) || (misses + 1 - cacheTime[index] > cacheSize))
+				{
+					misses++;
+					cacheTime[index] = misses;
+				}
+			}
+			stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+			stats.atvr = static_cast<float>(misses) / static_cast<float>(vertexCount);
+			return stats;
+		}
+
+		/**
+		* Merge vertices with identical data
+		*
+		* @param vertices Vertex data, replaced with the unique vertices
+		* @param stride Size of a vertex in bytes
+		* @param indices Triangle list indices, remapped to the unique vertices
+		*
+		* @return Number of unique vertices
+		*/
+		inline uint32_t weldVertices(std::vector<uint8_t> &vertices, uint32_t stride, std::vector<uint32_t> &indices)
+		{
+			const uint32_t vertexCount = static_cast<uint32_t>(vertices.size() / stride);
+			// Open addressing hash table with a power of two size of at least twice the vertex count
+			uint32_t tableSize = 1;
+			while (tableSize < vertexCount * 2)
+			{
+				tableSize <<= 1;
+			}
+			const uint32_t empty = ~0u;
+			std::vector<uint32_t> table(tableSize, empty);
+			std::vector<uint32_t> remap(vertexCount);
+			std::vector<uint8_t> unique;
+			unique.reserve(vertices.size());
+			uint32_t uniqueCount = 0;
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				const uint8_t *vertex = vertices.data() + static_cast<size_t>(v) * stride;
+				uint32_t hash = 2166136261u;
+				for (uint32_t b = 0; b < stride; b++)
+				{
+					hash = (hash ^ vertex[b]) * 16777619u;
+				}
+				uint32_t slot = hash & (tableSize - 1);
+				while ((table[slot] != empty) && (memcmp(unique.data() + static_cast<size_t>(table[slot]) * stride, vertex, stride) != 0))
+				{
+					slot = (slot + 1) & (tableSize - 1);
+				}
+				if (table[slot] == empty)
+				{
+					table[slot] = uniqueCount++;
+					unique.insert(unique.end(), vertex, vertex + stride);
+				}
+				remap[v] = table[slot];
+			}
+			for (auto &index : indices)
+			{
+				index = remap[index];
+			}
+			vertices.swap(unique);
+			return uniqueCount;
+		}
+
+		/**
+		* Reorder triangles for the post transform vertex cache (Tipsify)
+		*
+		* @param indices Triangle list indices, reordered in place
+		* @param vertexCount Number of vertices referenced by the indices
+		* @param clusters (Optional) Receives the first index of each cluster, clusters start where the algorithm had to jump to a new part of the mesh
+		*
+		* @note Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", SIGGRAPH 2007
+		*/
+		inline void optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount, std::vector<uint32_t> *clusters = nullptr)
+		{
+			const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+			if (clusters)
+			{
+				clusters->clear();
+			}
+			if (triangleCount == 0)
+			{
+				return;
+			}
+
+			// Vertex to triangle adjacency
+			std::vector<uint32_t> liveTriangles(vertexCount, 0);
+			for (auto index : indices)
+			{
+				liveTriangles[index]++;
+			}
+			std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+			}
+			std::vector<uint32_t> adjacency(indices.size());
+			{
+				std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (uint32_t t = 0; t < triangleCount; t++)
+				{
+					for (uint32_t k = 0; k < 3; k++)
+					{
+						adjacency[fill[indices[t * 3 + k]]++] = t;
+					}
+				}
+			}
+
+			std::vector<uint32_t> cacheTime(vertexCount, 0);
+			std::vector<bool> emitted(triangleCount, false);
+			std::vector<uint32_t> deadEnd;
+			std::vector<uint32_t> candidates;
+			std::vector<uint32_t> output;
+			output.reserve(indices.size());
+			uint32_t timeStamp = cacheSize + 1;
+			uint32_t cursor = 0;
+			int32_t fanning = 0;
+			bool newCluster = true;
+
+			while (fanning >= 0)
+			{
+				if (newCluster && clusters)
+				{
+					clusters->push_back(static_cast<uint32_t>(output.size()));
+				}
+				newCluster = false;
+				candidates.clear();
+				// Emit all remaining triangles around the fanning vertex
+				for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++)
+				{
+					uint32_t t = adjacency[a];
+					if (emitted[t])
+					{
+						continue;
+					}
+					for (uint32_t k = 0; k < 3; k++)
+					{
+						uint32_t v = indices[t * 3 + k];
+						output.push_back(v);
+						deadEnd.push_back(v);
+						candidates.push_back(v);
+						liveTriangles[v]--;
+						if (timeStamp - cacheTime[v] > cacheSize)
+						{
+							cacheTime[v] = timeStamp++;
+						}
+					}
+					emitted[t] = true;
+				}
+
+				// Next fanning vertex is the candidate that is still in the cache and has the most remaining triangles
+				int32_t best = -1;
+				int32_t bestPriority = -1;
+				for (auto v : candidates)
+				{
+					if (liveTriangles[v] == 0)
+					{
+						continue;
+					}
+					int32_t priority = 0;
+					if (timeStamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+					{
+						priority = timeStamp - cacheTime[v];
+					}
+					if (priority > bestPriority)
+					{
+						bestPriority = priority;
+						best = v;
+					}
+				}
+				if (best == -1)
+				{
+					// Dead end, continue with a recently used vertex or the next vertex in input order
+					while (!deadEnd.empty())
+					{
+						uint32_t v = deadEnd.back();
+						deadEnd.pop_back();
+						if (liveTriangles[v] > 0)
+						{
+							best = v;
+							break;
+						}
+					}
+					while ((best == -1) && (cursor < vertexCount))
+					{
+						if (liveTriangles[cursor] > 0)
+						{
+							best = cursor;
+							// Jumping to an unrelated part of the mesh starts a new cluster
+							newCluster = true;
+						}
+						cursor++;
+					}
+				}
+				fanning = best;
+			}
+			indices.swap(output);
+		}
+
+		/**
+		* Reorder the clusters of a vertex cache optimized index list to reduce overdraw
+		*
+		* @param indices Triangle list indices, as output by optimizeVertexCache
+		* @param hardClusters First index of each cluster, as output by optimizeVertexCache
+		* @param positions Pointer to the position (3 floats) of the first vertex
+		* @param stride Distance in bytes between the positions of two vertices
+		*
+		* @note Clusters are additionally split where a triangle misses the cache with all of its vertices, moving those clusters around doesn't add cache misses
+		* Clusters that face away from the center of the mesh are likely to occlude the other clusters, so they are drawn first (see Tipsify paper, section 4)
+		*/
+		inline void optimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<uint32_t> &hardClusters, const uint8_t *positions, uint32_t stride)
+		{
+			std::vector<uint32_t> clusters;
+			{
+				uint32_t vertexCount = 0;
+				for (auto index : indices)
+				{
+					vertexCount = std::max(vertexCount, index + 1);
+				}
+				std::vector<uint32_t> cacheTime(vertexCount, 0);
+				uint32_t misses = 0;
+				size_t nextHard = 0;
+				for (uint32_t i = 0; i < static_cast<uint32_t>(indices.size()); i += 3)
+				{
+					uint32_t triangleMisses = 0;
+					for (uint32_t k = 0; k < 3; k++)
+					{
+						uint32_t index = indices[i + k];
+						if ((cacheTime[index] == 0) || (misses + 1 - cacheTime[index] > cacheSize))
+						{
+							misses++;
+							cacheTime[index] = misses;
+							triangleMisses++;
+						}
+					}
+					bool hardSplit = (nextHard < hardClusters.size()) && (hardClusters[nextHard] == i);
+					if (hardSplit)
+					{
+						nextHard++;
+					}
+					if (hardSplit || (triangleMisses == 3) || (i == 0))
+					{
+						clusters.push_back(i);
+					}
+				}
+			}
+			if (clusters.size() < 2)
+			{
+				return;
+			}
+			auto position = [&](uint32_t index)
+			{
+				float p[3];
+				memcpy(p, positions + static_cast<size_t>(index) * stride, sizeof(p));
+				return glm::vec3(p[0], p[1], p[2]);
+			};
+
+			// Area weighted centroid of the mesh and of each cluster, area weighted normal of each cluster
+			struct Cluster
+			{
+				uint32_t begin;
+				uint32_t end;
+				glm::vec3 centroid;
+				glm::vec3 normal;
+				float area;
+				float sortKey;
+			};
+			std::vector<Cluster> sorted(clusters.size());
+			glm::vec3 meshCentroid(0.0f);
+			float meshArea = 0.0f;
+			for (size_t c = 0; c < clusters.size(); c++)
+			{
+				Cluster &cluster = sorted[c];
+				cluster.begin = clusters[c];
+				cluster.end = (c + 1 < clusters.size()) ? clusters[c + 1] : static_cast<uint32_t>(indices.size());
+				cluster.centroid = glm::vec3(0.0f);
+				cluster.normal = glm::vec3(0.0f);
+				cluster.area = 0.0f;
+				for (uint32_t i = cluster.begin; i < cluster.end; i += 3)
+				{
+					glm::vec3 p0 = position(indices[i + 0]);
+					glm::vec3 p1 = position(indices[i + 1]);
+					glm::vec3 p2 = position(indices[i + 2]);
+					glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+					float area = glm::length(normal) * 0.5f;
+					cluster.centroid += (p0 + p1 + p2) * (area / 3.0f);
+					cluster.normal += normal;
+					cluster.area += area;
+				}
+				meshCentroid += cluster.centroid;
+				meshArea += cluster.area;
+				if (cluster.area > 0.0f)
+				{
+					cluster.centroid /= cluster.area;
+				}
+				float normalLength = glm::length(cluster.normal);
+				if (normalLength > 0.0f)
+				{
+					cluster.normal /= normalLength;
+				}
+			}
+			if (meshArea > 0.0f)
+			{
+				meshCentroid /= meshArea;
+			}
+			for (auto &cluster : sorted)
+			{
+				cluster.sortKey = glm::dot(cluster.centroid - meshCentroid, cluster.normal);
+			}
+			std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster &a, const Cluster &b) { return a.sortKey > b.sortKey; });
+
+			std::vector<uint32_t> output;
+			output.reserve(indices.size());
+			for (auto &cluster : sorted)
+			{
+				output.insert(output.end(), indices.begin() + cluster.begin, indices.begin() + cluster.end);
+			}
+			indices.swap(output);
+		}
+
+		/**
+		* Reorder vertices in the order they are first referenced by the indices, so vertex fetches access memory linearly
+		*
+		* @param vertices Vertex data, reordered in place (unreferenced vertices are removed)
+		* @param stride Size of a vertex in bytes
+		* @param indices Triangle list indices, remapped to the new vertex order
+		*
+		* @return Number of vertices after reordering
+		*/
+		inline uint32_t optimizeVertexFetch(std::vector<uint8_t> &vertices, uint32_t stride, std::vector<uint32_t> &indices)
+		{
+			const uint32_t vertexCount = static_cast<uint32_t>(vertices.size() / stride);
+			const uint32_t unused = ~0u;
+			std::vector<uint32_t> remap(vertexCount, unused);
+			std::vector<uint8_t> output;
+			output.reserve(vertices.size());
+			uint32_t count = 0;
+			for (auto &index : indices)
+			{
+				if (remap[index] == unused)
+				{
+					remap[index] = count++;
+					const uint8_t *vertex = vertices.data() + static_cast<size_t>(index) * stride;
+					output.insert(output.end(), vertex, vertex + stride);
+				}
+				index = remap[index];
+			}
+			vertices.swap(output);
+			return count;
+		}
+	}
+}
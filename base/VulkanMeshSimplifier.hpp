@@ -0,0 +1,428 @@
+/*
+* Mesh simplification
+*
+* Quadric error metric edge collapse simplification of indexed triangle lists, used to generate levels of detail that share the vertices of the source mesh
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <assert.h>
+
+#include <glm/glm.hpp>
+
+namespace vks
+{
+	namespace meshsimplifier
+	{
+		/** @brief Weight of the planes that keep open borders in place, relative to the triangle planes */
+		const float borderWeight = 10.0f;
+
+		/** @brief Symmetric 4x4 matrix of summed squared plane distances (Garland, Heckbert) */
+		struct Quadric
+		{
+			// a00 a01 a02 a03 a11 a12 a13 a22 a23 a33
+			double a[10];
+			// Summed weight of all planes, used to normalize the error
+			double weight;
+
+			Quadric()
+			{
+				memset(a, 0, sizeof(a));
+				weight = 0.0;
+			}
+
+			/** @brief Quadric of the plane dot(normal, p) + d = 0, scaled by weight */
+			Quadric(glm::vec3 normal, float d, float weight)
+			{
+				const double n[4] = { normal.x, normal.y, normal.z, d };
+				uint32_t k = 0;
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					for (uint32_t j = i; j < 4; j++)
+					{
+						a[k++] = n[i] * n[j] * weight;
+					}
+				}
+				this->weight = weight;
+			}
+
+			Quadric& operator+=(const Quadric &other)
+			{
+				for (uint32_t i = 0; i < 10; i++)
+				{
+					a[i] += other.a[i];
+				}
+				weight += other.weight;
+				return *this;
+			}
+
+			/** @brief Weighted mean squared distance of p to the planes */
+			float error(glm::vec3 p) const
+			{
+				if (weight <= 0.0)
+				{
+					return 0.0f;
+				}
+				const double x = p.x, y = p.y, z = p.z;
+				double e = a[0] * x * x + 2.0 * a[1] * x * y + 2.0 * a[2] * x * z + 2.0 * a[3] * x
+					+ a[4] * y * y + 2.0 * a[5] * y * z + 2.0 * a[6] * y
+					+ a[7] * z * z + 2.0 * a[8] * z
+					+ a[9];
+				return static_cast<float>(std::max(e, 0.0) / weight);
+			}
+		};
+
+		/**
+		* Simplify a triangle list by collapsing edges in the order of their quadric error
+		*
+		* @param indices Triangle list indices
+		* @param indexCount Number of indices
+		* @param positions Pointer to the position (3 floats) of the first vertex the indices refer to
+		* @param stride Distance in bytes between the positions of two vertices
+		* @param vertexCount Number of vertices the indices can refer to
+		* @param targetIndexCount Simplification stops once the index count is at or below this
+		* @param targetError Simplification stops before collapsing an edge with a larger error (in position units)
+		* @param (Optional) resultError Receives the largest error of all collapsed edges
+		*
+		* @return Indices of the simplified mesh, these only refer to vertices of the source mesh so all levels of detail can share one vertex buffer
+		*
+		* @note Vertices with equal positions but different attributes (e.g. at texture seams) are collapsed together, so seams don't crack open
+		*/
+		inline std::vector<uint32_t> simplify(const uint32_t *indices, size_t indexCount, const uint8_t *positions, uint32_t stride, uint32_t vertexCount, size_t targetIndexCount, float targetError, float *resultError = nullptr)
+		{
+			std::vector<uint32_t> result(indices, indices + indexCount - indexCount % 3);
+			if (resultError)
+			{
+				*resultError = 0.0f;
+			}
+
+			auto position = [&](uint32_t index)
+			{
+				float p[3];
+				memcpy(p, positions + static_cast<size_t>(index) * stride, sizeof(p));
+				return glm::vec3(p[0], p[1], p[2]);
+			};
+
+			// Map all vertices sharing a position to the first of them, the simplification works on these
+			std::vector<uint32_t> canonical(vertexCount);
+			{
+				uint32_t tableSize = 1;
+				while (tableSize < vertexCount * 2)
+				{
+					tableSize <<= 1;
+				}
+				const uint32_t empty = ~0u;
+				std::vector<uint32_t> table(tableSize, empty);
+				for (uint32_t v = 0; v < vertexCount; v++)
+				{
+					const uint8_t *p = positions + static_cast<size_t>(v) * stride;
+					uint32_t hash = 2166136261u;
+					for (uint32_t b = 0; b < 3 * sizeof(float); b++)
+					{
+						hash = (hash ^ p[b]) * 16777619u;
+					}
+					uint32_t slot = hash & (tableSize - 1);
+					while ((table[slot] != empty) && (memcmp(positions + static_cast<size_t>(table[slot]) * stride, p, 3 * sizeof(float)) != 0))
+					{
+						slot = (slot + 1) & (tableSize - 1);
+					}
+					if (table[slot] == empty)
+					{
+						table[slot] = v;
+					}
+					canonical[v] = table[slot];
+				}
+			}
+
+			struct Edge
+			{
+				uint32_t v0, v1;
+				bool operator<(const Edge &other) const { return (v0 < other.v0) || ((v0 == other.v0) && (v1 < other.v1)); }
+				bool operator==(const Edge &other) const { return (v0 == other.v0) && (v1 == other.v1); }
+			};
+			// Collect the edges of all triangles, edges only used by a single triangle are open borders
+			std::vector<Edge> edges;
+			auto collectEdges = [&]()
+			{
+				edges.clear();
+				edges.reserve(result.size());
+				for (size_t i = 0; i < result.size(); i += 3)
+				{
+					for (uint32_t k = 0; k < 3; k++)
+					{
+						uint32_t a = canonical[result[i + k]];
+						uint32_t b = canonical[result[i + (k + 1) % 3]];
+						edges.push_back({ std::min(a, b), std::max(a, b) });
+					}
+				}
+				std::sort(edges.begin(), edges.end());
+			};
+
+			// Quadrics of the triangle planes, weighted by area, plus planes perpendicular to open borders
+			std::vector<Quadric> quadrics(vertexCount);
+			std::vector<bool> border(vertexCount, false);
+			collectEdges();
+			for (size_t i = 0; i < edges.size(); )
+			{
+				size_t j = i + 1;
+				while ((j < edges.size()) && (edges[j] == edges[i]))
+				{
+					j++;
+				}
+				if (j - i == 1)
+				{
+					border[edges[i].v0] = true;
+					border[edges[i].v1] = true;
+				}
+				i = j;
+			}
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				uint32_t v[3] = { canonical[result[i]], canonical[result[i + 1]], canonical[result[i + 2]] };
+				glm::vec3 p[3] = { position(v[0]), position(v[1]), position(v[2]) };
+				glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+				float area = glm::length(normal);
+				if (area == 0.0f)
+				{
+					continue;
+				}
+				normal /= area;
+				Quadric plane(normal, -glm::dot(normal, p[0]), area);
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					quadrics[v[k]] += plane;
+				}
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					uint32_t a = v[k];
+					uint32_t b = v[(k + 1) % 3];
+					Edge edge = { std::min(a, b), std::max(a, b) };
+					auto range = std::equal_range(edges.begin(), edges.end(), edge);
+					if (range.second - range.first != 1)
+					{
+						continue;
+					}
+					glm::vec3 edgeVector = p[(k + 1) % 3] - p[k];
+					float length = glm::length(edgeVector);
+					if (length == 0.0f)
+					{
+						continue;
+					}
+					glm::vec3 borderNormal = glm::normalize(glm::cross(edgeVector, normal));
+					Quadric borderPlane(borderNormal, -glm::dot(borderNormal, p[k]), length * length * borderWeight);
+					quadrics[a] += borderPlane;
+					quadrics[b] += borderPlane;
+				}
+			}
+
+			struct Collapse
+			{
+				float error;
+				uint32_t from;
+				uint32_t to;
+				bool operator<(const Collapse &other) const { return error < other.error; }
+			};
+			std::vector<Collapse> collapses;
+			std::vector<uint32_t> collapseTarget(vertexCount);
+			std::vector<uint32_t> wedgeTarget(vertexCount);
+			std::vector<bool> locked(vertexCount);
+			// Triangles around each vertex, rebuilt for each pass
+			std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+			std::vector<uint32_t> adjacency;
+			const uint32_t none = ~0u;
+			const float maxError = targetError * targetError;
+
+			// Every pass collapses a set of independent edges with the lowest errors
+			while (result.size() > targetIndexCount)
+			{
+				collectEdges();
+				// Edges used by a single triangle are borders
+				std::vector<bool> borderEdge;
+				borderEdge.reserve(edges.size());
+				size_t uniqueCount = 0;
+				for (size_t i = 0; i < edges.size(); )
+				{
+					size_t j = i + 1;
+					while ((j < edges.size()) && (edges[j] == edges[i]))
+					{
+						j++;
+					}
+					edges[uniqueCount++] = edges[i];
+					borderEdge.push_back(j - i == 1);
+					i = j;
+				}
+				edges.resize(uniqueCount);
+
+				std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+				for (size_t i = 0; i < result.size(); i++)
+				{
+					adjacencyOffsets[canonical[result[i]] + 1]++;
+				}
+				for (uint32_t v = 0; v < vertexCount; v++)
+				{
+					adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+				}
+				adjacency.resize(result.size());
+				{
+					std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+					for (size_t i = 0; i < result.size(); i++)
+					{
+						adjacency[fill[canonical[result[i]]]++] = static_cast<uint32_t>(i / 3);
+					}
+				}
+
+				collapses.clear();
+				for (size_t i = 0; i < edges.size(); i++)
+				{
+					const Edge &edge = edges[i];
+					if (edge.v0 == edge.v1)
+					{
+						continue;
+					}
+					Quadric q = quadrics[edge.v0];
+					q += quadrics[edge.v1];
+					// Border vertices may only move along the border
+					bool canCollapse0 = !border[edge.v0] || borderEdge[i];
+					bool canCollapse1 = !border[edge.v1] || borderEdge[i];
+					float error0 = canCollapse0 ? q.error(position(edge.v1)) : FLT_MAX;
+					float error1 = canCollapse1 ? q.error(position(edge.v0)) : FLT_MAX;
+					if (!canCollapse0 && !canCollapse1)
+					{
+						continue;
+					}
+					if (error0 <= error1)
+					{
+						collapses.push_back({ error0, edge.v0, edge.v1 });
+					}
+					else
+					{
+						collapses.push_back({ error1, edge.v1, edge.v0 });
+					}
+				}
+				std::sort(collapses.begin(), collapses.end());
+
+				// Each collapse removes about two triangles
+				size_t triangleCount = result.size() / 3;
+				size_t collapseLimit = std::max<size_t>((triangleCount - targetIndexCount / 3) / 2, 1);
+				size_t collapseCount = 0;
+				std::fill(collapseTarget.begin(), collapseTarget.end(), none);
+				std::fill(locked.begin(), locked.end(), false);
+				for (auto &collapse : collapses)
+				{
+					if ((collapseCount >= collapseLimit) || (collapse.error > maxError))
+					{
+						break;
+					}
+					if (locked[collapse.from] || locked[collapse.to])
+					{
+						continue;
+					}
+					// Reject collapses that flip a remaining triangle
+					glm::vec3 target = position(collapse.to);
+					bool flipped = false;
+					for (uint32_t t = adjacencyOffsets[collapse.from]; t < adjacencyOffsets[collapse.from + 1] && !flipped; t++)
+					{
+						const uint32_t *triangle = &result[adjacency[t] * 3];
+						uint32_t v[3] = { canonical[triangle[0]], canonical[triangle[1]], canonical[triangle[2]] };
+						if ((v[0] == collapse.to) || (v[1] == collapse.to) || (v[2] == collapse.to))
+						{
+							continue;
+						}
+						glm::vec3 p[3] = { position(v[0]), position(v[1]), position(v[2]) };
+						glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+						for (uint32_t k = 0; k < 3; k++)
+						{
+							if (v[k] == collapse.from)
+							{
+								p[k] = target;
+							}
+						}
+						glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+						flipped = glm::dot(before, after) <= 0.0f;
+					}
+					if (flipped)
+					{
+						continue;
+					}
+					collapseTarget[collapse.from] = collapse.to;
+					quadrics[collapse.to] += quadrics[collapse.from];
+					// Lock the one ring, so the adjacency used for the flip test stays valid during this pass
+					for (uint32_t t = adjacencyOffsets[collapse.from]; t < adjacencyOffsets[collapse.from + 1]; t++)
+					{
+						const uint32_t *triangle = &result[adjacency[t] * 3];
+						for (uint32_t k = 0; k < 3; k++)
+						{
+							locked[canonical[triangle[k]]] = true;
+						}
+					}
+					if (resultError)
+					{
+						*resultError = std::max(*resultError, sqrtf(collapse.error));
+					}
+					collapseCount++;
+				}
+				if (collapseCount == 0)
+				{
+					break;
+				}
+
+				// Move each collapsed vertex to the vertex on the other end of the collapsed edge that shares a triangle with it, so attributes stay continuous
+				std::fill(wedgeTarget.begin(), wedgeTarget.end(), none);
+				for (size_t i = 0; i < result.size(); i += 3)
+				{
+					for (uint32_t k = 0; k < 3; k++)
+					{
+						uint32_t from = result[i + k];
+						uint32_t to = collapseTarget[canonical[from]];
+						if ((to == none) || (wedgeTarget[from] != none))
+						{
+							continue;
+						}
+						for (uint32_t l = 0; l < 3; l++)
+						{
+							if (canonical[result[i + l]] == to)
+							{
+								wedgeTarget[from] = result[i + l];
+							}
+						}
+					}
+				}
+				size_t dst = 0;
+				for (size_t i = 0; i < result.size(); i += 3)
+				{
+					uint32_t triangle[3];
+					for (uint32_t k = 0; k < 3; k++)
+					{
+						uint32_t index = result[i + k];
+						uint32_t to = collapseTarget[canonical[index]];
+						if (to != none)
+						{
+							index = (wedgeTarget[index] != none) ? wedgeTarget[index] : to;
+						}
+						triangle[k] = index;
+					}
+					// Drop triangles that have collapsed to a line
+					uint32_t c0 = canonical[triangle[0]], c1 = canonical[triangle[1]], c2 = canonical[triangle[2]];
+					if ((c0 == c1) || (c1 == c2) || (c0 == c2))
+					{
+						continue;
+					}
+					result[dst++] = triangle[0];
+					result[dst++] = triangle[1];
+					result[dst++] = triangle[2];
+				}
+				result.resize(dst);
+			}
+			return result;
+		}
+	}
+}
@@ -0,0 +1,229 @@
+/*
+* Meshlet (cluster) generation
+*
+* Splits indexed triangle lists into small clusters with bounding spheres and normal cones that can be culled individually
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <assert.h>
+
+#include <glm/glm.hpp>
+
+namespace vks
+{
+	namespace meshlets
+	{
+		/** @brief Maximum number of unique vertices referenced by a cluster */
+		const uint32_t maxVertices = 64;
+		/** @brief Maximum number of triangles in a cluster */
+		const uint32_t maxTriangles = 124;
+
+		/**
+		* @brief Cluster of consecutive triangles in the index buffer with its culling bounds
+		* @note Laid out to match std430, so the clusters can be uploaded to a storage buffer as they are
+		*/
+		struct Cluster
+		{
+			// Bounding sphere (xyz = center, w = radius)
+			glm::vec4 sphere;
+			// Apex of the normal cone (xyz)
+			glm::vec4 coneApex;
+			// Normal cone axis (xyz) and cutoff (w), the cluster is backfacing if dot(normalize(coneApex - cameraPos), axis) >= cutoff
+			// A cutoff of 1.0 disables cone culling for clusters with widely spread normals
+			glm::vec4 coneAxisCutoff;
+			// Draw parameters, same meaning as in VkDrawIndexedIndirectCommand
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			int32_t vertexOffset;
+			uint32_t part;
+		};
+		static_assert(sizeof(Cluster) == 64, "Cluster must match the std430 layout");
+
+		/**
+		* Calculate the bounding sphere and normal cone of a cluster
+		*
+		* @param indices Triangle list indices of the cluster
+		* @param indexCount Number of indices
+		* @param positions Pointer to the position (3 floats) of the first vertex the indices refer to
+		* @param stride Distance in bytes between the positions of two vertices
+		* @param cluster Receives the bounds
+		*/
+		inline void computeBounds(const uint32_t *indices, uint32_t indexCount, const uint8_t *positions, uint32_t stride, Cluster &cluster)
+		{
+			auto position = [&](uint32_t index)
+			{
+				float p[3];
+				memcpy(p, positions + static_cast<size_t>(index) * stride, sizeof(p));
+				return glm::vec3(p[0], p[1], p[2]);
+			};
+
+			// Sphere around the center of the bounding box
+			glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+			for (uint32_t i = 0; i < indexCount; i++)
+			{
+				glm::vec3 p = position(indices[i]);
+				min = glm::min(min, p);
+				max = glm::max(max, p);
+			}
+			glm::vec3 center = (min + max) * 0.5f;
+			float radius = 0.0f;
+			for (uint32_t i = 0; i < indexCount; i++)
+			{
+				radius = std::max(radius, glm::length(position(indices[i]) - center));
+			}
+			cluster.sphere = glm::vec4(center, radius);
+
+			// Normal cone from the triangle normals
+			std::vector<glm::vec3> normals;
+			normals.reserve(indexCount / 3);
+			glm::vec3 axis(0.0f);
+			for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+			{
+				glm::vec3 p0 = position(indices[i + 0]);
+				glm::vec3 p1 = position(indices[i + 1]);
+				glm::vec3 p2 = position(indices[i + 2]);
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				float length = glm::length(normal);
+				if (length > 0.0f)
+				{
+					normal /= length;
+					normals.push_back(normal);
+					axis += normal;
+				}
+			}
+			float axisLength = glm::length(axis);
+			cluster.coneApex = glm::vec4(center, 0.0f);
+			cluster.coneAxisCutoff = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			if (normals.empty() || (axisLength == 0.0f))
+			{
+				return;
+			}
+			axis /= axisLength;
+			float minDot = 1.0f;
+			for (auto &normal : normals)
+			{
+				minDot = std::min(minDot, glm::dot(normal, axis));
+			}
+			// Normals spread over (nearly) a hemisphere or more can't be culled by the cone
+			if (minDot <= 0.1f)
+			{
+				cluster.coneAxisCutoff = glm::vec4(axis, 1.0f);
+				return;
+			}
+			// Move the apex back along the axis until it is behind all triangle planes (dot(apex - p0, normal) <= 0)
+			float maxT = 0.0f;
+			size_t n = 0;
+			for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+			{
+				glm::vec3 p0 = position(indices[i + 0]);
+				glm::vec3 p1 = position(indices[i + 1]);
+				glm::vec3 p2 = position(indices[i + 2]);
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				if (glm::length(normal) == 0.0f)
+				{
+					continue;
+				}
+				normal = normals[n++];
+				float t = glm::dot(center - p0, normal) / glm::dot(axis, normal);
+				maxT = std::max(maxT, t);
+			}
+			cluster.coneApex = glm::vec4(center - axis * maxT, 0.0f);
+#if !defined(NDEBUG)
+			// Concave clusters need the apex moved furthest, any triangle facing the apex would be culled while visible
+			glm::vec3 apex(cluster.coneApex);
+			for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+			{
+				glm::vec3 p0 = position(indices[i + 0]);
+				glm::vec3 normal = glm::cross(position(indices[i + 1]) - p0, position(indices[i + 2]) - p0);
+				assert(glm::dot(apex - p0, normal) <= 1e-4f * glm::length(normal) * (radius + maxT + 1.0f));
+			}
+#endif
+			cluster.coneAxisCutoff = glm::vec4(axis, sqrtf(1.0f - minDot * minDot));
+		}
+
+		/**
+		* Split a triangle list into clusters of consecutive triangles
+		*
+		* @param indices Triangle list indices
+		* @param indexCount Number of indices
+		* @param firstIndex Index of indices[0] inside of the index buffer, added to the clusters' first index
+		* @param vertexOffset Vertex offset used to draw the indices, the indices plus this offset address positions
+		* @param positions Pointer to the position (3 floats) of the first vertex in the vertex buffer
+		* @param stride Distance in bytes between the positions of two vertices
+		* @param part Part the indices belong to, stored with each cluster
+		* @param clusters Receives the clusters
+		*
+		* @note Triangles are not reordered, so an index order optimized for the vertex cache (see VulkanMeshOptimizer.hpp) also keeps the clusters compact
+		*/
+		inline void build(const uint32_t *indices, uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset, const uint8_t *positions, uint32_t stride, uint32_t part, std::vector<Cluster> &clusters)
+		{
+			const uint8_t *clusterPositions = positions + static_cast<ptrdiff_t>(vertexOffset) * stride;
+			// Unique vertices of the current cluster, the cluster is small enough for a linear search
+			uint32_t clusterVertices[maxVertices];
+			uint32_t vertexCount = 0;
+			uint32_t clusterStart = 0;
+
+			auto flush = [&](uint32_t end)
+			{
+				if (end == clusterStart)
+				{
+					return;
+				}
+				Cluster cluster;
+				cluster.firstIndex = firstIndex + clusterStart;
+				cluster.indexCount = end - clusterStart;
+				cluster.vertexOffset = vertexOffset;
+				cluster.part = part;
+				computeBounds(indices + clusterStart, cluster.indexCount, clusterPositions, stride, cluster);
+				clusters.push_back(cluster);
+				clusterStart = end;
+				vertexCount = 0;
+			};
+
+			for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+			{
+				uint32_t newVertices[3];
+				uint32_t newCount = 0;
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					uint32_t index = indices[i + k];
+					bool found = std::find(clusterVertices, clusterVertices + vertexCount, index) != clusterVertices + vertexCount;
+					found = found || (std::find(newVertices, newVertices + newCount, index) != newVertices + newCount);
+					if (!found)
+					{
+						newVertices[newCount++] = index;
+					}
+				}
+				if ((vertexCount + newCount > maxVertices) || ((i - clusterStart) / 3 + 1 > maxTriangles))
+				{
+					flush(i);
+					// All vertices of the triangle are new to the next cluster
+					newCount = 0;
+					for (uint32_t k = 0; k < 3; k++)
+					{
+						uint32_t index = indices[i + k];
+						if (std::find(newVertices, newVertices + newCount, index) == newVertices + newCount)
+						{
+							newVertices[newCount++] = index;
+						}
+					}
+				}
+				for (uint32_t k = 0; k < newCount; k++)
+				{
+					clusterVertices[vertexCount++] = newVertices[k];
+				}
+			}
+			flush(indexCount - indexCount % 3);
+		}
+	}
+}
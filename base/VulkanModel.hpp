@@ -11,7 +11,11 @@
 #include <stdlib.h>
 #include <string>
 #include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
 #include <vector>
+#include <algorithm>
 
 #include "vulkan/vulkan.h"
 
@@ -26,6 +30,14 @@
 
 #include "VulkanDevice.hpp"
 #include "VulkanBuffer.hpp"
+#include "VulkanMeshCache.hpp"
+#include "VulkanVertexLayout.hpp"
+#include "VulkanMeshOptimizer.hpp"
+#include "VulkanIndexBuffer.hpp"
+#include "VulkanMeshlets.hpp"
+#include "VulkanMeshSimplifier.hpp"
+#include "VulkanBounds.hpp"
+#include "frustum.hpp"
 
 #if defined(__ANDROID__)
 #include <android/asset_manager.h>
@@ -33,54 +45,6 @@
 
 namespace vks
 {
-	/** @brief Vertex layout components */
-	typedef enum Component {
-		VERTEX_COMPONENT_POSITION = 0x0,
-		VERTEX_COMPONENT_NORMAL = 0x1,
-		VERTEX_COMPONENT_COLOR = 0x2,
-		VERTEX_COMPONENT_UV = 0x3,
-		VERTEX_COMPONENT_TANGENT = 0x4,
-		VERTEX_COMPONENT_BITANGENT = 0x5,
-		VERTEX_COMPONENT_DUMMY_FLOAT = 0x6,
-		VERTEX_COMPONENT_DUMMY_VEC4 = 0x7
-	} Component;
-
-	/** @brief Stores vertex layout components for model loading and Vulkan vertex input and atribute bindings  */
-	struct VertexLayout {
-	public:
-		/** @brief Components used to generate vertices from */
-		std::vector<Component> components;
-
-		VertexLayout(std::vector<Component> components)
-		{
-			this->components = std::move(components);
-		}
-
-		uint32_t stride()
-		{
-			uint32_t res = 0;
-			for (auto& component : components)
-			{
-				switch (component)
-				{
-				case VERTEX_COMPONENT_UV:
-					res += 2 * sizeof(float);
-					break;
-				case VERTEX_COMPONENT_DUMMY_FLOAT:
-					res += sizeof(float);
-					break;
-				case VERTEX_COMPONENT_DUMMY_VEC4:
-					res += 4 * sizeof(float);
-					break;
-				default:
-					// All components except the ones listed above are made up of 3 floats
-					res += 3 * sizeof(float);
-				}
-			}
-			return res;
-		}
-	};
-
 	/** @brief Used to parametrize model loading */
 	struct ModelCreateInfo {
 		glm::vec3 center;
@@ -111,6 +75,50 @@ namespace vks
 		vks::Buffer indices;
 		uint32_t indexCount = 0;
 		uint32_t vertexCount = 0;
+		/** @brief Type of the indices, 16 bit if all vertices can be addressed with them (bind the index buffer with this type) */
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+		/** @brief Set to true before loading to also use 16 bit indices for models with more than 64K vertices, the model then has to be drawn with draw() or drawPart() */
+		bool useIndexRanges = false;
+		/** @brief Token of the upload batch that fills the vertex and index buffers */
+		vks::UploadToken uploadToken;
+		/** @brief Set to false before loading to always import the model file instead of using the binary mesh cache (see VulkanMeshCache.hpp) */
+		bool useMeshCache = true;
+		/** @brief True if the model has been loaded from the mesh cache */
+		bool loadedFromCache = false;
+		/** @brief Set to true before loading to weld duplicate vertices and reorder the indices and vertices of each part for the post transform cache, overdraw and vertex fetch (see VulkanMeshOptimizer.hpp) */
+		bool optimize = false;
+
+		/** @brief Vertex count and vertex cache statistics of a part before and after optimization */
+		struct OptimizationStatistics {
+			uint32_t vertexCountBefore;
+			uint32_t vertexCountAfter;
+			vks::meshoptimizer::CacheStatistics before;
+			vks::meshoptimizer::CacheStatistics after;
+		};
+		/** @brief Set to true before loading to split the parts into clusters of at most 64 vertices and 124 triangles for culling (see VulkanMeshlets.hpp), needs float positions in the vertex layout */
+		bool buildClusters = false;
+		/** @brief Clusters of all parts, with draw parameters and culling bounds */
+		std::vector<vks::meshlets::Cluster> clusters;
+
+		/** @brief Set to more than 1 before loading to append lodCount - 1 simplified levels of detail of the whole model to the index buffer (see VulkanMeshSimplifier.hpp), needs float positions in the vertex layout */
+		uint32_t lodCount = 1;
+		/** @brief Triangle count of each level of detail relative to the previous level */
+		float lodReduction = 0.5f;
+
+		/** @brief Indices of a level of detail, drawn with a vertex offset of zero */
+		struct LodLevel {
+			uint32_t indexBase;
+			uint32_t indexCount;
+			// Estimated geometric error of the level compared to the full detail model, in model units after the load time scale
+			float error;
+			float _pad0;
+		};
+		/** @brief Levels of detail, starting with the full detail model, empty if lodCount is 1 */
+		std::vector<LodLevel> lods;
+		static_assert(sizeof(LodLevel) == 4 * sizeof(uint32_t), "Mesh cache stores levels of detail as four 32 bit values");
+
+		/** @brief Statistics for each part, only filled if the model has been optimized while importing it (not when loaded from the mesh cache) */
+		std::vector<OptimizationStatistics> optimizationStatistics;
 
 		/** @brief Stores vertex and index base and counts for each part of a model */
 		struct ModelPart {
@@ -120,6 +128,53 @@ namespace vks
 			uint32_t indexCount;
 		};
 		std::vector<ModelPart> parts;
+		static_assert(sizeof(ModelPart) == 4 * sizeof(uint32_t), "Mesh cache stores parts as four uint32_t");
+
+		/** @brief Reconstructs the positions of a part: position = quantized position * scale + offset (only differs from identity for snorm16 positions) */
+		struct Dequantization {
+			glm::vec4 scale;
+			glm::vec4 offset;
+		};
+		/** @brief Position dequantization for each part */
+		std::vector<Dequantization> dequantization;
+		static_assert(sizeof(Dequantization) == 8 * sizeof(float), "Mesh cache stores dequantization as eight floats");
+
+		/** @brief Bounding box and sphere of each part, in model space after the load time transform */
+		std::vector<vks::bounds::Bounds> bounds;
+		static_assert(sizeof(vks::bounds::Bounds) == 12 * sizeof(float), "Mesh cache stores bounds as twelve floats");
+
+		/**
+		* Get the parts that are inside of or intersect the view frustum
+		*
+		* @param frustum Frustum built from projection * view * model matrix, so the part bounds can be tested in model space
+		* @param visibleParts Receives the indices of the visible parts
+		*/
+		void cullParts(vks::Frustum &frustum, std::vector<uint32_t> &visibleParts)
+		{
+			if (bounds.empty())
+			{
+				visibleParts.clear();
+				return;
+			}
+			frustum.cullSpheres(&bounds[0].sphere, static_cast<uint32_t>(bounds.size()), sizeof(vks::bounds::Bounds), visibleParts);
+		}
+
+		/** @brief Matrix that reconstructs the positions of a part, e.g. to be multiplied with the model matrix */
+		glm::mat4 getDequantizationMatrix(uint32_t part)
+		{
+			return glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(dequantization[part].offset)), glm::vec3(dequantization[part].scale));
+		}
+
+		/** @brief Indices of a part that are drawn with a common vertex offset, parts with more than 64K vertices are made up of multiple ranges */
+		struct IndexRange {
+			uint32_t part;
+			uint32_t indexBase;
+			uint32_t indexCount;
+			int32_t vertexOffset;
+		};
+		/** @brief Index ranges of all parts in part order, only used for models with more than 64K vertices and useIndexRanges enabled */
+		std::vector<IndexRange> indexRanges;
+		static_assert(sizeof(IndexRange) == 4 * sizeof(uint32_t), "Mesh cache stores index ranges as four uint32_t");
 
 		static const int defaultFlags = aiProcess_FlipWindingOrder | aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals;
 
@@ -130,16 +185,289 @@ namespace vks
 			glm::vec3 size;
 		} dim;
 
+		/** @brief Get size and modification time of the model file, used to detect outdated mesh caches */
+		bool getSourceInfo(const std::string &filename, uint64_t &size, int64_t &time)
+		{
+#if defined(__ANDROID__)
+			// Assets inside the apk only change with the apk, which also clears the app's internal data path the cache is stored in
+			AAsset* asset = AAssetManager_open(androidApp->activity->assetManager, filename.c_str(), AASSET_MODE_UNKNOWN);
+			if (!asset)
+			{
+				return false;
+			}
+			size = static_cast<uint64_t>(AAsset_getLength(asset));
+			time = 0;
+			AAsset_close(asset);
+			return true;
+#else
+			return vks::meshcache::getFileInfo(filename, size, time);
+#endif
+		}
+
+		/** @brief Hash of all settings that change the generated vertex and index data */
+		uint64_t getCacheKey(vks::VertexLayout &layout, glm::vec3 scale, glm::vec2 uvscale, glm::vec3 center, int flags)
+		{
+			uint64_t key = vks::meshcache::hash(layout.components.data(), layout.components.size() * sizeof(Component));
+			key = vks::meshcache::hash(&scale, sizeof(scale), key);
+			key = vks::meshcache::hash(&uvscale, sizeof(uvscale), key);
+			key = vks::meshcache::hash(&center, sizeof(center), key);
+			key = vks::meshcache::hash(&optimize, sizeof(optimize), key);
+			key = vks::meshcache::hash(&useIndexRanges, sizeof(useIndexRanges), key);
+			key = vks::meshcache::hash(&buildClusters, sizeof(buildClusters), key);
+			key = vks::meshcache::hash(&lodCount, sizeof(lodCount), key);
+			key = vks::meshcache::hash(&lodReduction, sizeof(lodReduction), key);
+			return vks::meshcache::hash(&flags, sizeof(flags), key);
+		}
+
+		/**
+		* Optimize the vertices and indices of a single part
+		*
+		* @param vertexData Vertex data of the part, compacted in place
+		* @param vertexCount Number of vertices of the part
+		* @param stride Size of a vertex in bytes
+		* @param positionOffset Offset of the position component inside of a vertex, ~0 if the layout has no positions
+		* @param indices Part relative indices, reordered and remapped in place
+		*
+		* @return Number of vertices after optimization
+		*/
+		uint32_t optimizePart(uint8_t *vertexData, uint32_t vertexCount, uint32_t stride, uint32_t positionOffset, std::vector<uint32_t> &indices)
+		{
+			OptimizationStatistics statistics;
+			statistics.vertexCountBefore = vertexCount;
+			statistics.before = vks::meshoptimizer::analyzeVertexCache(indices, vertexCount);
+
+			std::vector<uint8_t> partVertices(vertexData, vertexData + static_cast<size_t>(vertexCount) * stride);
+			vertexCount = vks::meshoptimizer::weldVertices(partVertices, stride, indices);
+			std::vector<uint32_t> clusters;
+			vks::meshoptimizer::optimizeVertexCache(indices, vertexCount, &clusters);
+			if (positionOffset != ~0u)
+			{
+				vks::meshoptimizer::optimizeOverdraw(indices, clusters, partVertices.data() + positionOffset, stride);
+			}
+			vertexCount = vks::meshoptimizer::optimizeVertexFetch(partVertices, stride, indices);
+			memcpy(vertexData, partVertices.data(), partVertices.size());
+
+			statistics.vertexCountAfter = vertexCount;
+			statistics.after = vks::meshoptimizer::analyzeVertexCache(indices, vertexCount);
+			optimizationStatistics.push_back(statistics);
+			return vertexCount;
+		}
+
+		/**
+		* Split all parts into index ranges that reference at most 64K vertices each, so they can be drawn with 16 bit indices
+		*
+		* @param vertexData Vertex data of all parts, replaced with the vertex data of all ranges
+		* @param stride Size of a vertex in bytes
+		* @param indexData Indices of all parts, replaced with the indices relative to the first vertex of their range
+		*/
+		void buildIndexRanges(std::vector<uint8_t> &vertexData, uint32_t stride, std::vector<uint32_t> &indexData)
+		{
+			std::vector<uint8_t> rangeVertices;
+			std::vector<uint32_t> rangeIndices;
+			rangeVertices.reserve(vertexData.size());
+			rangeIndices.reserve(indexData.size());
+			std::vector<uint32_t> partIndices;
+			std::vector<vks::indexbuffer::Range> ranges;
+			indexRanges.clear();
+			for (uint32_t i = 0; i < static_cast<uint32_t>(parts.size()); i++)
+			{
+				ModelPart &part = parts[i];
+				partIndices.assign(indexData.begin() + part.indexBase, indexData.begin() + part.indexBase + part.indexCount);
+				for (auto &index : partIndices)
+				{
+					index -= part.vertexBase;
+				}
+				ranges.clear();
+				vks::indexbuffer::split(vertexData.data() + static_cast<size_t>(part.vertexBase) * stride, stride, partIndices.data(), part.indexCount, rangeVertices, rangeIndices, ranges);
+				part.vertexBase = static_cast<uint32_t>(rangeVertices.size() / stride);
+				part.indexBase = static_cast<uint32_t>(rangeIndices.size());
+				part.vertexCount = 0;
+				part.indexCount = 0;
+				if (!ranges.empty())
+				{
+					part.vertexBase = ranges.front().vertexBase;
+					part.indexBase = ranges.front().indexBase;
+				}
+				for (auto &range : ranges)
+				{
+					IndexRange indexRange = { i, range.indexBase, range.indexCount, static_cast<int32_t>(range.vertexBase) };
+					indexRanges.push_back(indexRange);
+					part.vertexCount += range.vertexCount;
+					part.indexCount += range.indexCount;
+				}
+			}
+			vertexData.swap(rangeVertices);
+			indexData.swap(rangeIndices);
+			vertexCount = static_cast<uint32_t>(vertexData.size() / stride);
+			indexCount = static_cast<uint32_t>(indexData.size());
+		}
+
+		/**
+		* Generate the levels of detail by simplifying all parts of the model and append their indices to the index data
+		*
+		* @param vertexData Vertex data of all parts
+		* @param stride Size of a vertex in bytes
+		* @param positionOffset Offset of the float position component inside of a vertex
+		* @param indexData Indices of all parts, drawn with a vertex offset of zero
+		*/
+		void buildLods(const std::vector<uint8_t> &vertexData, uint32_t stride, uint32_t positionOffset, std::vector<uint32_t> &indexData)
+		{
+			lods.clear();
+			const uint32_t sourceIndexCount = static_cast<uint32_t>(indexData.size());
+			lods.push_back({ 0, sourceIndexCount, 0.0f, 0.0f });
+			float targetIndexCount = static_cast<float>(sourceIndexCount);
+			for (uint32_t i = 1; i < lodCount; i++)
+			{
+				// Each level is simplified from the full detail model, so its error is measured against it
+				targetIndexCount *= lodReduction;
+				float error = 0.0f;
+				std::vector<uint32_t> lodIndices = vks::meshsimplifier::simplify(indexData.data(), sourceIndexCount, vertexData.data() + positionOffset, stride, vertexCount, static_cast<size_t>(targetIndexCount), FLT_MAX, &error);
+				LodLevel lod;
+				lod.indexBase = static_cast<uint32_t>(indexData.size());
+				lod.indexCount = static_cast<uint32_t>(lodIndices.size());
+				// The error estimate of a coarser level is never below the one of a finer level, so distance based selection stays ordered
+				lod.error = std::max(error, lods.back().error);
+				lod._pad0 = 0.0f;
+				lods.push_back(lod);
+				indexData.insert(indexData.end(), lodIndices.begin(), lodIndices.end());
+			}
+		}
+
+		/**
+		* Distance from which on a level of detail can be used without its error exceeding the given size on screen
+		*
+		* @param level Level of detail
+		* @param fov Vertical field of view of the projection in degrees
+		* @param viewportHeight Height of the viewport in pixels
+		* @param pixelError Largest acceptable error in pixels
+		* @param (Optional) scale Scale the model is drawn with
+		*/
+		float getLodDistance(uint32_t level, float fov, float viewportHeight, float pixelError, float scale = 1.0f)
+		{
+			// Pixels covered by one unit at a distance of one unit
+			float projectionScale = viewportHeight / (2.0f * tanf(glm::radians(fov) * 0.5f));
+			return lods[level].error * scale * projectionScale / pixelError;
+		}
+
+		/** @brief Draw all parts of the model, the vertex and index buffers need to be bound */
+		void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0)
+		{
+			if (indexRanges.empty())
+			{
+				vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, firstInstance);
+				return;
+			}
+			for (auto &range : indexRanges)
+			{
+				vkCmdDrawIndexed(commandBuffer, range.indexCount, instanceCount, range.indexBase, range.vertexOffset, firstInstance);
+			}
+		}
+
+		/** @brief Draw a single part of the model, the vertex and index buffers need to be bound */
+		void drawPart(VkCommandBuffer commandBuffer, uint32_t part, uint32_t instanceCount = 1, uint32_t firstInstance = 0)
+		{
+			if (indexRanges.empty())
+			{
+				vkCmdDrawIndexed(commandBuffer, parts[part].indexCount, instanceCount, parts[part].indexBase, 0, firstInstance);
+				return;
+			}
+			for (auto &range : indexRanges)
+			{
+				if (range.part == part)
+				{
+					vkCmdDrawIndexed(commandBuffer, range.indexCount, instanceCount, range.indexBase, range.vertexOffset, firstInstance);
+				}
+			}
+		}
+
+		/** @brief Draw a level of detail of the model, the vertex and index buffers need to be bound */
+		void drawLod(VkCommandBuffer commandBuffer, uint32_t level, uint32_t instanceCount = 1, uint32_t firstInstance = 0)
+		{
+			vkCmdDrawIndexed(commandBuffer, lods[level].indexCount, instanceCount, lods[level].indexBase, 0, firstInstance);
+		}
+
+		/** @brief Create the device local vertex and index buffers and queue the uploads of their data */
+		void createBuffers(vks::VulkanDevice *device, const void *vertexData, VkDeviceSize vertexDataSize, const void *indexData, VkDeviceSize indexDataSize)
+		{
+			// Create device local target buffers
+			// Vertex buffer
+			VK_CHECK_RESULT(device->createBuffer(
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				&vertices,
+				vertexDataSize));
+
+			// Index buffer
+			VK_CHECK_RESULT(device->createBuffer(
+				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				&indices,
+				indexDataSize));
+
+			// Stage vertex and index data through the upload queue's staging ring
+			// The copies are batched with other uploads and submitted later on, so this doesn't wait for them to finish
+			device->uploadQueue.uploadBuffer(vertices.buffer, vertexData, vertexDataSize);
+			uploadToken = device->uploadQueue.uploadBuffer(indices.buffer, indexData, indexDataSize);
+		}
+
+		/**
+		* Load the model from a mesh cache file
+		*
+		* @return False if there is no cache file or it doesn't match the key, layout or source file
+		*/
+		bool loadFromCache(const std::string &cacheFilename, uint64_t key, uint64_t sourceSize, int64_t sourceTime, vks::VertexLayout &layout, vks::VulkanDevice *device)
+		{
+			vks::meshcache::MappedFile file;
+			if (!file.open(cacheFilename))
+			{
+				return false;
+			}
+			const vks::meshcache::FileHeader *header = vks::meshcache::validate(file, key, sourceSize, sourceTime);
+			if (!header || (header->vertexStride != layout.stride()))
+			{
+				return false;
+			}
+			parts.resize(header->partCount);
+			memcpy(parts.data(), file.data + header->partsOffset, parts.size() * sizeof(ModelPart));
+			indexRanges.resize(header->rangeCount);
+			memcpy(indexRanges.data(), file.data + header->rangesOffset, indexRanges.size() * sizeof(IndexRange));
+			dequantization.resize(header->partCount);
+			memcpy(dequantization.data(), file.data + header->dequantizationOffset, dequantization.size() * sizeof(Dequantization));
+			bounds.resize(header->partCount);
+			memcpy(bounds.data(), file.data + header->boundsOffset, bounds.size() * sizeof(vks::bounds::Bounds));
+			if (header->clusterSize != sizeof(vks::meshlets::Cluster))
+			{
+				return false;
+			}
+			clusters.resize(header->clusterCount);
+			memcpy(clusters.data(), file.data + header->clustersOffset, clusters.size() * sizeof(vks::meshlets::Cluster));
+			if (header->lodSize != sizeof(LodLevel))
+			{
+				return false;
+			}
+			lods.resize(header->lodCount);
+			memcpy(lods.data(), file.data + header->lodsOffset, lods.size() * sizeof(LodLevel));
+			vertexCount = header->vertexCount;
+			// The index data also contains the levels of detail, the model itself is the first level
+			indexCount = lods.empty() ? header->indexCount : lods[0].indexCount;
+			indexType = static_cast<VkIndexType>(header->indexType);
+			dim.min = glm::make_vec3(header->dimMin);
+			dim.max = glm::make_vec3(header->dimMax);
+			dim.size = dim.max - dim.min;
+			// The upload queue copies straight from the mapping into its staging buffer
+			createBuffers(device, file.data + header->vertexOffset, header->vertexSize, file.data + header->indexOffset, header->indexSize);
+			loadedFromCache = true;
+			return true;
+		}
+
 		/** @brief Release all Vulkan resources of this model */
 		void destroy()
 		{		
 			assert(device);
-			vkDestroyBuffer(device, vertices.buffer, nullptr);
-			vkFreeMemory(device, vertices.memory, nullptr);
+			vertices.destroy();
 			if (indices.buffer != VK_NULL_HANDLE)
 			{
-				vkDestroyBuffer(device, indices.buffer, nullptr);
-				vkFreeMemory(device, indices.memory, nullptr);
+				indices.destroy();
 			}
 		}
 
@@ -150,12 +478,39 @@ namespace vks
 		* @param filename File to load (must be a model format supported by ASSIMP)
 		* @param layout Vertex layout components (position, normals, tangents, etc.)
 		* @param createInfo MeshCreateInfo structure for load time settings like scale, center, etc.
-		* @param copyQueue Queue used for the memory staging copy commands (must support transfer)
+		* @param copyQueue Ignored, vertex and index data is uploaded through the device's upload queue (kept for source compatibility)
 		* @param (Optional) flags ASSIMP model loading flags
 		*/
-		bool loadFromFile(const std::string& filename, vks::VertexLayout layout, vks::ModelCreateInfo *createInfo, vks::VulkanDevice *device, VkQueue copyQueue, const int flags = defaultFlags)
+		bool loadFromFile(const std::string& filename, vks::VertexLayout layout, vks::ModelCreateInfo *createInfo, vks::VulkanDevice *device, VkQueue /*copyQueue*/, const int flags = defaultFlags)
 		{
 			this->device = device->logicalDevice;
+			loadedFromCache = false;
+
+			glm::vec3 scale(1.0f);
+			glm::vec2 uvscale(1.0f);
+			glm::vec3 center(0.0f);
+			if (createInfo)
+			{
+				scale = createInfo->scale;
+				uvscale = createInfo->uvscale;
+				center = createInfo->center;
+			}
+
+			// Use the binary mesh cache written by an earlier import if it's still up to date
+			uint64_t sourceSize = 0;
+			int64_t sourceTime = 0;
+			uint64_t cacheKey = 0;
+			std::string cacheFilename;
+			bool cacheable = useMeshCache && getSourceInfo(filename, sourceSize, sourceTime);
+			if (cacheable)
+			{
+				cacheKey = getCacheKey(layout, scale, uvscale, center, flags);
+				cacheFilename = vks::meshcache::getCacheFilename(filename, cacheKey);
+				if (loadFromCache(cacheFilename, cacheKey, sourceSize, sourceTime, layout, device))
+				{
+					return true;
+				}
+			}
 
 			Assimp::Importer Importer;
 			const aiScene* pScene;
@@ -190,23 +545,41 @@ namespace vks
 			{
 				parts.clear();
 				parts.resize(pScene->mNumMeshes);
+				dequantization.clear();
+				dequantization.resize(pScene->mNumMeshes, { glm::vec4(1.0f), glm::vec4(0.0f) });
+				bounds.clear();
+				bounds.resize(pScene->mNumMeshes);
+				bool quantizedPositions = std::find(layout.components.begin(), layout.components.end(), VERTEX_COMPONENT_POSITION_SNORM16) != layout.components.end();
+
+				static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "Vertex writer expects single precision ASSIMP vectors");
 
-				glm::vec3 scale(1.0f);
-				glm::vec2 uvscale(1.0f);
-				glm::vec3 center(0.0f);
-				if (createInfo)
+				// Presize the buffers so vertices and indices are written straight into them
+				uint32_t totalVertexCount = 0;
+				uint32_t totalIndexCount = 0;
+				for (unsigned int i = 0; i < pScene->mNumMeshes; i++)
 				{
-					scale = createInfo->scale;
-					uvscale = createInfo->uvscale;
-					center = createInfo->center;
+					totalVertexCount += pScene->mMeshes[i]->mNumVertices;
+					totalIndexCount += pScene->mMeshes[i]->mNumFaces * 3;
 				}
-
-				std::vector<float> vertexBuffer;
-				std::vector<uint32_t> indexBuffer;
+				const uint32_t stride = layout.stride();
+				std::vector<uint8_t> vertexBuffer(static_cast<size_t>(totalVertexCount) * stride);
+				std::vector<uint32_t> indexBuffer(totalIndexCount);
 
 				vertexCount = 0;
 				indexCount = 0;
 
+				optimizationStatistics.clear();
+				uint32_t positionOffset = ~0u;
+				for (uint32_t i = 0; i < static_cast<uint32_t>(layout.components.size()); i++)
+				{
+					if (layout.components[i] == VERTEX_COMPONENT_POSITION)
+					{
+						positionOffset = layout.offset(i);
+						break;
+					}
+				}
+				std::vector<uint32_t> partIndices;
+
 				// Load meshes
 				for (unsigned int i = 0; i < pScene->mNumMeshes; i++)
 				{
@@ -216,150 +589,185 @@ namespace vks
 					parts[i].vertexBase = vertexCount;
 					parts[i].indexBase = indexCount;
 
-					vertexCount += pScene->mMeshes[i]->mNumVertices;
-
 					aiColor3D pColor(0.f, 0.f, 0.f);
 					pScene->mMaterials[paiMesh->mMaterialIndex]->Get(AI_MATKEY_COLOR_DIFFUSE, pColor);
 
-					const aiVector3D Zero3D(0.0f, 0.0f, 0.0f);
-
-					for (unsigned int j = 0; j < paiMesh->mNumVertices; j++)
+					vks::vertexwriter::VertexSource source;
+					source.count = paiMesh->mNumVertices;
+					source.positions = reinterpret_cast<const float*>(paiMesh->mVertices);
+					source.normals = paiMesh->HasNormals() ? reinterpret_cast<const float*>(paiMesh->mNormals) : nullptr;
+					source.texCoords = paiMesh->HasTextureCoords(0) ? reinterpret_cast<const float*>(paiMesh->mTextureCoords[0]) : nullptr;
+					source.tangents = paiMesh->HasTangentsAndBitangents() ? reinterpret_cast<const float*>(paiMesh->mTangents) : nullptr;
+					source.bitangents = paiMesh->HasTangentsAndBitangents() ? reinterpret_cast<const float*>(paiMesh->mBitangents) : nullptr;
+					source.color = glm::vec3(pColor.r, pColor.g, pColor.b);
+					source.scale = scale;
+					source.center = center;
+					source.uvscale = uvscale;
+
+					// Bounds of the imported positions, moved to model space like the positions
+					vks::bounds::Bounds sourceBounds = vks::bounds::compute(reinterpret_cast<const uint8_t*>(paiMesh->mVertices), paiMesh->mNumVertices, sizeof(aiVector3D));
+					bounds[i] = vks::bounds::transform(sourceBounds, scale * glm::vec3(1.0f, -1.0f, 1.0f), center);
+
+					if (quantizedPositions && (paiMesh->mNumVertices > 0))
 					{
-						const aiVector3D* pPos = &(paiMesh->mVertices[j]);
-						const aiVector3D* pNormal = &(paiMesh->mNormals[j]);
-						const aiVector3D* pTexCoord = (paiMesh->HasTextureCoords(0)) ? &(paiMesh->mTextureCoords[0][j]) : &Zero3D;
-						const aiVector3D* pTangent = (paiMesh->HasTangentsAndBitangents()) ? &(paiMesh->mTangents[j]) : &Zero3D;
-						const aiVector3D* pBiTangent = (paiMesh->HasTangentsAndBitangents()) ? &(paiMesh->mBitangents[j]) : &Zero3D;
-
-						for (auto& component : layout.components)
-						{
-							switch (component) {
-							case VERTEX_COMPONENT_POSITION:
-								vertexBuffer.push_back(pPos->x * scale.x + center.x);
-								vertexBuffer.push_back(-pPos->y * scale.y + center.y);
-								vertexBuffer.push_back(pPos->z * scale.z + center.z);
-								break;
-							case VERTEX_COMPONENT_NORMAL:
-								vertexBuffer.push_back(pNormal->x);
-								vertexBuffer.push_back(-pNormal->y);
-								vertexBuffer.push_back(pNormal->z);
-								break;
-							case VERTEX_COMPONENT_UV:
-								vertexBuffer.push_back(pTexCoord->x * uvscale.s);
-								vertexBuffer.push_back(pTexCoord->y * uvscale.t);
-								break;
-							case VERTEX_COMPONENT_COLOR:
-								vertexBuffer.push_back(pColor.r);
-								vertexBuffer.push_back(pColor.g);
-								vertexBuffer.push_back(pColor.b);
-								break;
-							case VERTEX_COMPONENT_TANGENT:
-								vertexBuffer.push_back(pTangent->x);
-								vertexBuffer.push_back(pTangent->y);
-								vertexBuffer.push_back(pTangent->z);
-								break;
-							case VERTEX_COMPONENT_BITANGENT:
-								vertexBuffer.push_back(pBiTangent->x);
-								vertexBuffer.push_back(pBiTangent->y);
-								vertexBuffer.push_back(pBiTangent->z);
-								break;
-							// Dummy components for padding
-							case VERTEX_COMPONENT_DUMMY_FLOAT:
-								vertexBuffer.push_back(0.0f);
-								break;
-							case VERTEX_COMPONENT_DUMMY_VEC4:
-								vertexBuffer.push_back(0.0f);
-								vertexBuffer.push_back(0.0f);
-								vertexBuffer.push_back(0.0f);
-								vertexBuffer.push_back(0.0f);
-								break;
-							};
-						}
-
-						dim.max.x = fmax(pPos->x, dim.max.x);
-						dim.max.y = fmax(pPos->y, dim.max.y);
-						dim.max.z = fmax(pPos->z, dim.max.z);
+						// Quantize to the bounds of the part after the load time transform
+						glm::vec3 partMin(bounds[i].min);
+						glm::vec3 partMax(bounds[i].max);
+						source.quantizationOffset = (partMin + partMax) * 0.5f;
+						source.quantizationScale = glm::max((partMax - partMin) * 0.5f, glm::vec3(FLT_MIN));
+						dequantization[i].scale = glm::vec4(source.quantizationScale, 1.0f);
+						dequantization[i].offset = glm::vec4(source.quantizationOffset, 0.0f);
+					}
+					vks::vertexwriter::write(layout, source, vertexBuffer.data() + static_cast<size_t>(vertexCount) * stride);
 
-						dim.min.x = fmin(pPos->x, dim.min.x);
-						dim.min.y = fmin(pPos->y, dim.min.y);
-						dim.min.z = fmin(pPos->z, dim.min.z);
+					if (paiMesh->mNumVertices > 0)
+					{
+						dim.max = glm::max(dim.max, glm::vec3(sourceBounds.max));
+						dim.min = glm::min(dim.min, glm::vec3(sourceBounds.min));
 					}
 
 					dim.size = dim.max - dim.min;
 
-					parts[i].vertexCount = paiMesh->mNumVertices;
-
-					uint32_t indexBase = static_cast<uint32_t>(indexBuffer.size());
+					partIndices.clear();
+					partIndices.reserve(paiMesh->mNumFaces * 3);
 					for (unsigned int j = 0; j < paiMesh->mNumFaces; j++)
 					{
 						const aiFace& Face = paiMesh->mFaces[j];
 						if (Face.mNumIndices != 3)
 							continue;
-						indexBuffer.push_back(indexBase + Face.mIndices[0]);
-						indexBuffer.push_back(indexBase + Face.mIndices[1]);
-						indexBuffer.push_back(indexBase + Face.mIndices[2]);
-						parts[i].indexCount += 3;
-						indexCount += 3;
+						partIndices.push_back(Face.mIndices[0]);
+						partIndices.push_back(Face.mIndices[1]);
+						partIndices.push_back(Face.mIndices[2]);
 					}
-				}
-
 
-				uint32_t vBufferSize = static_cast<uint32_t>(vertexBuffer.size()) * sizeof(float);
-				uint32_t iBufferSize = static_cast<uint32_t>(indexBuffer.size()) * sizeof(uint32_t);
-
-				// Use staging buffer to move vertex and index buffer to device local memory
-				// Create staging buffers
-				vks::Buffer vertexStaging, indexStaging;
-
-				// Vertex buffer
-				VK_CHECK_RESULT(device->createBuffer(
-					VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-					&vertexStaging,
-					vBufferSize,
-					vertexBuffer.data()));
-
-				// Index buffer
-				VK_CHECK_RESULT(device->createBuffer(
-					VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-					&indexStaging,
-					iBufferSize,
-					indexBuffer.data()));
-
-				// Create device local target buffers
-				// Vertex buffer
-				VK_CHECK_RESULT(device->createBuffer(
-					VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-					&vertices,
-					vBufferSize));
+					parts[i].vertexCount = paiMesh->mNumVertices;
+					if (optimize)
+					{
+						// Welding only shrinks the part, so the next part is written right behind the optimized vertices
+						parts[i].vertexCount = optimizePart(vertexBuffer.data() + static_cast<size_t>(vertexCount) * stride, paiMesh->mNumVertices, stride, positionOffset, partIndices);
+					}
+					vertexCount += parts[i].vertexCount;
 
-				// Index buffer
-				VK_CHECK_RESULT(device->createBuffer(
-					VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-					&indices,
-					iBufferSize));
+					// Parts are drawn with a vertex offset of zero, so indices are offset by the part's first vertex
+					uint32_t *dstIndex = indexBuffer.data() + indexCount;
+					for (auto index : partIndices)
+					{
+						*dstIndex++ = parts[i].vertexBase + index;
+					}
+					parts[i].indexCount = static_cast<uint32_t>(partIndices.size());
+					indexCount += parts[i].indexCount;
+				}
+				// Faces that aren't triangles have been skipped and welded vertices have been removed
+				indexBuffer.resize(indexCount);
+				vertexBuffer.resize(static_cast<size_t>(vertexCount) * stride);
+
+				// Use 16 bit indices if all vertices can be addressed with them, or if the parts can be split into 64K vertex ranges
+				indexRanges.clear();
+				indexType = vks::indexbuffer::getIndexType(vertexCount);
+				if ((indexType == VK_INDEX_TYPE_UINT32) && useIndexRanges)
+				{
+					buildIndexRanges(vertexBuffer, stride, indexBuffer);
+					indexType = VK_INDEX_TYPE_UINT16;
+				}
+				// Split the final index ranges into clusters
+				clusters.clear();
+				if (buildClusters)
+				{
+					if (positionOffset == ~0u)
+					{
+						std::cerr << "Clusters need float positions in the vertex layout" << std::endl;
+					}
+					else
+					{
+						const uint8_t *positions = vertexBuffer.data() + positionOffset;
+						if (indexRanges.empty())
+						{
+							for (uint32_t i = 0; i < static_cast<uint32_t>(parts.size()); i++)
+							{
+								vks::meshlets::build(indexBuffer.data() + parts[i].indexBase, parts[i].indexCount, parts[i].indexBase, 0, positions, stride, i, clusters);
+							}
+						}
+						else
+						{
+							for (auto &range : indexRanges)
+							{
+								vks::meshlets::build(indexBuffer.data() + range.indexBase, range.indexCount, range.indexBase, range.vertexOffset, positions, stride, range.part, clusters);
+							}
+						}
+					}
+				}
 
-				// Copy from staging buffers
-				VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+				// Append the levels of detail behind the indices of the model
+				lods.clear();
+				if (lodCount > 1)
+				{
+					if ((positionOffset == ~0u) || !indexRanges.empty())
+					{
+						std::cerr << "Levels of detail need float positions in the vertex layout and can't be combined with index ranges" << std::endl;
+					}
+					else
+					{
+						buildLods(vertexBuffer, stride, positionOffset, indexBuffer);
+						for (size_t i = 1; i < lods.size(); i++)
+						{
+							std::stringstream ss;
+							ss << filename << " lod " << i << ": triangles " << lods[0].indexCount / 3 << " -> " << lods[i].indexCount / 3 << ", error " << lods[i].error;
+							std::cout << ss.str() << std::endl;
+#if defined(__ANDROID__)
+							LOGD("%s", ss.str().c_str());
+#endif
+						}
+					}
+				}
 
-				VkBufferCopy copyRegion{};
+				std::vector<uint8_t> packedIndices;
+				vks::indexbuffer::pack(indexBuffer.data(), indexBuffer.size(), indexType, packedIndices);
 
-				copyRegion.size = vertices.size;
-				vkCmdCopyBuffer(copyCmd, vertexStaging.buffer, vertices.buffer, 1, &copyRegion);
+				if (optimize)
+				{
+					for (size_t i = 0; i < optimizationStatistics.size(); i++)
+					{
+						const OptimizationStatistics &statistics = optimizationStatistics[i];
+						std::stringstream ss;
+						ss << std::fixed << std::setprecision(3);
+						ss << filename << " part " << i << ": vertices " << statistics.vertexCountBefore << " -> " << statistics.vertexCountAfter;
+						ss << ", ACMR " << statistics.before.acmr << " -> " << statistics.after.acmr;
+						ss << ", ATVR " << statistics.before.atvr << " -> " << statistics.after.atvr;
+						std::cout << ss.str() << std::endl;
+#if defined(__ANDROID__)
+						LOGD("%s", ss.str().c_str());
+#endif
+					}
+				}
 
-				copyRegion.size = indices.size;
-				vkCmdCopyBuffer(copyCmd, indexStaging.buffer, indices.buffer, 1, &copyRegion);
+				uint32_t vBufferSize = static_cast<uint32_t>(vertexBuffer.size());
+				uint32_t iBufferSize = static_cast<uint32_t>(packedIndices.size());
 
-				device->flushCommandBuffer(copyCmd, copyQueue);
+				createBuffers(device, vertexBuffer.data(), vBufferSize, packedIndices.data(), iBufferSize);
 
-				// Destroy staging resources
-				vkDestroyBuffer(device->logicalDevice, vertexStaging.buffer, nullptr);
-				vkFreeMemory(device->logicalDevice, vertexStaging.memory, nullptr);
-				vkDestroyBuffer(device->logicalDevice, indexStaging.buffer, nullptr);
-				vkFreeMemory(device->logicalDevice, indexStaging.memory, nullptr);
+				if (cacheable)
+				{
+					vks::meshcache::FileHeader header = {};
+					header.key = cacheKey;
+					header.sourceSize = sourceSize;
+					header.sourceTime = sourceTime;
+					header.partCount = static_cast<uint32_t>(parts.size());
+					header.vertexCount = vertexCount;
+					header.indexCount = static_cast<uint32_t>(indexBuffer.size());
+					header.vertexStride = layout.stride();
+					header.indexType = indexType;
+					header.rangeCount = static_cast<uint32_t>(indexRanges.size());
+					header.clusterCount = static_cast<uint32_t>(clusters.size());
+					header.clusterSize = sizeof(vks::meshlets::Cluster);
+					header.lodCount = static_cast<uint32_t>(lods.size());
+					header.lodSize = sizeof(LodLevel);
+					memcpy(header.dimMin, &dim.min, sizeof(header.dimMin));
+					memcpy(header.dimMax, &dim.max, sizeof(header.dimMax));
+					if (!vks::meshcache::save(cacheFilename, header, parts.data(), indexRanges.data(), dequantization.data(), bounds.data(), clusters.data(), lods.data(), vertexBuffer.data(), packedIndices.data()))
+					{
+						std::cerr << "Could not write mesh cache \"" << cacheFilename << "\"" << std::endl;
+					}
+				}
 
 				return true;
 			}
@@ -380,13 +788,13 @@ namespace vks
 		* @param filename File to load (must be a model format supported by ASSIMP)
 		* @param layout Vertex layout components (position, normals, tangents, etc.)
 		* @param scale Load time scene scale
-		* @param copyQueue Queue used for the memory staging copy commands (must support transfer)
+		* @param copyQueue Ignored, vertex and index data is uploaded through the device's upload queue (kept for source compatibility)
 		* @param (Optional) flags ASSIMP model loading flags
 		*/
-		bool loadFromFile(const std::string& filename, vks::VertexLayout layout, float scale, vks::VulkanDevice *device, VkQueue copyQueue, const int flags = defaultFlags)
+		bool loadFromFile(const std::string& filename, vks::VertexLayout layout, float scale, vks::VulkanDevice *device, VkQueue /*copyQueue*/, const int flags = defaultFlags)
 		{
 			vks::ModelCreateInfo modelCreateInfo(scale, 1.0f, 0.0f);
-			return loadFromFile(filename, layout, &modelCreateInfo, device, copyQueue, flags);
+			return loadFromFile(filename, layout, &modelCreateInfo, device, VK_NULL_HANDLE, flags);
 		}
 	};
 };
\ No newline at end of file
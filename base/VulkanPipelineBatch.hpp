@@ -0,0 +1,361 @@
+/*
+* Vulkan pipeline batch
+*
+* Collects pipeline descriptions and compiles them in parallel on the workers of a thread pool
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <assert.h>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+#include "threadpool.hpp"
+
+namespace vks
+{
+	/**
+	* @brief Compiles a set of graphics and compute pipelines across the workers of a thread pool
+	*
+	* Each worker compiles into its own pipeline cache that is seeded with the contents of the target cache, so workers don't contend on a single cache.
+	* The worker caches are merged back into the target cache with vkMergePipelineCaches once all pipelines have been built.
+	*
+	* @note The create infos are deep copied when adding them, so the state structures they point to may be changed or go out of scope before building.
+	* pNext chains are not copied and must stay valid until build() returns. Shader modules, layouts, render passes and base pipeline handles must be valid at build time.
+	*/
+	class PipelineBatch
+	{
+	private:
+		/** @brief Owned copy of a shader stage including its entry point name and specialization data */
+		struct ShaderStage
+		{
+			VkPipelineShaderStageCreateInfo createInfo;
+			std::string entryPoint;
+			bool specialized = false;
+			VkSpecializationInfo specializationInfo;
+			std::vector<VkSpecializationMapEntry> mapEntries;
+			std::vector<uint8_t> data;
+
+			void copy(const VkPipelineShaderStageCreateInfo &stage)
+			{
+				createInfo = stage;
+				entryPoint = stage.pName;
+				if (stage.pSpecializationInfo)
+				{
+					specialized = true;
+					specializationInfo = *stage.pSpecializationInfo;
+					mapEntries.assign(specializationInfo.pMapEntries, specializationInfo.pMapEntries + specializationInfo.mapEntryCount);
+					const uint8_t *src = static_cast<const uint8_t*>(specializationInfo.pData);
+					data.assign(src, src + specializationInfo.dataSize);
+				}
+			}
+
+			// Must only be called once the stage has reached its final location in memory
+			void link()
+			{
+				createInfo.pName = entryPoint.c_str();
+				if (specialized)
+				{
+					specializationInfo.pMapEntries = mapEntries.data();
+					specializationInfo.pData = data.data();
+					createInfo.pSpecializationInfo = &specializationInfo;
+				}
+			}
+		};
+
+		/** @brief Owned copy of a graphics pipeline create info and all state referenced by it */
+		struct GraphicsPipeline
+		{
+			VkGraphicsPipelineCreateInfo createInfo;
+			std::vector<ShaderStage> stages;
+			std::vector<VkPipelineShaderStageCreateInfo> stageCreateInfos;
+			VkPipelineVertexInputStateCreateInfo vertexInputState;
+			std::vector<VkVertexInputBindingDescription> vertexBindings;
+			std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+			VkPipelineInputAssemblyStateCreateInfo inputAssemblyState;
+			VkPipelineTessellationStateCreateInfo tessellationState;
+			VkPipelineViewportStateCreateInfo viewportState;
+			std::vector<VkViewport> viewports;
+			std::vector<VkRect2D> scissors;
+			VkPipelineRasterizationStateCreateInfo rasterizationState;
+			VkPipelineMultisampleStateCreateInfo multisampleState;
+			std::vector<VkSampleMask> sampleMask;
+			VkPipelineDepthStencilStateCreateInfo depthStencilState;
+			VkPipelineColorBlendStateCreateInfo colorBlendState;
+			std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+			VkPipelineDynamicStateCreateInfo dynamicState;
+			std::vector<VkDynamicState> dynamicStates;
+
+			GraphicsPipeline(const VkGraphicsPipelineCreateInfo &info)
+			{
+				createInfo = info;
+				stages.resize(info.stageCount);
+				stageCreateInfos.resize(info.stageCount);
+				for (uint32_t i = 0; i < info.stageCount; i++)
+				{
+					stages[i].copy(info.pStages[i]);
+					stages[i].link();
+					stageCreateInfos[i] = stages[i].createInfo;
+				}
+				createInfo.pStages = stageCreateInfos.data();
+
+				if (info.pVertexInputState)
+				{
+					vertexInputState = *info.pVertexInputState;
+					vertexBindings.assign(vertexInputState.pVertexBindingDescriptions, vertexInputState.pVertexBindingDescriptions + vertexInputState.vertexBindingDescriptionCount);
+					vertexAttributes.assign(vertexInputState.pVertexAttributeDescriptions, vertexInputState.pVertexAttributeDescriptions + vertexInputState.vertexAttributeDescriptionCount);
+					vertexInputState.pVertexBindingDescriptions = vertexBindings.data();
+					vertexInputState.pVertexAttributeDescriptions = vertexAttributes.data();
+					createInfo.pVertexInputState = &vertexInputState;
+				}
+				if (info.pInputAssemblyState)
+				{
+					inputAssemblyState = *info.pInputAssemblyState;
+					createInfo.pInputAssemblyState = &inputAssemblyState;
+				}
+				if (info.pTessellationState)
+				{
+					tessellationState = *info.pTessellationState;
+					createInfo.pTessellationState = &tessellationState;
+				}
+				if (info.pViewportState)
+				{
+					viewportState = *info.pViewportState;
+					// Viewports and scissors may be null if they are dynamic state
+					if (viewportState.pViewports)
+					{
+						viewports.assign(viewportState.pViewports, viewportState.pViewports + viewportState.viewportCount);
+						viewportState.pViewports = viewports.data();
+					}
+					if (viewportState.pScissors)
+					{
+						scissors.assign(viewportState.pScissors, viewportState.pScissors + viewportState.scissorCount);
+						viewportState.pScissors = scissors.data();
+					}
+					createInfo.pViewportState = &viewportState;
+				}
+				if (info.pRasterizationState)
+				{
+					rasterizationState = *info.pRasterizationState;
+					createInfo.pRasterizationState = &rasterizationState;
+				}
+				if (info.pMultisampleState)
+				{
+					multisampleState = *info.pMultisampleState;
+					if (multisampleState.pSampleMask)
+					{
+						// One mask word per 32 samples
+						uint32_t maskWords = (static_cast<uint32_t>(multisampleState.rasterizationSamples) + 31) / 32;
+						sampleMask.assign(multisampleState.pSampleMask, multisampleState.pSampleMask + maskWords);
+						multisampleState.pSampleMask = sampleMask.data();
+					}
+					createInfo.pMultisampleState = &multisampleState;
+				}
+				if (info.pDepthStencilState)
+				{
+					depthStencilState = *info.pDepthStencilState;
+					createInfo.pDepthStencilState = &depthStencilState;
+				}
+				if (info.pColorBlendState)
+				{
+					colorBlendState = *info.pColorBlendState;
+					blendAttachments.assign(colorBlendState.pAttachments, colorBlendState.pAttachments + colorBlendState.attachmentCount);
+					colorBlendState.pAttachments = blendAttachments.data();
+					createInfo.pColorBlendState = &colorBlendState;
+				}
+				if (info.pDynamicState)
+				{
+					dynamicState = *info.pDynamicState;
+					dynamicStates.assign(dynamicState.pDynamicStates, dynamicState.pDynamicStates + dynamicState.dynamicStateCount);
+					dynamicState.pDynamicStates = dynamicStates.data();
+					createInfo.pDynamicState = &dynamicState;
+				}
+			}
+		};
+
+		/** @brief Owned copy of a compute pipeline create info */
+		struct ComputePipeline
+		{
+			VkComputePipelineCreateInfo createInfo;
+			ShaderStage stage;
+
+			ComputePipeline(const VkComputePipelineCreateInfo &info)
+			{
+				createInfo = info;
+				stage.copy(info.stage);
+				stage.link();
+				createInfo.stage = stage.createInfo;
+			}
+		};
+
+		/** @brief Pipeline added to the batch, either graphics or compute */
+		struct Entry
+		{
+			std::unique_ptr<GraphicsPipeline> graphics;
+			std::unique_ptr<ComputePipeline> compute;
+			VkPipeline *target = nullptr;
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			VkResult result = VK_SUCCESS;
+		};
+
+		VkDevice device;
+		std::vector<Entry> entries;
+
+		void buildEntry(Entry &entry, VkPipelineCache cache)
+		{
+			if (entry.graphics)
+			{
+				entry.result = vkCreateGraphicsPipelines(device, cache, 1, &entry.graphics->createInfo, nullptr, &entry.pipeline);
+			}
+			else
+			{
+				entry.result = vkCreateComputePipelines(device, cache, 1, &entry.compute->createInfo, nullptr, &entry.pipeline);
+			}
+		}
+
+	public:
+		/** @brief Number of pipelines built by the last call to build() */
+		uint32_t builtCount = 0;
+		/** @brief Number of pipeline caches (and workers) used by the last call to build() */
+		uint32_t workerCount = 0;
+
+		PipelineBatch(VkDevice device) : device(device) {}
+
+		/**
+		* Add a graphics pipeline to the batch
+		*
+		* @param createInfo Pipeline create info, deep copied so the referenced state may be changed afterwards
+		* @param (Optional) pipeline Pointer to the handle that receives the pipeline when the batch is built
+		*
+		* @note basePipelineIndex refers to the pipelines passed to a single vkCreate*Pipelines call and can't be used in a batch, use basePipelineHandle instead
+		*
+		* @return Index of the pipeline in the list returned by build()
+		*/
+		uint32_t add(const VkGraphicsPipelineCreateInfo &createInfo, VkPipeline *pipeline = nullptr)
+		{
+			assert((createInfo.flags & VK_PIPELINE_CREATE_DERIVATIVE_BIT) == 0 || createInfo.basePipelineIndex == -1);
+			Entry entry;
+			entry.graphics.reset(new GraphicsPipeline(createInfo));
+			entry.target = pipeline;
+			entries.push_back(std::move(entry));
+			return static_cast<uint32_t>(entries.size() - 1);
+		}
+
+		/**
+		* Add a compute pipeline to the batch
+		*
+		* @param createInfo Pipeline create info, deep copied so the referenced state may be changed afterwards
+		* @param (Optional) pipeline Pointer to the handle that receives the pipeline when the batch is built
+		*
+		* @return Index of the pipeline in the list returned by build()
+		*/
+		uint32_t add(const VkComputePipelineCreateInfo &createInfo, VkPipeline *pipeline = nullptr)
+		{
+			assert((createInfo.flags & VK_PIPELINE_CREATE_DERIVATIVE_BIT) == 0 || createInfo.basePipelineIndex == -1);
+			Entry entry;
+			entry.compute.reset(new ComputePipeline(createInfo));
+			entry.target = pipeline;
+			entries.push_back(std::move(entry));
+			return static_cast<uint32_t>(entries.size() - 1);
+		}
+
+		/** @brief Number of pipelines waiting to be built */
+		uint32_t size()
+		{
+			return static_cast<uint32_t>(entries.size());
+		}
+
+		/**
+		* Compile all pipelines of the batch and clear it
+		*
+		* @param pipelineCache Cache the worker caches are seeded from and merged into (may be VK_NULL_HANDLE)
+		* @param threadPool Thread pool whose workers compile the pipelines, pipelines are built on the calling thread if it has no threads
+		*
+		* @return Handles of all pipelines in the order they have been added, also written to the pointers passed to add()
+		*/
+		std::vector<VkPipeline> build(VkPipelineCache pipelineCache, vks::ThreadPool &threadPool)
+		{
+			std::vector<VkPipeline> pipelines;
+			builtCount = static_cast<uint32_t>(entries.size());
+			workerCount = std::min(static_cast<uint32_t>(threadPool.threads.size()), builtCount);
+
+			if (workerCount <= 1)
+			{
+				for (auto &entry : entries)
+				{
+					buildEntry(entry, pipelineCache);
+				}
+				workerCount = std::min(builtCount, 1u);
+			}
+			else
+			{
+				// Seed the worker caches with the target cache so pipelines already in there are still found
+				std::vector<uint8_t> initialData;
+				if (pipelineCache != VK_NULL_HANDLE)
+				{
+					size_t dataSize = 0;
+					VK_CHECK_RESULT(vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr));
+					initialData.resize(dataSize);
+					VK_CHECK_RESULT(vkGetPipelineCacheData(device, pipelineCache, &dataSize, initialData.data()));
+					initialData.resize(dataSize);
+				}
+				std::vector<VkPipelineCache> workerCaches(workerCount);
+				for (auto &workerCache : workerCaches)
+				{
+					VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
+					pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+					pipelineCacheCreateInfo.initialDataSize = initialData.size();
+					pipelineCacheCreateInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+					VK_CHECK_RESULT(vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &workerCache));
+				}
+
+				// Pipelines are fetched from a shared counter instead of being assigned up front, so a worker that got cheap pipelines picks up more
+				std::atomic<uint32_t> nextEntry(0);
+				for (uint32_t i = 0; i < workerCount; i++)
+				{
+					VkPipelineCache workerCache = workerCaches[i];
+					threadPool.threads[i]->addJob([this, workerCache, &nextEntry]
+					{
+						uint32_t index;
+						while ((index = nextEntry.fetch_add(1)) < builtCount)
+						{
+							buildEntry(entries[index], workerCache);
+						}
+					});
+				}
+				threadPool.wait();
+
+				if (pipelineCache != VK_NULL_HANDLE)
+				{
+					VK_CHECK_RESULT(vkMergePipelineCaches(device, pipelineCache, workerCount, workerCaches.data()));
+				}
+				for (auto workerCache : workerCaches)
+				{
+					vkDestroyPipelineCache(device, workerCache, nullptr);
+				}
+			}
+
+			pipelines.reserve(entries.size());
+			for (auto &entry : entries)
+			{
+				VK_CHECK_RESULT(entry.result);
+				if (entry.target)
+				{
+					*entry.target = entry.pipeline;
+				}
+				pipelines.push_back(entry.pipeline);
+			}
+			entries.clear();
+			return pipelines;
+		}
+	};
+}
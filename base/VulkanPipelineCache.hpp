@@ -0,0 +1,207 @@
+/*
+* Vulkan pipeline cache serialization
+*
+* Loads and saves pipeline cache data so pipelines don't have to be compiled from scratch on every start
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+
+namespace vks
+{
+	namespace pipelinecache
+	{
+		/**
+		* @brief Header written in front of the driver's pipeline cache data
+		* @note The driver version is not part of Vulkan's own pipeline cache header, so it's stored here to discard caches from older drivers
+		*/
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t vendorID;
+			uint32_t deviceID;
+			uint32_t driverVersion;
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+			uint64_t dataSize;
+			uint64_t checksum;
+		};
+
+		const uint32_t fileMagic = 0x43504b56; // "VKPC"
+		const uint32_t fileVersion = 1;
+
+		/** @brief 64 bit FNV-1a hash used to detect truncated or corrupted cache files */
+		inline uint64_t checksum(const uint8_t *data, size_t size)
+		{
+			uint64_t hash = 14695981039346656037ULL;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= data[i];
+				hash *= 1099511628211ULL;
+			}
+			return hash;
+		}
+
+		/**
+		* Load pipeline cache data from a file and validate it against the device
+		*
+		* @param filename File to load
+		* @param properties Properties of the physical device the cache is used on
+		* @param data Vector receiving the pipeline cache data (without the file header)
+		* @param (Optional) error Pointer to a string receiving the reason if the file is rejected
+		*
+		* @return True if the file exists and the data matches the device and driver
+		*/
+		inline bool load(const std::string &filename, const VkPhysicalDeviceProperties &properties, std::vector<uint8_t> &data, std::string *error = nullptr)
+		{
+			data.clear();
+			std::string reason;
+			std::ifstream file(filename, std::ios::binary | std::ios::ate);
+			if (!file.is_open())
+			{
+				reason = "no cache file";
+			}
+			else
+			{
+				size_t fileSize = static_cast<size_t>(file.tellg());
+				file.seekg(0, std::ios::beg);
+				FileHeader header;
+				if ((fileSize < sizeof(FileHeader)) || !file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader)))
+				{
+					reason = "file too small";
+				}
+				else if ((header.magic != fileMagic) || (header.version != fileVersion))
+				{
+					reason = "unknown file format";
+				}
+				else if ((header.vendorID != properties.vendorID) || (header.deviceID != properties.deviceID) || (memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0))
+				{
+					reason = "created on a different device";
+				}
+				else if (header.driverVersion != properties.driverVersion)
+				{
+					reason = "created with a different driver version";
+				}
+				else if (header.dataSize != fileSize - sizeof(FileHeader))
+				{
+					reason = "truncated file";
+				}
+				else
+				{
+					data.resize(static_cast<size_t>(header.dataSize));
+					if (!file.read(reinterpret_cast<char*>(data.data()), data.size()) || (checksum(data.data(), data.size()) != header.checksum))
+					{
+						reason = "checksum mismatch";
+					}
+					else
+					{
+						// Also check Vulkan's own header at the start of the data (length, version, vendor, device and uuid)
+						uint32_t vkHeader[4];
+						if (data.size() < sizeof(vkHeader) + VK_UUID_SIZE)
+						{
+							reason = "invalid pipeline cache header";
+						}
+						else
+						{
+							memcpy(vkHeader, data.data(), sizeof(vkHeader));
+							if ((vkHeader[0] < sizeof(vkHeader) + VK_UUID_SIZE) ||
+								(vkHeader[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) ||
+								(vkHeader[2] != properties.vendorID) ||
+								(vkHeader[3] != properties.deviceID) ||
+								(memcmp(data.data() + sizeof(vkHeader), properties.pipelineCacheUUID, VK_UUID_SIZE) != 0))
+							{
+								reason = "invalid pipeline cache header";
+							}
+						}
+					}
+				}
+			}
+			if (!reason.empty())
+			{
+				data.clear();
+				if (error)
+				{
+					*error = reason;
+				}
+				return false;
+			}
+			return true;
+		}
+
+		/**
+		* Save the data of a pipeline cache to a file
+		*
+		* @param filename File to write
+		* @param properties Properties of the physical device the cache has been created on
+		* @param device Logical device the cache has been created on
+		* @param pipelineCache Pipeline cache to save
+		*
+		* @note The data is written to a temporary file first that then replaces the target file, so an interrupted write never leaves a partial cache file behind
+		*
+		* @return True if the file has been written
+		*/
+		inline bool save(const std::string &filename, const VkPhysicalDeviceProperties &properties, VkDevice device, VkPipelineCache pipelineCache)
+		{
+			size_t dataSize = 0;
+			VK_CHECK_RESULT(vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr));
+			std::vector<uint8_t> data(dataSize);
+			VK_CHECK_RESULT(vkGetPipelineCacheData(device, pipelineCache, &dataSize, data.data()));
+			data.resize(dataSize);
+
+			FileHeader header = {};
+			header.magic = fileMagic;
+			header.version = fileVersion;
+			header.vendorID = properties.vendorID;
+			header.deviceID = properties.deviceID;
+			header.driverVersion = properties.driverVersion;
+			memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+			header.dataSize = data.size();
+			header.checksum = checksum(data.data(), data.size());
+
+			// Each saving process and thread uses its own temporary file, so concurrent saves of the same cache can't interleave
+			std::string tempFilename = vks::tools::getTemporaryFilename(filename);
+			{
+				std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+				if (!file.is_open())
+				{
+					return false;
+				}
+				file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+				file.write(reinterpret_cast<const char*>(data.data()), data.size());
+				file.flush();
+				if (!file.good())
+				{
+					file.close();
+					std::remove(tempFilename.c_str());
+					return false;
+				}
+			}
+#if defined(_WIN32)
+			bool replaced = MoveFileExA(tempFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+			bool replaced = std::rename(tempFilename.c_str(), filename.c_str()) == 0;
+#endif
+			if (!replaced)
+			{
+				std::remove(tempFilename.c_str());
+			}
+			return replaced;
+		}
+	}
+}
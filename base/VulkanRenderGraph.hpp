@@ -0,0 +1,901 @@
+/*
+* Vulkan render graph
+*
+* Offscreen passes declared by their attachment reads and writes, with automatic barriers and transient attachment aliasing
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <assert.h>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+#include "VulkanDevice.hpp"
+
+namespace vks
+{
+	/**
+	* @brief Frame graph for chains of offscreen passes (e.g. post processing)
+	*
+	* Passes declare the attachments they render to and the attachments they sample from. Compiling the graph
+	* - culls all passes whose results are never read (by a later pass or by an external read after the graph)
+	* - creates the attachments, render passes and framebuffers of the remaining passes
+	* - computes the layout transitions and memory dependencies between the passes and batches them into one barrier per pass
+	* - aliases the memory of attachments whose lifetimes don't overlap and puts attachments that are only used inside of a single
+	*   pass into lazily allocated memory (if the device has such a memory type, e.g. on tile based GPUs)
+	*
+	* Passes are executed in the order they have been added, the first pass writing an attachment clears it, later ones load it.
+	* Attachments don't keep their contents between frames (apart from those read externally).
+	*/
+	class RenderGraph
+	{
+	public:
+		/** @brief Index of an attachment of the graph */
+		typedef uint32_t ResourceHandle;
+
+		/** @brief Description of an attachment */
+		struct AttachmentInfo
+		{
+			VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+			/** @brief Size in pixels, if zero the size is relative to the extent the graph is compiled with */
+			uint32_t width = 0;
+			uint32_t height = 0;
+			/** @brief Scale applied to the graph's extent for relative sizes */
+			float sizeScale = 1.0f;
+			/** @brief Array layers, attachments with more than one layer are rendered to as layered framebuffer attachments (e.g. selected by a geometry shader) and sampled as arrays */
+			uint32_t layerCount = 1;
+		};
+
+		/** @brief Statistics of the last compilation */
+		struct Stats
+		{
+			uint32_t passCount = 0;
+			uint32_t culledPassCount = 0;
+			uint32_t attachmentCount = 0;
+			uint32_t lazyAttachmentCount = 0;
+			/** @brief Memory ranges shared by the non-lazy attachments */
+			uint32_t memoryRangeCount = 0;
+			/** @brief Memory required without aliasing */
+			VkDeviceSize requiredBytes = 0;
+			/** @brief Memory actually allocated for the attachments */
+			VkDeviceSize allocatedBytes = 0;
+			/** @brief Pipeline barrier commands, image and memory barriers recorded per execution */
+			uint32_t barrierBatchCount = 0;
+			uint32_t imageBarrierCount = 0;
+			uint32_t memoryBarrierCount = 0;
+		};
+
+		class Pass
+		{
+			friend class RenderGraph;
+		private:
+			struct Output
+			{
+				ResourceHandle resource;
+				VkClearValue clearValue;
+			};
+			struct Input
+			{
+				ResourceHandle resource;
+				VkPipelineStageFlags stages;
+			};
+
+			std::string name;
+			std::vector<Output> colorOutputs;
+			std::vector<Output> depthStencilOutput;
+			std::vector<Input> textureInputs;
+			bool sideEffects = false;
+
+			// Compiled state
+			bool culled = false;
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+			VkFramebuffer framebuffer = VK_NULL_HANDLE;
+			VkExtent2D extent = {};
+			uint32_t layers = 1;
+			std::vector<VkClearValue> clearValues;
+			std::vector<VkImageMemoryBarrier> barriers;
+			// Make writes to aliased memory by a different attachment available
+			std::vector<VkMemoryBarrier> memoryBarriers;
+			VkPipelineStageFlags srcStageMask = 0;
+			VkPipelineStageFlags dstStageMask = 0;
+
+		public:
+			/** @brief Records the commands of the pass, called inside of the pass' render pass with viewport and scissor set to the pass' extent */
+			std::function<void(VkCommandBuffer)> record;
+
+			/**
+			* Render to a color attachment
+			*
+			* @param resource Attachment to render to
+			* @param (Optional) clearColor Color the attachment is cleared to if this is the first pass writing it
+			*/
+			void addColorOutput(ResourceHandle resource, VkClearColorValue clearColor = { { 0.0f, 0.0f, 0.0f, 0.0f } })
+			{
+				Output output;
+				output.resource = resource;
+				output.clearValue.color = clearColor;
+				colorOutputs.push_back(output);
+			}
+
+			/**
+			* Use a depth stencil attachment
+			*
+			* @param resource Depth stencil attachment
+			* @param (Optional) clearValue Value the attachment is cleared to if this is the first pass writing it
+			*/
+			void setDepthStencilOutput(ResourceHandle resource, VkClearDepthStencilValue clearValue = { 1.0f, 0 })
+			{
+				Output output;
+				output.resource = resource;
+				output.clearValue.depthStencil = clearValue;
+				depthStencilOutput.assign(1, output);
+			}
+
+			/**
+			* Sample from an attachment written by an earlier pass
+			*
+			* @param resource Attachment to sample from
+			* @param (Optional) stages Shader stages that sample the attachment (defaults to the fragment shader)
+			*/
+			void addTextureInput(ResourceHandle resource, VkPipelineStageFlags stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
+			{
+				Input input = { resource, stages };
+				textureInputs.push_back(input);
+			}
+
+			/** @brief Never cull the pass, even if none of its outputs are read */
+			void setSideEffects(bool sideEffects)
+			{
+				this->sideEffects = sideEffects;
+			}
+
+			/** @brief Render pass to create the pass' pipelines with (valid after compile) */
+			VkRenderPass getRenderPass() const
+			{
+				return renderPass;
+			}
+
+			/** @brief Returns true if the pass has been culled by the last compilation */
+			bool isCulled() const
+			{
+				return culled;
+			}
+		};
+
+	private:
+		// A single access of a pass (or the external read) to an attachment
+		struct Use
+		{
+			uint32_t pass;
+			VkImageLayout layout;
+			VkPipelineStageFlags stages;
+			VkAccessFlags access;
+			bool write;
+		};
+
+		struct Resource
+		{
+			std::string name;
+			AttachmentInfo info;
+			// External read after the last pass
+			bool externalRead = false;
+			VkPipelineStageFlags externalStages = 0;
+
+			// Compiled state
+			std::vector<Use> uses;
+			VkImageUsageFlags usage = 0;
+			bool lazy = false;
+			VkExtent2D extent = {};
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView view = VK_NULL_HANDLE;
+			VkMemoryRequirements memReqs = {};
+			// Memory range the attachment is bound to
+			uint32_t range = UINT32_MAX;
+			// Use the first use of the attachment waits for (last use of the previous attachment in the same memory, cyclic over frames)
+			Use previousUse = {};
+			// Set if previousUse belongs to a different attachment
+			bool aliased = false;
+
+			uint32_t firstPass() const { return uses.front().pass; }
+			uint32_t lastPass() const { return uses.back().pass; }
+		};
+
+		// Memory shared by attachments with disjoint lifetimes
+		struct MemoryRange
+		{
+			VkMemoryRequirements memReqs;
+			std::vector<ResourceHandle> resources;
+			vks::Allocation allocation;
+		};
+
+		vks::VulkanDevice *device = nullptr;
+		std::vector<Resource> resources;
+		std::vector<std::unique_ptr<Pass>> passes;
+		std::vector<MemoryRange> memoryRanges;
+
+		// Barriers that transition the externally read attachments after the last pass
+		std::vector<VkImageMemoryBarrier> finalBarriers;
+		std::vector<VkMemoryBarrier> finalMemoryBarriers;
+		VkPipelineStageFlags finalSrcStageMask = 0;
+		VkPipelineStageFlags finalDstStageMask = 0;
+
+		Stats stats;
+
+		static bool isDepthFormat(VkFormat format)
+		{
+			return (format >= VK_FORMAT_D16_UNORM) && (format <= VK_FORMAT_D32_SFLOAT_S8_UINT);
+		}
+
+		static VkImageAspectFlags getAspectMask(VkFormat format)
+		{
+			if (!isDepthFormat(format))
+			{
+				return VK_IMAGE_ASPECT_COLOR_BIT;
+			}
+			VkImageAspectFlags aspectMask = 0;
+			if (format != VK_FORMAT_S8_UINT)
+			{
+				aspectMask |= VK_IMAGE_ASPECT_DEPTH_BIT;
+			}
+			if (format >= VK_FORMAT_S8_UINT)
+			{
+				aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+			}
+			return aspectMask;
+		}
+
+		// Returns true if the pass is the first one (in declaration order) that writes the resource, i.e. clears it
+		bool isFirstWriter(uint32_t passIndex, ResourceHandle resource)
+		{
+			for (uint32_t i = 0; i < passIndex; i++)
+			{
+				for (auto &output : passes[i]->colorOutputs)
+				{
+					if (output.resource == resource)
+					{
+						return false;
+					}
+				}
+				for (auto &output : passes[i]->depthStencilOutput)
+				{
+					if (output.resource == resource)
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		// Walk the passes backwards and keep those that write attachments whose contents are needed later on
+		void cullPasses()
+		{
+			std::vector<bool> needed(resources.size(), false);
+			for (size_t i = 0; i < resources.size(); i++)
+			{
+				needed[i] = resources[i].externalRead;
+			}
+			for (int32_t i = static_cast<int32_t>(passes.size()) - 1; i >= 0; i--)
+			{
+				Pass &pass = *passes[i];
+				std::vector<Pass::Output> outputs(pass.colorOutputs);
+				outputs.insert(outputs.end(), pass.depthStencilOutput.begin(), pass.depthStencilOutput.end());
+				bool keep = pass.sideEffects;
+				for (auto &output : outputs)
+				{
+					keep |= needed[output.resource];
+				}
+				pass.culled = !keep;
+				if (!keep)
+				{
+					continue;
+				}
+				// Cleared attachments don't depend on earlier contents, loaded ones do
+				for (auto &output : outputs)
+				{
+					needed[output.resource] = !isFirstWriter(i, output.resource);
+				}
+				for (auto &input : pass.textureInputs)
+				{
+					needed[input.resource] = true;
+				}
+			}
+		}
+
+		void collectUses()
+		{
+			for (auto &resource : resources)
+			{
+				resource.uses.clear();
+				resource.usage = 0;
+			}
+			for (uint32_t i = 0; i < passes.size(); i++)
+			{
+				Pass &pass = *passes[i];
+				if (pass.culled)
+				{
+					continue;
+				}
+				for (auto &output : pass.colorOutputs)
+				{
+					Use use = { i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, true };
+					resources[output.resource].uses.push_back(use);
+					resources[output.resource].usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+				}
+				for (auto &output : pass.depthStencilOutput)
+				{
+					Use use = { i, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, true };
+					resources[output.resource].uses.push_back(use);
+					resources[output.resource].usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+				}
+				for (auto &input : pass.textureInputs)
+				{
+					Use use = { i, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, input.stages, VK_ACCESS_SHADER_READ_BIT, false };
+					resources[input.resource].uses.push_back(use);
+					resources[input.resource].usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+				}
+			}
+			for (auto &resource : resources)
+			{
+				if (resource.externalRead && !resource.uses.empty())
+				{
+					Use use = { static_cast<uint32_t>(passes.size()), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, resource.externalStages, VK_ACCESS_SHADER_READ_BIT, false };
+					resource.uses.push_back(use);
+					resource.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+				}
+				// Attachments that only live inside of a single render pass never need to be backed by memory on tile based GPUs
+				resource.lazy = !resource.uses.empty() && (resource.uses.front().pass == resource.uses.back().pass) && !(resource.usage & VK_IMAGE_USAGE_SAMPLED_BIT);
+				if (resource.lazy)
+				{
+					resource.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+				}
+			}
+		}
+
+		void createImages(uint32_t width, uint32_t height)
+		{
+			for (auto &resource : resources)
+			{
+				if (resource.uses.empty())
+				{
+					continue;
+				}
+				resource.extent.width = (resource.info.width > 0) ? resource.info.width : std::max(static_cast<uint32_t>(width * resource.info.sizeScale), 1u);
+				resource.extent.height = (resource.info.height > 0) ? resource.info.height : std::max(static_cast<uint32_t>(height * resource.info.sizeScale), 1u);
+
+				VkImageCreateInfo imageCreateInfo = vks::initializers::imageCreateInfo();
+				imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+				imageCreateInfo.format = resource.info.format;
+				imageCreateInfo.extent = { resource.extent.width, resource.extent.height, 1 };
+				imageCreateInfo.mipLevels = 1;
+				imageCreateInfo.arrayLayers = resource.info.layerCount;
+				imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+				imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+				imageCreateInfo.usage = resource.usage;
+				imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				VK_CHECK_RESULT(vkCreateImage(device->logicalDevice, &imageCreateInfo, nullptr, &resource.image));
+				vkGetImageMemoryRequirements(device->logicalDevice, resource.image, &resource.memReqs);
+				stats.requiredBytes += resource.memReqs.size;
+				stats.attachmentCount++;
+			}
+		}
+
+		// Assign the attachments to memory ranges, attachments whose lifetimes (first to last use) don't overlap share a range
+		void assignMemory()
+		{
+			VkBool32 lazyMemory = VK_FALSE;
+			std::vector<ResourceHandle> order;
+			for (uint32_t i = 0; i < resources.size(); i++)
+			{
+				Resource &resource = resources[i];
+				if (resource.uses.empty())
+				{
+					continue;
+				}
+				if (resource.lazy)
+				{
+					device->getMemoryType(resource.memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, &lazyMemory);
+					if (lazyMemory)
+					{
+						// Lazily allocated attachments get memory of their own that (ideally) is never committed
+						MemoryRange range;
+						range.memReqs = resource.memReqs;
+						range.resources.push_back(i);
+						resource.range = static_cast<uint32_t>(memoryRanges.size());
+						memoryRanges.push_back(range);
+						stats.lazyAttachmentCount++;
+						continue;
+					}
+					resource.lazy = false;
+				}
+				order.push_back(i);
+			}
+
+			// Largest attachments first, so smaller ones fill up the ranges they create
+			std::sort(order.begin(), order.end(), [this](ResourceHandle a, ResourceHandle b) { return resources[a].memReqs.size > resources[b].memReqs.size; });
+			size_t firstShared = memoryRanges.size();
+			for (auto handle : order)
+			{
+				Resource &resource = resources[handle];
+				bool placed = false;
+				for (size_t i = firstShared; i < memoryRanges.size() && !placed; i++)
+				{
+					MemoryRange &range = memoryRanges[i];
+					if ((range.memReqs.memoryTypeBits & resource.memReqs.memoryTypeBits) == 0)
+					{
+						continue;
+					}
+					bool overlaps = false;
+					for (auto other : range.resources)
+					{
+						overlaps |= (resource.firstPass() <= resources[other].lastPass()) && (resources[other].firstPass() <= resource.lastPass());
+					}
+					if (overlaps)
+					{
+						continue;
+					}
+					range.memReqs.size = std::max(range.memReqs.size, resource.memReqs.size);
+					range.memReqs.alignment = std::max(range.memReqs.alignment, resource.memReqs.alignment);
+					range.memReqs.memoryTypeBits &= resource.memReqs.memoryTypeBits;
+					range.resources.push_back(handle);
+					resource.range = static_cast<uint32_t>(i);
+					placed = true;
+				}
+				if (!placed)
+				{
+					MemoryRange range;
+					range.memReqs = resource.memReqs;
+					range.resources.push_back(handle);
+					resource.range = static_cast<uint32_t>(memoryRanges.size());
+					memoryRanges.push_back(range);
+				}
+			}
+
+			for (auto &range : memoryRanges)
+			{
+				Resource &first = resources[range.resources.front()];
+				VkMemoryPropertyFlags memoryProperties = first.lazy ? VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+				VK_CHECK_RESULT(device->allocateMemory(range.memReqs, memoryProperties, false, &range.allocation));
+				stats.allocatedBytes += range.memReqs.size;
+				if (!first.lazy)
+				{
+					stats.memoryRangeCount++;
+				}
+
+				// The first use of an attachment has to wait for the last use of the attachment that used the memory before
+				// The first attachment of a range waits for the last one of the previous frame
+				std::sort(range.resources.begin(), range.resources.end(), [this](ResourceHandle a, ResourceHandle b) { return resources[a].firstPass() < resources[b].firstPass(); });
+				for (size_t i = 0; i < range.resources.size(); i++)
+				{
+					Resource &resource = resources[range.resources[i]];
+					Resource &previous = resources[range.resources[(i + range.resources.size() - 1) % range.resources.size()]];
+					resource.previousUse = previous.uses.back();
+					resource.aliased = (range.resources.size() > 1);
+					VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, resource.image, range.allocation.memory, range.allocation.offset));
+
+					VkImageViewCreateInfo viewCreateInfo = vks::initializers::imageViewCreateInfo();
+					viewCreateInfo.viewType = (resource.info.layerCount > 1) ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+					viewCreateInfo.format = resource.info.format;
+					// Sampled depth stencil attachments are read through their depth aspect
+					VkImageAspectFlags aspectMask = ((resource.usage & VK_IMAGE_USAGE_SAMPLED_BIT) && isDepthFormat(resource.info.format)) ? VK_IMAGE_ASPECT_DEPTH_BIT : getAspectMask(resource.info.format);
+					viewCreateInfo.subresourceRange = { aspectMask, 0, 1, 0, resource.info.layerCount };
+					viewCreateInfo.image = resource.image;
+					VK_CHECK_RESULT(vkCreateImageView(device->logicalDevice, &viewCreateInfo, nullptr, &resource.view));
+				}
+			}
+		}
+
+		// Add the barrier a use of an attachment requires, previous is the use before it (in this or the previous frame)
+		void addBarrier(Resource &resource, const Use &previous, const Use &use, bool discard, std::vector<VkImageMemoryBarrier> &barriers, std::vector<VkMemoryBarrier> &memoryBarriers, VkPipelineStageFlags &srcStageMask, VkPipelineStageFlags &dstStageMask)
+		{
+			// Reads of the same layout don't depend on each other
+			if (!discard && !previous.write && !use.write && (previous.layout == use.layout))
+			{
+				return;
+			}
+			// Only writes have to be made available, reads only need an execution dependency
+			VkAccessFlags previousWrites = previous.write ? previous.access & (VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT) : 0;
+			bool aliased = discard && resource.aliased;
+			if (aliased && (previousWrites != 0))
+			{
+				// The previous writes were made through another image, an image barrier on this one doesn't make them available
+				VkMemoryBarrier memoryBarrier = vks::initializers::memoryBarrier();
+				memoryBarrier.srcAccessMask = previousWrites;
+				memoryBarrier.dstAccessMask = use.access;
+				memoryBarriers.push_back(memoryBarrier);
+			}
+			VkImageMemoryBarrier barrier = vks::initializers::imageMemoryBarrier();
+			barrier.srcAccessMask = aliased ? 0 : previousWrites;
+			barrier.dstAccessMask = use.access;
+			// Contents of attachments aren't kept between frames (or in memory shared with other attachments)
+			barrier.oldLayout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : previous.layout;
+			barrier.newLayout = use.layout;
+			barrier.image = resource.image;
+			barrier.subresourceRange = { getAspectMask(resource.info.format), 0, 1, 0, resource.info.layerCount };
+			barriers.push_back(barrier);
+			srcStageMask |= previous.stages;
+			dstStageMask |= use.stages;
+		}
+
+		void computeBarriers()
+		{
+			for (auto &resource : resources)
+			{
+				for (size_t i = 0; i < resource.uses.size(); i++)
+				{
+					const Use &use = resource.uses[i];
+					bool discard = (i == 0);
+					const Use &previous = discard ? resource.previousUse : resource.uses[i - 1];
+					if (use.pass == passes.size())
+					{
+						addBarrier(resource, previous, use, discard, finalBarriers, finalMemoryBarriers, finalSrcStageMask, finalDstStageMask);
+					}
+					else
+					{
+						Pass &pass = *passes[use.pass];
+						addBarrier(resource, previous, use, discard, pass.barriers, pass.memoryBarriers, pass.srcStageMask, pass.dstStageMask);
+					}
+				}
+			}
+			for (auto &pass : passes)
+			{
+				if (!pass->barriers.empty())
+				{
+					stats.barrierBatchCount++;
+					stats.imageBarrierCount += static_cast<uint32_t>(pass->barriers.size());
+					stats.memoryBarrierCount += static_cast<uint32_t>(pass->memoryBarriers.size());
+				}
+			}
+			if (!finalBarriers.empty())
+			{
+				stats.barrierBatchCount++;
+				stats.imageBarrierCount += static_cast<uint32_t>(finalBarriers.size());
+				stats.memoryBarrierCount += static_cast<uint32_t>(finalMemoryBarriers.size());
+			}
+		}
+
+		// Returns true if the contents of an attachment written by a pass are used after the pass
+		bool isReadLater(const Resource &resource, uint32_t passIndex)
+		{
+			return resource.uses.back().pass > passIndex;
+		}
+
+		void createRenderPasses()
+		{
+			for (uint32_t p = 0; p < passes.size(); p++)
+			{
+				Pass &pass = *passes[p];
+				if (pass.culled)
+				{
+					continue;
+				}
+				std::vector<VkAttachmentDescription> attachmentDescriptions;
+				std::vector<VkAttachmentReference> colorReferences;
+				VkAttachmentReference depthReference = {};
+				std::vector<VkImageView> views;
+				pass.clearValues.clear();
+
+				std::vector<Pass::Output> outputs(pass.colorOutputs);
+				outputs.insert(outputs.end(), pass.depthStencilOutput.begin(), pass.depthStencilOutput.end());
+				for (size_t i = 0; i < outputs.size(); i++)
+				{
+					Resource &resource = resources[outputs[i].resource];
+					bool depth = isDepthFormat(resource.info.format);
+					VkImageLayout layout = depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+					VkAttachmentLoadOp loadOp = isFirstWriter(p, outputs[i].resource) ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+					VkAttachmentStoreOp storeOp = isReadLater(resource, p) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+					VkAttachmentDescription attachmentDescription = {};
+					attachmentDescription.format = resource.info.format;
+					attachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
+					attachmentDescription.loadOp = loadOp;
+					attachmentDescription.storeOp = storeOp;
+					attachmentDescription.stencilLoadOp = (getAspectMask(resource.info.format) & VK_IMAGE_ASPECT_STENCIL_BIT) ? loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+					attachmentDescription.stencilStoreOp = (getAspectMask(resource.info.format) & VK_IMAGE_ASPECT_STENCIL_BIT) ? storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+					// Layout transitions are done by the graph's barriers
+					attachmentDescription.initialLayout = layout;
+					attachmentDescription.finalLayout = layout;
+					attachmentDescriptions.push_back(attachmentDescription);
+
+					VkAttachmentReference reference = { static_cast<uint32_t>(i), layout };
+					if (depth)
+					{
+						depthReference = reference;
+					}
+					else
+					{
+						colorReferences.push_back(reference);
+					}
+					views.push_back(resource.view);
+					pass.clearValues.push_back(outputs[i].clearValue);
+					// All attachments of a framebuffer must have the same size and number of layers
+					assert((i == 0) || ((pass.extent.width == resource.extent.width) && (pass.extent.height == resource.extent.height) && (pass.layers == resource.info.layerCount)));
+					pass.extent = resource.extent;
+					pass.layers = resource.info.layerCount;
+				}
+
+				VkSubpassDescription subpassDescription = {};
+				subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+				subpassDescription.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+				subpassDescription.pColorAttachments = colorReferences.data();
+				subpassDescription.pDepthStencilAttachment = pass.depthStencilOutput.empty() ? nullptr : &depthReference;
+
+				VkRenderPassCreateInfo renderPassInfo = {};
+				renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+				renderPassInfo.attachmentCount = static_cast<uint32_t>(attachmentDescriptions.size());
+				renderPassInfo.pAttachments = attachmentDescriptions.data();
+				renderPassInfo.subpassCount = 1;
+				renderPassInfo.pSubpasses = &subpassDescription;
+				VK_CHECK_RESULT(vkCreateRenderPass(device->logicalDevice, &renderPassInfo, nullptr, &pass.renderPass));
+
+				VkFramebufferCreateInfo framebufferCreateInfo = vks::initializers::framebufferCreateInfo();
+				framebufferCreateInfo.renderPass = pass.renderPass;
+				framebufferCreateInfo.attachmentCount = static_cast<uint32_t>(views.size());
+				framebufferCreateInfo.pAttachments = views.data();
+				framebufferCreateInfo.width = pass.extent.width;
+				framebufferCreateInfo.height = pass.extent.height;
+				framebufferCreateInfo.layers = pass.layers;
+				VK_CHECK_RESULT(vkCreateFramebuffer(device->logicalDevice, &framebufferCreateInfo, nullptr, &pass.framebuffer));
+			}
+		}
+
+		// Destroy everything created by compile()
+		void release()
+		{
+			if (!device)
+			{
+				return;
+			}
+			for (auto &pass : passes)
+			{
+				if (pass->framebuffer)
+				{
+					vkDestroyFramebuffer(device->logicalDevice, pass->framebuffer, nullptr);
+				}
+				if (pass->renderPass)
+				{
+					vkDestroyRenderPass(device->logicalDevice, pass->renderPass, nullptr);
+				}
+				pass->framebuffer = VK_NULL_HANDLE;
+				pass->renderPass = VK_NULL_HANDLE;
+				pass->barriers.clear();
+				pass->memoryBarriers.clear();
+				pass->srcStageMask = 0;
+				pass->dstStageMask = 0;
+			}
+			for (auto &resource : resources)
+			{
+				if (resource.view)
+				{
+					vkDestroyImageView(device->logicalDevice, resource.view, nullptr);
+				}
+				if (resource.image)
+				{
+					vkDestroyImage(device->logicalDevice, resource.image, nullptr);
+				}
+				resource.view = VK_NULL_HANDLE;
+				resource.image = VK_NULL_HANDLE;
+				resource.range = UINT32_MAX;
+			}
+			for (auto &range : memoryRanges)
+			{
+				range.allocation.free();
+			}
+			memoryRanges.clear();
+			finalBarriers.clear();
+			finalMemoryBarriers.clear();
+			finalSrcStageMask = 0;
+			finalDstStageMask = 0;
+			stats = Stats();
+		}
+
+	public:
+		/**
+		* Prepare the graph for use
+		*
+		* @param device Vulkan device the attachments are created on
+		*/
+		void create(vks::VulkanDevice *device)
+		{
+			this->device = device;
+		}
+
+		/**
+		* Add an attachment to the graph
+		*
+		* @param name Name of the attachment (for statistics and debugging)
+		* @param info Format and size of the attachment
+		*
+		* @return Handle of the attachment
+		*/
+		ResourceHandle addAttachment(const std::string &name, const AttachmentInfo &info)
+		{
+			Resource resource;
+			resource.name = name;
+			resource.info = info;
+			resources.push_back(resource);
+			return static_cast<ResourceHandle>(resources.size() - 1);
+		}
+
+		/**
+		* Add a pass to the graph, passes are executed in the order they have been added
+		*
+		* @param name Name of the pass
+		*
+		* @return Reference to the pass to declare its inputs and outputs and set its record function with, stays valid for the lifetime of the graph
+		*/
+		Pass &addPass(const std::string &name)
+		{
+			std::unique_ptr<Pass> pass(new Pass);
+			pass->name = name;
+			passes.push_back(std::move(pass));
+			return *passes.back();
+		}
+
+		/**
+		* Mark an attachment as read after the graph has been executed (e.g. by the example's final pass)
+		*
+		* @param resource Attachment that is sampled after the graph
+		* @param (Optional) stages Shader stages that sample the attachment (defaults to the fragment shader)
+		*
+		* @note Externally read attachments are the roots the graph is culled from, they are transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL after the last pass
+		*/
+		void addExternalRead(ResourceHandle resource, VkPipelineStageFlags stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
+		{
+			resources[resource].externalRead = true;
+			resources[resource].externalStages |= stages;
+		}
+
+		/**
+		* Stop reading an attachment after the graph, takes effect on the next compilation
+		*
+		* @param resource Attachment that is no longer sampled after the graph
+		*
+		* @note Attachments that are neither read externally nor by a later pass only live as long as the passes using them and may share their memory, attachments that aren't used at all aren't created
+		*/
+		void removeExternalRead(ResourceHandle resource)
+		{
+			resources[resource].externalRead = false;
+			resources[resource].externalStages = 0;
+		}
+
+		/**
+		* Cull passes, create the attachments, render passes and framebuffers and compute the barriers
+		*
+		* @param width Width the relative attachment sizes refer to (usually the window width)
+		* @param height Height the relative attachment sizes refer to (usually the window height)
+		*
+		* @note Recompiling (e.g. after a resize) recreates the render passes and attachments, descriptors sampling the attachments have to be updated
+		* @note Pipelines stay usable as long as the attachment formats of their pass don't change, the recreated render passes are compatible with the previous ones
+		* @note The device must not use any of the graph's resources anymore when recompiling
+		*/
+		void compile(uint32_t width, uint32_t height)
+		{
+			assert(device);
+			release();
+			cullPasses();
+			collectUses();
+			createImages(width, height);
+			assignMemory();
+			computeBarriers();
+			createRenderPasses();
+			for (auto &pass : passes)
+			{
+				stats.passCount++;
+				if (pass->culled)
+				{
+					stats.culledPassCount++;
+				}
+			}
+		}
+
+		/**
+		* Record all passes that haven't been culled into a command buffer
+		*
+		* @param commandBuffer Command buffer to record to, must be outside of a render pass
+		*/
+		void execute(VkCommandBuffer commandBuffer)
+		{
+			for (auto &pass : passes)
+			{
+				if (pass->culled)
+				{
+					continue;
+				}
+				if (!pass->barriers.empty())
+				{
+					vkCmdPipelineBarrier(commandBuffer, pass->srcStageMask, pass->dstStageMask, 0, static_cast<uint32_t>(pass->memoryBarriers.size()), pass->memoryBarriers.data(), 0, nullptr, static_cast<uint32_t>(pass->barriers.size()), pass->barriers.data());
+				}
+
+				VkRenderPassBeginInfo renderPassBeginInfo = vks::initializers::renderPassBeginInfo();
+				renderPassBeginInfo.renderPass = pass->renderPass;
+				renderPassBeginInfo.framebuffer = pass->framebuffer;
+				renderPassBeginInfo.renderArea.extent = pass->extent;
+				renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(pass->clearValues.size());
+				renderPassBeginInfo.pClearValues = pass->clearValues.data();
+				vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+				VkViewport viewport = vks::initializers::viewport((float)pass->extent.width, (float)pass->extent.height, 0.0f, 1.0f);
+				vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+				VkRect2D scissor = vks::initializers::rect2D(pass->extent.width, pass->extent.height, 0, 0);
+				vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+				if (pass->record)
+				{
+					pass->record(commandBuffer);
+				}
+
+				vkCmdEndRenderPass(commandBuffer);
+			}
+			if (!finalBarriers.empty())
+			{
+				vkCmdPipelineBarrier(commandBuffer, finalSrcStageMask, finalDstStageMask, 0, static_cast<uint32_t>(finalMemoryBarriers.size()), finalMemoryBarriers.data(), 0, nullptr, static_cast<uint32_t>(finalBarriers.size()), finalBarriers.data());
+			}
+		}
+
+		/** @brief Image view of an attachment (valid after compile) */
+		VkImageView getView(ResourceHandle resource)
+		{
+			return resources[resource].view;
+		}
+
+		/**
+		* Get a descriptor for sampling an attachment
+		*
+		* @param resource Attachment that is sampled
+		* @param sampler Sampler to use
+		*/
+		VkDescriptorImageInfo getDescriptor(ResourceHandle resource, VkSampler sampler)
+		{
+			VkDescriptorImageInfo descriptor;
+			descriptor.sampler = sampler;
+			descriptor.imageView = resources[resource].view;
+			descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			return descriptor;
+		}
+
+		/** @brief Get the statistics of the last compilation */
+		Stats getStats()
+		{
+			return stats;
+		}
+
+		/** @brief Print the statistics of the last compilation */
+		void printStats()
+		{
+			std::cout << "Render graph statistics:" << std::endl;
+			std::cout << "\t" << stats.passCount - stats.culledPassCount << " of " << stats.passCount << " passes executed" << std::endl;
+			for (auto &pass : passes)
+			{
+				if (pass->culled)
+				{
+					std::cout << "\t\tCulled \"" << pass->name << "\"" << std::endl;
+				}
+			}
+			std::cout << "\t" << stats.attachmentCount << " attachments (" << stats.lazyAttachmentCount << " lazily allocated) in " << stats.memoryRangeCount << " shared memory ranges, "
+				<< std::fixed << std::setprecision(2) << (double)stats.allocatedBytes / (1024.0 * 1024.0) << " of " << (double)stats.requiredBytes / (1024.0 * 1024.0) << " MB allocated" << std::endl;
+			std::cout << "\t" << stats.imageBarrierCount << " image and " << stats.memoryBarrierCount << " memory barriers in " << stats.barrierBatchCount << " pipeline barriers" << std::endl;
+		}
+
+		/** @brief Destroy all resources of the graph, the graph's passes and attachments are kept so it can be compiled again */
+		void destroy()
+		{
+			release();
+			for (auto &pass : passes)
+			{
+				pass->culled = false;
+			}
+		}
+	};
+}
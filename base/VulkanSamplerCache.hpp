@@ -0,0 +1,232 @@
+/*
+* Vulkan sampler cache
+*
+* Shares sampler objects between all resources created with the same sampler state
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <array>
+#include <unordered_map>
+#include <mutex>
+#include <cstring>
+#include <iostream>
+#include <assert.h>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+
+namespace vks
+{
+	/**
+	* @brief Reference counted cache of sampler objects, keyed by their create info
+	*
+	* Most textures are sampled with one of a handful of sampler states, so instead of creating a sampler per texture
+	* all users of the same state share one sampler object. This keeps the number of samplers far below the device's
+	* maxSamplerAllocationCount, even for scenes with hundreds of materials.
+	* Samplers are destroyed once the last reference has been released.
+	*
+	* @note Thread safe, textures may be loaded on several threads at once
+	*/
+	class SamplerCache
+	{
+	public:
+		/** @brief Cache statistics */
+		struct Stats
+		{
+			/** @brief Number of sampler objects currently alive */
+			uint32_t samplerCount = 0;
+			/** @brief Number of references held to these samplers */
+			uint32_t referenceCount = 0;
+			/** @brief Number of samplers requested over the cache's lifetime */
+			uint32_t requestCount = 0;
+			/** @brief Number of requests that got an existing sampler */
+			uint32_t hitCount = 0;
+		};
+
+	private:
+		// Sampler state packed into words, all fields of VkSamplerCreateInfo except for sType and pNext
+		typedef std::array<uint32_t, 16> Key;
+
+		struct KeyHash
+		{
+			size_t operator()(const Key &key) const
+			{
+				// FNV-1a
+				uint64_t hash = 14695981039346656037ULL;
+				for (auto word : key)
+				{
+					hash ^= word;
+					hash *= 1099511628211ULL;
+				}
+				return static_cast<size_t>(hash);
+			}
+		};
+
+		struct Entry
+		{
+			VkSampler sampler;
+			uint32_t references;
+		};
+
+		VkDevice device = VK_NULL_HANDLE;
+		std::unordered_map<Key, Entry, KeyHash> entries;
+		std::unordered_map<VkSampler, Key> keys;
+		Stats stats;
+		std::mutex mutex;
+
+		static uint32_t floatBits(float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+
+		static Key getKey(const VkSamplerCreateInfo &createInfo)
+		{
+			// States that differ only in values the implementation ignores share a sampler
+			bool anisotropy = createInfo.anisotropyEnable == VK_TRUE;
+			bool compare = createInfo.compareEnable == VK_TRUE;
+			Key key = {{
+				createInfo.flags,
+				static_cast<uint32_t>(createInfo.magFilter),
+				static_cast<uint32_t>(createInfo.minFilter),
+				static_cast<uint32_t>(createInfo.mipmapMode),
+				static_cast<uint32_t>(createInfo.addressModeU),
+				static_cast<uint32_t>(createInfo.addressModeV),
+				static_cast<uint32_t>(createInfo.addressModeW),
+				floatBits(createInfo.mipLodBias),
+				anisotropy ? 1u : 0u,
+				anisotropy ? floatBits(createInfo.maxAnisotropy) : 0u,
+				compare ? 1u : 0u,
+				compare ? static_cast<uint32_t>(createInfo.compareOp) : 0u,
+				floatBits(createInfo.minLod),
+				floatBits(createInfo.maxLod),
+				static_cast<uint32_t>(createInfo.borderColor),
+				createInfo.unnormalizedCoordinates
+			}};
+			return key;
+		}
+
+	public:
+		/**
+		* Prepare the cache for use
+		*
+		* @param device Logical device the samplers are created on
+		*/
+		void create(VkDevice device)
+		{
+			this->device = device;
+		}
+
+		/**
+		* Get a sampler for the given state, creating it if no sampler with that state exists yet
+		*
+		* @param createInfo Sampler state
+		* @param sampler Pointer to the sampler handle that receives the shared sampler
+		*
+		* @note Each successful call adds a reference that has to be returned with release()
+		* @note Create infos with a pNext chain always get a sampler of their own, as the chained structures aren't part of the key
+		*
+		* @return VkResult of the sampler creation, VK_SUCCESS if an existing sampler has been returned
+		*/
+		VkResult acquire(const VkSamplerCreateInfo &createInfo, VkSampler *sampler)
+		{
+			assert(device);
+			if (createInfo.pNext)
+			{
+				return vkCreateSampler(device, &createInfo, nullptr, sampler);
+			}
+
+			Key key = getKey(createInfo);
+			std::lock_guard<std::mutex> lock(mutex);
+			stats.requestCount++;
+			auto entry = entries.find(key);
+			if (entry != entries.end())
+			{
+				entry->second.references++;
+				stats.referenceCount++;
+				stats.hitCount++;
+				*sampler = entry->second.sampler;
+				return VK_SUCCESS;
+			}
+
+			VkResult result = vkCreateSampler(device, &createInfo, nullptr, sampler);
+			if (result != VK_SUCCESS)
+			{
+				return result;
+			}
+			entries[key] = { *sampler, 1 };
+			keys[*sampler] = key;
+			stats.samplerCount++;
+			stats.referenceCount++;
+			return VK_SUCCESS;
+		}
+
+		/**
+		* Release a reference to a sampler, the sampler is destroyed with its last reference
+		*
+		* @param sampler Sampler returned by acquire()
+		*
+		* @note Samplers that haven't been created by the cache are destroyed right away, so resources may be handed samplers created by the application
+		*/
+		void release(VkSampler sampler)
+		{
+			if (sampler == VK_NULL_HANDLE)
+			{
+				return;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			auto key = keys.find(sampler);
+			if (key == keys.end())
+			{
+				vkDestroySampler(device, sampler, nullptr);
+				return;
+			}
+			auto entry = entries.find(key->second);
+			assert(entry != entries.end());
+			stats.referenceCount--;
+			if (--entry->second.references == 0)
+			{
+				vkDestroySampler(device, sampler, nullptr);
+				entries.erase(entry);
+				keys.erase(key);
+				stats.samplerCount--;
+			}
+		}
+
+		/** @brief Get the cache statistics */
+		Stats getStats()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return stats;
+		}
+
+		/** @brief Print the cache statistics */
+		void printStats()
+		{
+			Stats current = getStats();
+			std::cout << "Sampler cache statistics:" << std::endl;
+			std::cout << "\t" << current.samplerCount << " samplers shared by " << current.referenceCount << " references" << std::endl;
+			std::cout << "\t" << current.hitCount << " of " << current.requestCount << " requests used an existing sampler" << std::endl;
+		}
+
+		/** @brief Destroy all samplers that are still referenced */
+		void destroy()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (auto &entry : entries)
+			{
+				vkDestroySampler(device, entry.second.sampler, nullptr);
+			}
+			entries.clear();
+			keys.clear();
+			stats.samplerCount = 0;
+			stats.referenceCount = 0;
+		}
+	};
+}
@@ -16,6 +16,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <vector>
+#include <mutex>
 #ifdef _WIN32
 #include <windows.h>
 #include <fcntl.h>
@@ -25,6 +26,7 @@
 
 #include <vulkan/vulkan.h>
 #include "VulkanTools.h"
+#include "VulkanMemoryAllocator.hpp"
 
 #ifdef __ANDROID__
 #include "vulkanandroid.h"
@@ -61,7 +63,18 @@ private:
 	VkInstance instance;
 	VkDevice device;
 	VkPhysicalDevice physicalDevice;
-	VkSurfaceKHR surface;
+	VkSurfaceKHR surface = VK_NULL_HANDLE;
+	// Headless mode: Queue used to signal the acquire semaphores, memory backing the offscreen images and next image index
+	VkQueue headlessQueue = VK_NULL_HANDLE;
+	vks::MemoryAllocator *headlessAllocator = nullptr;
+	std::vector<vks::Allocation> headlessMemory;
+	uint32_t headlessImageIndex = 0;
+
+	// Locks the queue mutex if one has been set, the returned lock is empty otherwise
+	std::unique_lock<std::mutex> lockQueue()
+	{
+		return queueMutex ? std::unique_lock<std::mutex>(*queueMutex) : std::unique_lock<std::mutex>();
+	}
 	// Function pointers
 	PFN_vkGetPhysicalDeviceSurfaceSupportKHR fpGetPhysicalDeviceSurfaceSupportKHR;
 	PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR fpGetPhysicalDeviceSurfaceCapabilitiesKHR; 
@@ -83,6 +96,12 @@ public:
 	// Index of the deteced graphics and presenting device queue
 	/** @brief Queue family index of the detected graphics and presenting device queue */
 	uint32_t queueNodeIndex = UINT32_MAX;
+	/** @brief Set to true if the swap chain images are offscreen images without a surface (see initHeadless) */
+	bool headless = false;
+	/** @brief Layout the images have to be in after rendering, offscreen images are left in transfer source layout as VK_KHR_swapchain isn't enabled in headless mode */
+	VkImageLayout presentLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	/** @brief (Optional) Mutex locked around all queue operations of the swap chain, required if other threads submit to the same queue (e.g. the device's queueMutex) */
+	std::mutex *queueMutex = nullptr;
 
 	// Creates an os specific surface
 	/**
@@ -279,6 +298,11 @@ public:
 		this->instance = instance;
 		this->physicalDevice = physicalDevice;
 		this->device = device;
+		// Surface and swapchain functions are not required (and may not be available) without a window
+		if (headless)
+		{
+			return;
+		}
 		GET_INSTANCE_PROC_ADDR(instance, GetPhysicalDeviceSurfaceSupportKHR);
 		GET_INSTANCE_PROC_ADDR(instance, GetPhysicalDeviceSurfaceCapabilitiesKHR);
 		GET_INSTANCE_PROC_ADDR(instance, GetPhysicalDeviceSurfaceFormatsKHR);
@@ -299,6 +323,12 @@ public:
 	*/
 	void create(uint32_t *width, uint32_t *height, bool vsync = false)
 	{
+		if (headless)
+		{
+			createHeadless(*width, *height);
+			return;
+		}
+
 		VkResult err;
 		VkSwapchainKHR oldSwapchain = swapChain;
 
@@ -482,11 +512,28 @@ public:
 	* @param imageIndex Pointer to the image index that will be increased if the next image could be acquired
 	*
 	* @note The function will always wait until the next image has been acquired by setting timeout to UINT64_MAX
+	* @note Headless mode submits to the queue passed to initHeadless and locks queueMutex if set, so the caller must not hold it
 	*
 	* @return VkResult of the image acquisition
 	*/
 	VkResult acquireNextImage(VkSemaphore presentCompleteSemaphore, uint32_t *imageIndex)
 	{
+		if (headless)
+		{
+			// Offscreen images are used in a fixed round robin order
+			*imageIndex = headlessImageIndex;
+			headlessImageIndex = (headlessImageIndex + 1) % imageCount;
+			// Signal the semaphore with an empty submission, so callers can wait on it like for a real swap chain image
+			if (presentCompleteSemaphore == VK_NULL_HANDLE)
+			{
+				return VK_SUCCESS;
+			}
+			VkSubmitInfo submitInfo = vks::initializers::submitInfo();
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &presentCompleteSemaphore;
+			std::unique_lock<std::mutex> lock = lockQueue();
+			return vkQueueSubmit(headlessQueue, 1, &submitInfo, VK_NULL_HANDLE);
+		}
 		// By setting timeout to UINT64_MAX we will always wait until the next image has been acquired or an actual error is thrown
 		// With that we don't have to handle VK_NOT_READY
 		return fpAcquireNextImageKHR(device, swapChain, UINT64_MAX, presentCompleteSemaphore, (VkFence)nullptr, imageIndex);
@@ -499,10 +546,27 @@ public:
 	* @param imageIndex Index of the swapchain image to queue for presentation
 	* @param waitSemaphore (Optional) Semaphore that is waited on before the image is presented (only used if != VK_NULL_HANDLE)
 	*
+	* @note Locks queueMutex if set, so the caller must not hold it
+	*
 	* @return VkResult of the queue presentation
 	*/
 	VkResult queuePresent(VkQueue queue, uint32_t imageIndex, VkSemaphore waitSemaphore = VK_NULL_HANDLE)
 	{
+		if (headless)
+		{
+			// Nothing to present, but the wait semaphore needs to be unsignaled again for the next frame
+			if (waitSemaphore == VK_NULL_HANDLE)
+			{
+				return VK_SUCCESS;
+			}
+			VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			VkSubmitInfo submitInfo = vks::initializers::submitInfo();
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &waitSemaphore;
+			submitInfo.pWaitDstStageMask = &waitStageMask;
+			std::unique_lock<std::mutex> lock = lockQueue();
+			return vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		}
 		VkPresentInfoKHR presentInfo = {};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 		presentInfo.pNext = NULL;
@@ -515,6 +579,7 @@ public:
 			presentInfo.pWaitSemaphores = &waitSemaphore;
 			presentInfo.waitSemaphoreCount = 1;
 		}
+		std::unique_lock<std::mutex> lock = lockQueue();
 		return fpQueuePresentKHR(queue, &presentInfo);
 	}
 
@@ -524,6 +589,11 @@ public:
 	*/
 	void cleanup()
 	{
+		if (headless)
+		{
+			destroyHeadlessImages();
+			return;
+		}
 		if (swapChain != VK_NULL_HANDLE)
 		{
 			for (uint32_t i = 0; i < imageCount; i++)
@@ -540,6 +610,118 @@ public:
 		swapChain = VK_NULL_HANDLE;
 	}
 
+	/**
+	* Use a ring of offscreen images instead of a surface based swap chain (e.g. for rendering on machines without a display)
+	*
+	* @param queue Queue used to signal the semaphores passed to acquireNextImage
+	* @param queueFamilyIndex Family index of the graphics queue
+	* @param allocator Memory allocator the offscreen images are allocated from
+	* @param format (Optional) Color format of the offscreen images (defaults to VK_FORMAT_B8G8R8A8_UNORM, the most common swap chain format)
+	* @param imageCount (Optional) Number of offscreen images (defaults to 3)
+	*
+	* @note Must be called after connect and before create, width and height passed to create are used as the image extent
+	* @note Falls back to VK_FORMAT_R8G8B8A8_UNORM if the device can't render to and copy from images of the requested format
+	*/
+	void initHeadless(VkQueue queue, uint32_t queueFamilyIndex, vks::MemoryAllocator *allocator, VkFormat format = VK_FORMAT_B8G8R8A8_UNORM, uint32_t imageCount = 3)
+	{
+		assert(headless);
+		headlessQueue = queue;
+		headlessAllocator = allocator;
+		queueNodeIndex = queueFamilyIndex;
+		// The images are rendered to and read back for frame capture
+		std::vector<VkFormat> formatList = { format, VK_FORMAT_R8G8B8A8_UNORM };
+		colorFormat = VK_FORMAT_UNDEFINED;
+		for (auto& candidate : formatList)
+		{
+			VkFormatProperties formatProps;
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, candidate, &formatProps);
+			// Transfer source support is only reported with VK_KHR_maintenance1, blit source support implies it
+			if ((formatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT) &&
+				(formatProps.optimalTilingFeatures & (VK_FORMAT_FEATURE_TRANSFER_SRC_BIT_KHR | VK_FORMAT_FEATURE_BLIT_SRC_BIT)))
+			{
+				colorFormat = candidate;
+				break;
+			}
+		}
+		if (colorFormat == VK_FORMAT_UNDEFINED)
+		{
+			vks::tools::exitFatal("Could not find a supported color format for the offscreen images!", "Fatal error");
+		}
+		colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+		presentLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		this->imageCount = imageCount;
+	}
+
+	/**
+	* Create the offscreen images and image views used in headless mode
+	*/
+	void createHeadless(uint32_t width, uint32_t height)
+	{
+		destroyHeadlessImages();
+
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+		images.resize(imageCount);
+		buffers.resize(imageCount);
+		headlessMemory.resize(imageCount);
+		headlessImageIndex = 0;
+
+		for (uint32_t i = 0; i < imageCount; i++)
+		{
+			VkImageCreateInfo imageCI = vks::initializers::imageCreateInfo();
+			imageCI.imageType = VK_IMAGE_TYPE_2D;
+			imageCI.format = colorFormat;
+			imageCI.extent = { width, height, 1 };
+			imageCI.mipLevels = 1;
+			imageCI.arrayLayers = 1;
+			imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+			// Transfer source is required for reading back rendered frames
+			imageCI.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VK_CHECK_RESULT(vkCreateImage(device, &imageCI, nullptr, &images[i]));
+
+			VkMemoryRequirements memReqs;
+			vkGetImageMemoryRequirements(device, images[i], &memReqs);
+			uint32_t memoryTypeIndex = UINT32_MAX;
+			for (uint32_t j = 0; j < memoryProperties.memoryTypeCount; j++)
+			{
+				if ((memReqs.memoryTypeBits & (1 << j)) && (memoryProperties.memoryTypes[j].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+				{
+					memoryTypeIndex = j;
+					break;
+				}
+			}
+			assert(memoryTypeIndex != UINT32_MAX);
+			VK_CHECK_RESULT(headlessAllocator->allocate(memReqs, memoryTypeIndex, false, &headlessMemory[i]));
+			VK_CHECK_RESULT(vkBindImageMemory(device, images[i], headlessMemory[i].memory, headlessMemory[i].offset));
+
+			VkImageViewCreateInfo colorAttachmentView = vks::initializers::imageViewCreateInfo();
+			colorAttachmentView.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			colorAttachmentView.format = colorFormat;
+			colorAttachmentView.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
+			colorAttachmentView.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			colorAttachmentView.image = images[i];
+			VK_CHECK_RESULT(vkCreateImageView(device, &colorAttachmentView, nullptr, &buffers[i].view));
+			buffers[i].image = images[i];
+		}
+	}
+
+	/**
+	* Destroy the offscreen images used in headless mode
+	*/
+	void destroyHeadlessImages()
+	{
+		for (size_t i = 0; i < headlessMemory.size(); i++)
+		{
+			vkDestroyImageView(device, buffers[i].view, nullptr);
+			vkDestroyImage(device, images[i], nullptr);
+			headlessMemory[i].free();
+		}
+		headlessMemory.clear();
+	}
+
 #if defined(_DIRECT2DISPLAY)
 	/**
 	* Create direct to display surface
@@ -51,6 +51,7 @@ private:
 	VkQueue queue;
 	VkFormat colorFormat;
 	VkFormat depthFormat;
+	VkImageLayout finalLayout;
 
 	uint32_t *frameBufferWidth;
 	uint32_t *frameBufferHeight;
@@ -59,7 +60,7 @@ private:
 	VkImage image;
 	VkImageView view;
 	vks::Buffer vertexBuffer;
-	VkDeviceMemory imageMemory;
+	vks::Allocation imageMemory;
 	VkDescriptorPool descriptorPool;
 	VkDescriptorSetLayout descriptorSetLayout;
 	VkDescriptorSet descriptorSet;
@@ -102,12 +103,14 @@ public:
 		VkFormat depthformat,
 		uint32_t *framebufferwidth,
 		uint32_t *framebufferheight,
-		std::vector<VkPipelineShaderStageCreateInfo> shaderstages)
+		std::vector<VkPipelineShaderStageCreateInfo> shaderstages,
+		VkImageLayout finallayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
 	{
 		this->vulkanDevice = vulkanDevice;
 		this->queue = queue;
 		this->colorFormat = colorformat;
 		this->depthFormat = depthformat;
+		this->finalLayout = finallayout;
 
 		this->frameBuffers.resize(framebuffers.size());
 		for (uint32_t i = 0; i < framebuffers.size(); i++)
@@ -153,7 +156,7 @@ public:
 		vkDestroySampler(vulkanDevice->logicalDevice, sampler, nullptr);
 		vkDestroyImage(vulkanDevice->logicalDevice, image, nullptr);
 		vkDestroyImageView(vulkanDevice->logicalDevice, view, nullptr);
-		vkFreeMemory(vulkanDevice->logicalDevice, imageMemory, nullptr);
+		imageMemory.free();
 		vkDestroyDescriptorSetLayout(vulkanDevice->logicalDevice, descriptorSetLayout, nullptr);
 		vkDestroyDescriptorPool(vulkanDevice->logicalDevice, descriptorPool, nullptr);
 		vkDestroyPipelineLayout(vulkanDevice->logicalDevice, pipelineLayout, nullptr);
@@ -218,12 +221,9 @@ public:
 		VK_CHECK_RESULT(vkCreateImage(vulkanDevice->logicalDevice, &imageInfo, nullptr, &image));
 
 		VkMemoryRequirements memReqs;
-		VkMemoryAllocateInfo allocInfo = vks::initializers::memoryAllocateInfo();
 		vkGetImageMemoryRequirements(vulkanDevice->logicalDevice, image, &memReqs);
-		allocInfo.allocationSize = memReqs.size;
-		allocInfo.memoryTypeIndex = vulkanDevice->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-		VK_CHECK_RESULT(vkAllocateMemory(vulkanDevice->logicalDevice, &allocInfo, nullptr, &imageMemory));
-		VK_CHECK_RESULT(vkBindImageMemory(vulkanDevice->logicalDevice, image, imageMemory, 0));
+		VK_CHECK_RESULT(vulkanDevice->allocateMemory(memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, &imageMemory));
+		VK_CHECK_RESULT(vkBindImageMemory(vulkanDevice->logicalDevice, image, imageMemory.memory, imageMemory.offset));
 
 		// Staging
 		vks::Buffer stagingBuffer;
@@ -232,7 +232,7 @@ public:
 			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 			&stagingBuffer,
-			allocInfo.allocationSize));
+			memReqs.size));
 
 		stagingBuffer.map();
 		memcpy(stagingBuffer.mapped, &font24pixels[0][0], STB_FONT_WIDTH * STB_FONT_HEIGHT);	// Only one channel, so data size = W * H (*R8)
@@ -488,7 +488,7 @@ public:
 		attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		attachments[0].finalLayout = finalLayout;
 
 		// Depth attachment
 		attachments[1].format = depthFormat;
@@ -20,6 +20,7 @@
 #include "VulkanTools.h"
 #include "VulkanDevice.hpp"
 #include "VulkanBuffer.hpp"
+#include "VulkanTextureFile.hpp"
 
 #if defined(__ANDROID__)
 #include <android/asset_manager.h>
@@ -33,16 +34,25 @@ namespace vks
 		vks::VulkanDevice *device;
 		VkImage image;
 		VkImageLayout imageLayout;
-		VkDeviceMemory deviceMemory;
+		/** @brief Device memory range (memory object and offset) the image is bound to */
+		vks::Allocation allocation;
 		VkImageView view;
 		uint32_t width, height;
 		uint32_t mipLevels;
 		uint32_t layerCount;
 		VkDescriptorImageInfo descriptor;
+		/** @brief Token of the upload batch that fills the image (staged textures only) */
+		vks::UploadToken uploadToken;
 
-		/** @brief Optional sampler to use with this texture */
+		/** @brief Optional sampler to use with this texture, samplers created by the loaders are shared through the device's sampler cache */
 		VkSampler sampler;
 
+		/** @brief Format and view type of textures whose mip levels are uploaded separately (see createForStreaming) */
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D;
+		/** @brief First mip level of the view, larger than zero while the more detailed levels of a streamed texture haven't arrived yet */
+		uint32_t baseMipLevel = 0;
+
 		/** @brief Update image descriptor from current sampler, view and image layout */
 		void updateDescriptor()
 		{
@@ -51,6 +61,113 @@ namespace vks
 			descriptor.imageLayout = imageLayout;
 		}
 
+		/**
+		* Create an optimal tiled image and a sampler for all mip levels of a texture file without uploading any image data
+		* The levels are then uploaded with uploadLevels() and made visible with setBaseMipLevel(), e.g. to stream the smallest levels first
+		*
+		* @param file Opened texture file (2D or cube map)
+		* @param format Vulkan format of the image data stored in the file
+		* @param viewType VK_IMAGE_VIEW_TYPE_2D or VK_IMAGE_VIEW_TYPE_CUBE
+		* @param device Vulkan device to create the texture on
+		* @param (Optional) imageUsageFlags Usage flags for the texture's image (defaults to VK_IMAGE_USAGE_SAMPLED_BIT)
+		* @param (Optional) imageLayout Usage layout for the texture (defaults VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		*
+		* @note No view is created until the first call to setBaseMipLevel()
+		*/
+		void createForStreaming(const vks::TextureFile &file, VkFormat format, VkImageViewType viewType, vks::VulkanDevice *device, VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		{
+			assert((viewType == VK_IMAGE_VIEW_TYPE_2D) || ((viewType == VK_IMAGE_VIEW_TYPE_CUBE) && (file.layerCount == 6)));
+
+			this->device = device;
+			this->format = format;
+			this->viewType = viewType;
+			this->imageLayout = imageLayout;
+			width = file.width;
+			height = file.height;
+			mipLevels = file.levelCount;
+			layerCount = (viewType == VK_IMAGE_VIEW_TYPE_CUBE) ? 6 : 1;
+			baseMipLevel = mipLevels;
+			view = VK_NULL_HANDLE;
+
+			VkImageCreateInfo imageCreateInfo = vks::initializers::imageCreateInfo();
+			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageCreateInfo.format = format;
+			imageCreateInfo.mipLevels = mipLevels;
+			imageCreateInfo.arrayLayers = layerCount;
+			imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			imageCreateInfo.extent = { width, height, 1 };
+			imageCreateInfo.usage = imageUsageFlags | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			imageCreateInfo.flags = (viewType == VK_IMAGE_VIEW_TYPE_CUBE) ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+			VK_CHECK_RESULT(vkCreateImage(device->logicalDevice, &imageCreateInfo, nullptr, &image));
+
+			VkMemoryRequirements memReqs;
+			vkGetImageMemoryRequirements(device->logicalDevice, image, &memReqs);
+			VK_CHECK_RESULT(device->allocateMemory(memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, &allocation));
+			VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, allocation.memory, allocation.offset));
+
+			// LOD is relative to the first level of the view, so the sampler covers the whole chain
+			VkSamplerCreateInfo samplerCreateInfo = vks::initializers::samplerCreateInfo();
+			samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+			samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+			samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+			samplerCreateInfo.addressModeU = (viewType == VK_IMAGE_VIEW_TYPE_CUBE) ? VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE : VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			samplerCreateInfo.addressModeV = samplerCreateInfo.addressModeU;
+			samplerCreateInfo.addressModeW = samplerCreateInfo.addressModeU;
+			samplerCreateInfo.mipLodBias = 0.0f;
+			samplerCreateInfo.maxAnisotropy = 1.0f;
+			samplerCreateInfo.compareOp = VK_COMPARE_OP_NEVER;
+			samplerCreateInfo.minLod = 0.0f;
+			samplerCreateInfo.maxLod = (float)mipLevels;
+			samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+			VK_CHECK_RESULT(device->samplerCache.acquire(samplerCreateInfo, &sampler));
+		}
+
+		/**
+		* Upload a range of mip levels of a texture created with createForStreaming()
+		*
+		* @param file Texture file the texture has been created from, must stay open until the function returns
+		* @param baseLevel First mip level to upload
+		* @param levelCount Number of mip levels to upload
+		*
+		* @return Token of the upload batch, the levels can be made visible with setBaseMipLevel() once it has completed
+		*/
+		vks::UploadToken uploadLevels(const vks::TextureFile &file, uint32_t baseLevel, uint32_t levelCount)
+		{
+			std::vector<VkBufferImageCopy> regions;
+			VkDeviceSize stagingSize = file.getLevelCopyRegions(baseLevel, levelCount, regions, layerCount);
+			VkImageSubresourceRange subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, levelCount, 0, layerCount };
+			return device->uploadQueue.uploadImage(image, format, stagingSize, regions, subresourceRange, imageLayout, [&](uint8_t *staging) { file.copyLevelsTo(staging, baseLevel, levelCount, layerCount); });
+		}
+
+		/**
+		* Recreate the view of a texture created with createForStreaming() so it starts at the given mip level
+		* Restricting the view clamps the sampled LOD to the levels that have arrived, the levels above it are never accessed
+		*
+		* @param level Most detailed mip level whose data (and that of all smaller levels) has been uploaded
+		*
+		* @note The previous view is destroyed, so it must not be in use by the GPU anymore
+		*/
+		void setBaseMipLevel(uint32_t level)
+		{
+			assert(level < mipLevels);
+			if (view != VK_NULL_HANDLE)
+			{
+				vkDestroyImageView(device->logicalDevice, view, nullptr);
+			}
+			baseMipLevel = level;
+			VkImageViewCreateInfo viewCreateInfo = vks::initializers::imageViewCreateInfo();
+			viewCreateInfo.viewType = viewType;
+			viewCreateInfo.format = format;
+			viewCreateInfo.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
+			viewCreateInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, mipLevels - level, 0, layerCount };
+			viewCreateInfo.image = image;
+			VK_CHECK_RESULT(vkCreateImageView(device->logicalDevice, &viewCreateInfo, nullptr, &view));
+			updateDescriptor();
+		}
+
 		/** @brief Release all Vulkan resources held by this texture */
 		void destroy()
 		{
@@ -58,9 +175,10 @@ namespace vks
 			vkDestroyImage(device->logicalDevice, image, nullptr);
 			if (sampler)
 			{
-				vkDestroySampler(device->logicalDevice, sampler, nullptr);
+				device->samplerCache.release(sampler);
+				sampler = VK_NULL_HANDLE;
 			}
-			vkFreeMemory(device->logicalDevice, deviceMemory, nullptr);
+			allocation.free();
 		}
 	};
 
@@ -73,7 +191,7 @@ namespace vks
 		* @param filename File to load (supports .ktx and .dds)
 		* @param format Vulkan format of the image data stored in the file
 		* @param device Vulkan device to create the texture on
-		* @param copyQueue Queue used for the texture staging copy commands (must support transfer)
+		* @param copyQueue Queue used for the layout transition of linear tiled textures, staged textures are uploaded through the device's upload queue
 		* @param (Optional) imageUsageFlags Usage flags for the texture's image (defaults to VK_IMAGE_USAGE_SAMPLED_BIT)
 		* @param (Optional) imageLayout Usage layout for the texture (defaults VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
 		* @param (Optional) forceLinear Force linear tiling (not advised, defaults to false)
@@ -88,30 +206,17 @@ namespace vks
 			VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 
 			bool forceLinear = false)
 		{
-#if defined(__ANDROID__)
-			// Textures are stored inside the apk on Android (compressed)
-			// So they need to be loaded via the asset manager
-			AAsset* asset = AAssetManager_open(androidApp->activity->assetManager, filename.c_str(), AASSET_MODE_STREAMING);
-			assert(asset);
-			size_t size = AAsset_getLength(asset);
-			assert(size > 0);
-
-			void *textureData = malloc(size);
-			AAsset_read(asset, textureData, size);
-			AAsset_close(asset);
-
-			gli::texture2d tex2D(gli::load((const char*)textureData, size));
-
-			free(textureData);
-#else
-			gli::texture2d tex2D(gli::load(filename.c_str()));
-#endif		
-			assert(!tex2D.empty());
+			// KTX files are read through a memory mapping and copied straight into staging memory
+			vks::TextureFile file;
+			if (!file.open(filename, format))
+			{
+				vks::tools::exitFatal("Could not load texture from " + filename, "File not found");
+			}
 
 			this->device = device;
-			width = static_cast<uint32_t>(tex2D[0].extent().x);
-			height = static_cast<uint32_t>(tex2D[0].extent().y);
-			mipLevels = static_cast<uint32_t>(tex2D.levels());
+			width = file.width;
+			height = file.height;
+			mipLevels = file.levelCount;
 
 			// Get device properites for the requested texture format
 			VkFormatProperties formatProperties;
@@ -124,62 +229,12 @@ namespace vks
 			// limited amount of formats and features (mip maps, cubemaps, arrays, etc.)
 			VkBool32 useStaging = !forceLinear;
 
-			VkMemoryAllocateInfo memAllocInfo = vks::initializers::memoryAllocateInfo();
 			VkMemoryRequirements memReqs;
 
-			// Use a separate command buffer for texture loading
-			VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
 			if (useStaging)
 			{
-				// Create a host-visible staging buffer that contains the raw image data
-				VkBuffer stagingBuffer;
-				VkDeviceMemory stagingMemory;
-
-				VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo();
-				bufferCreateInfo.size = tex2D.size();
-				// This buffer is used as a transfer source for the buffer copy
-				bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-				bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-				VK_CHECK_RESULT(vkCreateBuffer(device->logicalDevice, &bufferCreateInfo, nullptr, &stagingBuffer));
-
-				// Get memory requirements for the staging buffer (alignment, memory type bits)
-				vkGetBufferMemoryRequirements(device->logicalDevice, stagingBuffer, &memReqs);
-
-				memAllocInfo.allocationSize = memReqs.size;
-				// Get memory type index for a host visible buffer
-				memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-				VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &stagingMemory));
-				VK_CHECK_RESULT(vkBindBufferMemory(device->logicalDevice, stagingBuffer, stagingMemory, 0));
-
-				// Copy texture data into staging buffer
-				uint8_t *data;
-				VK_CHECK_RESULT(vkMapMemory(device->logicalDevice, stagingMemory, 0, memReqs.size, 0, (void **)&data));
-				memcpy(data, tex2D.data(), tex2D.size());
-				vkUnmapMemory(device->logicalDevice, stagingMemory);
-
-				// Setup buffer copy regions for each mip level
-				std::vector<VkBufferImageCopy> bufferCopyRegions;
-				uint32_t offset = 0;
-
-				for (uint32_t i = 0; i < mipLevels; i++)
-				{
-					VkBufferImageCopy bufferCopyRegion = {};
-					bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-					bufferCopyRegion.imageSubresource.mipLevel = i;
-					bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
-					bufferCopyRegion.imageSubresource.layerCount = 1;
-					bufferCopyRegion.imageExtent.width = static_cast<uint32_t>(tex2D[i].extent().x);
-					bufferCopyRegion.imageExtent.height = static_cast<uint32_t>(tex2D[i].extent().y);
-					bufferCopyRegion.imageExtent.depth = 1;
-					bufferCopyRegion.bufferOffset = offset;
-
-					bufferCopyRegions.push_back(bufferCopyRegion);
-
-					offset += static_cast<uint32_t>(tex2D[i].size());
-				}
+				// Setup buffer copy regions for each mip level of the first layer
+				std::vector<VkBufferImageCopy> bufferCopyRegions = file.getCopyRegions(1);
 
 				// Create optimal tiled target image
 				VkImageCreateInfo imageCreateInfo = vks::initializers::imageCreateInfo();
@@ -202,11 +257,8 @@ namespace vks
 
 				vkGetImageMemoryRequirements(device->logicalDevice, image, &memReqs);
 
-				memAllocInfo.allocationSize = memReqs.size;
-
-				memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-				VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &deviceMemory));
-				VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, deviceMemory, 0));
+				VK_CHECK_RESULT(device->allocateMemory(memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, &allocation));
+				VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, allocation.memory, allocation.offset));
 
 				VkImageSubresourceRange subresourceRange = {};
 				subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -214,41 +266,10 @@ namespace vks
 				subresourceRange.levelCount = mipLevels;
 				subresourceRange.layerCount = 1;
 
-				// Image barrier for optimal image (target)
-				// Optimal image will be used as destination for the copy
-				vks::tools::setImageLayout(
-					copyCmd,
-					image,
-					VK_IMAGE_ASPECT_COLOR_BIT,
-					VK_IMAGE_LAYOUT_UNDEFINED,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					subresourceRange);
-
-				// Copy mip levels from staging buffer
-				vkCmdCopyBufferToImage(
-					copyCmd,
-					stagingBuffer,
-					image,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					static_cast<uint32_t>(bufferCopyRegions.size()),
-					bufferCopyRegions.data()
-				);
-
-				// Change texture image layout to shader read after all mip levels have been copied
+				// Stage all mip levels through the upload queue's staging ring
+				// The copies and layout transitions are batched with other uploads and submitted later on
 				this->imageLayout = imageLayout;
-				vks::tools::setImageLayout(
-					copyCmd,
-					image,
-					VK_IMAGE_ASPECT_COLOR_BIT,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					imageLayout,
-					subresourceRange);
-
-				device->flushCommandBuffer(copyCmd, copyQueue);
-
-				// Clean up staging resources
-				vkFreeMemory(device->logicalDevice, stagingMemory, nullptr);
-				vkDestroyBuffer(device->logicalDevice, stagingBuffer, nullptr);
+				uploadToken = device->uploadQueue.uploadImage(image, format, file.stagingSize, bufferCopyRegions, subresourceRange, imageLayout, [&file](uint8_t *staging) { file.copyTo(staging); });
 			}
 			else
 			{
@@ -260,7 +281,6 @@ namespace vks
 				assert(formatProperties.linearTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
 
 				VkImage mappableImage;
-				VkDeviceMemory mappableMemory;
 
 				VkImageCreateInfo imageCreateInfo = vks::initializers::imageCreateInfo();
 				imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -280,17 +300,12 @@ namespace vks
 				// Get memory requirements for this image 
 				// like size and alignment
 				vkGetImageMemoryRequirements(device->logicalDevice, mappableImage, &memReqs);
-				// Set memory allocation size to required memory size
-				memAllocInfo.allocationSize = memReqs.size;
-
-				// Get memory type that can be mapped to host memory
-				memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-				// Allocate host memory
-				VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &mappableMemory));
+				// Allocate memory that can be mapped to host memory (linear tiled images can share blocks with buffers)
+				VK_CHECK_RESULT(device->allocateMemory(memReqs, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, true, &allocation));
 
 				// Bind allocated image for use
-				VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, mappableImage, mappableMemory, 0));
+				VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, mappableImage, allocation.memory, allocation.offset));
 
 				// Get sub resource layout
 				// Mip map count, array layer, etc.
@@ -305,21 +320,20 @@ namespace vks
 				// Includes row pitch, size offsets, etc.
 				vkGetImageSubresourceLayout(device->logicalDevice, mappableImage, &subRes, &subResLayout);
 
-				// Map image memory
-				VK_CHECK_RESULT(vkMapMemory(device->logicalDevice, mappableMemory, 0, memReqs.size, 0, &data));
+				// Image memory is host visible and persistently mapped by the allocator
+				data = allocation.mapped;
 
 				// Copy image data into memory
-				memcpy(data, tex2D[subRes.mipLevel].data(), tex2D[subRes.mipLevel].size());
-
-				vkUnmapMemory(device->logicalDevice, mappableMemory);
+				const vks::TextureFile::Subresource *subresource = file.getSubresource(subRes.mipLevel, 0);
+				memcpy(data, subresource->data, static_cast<size_t>(subresource->size));
 
 				// Linear tiled images don't need to be staged
 				// and can be directly used as textures
 				image = mappableImage;
-				deviceMemory = mappableMemory;
 				imageLayout = imageLayout;
 
 				// Setup image memory barrier
+				VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
 				vks::tools::setImageLayout(copyCmd, image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, imageLayout);
 
 				device->flushCommandBuffer(copyCmd, copyQueue);
@@ -343,7 +357,7 @@ namespace vks
 			samplerCreateInfo.maxAnisotropy = 8;
 			samplerCreateInfo.anisotropyEnable = VK_TRUE;
 			samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-			VK_CHECK_RESULT(vkCreateSampler(device->logicalDevice, &samplerCreateInfo, nullptr, &sampler));
+			VK_CHECK_RESULT(device->samplerCache.acquire(samplerCreateInfo, &sampler));
 
 			// Create image view
 			// Textures are not directly accessed by the shaders and
@@ -374,7 +388,7 @@ namespace vks
 		* @param height Height of the texture to create
 		* @param format Vulkan format of the image data stored in the file
 		* @param device Vulkan device to create the texture on
-		* @param copyQueue Queue used for the texture staging copy commands (must support transfer)
+		* @param copyQueue Ignored, the image data is uploaded through the device's upload queue (kept for source compatibility)
 		* @param (Optional) filter Texture filtering for the sampler (defaults to VK_FILTER_LINEAR)
 		* @param (Optional) imageUsageFlags Usage flags for the texture's image (defaults to VK_IMAGE_USAGE_SAMPLED_BIT)
 		* @param (Optional) imageLayout Usage layout for the texture (defaults VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
@@ -386,7 +400,7 @@ namespace vks
 			uint32_t width,
 			uint32_t height,
 			vks::VulkanDevice *device,
-			VkQueue copyQueue,
+			VkQueue /*copyQueue*/,
 			VkFilter filter = VK_FILTER_LINEAR,
 			VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
 			VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
@@ -398,40 +412,8 @@ namespace vks
 			height = height;
 			mipLevels = 1;
 
-			VkMemoryAllocateInfo memAllocInfo = vks::initializers::memoryAllocateInfo();
 			VkMemoryRequirements memReqs;
 
-			// Use a separate command buffer for texture loading
-			VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-			// Create a host-visible staging buffer that contains the raw image data
-			VkBuffer stagingBuffer;
-			VkDeviceMemory stagingMemory;
-
-			VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo();
-			bufferCreateInfo.size = bufferSize;
-			// This buffer is used as a transfer source for the buffer copy
-			bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-			bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-			VK_CHECK_RESULT(vkCreateBuffer(device->logicalDevice, &bufferCreateInfo, nullptr, &stagingBuffer));
-
-			// Get memory requirements for the staging buffer (alignment, memory type bits)
-			vkGetBufferMemoryRequirements(device->logicalDevice, stagingBuffer, &memReqs);
-
-			memAllocInfo.allocationSize = memReqs.size;
-			// Get memory type index for a host visible buffer
-			memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-			VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &stagingMemory));
-			VK_CHECK_RESULT(vkBindBufferMemory(device->logicalDevice, stagingBuffer, stagingMemory, 0));
-
-			// Copy texture data into staging buffer
-			uint8_t *data;
-			VK_CHECK_RESULT(vkMapMemory(device->logicalDevice, stagingMemory, 0, memReqs.size, 0, (void **)&data));
-			memcpy(data, buffer, bufferSize);
-			vkUnmapMemory(device->logicalDevice, stagingMemory);
-
 			VkBufferImageCopy bufferCopyRegion = {};
 			bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 			bufferCopyRegion.imageSubresource.mipLevel = 0;
@@ -463,11 +445,8 @@ namespace vks
 
 			vkGetImageMemoryRequirements(device->logicalDevice, image, &memReqs);
 
-			memAllocInfo.allocationSize = memReqs.size;
-
-			memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-			VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &deviceMemory));
-			VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, deviceMemory, 0));
+			VK_CHECK_RESULT(device->allocateMemory(memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, &allocation));
+			VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, allocation.memory, allocation.offset));
 
 			VkImageSubresourceRange subresourceRange = {};
 			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -475,41 +454,9 @@ namespace vks
 			subresourceRange.levelCount = mipLevels;
 			subresourceRange.layerCount = 1;
 
-			// Image barrier for optimal image (target)
-			// Optimal image will be used as destination for the copy
-			vks::tools::setImageLayout(
-				copyCmd,
-				image,
-				VK_IMAGE_ASPECT_COLOR_BIT,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				subresourceRange);
-
-			// Copy mip levels from staging buffer
-			vkCmdCopyBufferToImage(
-				copyCmd,
-				stagingBuffer,
-				image,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				1,
-				&bufferCopyRegion
-			);
-
-			// Change texture image layout to shader read after all mip levels have been copied
+			// Stage the image data through the upload queue
 			this->imageLayout = imageLayout;
-			vks::tools::setImageLayout(
-				copyCmd,
-				image,
-				VK_IMAGE_ASPECT_COLOR_BIT,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				imageLayout,
-				subresourceRange);
-
-			device->flushCommandBuffer(copyCmd, copyQueue);
-
-			// Clean up staging resources
-			vkFreeMemory(device->logicalDevice, stagingMemory, nullptr);
-			vkDestroyBuffer(device->logicalDevice, stagingBuffer, nullptr);
+			uploadToken = device->uploadQueue.uploadImage(image, format, buffer, bufferSize, { bufferCopyRegion }, subresourceRange, imageLayout);
 
 			// Create sampler
 			VkSamplerCreateInfo samplerCreateInfo = {};
@@ -524,7 +471,7 @@ namespace vks
 			samplerCreateInfo.compareOp = VK_COMPARE_OP_NEVER;
 			samplerCreateInfo.minLod = 0.0f;
 			samplerCreateInfo.maxLod = 0.0f;
-			VK_CHECK_RESULT(vkCreateSampler(device->logicalDevice, &samplerCreateInfo, nullptr, &sampler));
+			VK_CHECK_RESULT(device->samplerCache.acquire(samplerCreateInfo, &sampler));
 
 			// Create image view
 			VkImageViewCreateInfo viewCreateInfo = {};
@@ -553,7 +500,7 @@ namespace vks
 		* @param filename File to load (supports .ktx and .dds)
 		* @param format Vulkan format of the image data stored in the file
 		* @param device Vulkan device to create the texture on
-		* @param copyQueue Queue used for the texture staging copy commands (must support transfer)
+		* @param copyQueue Ignored, the image data is uploaded through the device's upload queue (kept for source compatibility)
 		* @param (Optional) imageUsageFlags Usage flags for the texture's image (defaults to VK_IMAGE_USAGE_SAMPLED_BIT)
 		* @param (Optional) imageLayout Usage layout for the texture (defaults VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
 		*
@@ -562,92 +509,27 @@ namespace vks
 			std::string filename,
 			VkFormat format,
 			vks::VulkanDevice *device,
-			VkQueue copyQueue,
+			VkQueue /*copyQueue*/,
 			VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
 			VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
 		{
-#if defined(__ANDROID__)
-			// Textures are stored inside the apk on Android (compressed)
-			// So they need to be loaded via the asset manager
-			AAsset* asset = AAssetManager_open(androidApp->activity->assetManager, filename.c_str(), AASSET_MODE_STREAMING);
-			assert(asset);
-			size_t size = AAsset_getLength(asset);
-			assert(size > 0);
-
-			void *textureData = malloc(size);
-			AAsset_read(asset, textureData, size);
-			AAsset_close(asset);
-
-			gli::texture2d_array tex2DArray(gli::load((const char*)textureData, size));
-
-			free(textureData);
-#else
-			gli::texture2d_array tex2DArray(gli::load(filename));
-#endif	
-
-			assert(!tex2DArray.empty());
+			// KTX files are read through a memory mapping and copied straight into staging memory
+			vks::TextureFile file;
+			if (!file.open(filename, format))
+			{
+				vks::tools::exitFatal("Could not load texture from " + filename, "File not found");
+			}
 
 			this->device = device;
-			width = static_cast<uint32_t>(tex2DArray.extent().x);
-			height = static_cast<uint32_t>(tex2DArray.extent().y);
-			layerCount = static_cast<uint32_t>(tex2DArray.layers());
-			mipLevels = static_cast<uint32_t>(tex2DArray.levels());
+			width = file.width;
+			height = file.height;
+			layerCount = file.layerCount;
+			mipLevels = file.levelCount;
 
-			VkMemoryAllocateInfo memAllocInfo = vks::initializers::memoryAllocateInfo();
 			VkMemoryRequirements memReqs;
 
-			// Create a host-visible staging buffer that contains the raw image data
-			VkBuffer stagingBuffer;
-			VkDeviceMemory stagingMemory;
-
-			VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo();
-			bufferCreateInfo.size = tex2DArray.size();
-			// This buffer is used as a transfer source for the buffer copy
-			bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-			bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-			VK_CHECK_RESULT(vkCreateBuffer(device->logicalDevice, &bufferCreateInfo, nullptr, &stagingBuffer));
-
-			// Get memory requirements for the staging buffer (alignment, memory type bits)
-			vkGetBufferMemoryRequirements(device->logicalDevice, stagingBuffer, &memReqs);
-
-			memAllocInfo.allocationSize = memReqs.size;
-			// Get memory type index for a host visible buffer
-			memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-			VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &stagingMemory));
-			VK_CHECK_RESULT(vkBindBufferMemory(device->logicalDevice, stagingBuffer, stagingMemory, 0));
-
-			// Copy texture data into staging buffer
-			uint8_t *data;
-			VK_CHECK_RESULT(vkMapMemory(device->logicalDevice, stagingMemory, 0, memReqs.size, 0, (void **)&data));
-			memcpy(data, tex2DArray.data(), static_cast<size_t>(tex2DArray.size()));
-			vkUnmapMemory(device->logicalDevice, stagingMemory);
-
 			// Setup buffer copy regions for each layer including all of it's miplevels
-			std::vector<VkBufferImageCopy> bufferCopyRegions;
-			size_t offset = 0;
-
-			for (uint32_t layer = 0; layer < layerCount; layer++)
-			{
-				for (uint32_t level = 0; level < mipLevels; level++)
-				{
-					VkBufferImageCopy bufferCopyRegion = {};
-					bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-					bufferCopyRegion.imageSubresource.mipLevel = level;
-					bufferCopyRegion.imageSubresource.baseArrayLayer = layer;
-					bufferCopyRegion.imageSubresource.layerCount = 1;
-					bufferCopyRegion.imageExtent.width = static_cast<uint32_t>(tex2DArray[layer][level].extent().x);
-					bufferCopyRegion.imageExtent.height = static_cast<uint32_t>(tex2DArray[layer][level].extent().y);
-					bufferCopyRegion.imageExtent.depth = 1;
-					bufferCopyRegion.bufferOffset = offset;
-
-					bufferCopyRegions.push_back(bufferCopyRegion);
-
-					// Increase offset into staging buffer for next level / face
-					offset += tex2DArray[layer][level].size();
-				}
-			}
+			std::vector<VkBufferImageCopy> bufferCopyRegions = file.getCopyRegions();
 
 			// Create optimal tiled target image
 			VkImageCreateInfo imageCreateInfo = vks::initializers::imageCreateInfo();
@@ -671,51 +553,19 @@ namespace vks
 
 			vkGetImageMemoryRequirements(device->logicalDevice, image, &memReqs);
 
-			memAllocInfo.allocationSize = memReqs.size;
-			memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-			VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &deviceMemory));
-			VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, deviceMemory, 0));
+			VK_CHECK_RESULT(device->allocateMemory(memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, &allocation));
+			VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, allocation.memory, allocation.offset));
 
-			// Use a separate command buffer for texture loading
-			VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-			// Image barrier for optimal image (target)
-			// Set initial layout for all array layers (faces) of the optimal (target) tiled texture
+			// Set up the subresource range covering all array layers (faces) and mip levels
 			VkImageSubresourceRange subresourceRange = {};
 			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 			subresourceRange.baseMipLevel = 0;
 			subresourceRange.levelCount = mipLevels;
 			subresourceRange.layerCount = layerCount;
 
-			vks::tools::setImageLayout(
-				copyCmd,
-				image,
-				VK_IMAGE_ASPECT_COLOR_BIT,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				subresourceRange);
-
-			// Copy the layers and mip levels from the staging buffer to the optimal tiled image
-			vkCmdCopyBufferToImage(
-				copyCmd,
-				stagingBuffer,
-				image,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				static_cast<uint32_t>(bufferCopyRegions.size()),
-				bufferCopyRegions.data());
-
-			// Change texture image layout to shader read after all faces have been copied
+			// Stage all layers and mip levels through the upload queue
 			this->imageLayout = imageLayout;
-			vks::tools::setImageLayout(
-				copyCmd,
-				image,
-				VK_IMAGE_ASPECT_COLOR_BIT,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				imageLayout,
-				subresourceRange);
-
-			device->flushCommandBuffer(copyCmd, copyQueue);
+			uploadToken = device->uploadQueue.uploadImage(image, format, file.stagingSize, bufferCopyRegions, subresourceRange, imageLayout, [&file](uint8_t *staging) { file.copyTo(staging); });
 
 			// Create sampler
 			VkSamplerCreateInfo samplerCreateInfo = vks::initializers::samplerCreateInfo();
@@ -731,7 +581,7 @@ namespace vks
 			samplerCreateInfo.minLod = 0.0f;
 			samplerCreateInfo.maxLod = (float)mipLevels;
 			samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-			VK_CHECK_RESULT(vkCreateSampler(device->logicalDevice, &samplerCreateInfo, nullptr, &sampler));
+			VK_CHECK_RESULT(device->samplerCache.acquire(samplerCreateInfo, &sampler));
 
 			// Create image view
 			VkImageViewCreateInfo viewCreateInfo = vks::initializers::imageViewCreateInfo();
@@ -744,10 +594,6 @@ namespace vks
 			viewCreateInfo.image = image;
 			VK_CHECK_RESULT(vkCreateImageView(device->logicalDevice, &viewCreateInfo, nullptr, &view));
 
-			// Clean up staging resources
-			vkFreeMemory(device->logicalDevice, stagingMemory, nullptr);
-			vkDestroyBuffer(device->logicalDevice, stagingBuffer, nullptr);
-
 			// Update descriptor image info member that can be used for setting up descriptor sets
 			updateDescriptor();
 		}
@@ -762,7 +608,7 @@ namespace vks
 		* @param filename File to load (supports .ktx and .dds)
 		* @param format Vulkan format of the image data stored in the file
 		* @param device Vulkan device to create the texture on
-		* @param copyQueue Queue used for the texture staging copy commands (must support transfer)
+		* @param copyQueue Ignored, the image data is uploaded through the device's upload queue (kept for source compatibility)
 		* @param (Optional) imageUsageFlags Usage flags for the texture's image (defaults to VK_IMAGE_USAGE_SAMPLED_BIT)
 		* @param (Optional) imageLayout Usage layout for the texture (defaults VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
 		*
@@ -771,90 +617,26 @@ namespace vks
 			std::string filename,
 			VkFormat format,
 			vks::VulkanDevice *device,
-			VkQueue copyQueue,
+			VkQueue /*copyQueue*/,
 			VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
 			VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
 		{
-#if defined(__ANDROID__)
-			// Textures are stored inside the apk on Android (compressed)
-			// So they need to be loaded via the asset manager
-			AAsset* asset = AAssetManager_open(androidApp->activity->assetManager, filename.c_str(), AASSET_MODE_STREAMING);
-			assert(asset);
-			size_t size = AAsset_getLength(asset);
-			assert(size > 0);
-
-			void *textureData = malloc(size);
-			AAsset_read(asset, textureData, size);
-			AAsset_close(asset);
-
-			gli::texture_cube texCube(gli::load((const char*)textureData, size));
-
-			free(textureData);
-#else
-			gli::texture_cube texCube(gli::load(filename));
-#endif	
-			assert(!texCube.empty());
+			// KTX files are read through a memory mapping and copied straight into staging memory
+			vks::TextureFile file;
+			if (!file.open(filename, format) || (file.layerCount != 6))
+			{
+				vks::tools::exitFatal("Could not load cube map from " + filename, "File not found");
+			}
 
 			this->device = device;
-			width = static_cast<uint32_t>(texCube.extent().x);
-			height = static_cast<uint32_t>(texCube.extent().y);
-			mipLevels = static_cast<uint32_t>(texCube.levels());
+			width = file.width;
+			height = file.height;
+			mipLevels = file.levelCount;
 
-			VkMemoryAllocateInfo memAllocInfo = vks::initializers::memoryAllocateInfo();
 			VkMemoryRequirements memReqs;
 
-			// Create a host-visible staging buffer that contains the raw image data
-			VkBuffer stagingBuffer;
-			VkDeviceMemory stagingMemory;
-
-			VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo();
-			bufferCreateInfo.size = texCube.size();
-			// This buffer is used as a transfer source for the buffer copy
-			bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-			bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-			VK_CHECK_RESULT(vkCreateBuffer(device->logicalDevice, &bufferCreateInfo, nullptr, &stagingBuffer));
-
-			// Get memory requirements for the staging buffer (alignment, memory type bits)
-			vkGetBufferMemoryRequirements(device->logicalDevice, stagingBuffer, &memReqs);
-
-			memAllocInfo.allocationSize = memReqs.size;
-			// Get memory type index for a host visible buffer
-			memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-			VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &stagingMemory));
-			VK_CHECK_RESULT(vkBindBufferMemory(device->logicalDevice, stagingBuffer, stagingMemory, 0));
-
-			// Copy texture data into staging buffer
-			uint8_t *data;
-			VK_CHECK_RESULT(vkMapMemory(device->logicalDevice, stagingMemory, 0, memReqs.size, 0, (void **)&data));
-			memcpy(data, texCube.data(), texCube.size());
-			vkUnmapMemory(device->logicalDevice, stagingMemory);
-
 			// Setup buffer copy regions for each face including all of it's miplevels
-			std::vector<VkBufferImageCopy> bufferCopyRegions;
-			size_t offset = 0;
-
-			for (uint32_t face = 0; face < 6; face++)
-			{
-				for (uint32_t level = 0; level < mipLevels; level++)
-				{
-					VkBufferImageCopy bufferCopyRegion = {};
-					bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-					bufferCopyRegion.imageSubresource.mipLevel = level;
-					bufferCopyRegion.imageSubresource.baseArrayLayer = face;
-					bufferCopyRegion.imageSubresource.layerCount = 1;
-					bufferCopyRegion.imageExtent.width = static_cast<uint32_t>(texCube[face][level].extent().x);
-					bufferCopyRegion.imageExtent.height = static_cast<uint32_t>(texCube[face][level].extent().y);
-					bufferCopyRegion.imageExtent.depth = 1;
-					bufferCopyRegion.bufferOffset = offset;
-
-					bufferCopyRegions.push_back(bufferCopyRegion);
-
-					// Increase offset into staging buffer for next level / face
-					offset += texCube[face][level].size();
-				}
-			}
+			std::vector<VkBufferImageCopy> bufferCopyRegions = file.getCopyRegions();
 
 			// Create optimal tiled target image
 			VkImageCreateInfo imageCreateInfo = vks::initializers::imageCreateInfo();
@@ -882,51 +664,19 @@ namespace vks
 
 			vkGetImageMemoryRequirements(device->logicalDevice, image, &memReqs);
 
-			memAllocInfo.allocationSize = memReqs.size;
-			memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-			VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &deviceMemory));
-			VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, deviceMemory, 0));
-
-			// Use a separate command buffer for texture loading
-			VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+			VK_CHECK_RESULT(device->allocateMemory(memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, &allocation));
+			VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, allocation.memory, allocation.offset));
 
-			// Image barrier for optimal image (target)
-			// Set initial layout for all array layers (faces) of the optimal (target) tiled texture
+			// Set up the subresource range covering all array layers (faces) and mip levels
 			VkImageSubresourceRange subresourceRange = {};
 			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 			subresourceRange.baseMipLevel = 0;
 			subresourceRange.levelCount = mipLevels;
 			subresourceRange.layerCount = 6;
 
-			vks::tools::setImageLayout(
-				copyCmd,
-				image,
-				VK_IMAGE_ASPECT_COLOR_BIT,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				subresourceRange);
-
-			// Copy the cube map faces from the staging buffer to the optimal tiled image
-			vkCmdCopyBufferToImage(
-				copyCmd,
-				stagingBuffer,
-				image,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				static_cast<uint32_t>(bufferCopyRegions.size()),
-				bufferCopyRegions.data());
-
-			// Change texture image layout to shader read after all faces have been copied
+			// Stage all layers and mip levels through the upload queue
 			this->imageLayout = imageLayout;
-			vks::tools::setImageLayout(
-				copyCmd,
-				image,
-				VK_IMAGE_ASPECT_COLOR_BIT,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				imageLayout,
-				subresourceRange);
-
-			device->flushCommandBuffer(copyCmd, copyQueue);
+			uploadToken = device->uploadQueue.uploadImage(image, format, file.stagingSize, bufferCopyRegions, subresourceRange, imageLayout, [&file](uint8_t *staging) { file.copyTo(staging); });
 
 			// Create sampler
 			VkSamplerCreateInfo samplerCreateInfo = vks::initializers::samplerCreateInfo();
@@ -942,7 +692,7 @@ namespace vks
 			samplerCreateInfo.minLod = 0.0f;
 			samplerCreateInfo.maxLod = (float)mipLevels;
 			samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-			VK_CHECK_RESULT(vkCreateSampler(device->logicalDevice, &samplerCreateInfo, nullptr, &sampler));
+			VK_CHECK_RESULT(device->samplerCache.acquire(samplerCreateInfo, &sampler));
 
 			// Create image view
 			VkImageViewCreateInfo viewCreateInfo = vks::initializers::imageViewCreateInfo();
@@ -955,9 +705,110 @@ namespace vks
 			viewCreateInfo.image = image;
 			VK_CHECK_RESULT(vkCreateImageView(device->logicalDevice, &viewCreateInfo, nullptr, &view));
 
-			// Clean up staging resources
-			vkFreeMemory(device->logicalDevice, stagingMemory, nullptr);
-			vkDestroyBuffer(device->logicalDevice, stagingBuffer, nullptr);
+			// Update descriptor image info member that can be used for setting up descriptor sets
+			updateDescriptor();
+		}
+
+		/**
+		* Creates a cubemap texture with a single mip level from a buffer
+		*
+		* @param buffer Buffer containing the six faces (+X, -X, +Y, -Y, +Z, -Z) one after another
+		* @param bufferSize Size of the buffer in machine units, must be divisible by six
+		* @param format Vulkan format of the image data stored in the buffer
+		* @param size Width and height of the faces
+		* @param device Vulkan device to create the texture on
+		* @param copyQueue Ignored, the image data is uploaded through the device's upload queue (kept for source compatibility)
+		* @param (Optional) imageUsageFlags Usage flags for the texture's image (defaults to VK_IMAGE_USAGE_SAMPLED_BIT)
+		* @param (Optional) imageLayout Usage layout for the texture (defaults VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		*/
+		void fromBuffer(
+			void* buffer,
+			VkDeviceSize bufferSize,
+			VkFormat format,
+			uint32_t size,
+			vks::VulkanDevice *device,
+			VkQueue /*copyQueue*/,
+			VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
+			VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		{
+			assert(buffer);
+			assert(bufferSize % 6 == 0);
+
+			this->device = device;
+			width = size;
+			height = size;
+			mipLevels = 1;
+
+			VkMemoryRequirements memReqs;
+
+			std::vector<VkBufferImageCopy> bufferCopyRegions;
+			for (uint32_t face = 0; face < 6; face++)
+			{
+				VkBufferImageCopy bufferCopyRegion = {};
+				bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				bufferCopyRegion.imageSubresource.mipLevel = 0;
+				bufferCopyRegion.imageSubresource.baseArrayLayer = face;
+				bufferCopyRegion.imageSubresource.layerCount = 1;
+				bufferCopyRegion.imageExtent.width = size;
+				bufferCopyRegion.imageExtent.height = size;
+				bufferCopyRegion.imageExtent.depth = 1;
+				bufferCopyRegion.bufferOffset = face * (bufferSize / 6);
+				bufferCopyRegions.push_back(bufferCopyRegion);
+			}
+
+			// Create optimal tiled target image
+			VkImageCreateInfo imageCreateInfo = vks::initializers::imageCreateInfo();
+			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageCreateInfo.format = format;
+			imageCreateInfo.mipLevels = mipLevels;
+			imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			imageCreateInfo.extent = { width, height, 1 };
+			imageCreateInfo.usage = imageUsageFlags | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			imageCreateInfo.arrayLayers = 6;
+			imageCreateInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+			VK_CHECK_RESULT(vkCreateImage(device->logicalDevice, &imageCreateInfo, nullptr, &image));
+
+			vkGetImageMemoryRequirements(device->logicalDevice, image, &memReqs);
+
+			VK_CHECK_RESULT(device->allocateMemory(memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, &allocation));
+			VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, allocation.memory, allocation.offset));
+
+			VkImageSubresourceRange subresourceRange = {};
+			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			subresourceRange.baseMipLevel = 0;
+			subresourceRange.levelCount = mipLevels;
+			subresourceRange.layerCount = 6;
+
+			// Stage the faces through the upload queue
+			this->imageLayout = imageLayout;
+			uploadToken = device->uploadQueue.uploadImage(image, format, buffer, bufferSize, bufferCopyRegions, subresourceRange, imageLayout);
+
+			// Create sampler
+			VkSamplerCreateInfo samplerCreateInfo = vks::initializers::samplerCreateInfo();
+			samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+			samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+			samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+			samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+			samplerCreateInfo.addressModeV = samplerCreateInfo.addressModeU;
+			samplerCreateInfo.addressModeW = samplerCreateInfo.addressModeU;
+			samplerCreateInfo.compareOp = VK_COMPARE_OP_NEVER;
+			samplerCreateInfo.maxAnisotropy = 1.0f;
+			samplerCreateInfo.minLod = 0.0f;
+			samplerCreateInfo.maxLod = 0.0f;
+			samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+			VK_CHECK_RESULT(device->samplerCache.acquire(samplerCreateInfo, &sampler));
+
+			// Create image view
+			VkImageViewCreateInfo viewCreateInfo = vks::initializers::imageViewCreateInfo();
+			viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
+			viewCreateInfo.format = format;
+			viewCreateInfo.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
+			viewCreateInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 6 };
+			viewCreateInfo.image = image;
+			VK_CHECK_RESULT(vkCreateImageView(device->logicalDevice, &viewCreateInfo, nullptr, &view));
 
 			// Update descriptor image info member that can be used for setting up descriptor sets
 			updateDescriptor();
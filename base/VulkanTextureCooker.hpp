@@ -0,0 +1,266 @@
+/*
+* Vulkan texture cooker
+*
+* Block compresses uncompressed KTX textures at load time and caches the results on disk
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <functional>
+#include <cstdio>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "vulkan/vulkan.h"
+#include "VulkanDevice.hpp"
+#include "VulkanMeshCache.hpp"
+#include "VulkanTextureFile.hpp"
+#include "VulkanTextureEncoder.hpp"
+#include "jobsystem.hpp"
+
+namespace vks
+{
+	/**
+	* @brief Cooks compressed copies of uncompressed (RGBA8) KTX textures
+	*
+	* The first load of a texture encodes all of its mip levels, array layers and cube faces with the block compression encoder
+	* and writes them to a KTX file next to the source (on Android to the app's internal data path). Later loads read the cached file.
+	* Cached files are keyed by a hash of the source image data and the target format, so changing the source cooks a new file.
+	*/
+	namespace texturecooker
+	{
+		// Changing the encoder's output invalidates all cached files
+		const uint32_t encoderVersion = 1;
+
+		// OpenGL internal format of uncompressed sources in the KTX header
+		const uint32_t glInternalFormatRGBA8 = 0x8058;
+
+		/** @brief OpenGL internal and base internal format written to the KTX header of a compressed format */
+		inline bool getGlFormats(VkFormat format, uint32_t &internalFormat, uint32_t &baseInternalFormat)
+		{
+			const uint32_t red = 0x1903, rg = 0x8227, rgb = 0x1907, rgba = 0x1908;
+			switch (format)
+			{
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK: internalFormat = 0x83F0; baseInternalFormat = rgb; return true;
+			case VK_FORMAT_BC3_UNORM_BLOCK: internalFormat = 0x83F3; baseInternalFormat = rgba; return true;
+			case VK_FORMAT_BC4_UNORM_BLOCK: internalFormat = 0x8DBB; baseInternalFormat = red; return true;
+			case VK_FORMAT_BC5_UNORM_BLOCK: internalFormat = 0x8DBD; baseInternalFormat = rg; return true;
+			case VK_FORMAT_BC7_UNORM_BLOCK: internalFormat = 0x8E8C; baseInternalFormat = rgba; return true;
+			case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK: internalFormat = 0x9274; baseInternalFormat = rgb; return true;
+			case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK: internalFormat = 0x9278; baseInternalFormat = rgba; return true;
+			default: return false;
+			}
+		}
+
+		/** @brief Returns true if the file exists (on Android also checks the assets of the apk) */
+		inline bool fileExists(const std::string &filename)
+		{
+#if defined(__ANDROID__)
+			if (filename[0] != '/')
+			{
+				AAsset *asset = AAssetManager_open(androidApp->activity->assetManager, filename.c_str(), AASSET_MODE_UNKNOWN);
+				if (asset)
+				{
+					AAsset_close(asset);
+				}
+				return asset != nullptr;
+			}
+#endif
+			struct stat info;
+			return stat(filename.c_str(), &info) == 0;
+		}
+
+		/** @brief Cache key of a source texture cooked to a format */
+		inline uint64_t getKey(const vks::TextureFile &source, VkFormat format)
+		{
+			uint32_t description[6] = { encoderVersion, static_cast<uint32_t>(format), source.width, source.height, source.levelCount, source.layerCount };
+			uint64_t key = vks::meshcache::hash(description, sizeof(description));
+			for (auto &subresource : source.subresources)
+			{
+				key = vks::meshcache::hash(subresource.data, static_cast<size_t>(subresource.size), key);
+			}
+			return key;
+		}
+
+		/**
+		* Encode all subresources of a source texture and write them to a KTX file
+		*
+		* @param filename KTX file to write
+		* @param source Uncompressed RGBA8 source texture
+		* @param format Format to encode to
+		* @param jobSystem (Optional) Job system to encode with
+		*
+		* @note The data is written to a temporary file first that then replaces the target file, so an interrupted write never leaves a partial cache file behind
+		*
+		* @return True if the file has been written
+		*/
+		inline bool save(const std::string &filename, const vks::TextureFile &source, VkFormat format, vks::JobSystem *jobSystem)
+		{
+			static const uint8_t identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+			uint32_t internalFormat, baseInternalFormat;
+			if (!getGlFormats(format, internalFormat, baseInternalFormat))
+			{
+				return false;
+			}
+			uint32_t arrayElements = source.layerCount / source.faceCount;
+			// Cube maps that aren't arrays store the size of a single face per level
+			bool singleCube = (source.faceCount == 6) && (arrayElements == 1);
+			uint32_t header[13] = {
+				0x04030201,
+				0,	// glType
+				1,	// glTypeSize
+				0,	// glFormat
+				internalFormat,
+				baseInternalFormat,
+				source.width,
+				source.height,
+				0,	// pixelDepth
+				(arrayElements > 1) ? arrayElements : 0,
+				source.faceCount,
+				source.levelCount,
+				0	// bytesOfKeyValueData
+			};
+
+			// Threads and processes cooking the same texture must not share a temporary file
+			std::string tempFilename = vks::tools::getTemporaryFilename(filename);
+			{
+				std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+				if (!file.is_open())
+				{
+					return false;
+				}
+				file.write(reinterpret_cast<const char*>(identifier), sizeof(identifier));
+				file.write(reinterpret_cast<const char*>(header), sizeof(header));
+				std::vector<uint8_t> blocks;
+				for (uint32_t level = 0; level < source.levelCount; level++)
+				{
+					uint32_t width = std::max(source.width >> level, 1u);
+					uint32_t height = std::max(source.height >> level, 1u);
+					uint32_t imageSize = static_cast<uint32_t>(vks::textureencoder::getEncodedSize(format, width, height));
+					uint32_t levelSize = singleCube ? imageSize : imageSize * source.layerCount;
+					file.write(reinterpret_cast<const char*>(&levelSize), sizeof(levelSize));
+					blocks.resize(imageSize);
+					for (uint32_t layer = 0; layer < source.layerCount; layer++)
+					{
+						const vks::TextureFile::Subresource *subresource = source.getSubresource(level, layer);
+						if (!subresource || (subresource->size < static_cast<VkDeviceSize>(width) * height * 4))
+						{
+							file.close();
+							std::remove(tempFilename.c_str());
+							return false;
+						}
+						vks::textureencoder::encode(format, subresource->data, width, height, blocks.data(), jobSystem);
+						// Blocks are multiples of eight bytes, so neither faces nor mip levels need padding
+						file.write(reinterpret_cast<const char*>(blocks.data()), imageSize);
+					}
+				}
+				file.flush();
+				if (!file.good())
+				{
+					file.close();
+					std::remove(tempFilename.c_str());
+					return false;
+				}
+			}
+#if defined(_WIN32)
+			bool replaced = MoveFileExA(tempFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+			bool replaced = std::rename(tempFilename.c_str(), filename.c_str()) == 0;
+#endif
+			if (!replaced)
+			{
+				std::remove(tempFilename.c_str());
+			}
+			return replaced;
+		}
+
+		/**
+		* Get a compressed copy of an uncompressed texture, cooking it if there is no cached copy yet
+		*
+		* @param filename Uncompressed RGBA8 KTX file
+		* @param format Compressed format to cook to, must be supported by the encoder
+		* @param jobSystem (Optional) Job system to encode with, the calling thread helps out
+		* @param cookedFilename Receives the name of the cooked KTX file
+		*
+		* @return False if the source isn't an RGBA8 KTX file or the cooked file can't be written
+		*/
+		inline bool cook(const std::string &filename, VkFormat format, vks::JobSystem *jobSystem, std::string &cookedFilename)
+		{
+			if (!vks::textureencoder::isSupported(format))
+			{
+				return false;
+			}
+			vks::TextureFile source;
+			if (!source.open(filename) || (source.glInternalFormat != glInternalFormatRGBA8))
+			{
+				return false;
+			}
+			cookedFilename = vks::meshcache::getCacheFilename(filename, getKey(source, format), "ktx");
+			uint32_t internalFormat, baseInternalFormat;
+			getGlFormats(format, internalFormat, baseInternalFormat);
+			vks::TextureFile cached;
+			if (cached.open(cookedFilename) && (cached.glInternalFormat == internalFormat) && (cached.levelCount == source.levelCount) && (cached.layerCount == source.layerCount))
+			{
+				return true;
+			}
+			cached.close();
+			return save(cookedFilename, source, format, jobSystem);
+		}
+
+		/**
+		* Select the format to cook to for a device
+		*
+		* @param device Vulkan device the texture is created on
+		* @param alpha True if the texture uses its alpha channel
+		*
+		* @return BC7 (with alpha) or BC1 if the device supports BC formats, ETC2 RGBA8 or RGB8 if it supports ETC2, VK_FORMAT_UNDEFINED otherwise
+		*/
+		inline VkFormat selectFormat(vks::VulkanDevice *device, bool alpha)
+		{
+			VkFormat candidates[2] = {
+				alpha ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK,
+				alpha ? VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK : VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+			};
+			VkBool32 supported[2] = { device->features.textureCompressionBC, device->features.textureCompressionETC2 };
+			for (uint32_t i = 0; i < 2; i++)
+			{
+				VkFormatProperties formatProperties;
+				vkGetPhysicalDeviceFormatProperties(device->physicalDevice, candidates[i], &formatProperties);
+				if (supported[i] && (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+				{
+					return candidates[i];
+				}
+			}
+			return VK_FORMAT_UNDEFINED;
+		}
+
+		/**
+		* Get the file and format to load an uncompressed RGBA8 texture with, cooking a compressed copy if the device supports a format the encoder writes
+		*
+		* @param device Vulkan device the texture is created on
+		* @param jobSystem (Optional) Job system to encode with
+		* @param filename Uncompressed RGBA8 KTX file
+		* @param alpha True if the texture uses its alpha channel
+		* @param loadFilename Receives the file to load, the source file if it couldn't be cooked
+		*
+		* @return Format to load the file with, VK_FORMAT_R8G8B8A8_UNORM if it couldn't be cooked
+		*/
+		inline VkFormat cookForDevice(vks::VulkanDevice *device, vks::JobSystem *jobSystem, const std::string &filename, bool alpha, std::string &loadFilename)
+		{
+			VkFormat format = selectFormat(device, alpha);
+			if ((format != VK_FORMAT_UNDEFINED) && cook(filename, format, jobSystem, loadFilename))
+			{
+				return format;
+			}
+			loadFilename = filename;
+			return VK_FORMAT_R8G8B8A8_UNORM;
+		}
+	}
+}
@@ -0,0 +1,851 @@
+/*
+* Block compression encoder
+*
+* Encodes RGBA8 images into BC1, BC3, BC4, BC5, BC7 and ETC2 blocks on the CPU
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "vulkan/vulkan.h"
+#include "jobsystem.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define VKS_ENCODER_SSE
+#include <emmintrin.h>
+#endif
+
+namespace vks
+{
+	/**
+	* @brief Fast single pass block compression encoders
+	*
+	* The encoders fit the endpoints along the principal axis of each block and refine them once with a least squares fit,
+	* which is close to the quality of offline tools at their fastest settings. BC7 only uses mode 6 and ETC2 only uses the
+	* ETC1 compatible individual and differential modes (plus EAC for the alpha channel of ETC2 RGBA8).
+	*/
+	namespace textureencoder
+	{
+		/** @brief The pixels of a 4x4 block, stored channel by channel so four pixels can be processed with one SIMD instruction */
+		struct Block
+		{
+			alignas(16) float channels[4][16];
+		};
+
+		/** @brief Returns true if the encoder can write the format */
+		inline bool isSupported(VkFormat format)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			case VK_FORMAT_BC3_UNORM_BLOCK:
+			case VK_FORMAT_BC4_UNORM_BLOCK:
+			case VK_FORMAT_BC5_UNORM_BLOCK:
+			case VK_FORMAT_BC7_UNORM_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		/** @brief Size in bytes of a 4x4 block of the format */
+		inline uint32_t getBlockSize(VkFormat format)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			case VK_FORMAT_BC4_UNORM_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+				return 8;
+			default:
+				return 16;
+			}
+		}
+
+		/** @brief Size in bytes of an image of the format */
+		inline size_t getEncodedSize(VkFormat format, uint32_t width, uint32_t height)
+		{
+			return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+		}
+
+		/**
+		* Find the closest palette entry for all pixels of a block
+		*
+		* @param block Pixels to fit
+		* @param palette Palette entries (RGBA)
+		* @param paletteSize Number of palette entries
+		* @param weights Weight of each channel in the squared distance, zero ignores a channel
+		* @param indices Receives the palette index of each pixel
+		*
+		* @return Weighted squared error of the whole block
+		*/
+		inline float fitIndices(const Block &block, const float palette[][4], uint32_t paletteSize, const float weights[4], uint8_t indices[16])
+		{
+			float error = 0.0f;
+#if defined(VKS_ENCODER_SSE)
+			for (uint32_t i = 0; i < 16; i += 4)
+			{
+				__m128 r = _mm_load_ps(&block.channels[0][i]);
+				__m128 g = _mm_load_ps(&block.channels[1][i]);
+				__m128 b = _mm_load_ps(&block.channels[2][i]);
+				__m128 a = _mm_load_ps(&block.channels[3][i]);
+				__m128 bestError = _mm_set1_ps(FLT_MAX);
+				__m128i bestIndex = _mm_setzero_si128();
+				for (uint32_t entry = 0; entry < paletteSize; entry++)
+				{
+					__m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[entry][0]));
+					__m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[entry][1]));
+					__m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[entry][2]));
+					__m128 da = _mm_sub_ps(a, _mm_set1_ps(palette[entry][3]));
+					__m128 d = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(_mm_mul_ps(dr, dr), _mm_set1_ps(weights[0])), _mm_mul_ps(_mm_mul_ps(dg, dg), _mm_set1_ps(weights[1]))),
+						_mm_add_ps(_mm_mul_ps(_mm_mul_ps(db, db), _mm_set1_ps(weights[2])), _mm_mul_ps(_mm_mul_ps(da, da), _mm_set1_ps(weights[3]))));
+					// Strictly closer, so ties keep the lower index like the scalar path
+					__m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, bestError));
+					bestError = _mm_min_ps(d, bestError);
+					bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(static_cast<int>(entry))), _mm_andnot_si128(closer, bestIndex));
+				}
+				alignas(16) float errors[4];
+				alignas(16) int32_t lanes[4];
+				_mm_store_ps(errors, bestError);
+				_mm_store_si128(reinterpret_cast<__m128i*>(lanes), bestIndex);
+				for (uint32_t lane = 0; lane < 4; lane++)
+				{
+					indices[i + lane] = static_cast<uint8_t>(lanes[lane]);
+					error += errors[lane];
+				}
+			}
+#else
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				float bestError = FLT_MAX;
+				for (uint32_t entry = 0; entry < paletteSize; entry++)
+				{
+					float d = 0.0f;
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						float delta = block.channels[c][i] - palette[entry][c];
+						d += delta * delta * weights[c];
+					}
+					if (d < bestError)
+					{
+						bestError = d;
+						indices[i] = static_cast<uint8_t>(entry);
+					}
+				}
+				error += bestError;
+			}
+#endif
+			return error;
+		}
+
+		/** @brief Fit a line through the pixels along their principal axis, start and end receive the extreme points of the pixels projected onto it */
+		inline void fitAxis(const Block &block, const float weights[4], float start[4], float end[4])
+		{
+			float mean[4] = {};
+			float min[4], max[4];
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				min[c] = FLT_MAX;
+				max[c] = -FLT_MAX;
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					mean[c] += block.channels[c][i];
+					min[c] = std::min(min[c], block.channels[c][i]);
+					max[c] = std::max(max[c], block.channels[c][i]);
+				}
+				mean[c] /= 16.0f;
+			}
+			float covariance[4][4] = {};
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				for (uint32_t c0 = 0; c0 < 4; c0++)
+				{
+					for (uint32_t c1 = c0; c1 < 4; c1++)
+					{
+						covariance[c0][c1] += (block.channels[c0][i] - mean[c0]) * (block.channels[c1][i] - mean[c1]) * weights[c0] * weights[c1];
+					}
+				}
+			}
+			for (uint32_t c0 = 0; c0 < 4; c0++)
+			{
+				for (uint32_t c1 = 0; c1 < c0; c1++)
+				{
+					covariance[c0][c1] = covariance[c1][c0];
+				}
+			}
+			// Power iteration, starting with the diagonal of the bounding box converges in a few steps
+			float axis[4];
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				axis[c] = (max[c] - min[c]) * weights[c];
+			}
+			for (uint32_t iteration = 0; iteration < 8; iteration++)
+			{
+				float next[4] = {};
+				float length = 0.0f;
+				for (uint32_t c0 = 0; c0 < 4; c0++)
+				{
+					for (uint32_t c1 = 0; c1 < 4; c1++)
+					{
+						next[c0] += covariance[c0][c1] * axis[c1];
+					}
+					length = std::max(length, fabsf(next[c0]));
+				}
+				if (length < FLT_EPSILON)
+				{
+					break;
+				}
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					axis[c] = next[c] / length;
+				}
+			}
+			float lengthSquared = 0.0f;
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				lengthSquared += axis[c] * axis[c];
+			}
+			if (lengthSquared < FLT_EPSILON)
+			{
+				// All pixels are equal in the weighted channels
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					start[c] = end[c] = mean[c];
+				}
+				return;
+			}
+			float tMin = FLT_MAX;
+			float tMax = -FLT_MAX;
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				float t = 0.0f;
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					t += (block.channels[c][i] - mean[c]) * axis[c];
+				}
+				tMin = std::min(tMin, t);
+				tMax = std::max(tMax, t);
+			}
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				start[c] = std::min(std::max(mean[c] + axis[c] * tMin / lengthSquared, 0.0f), 255.0f);
+				end[c] = std::min(std::max(mean[c] + axis[c] * tMax / lengthSquared, 0.0f), 255.0f);
+			}
+		}
+
+		/**
+		* Least squares fit of the endpoints for the given indices
+		*
+		* @param block Pixels of the block
+		* @param indices Palette index of each pixel
+		* @param indexWeights Interpolation weight of the end point for each palette index
+		* @param start Receives the start point
+		* @param end Receives the end point
+		*
+		* @return False if the indices don't allow a fit (e.g. all pixels use the same index)
+		*/
+		inline bool refineEndpoints(const Block &block, const uint8_t indices[16], const float *indexWeights, float start[4], float end[4])
+		{
+			float alpha2 = 0.0f, beta2 = 0.0f, alphaBeta = 0.0f;
+			float alphaX[4] = {}, betaX[4] = {};
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				float beta = indexWeights[indices[i]];
+				float alpha = 1.0f - beta;
+				alpha2 += alpha * alpha;
+				beta2 += beta * beta;
+				alphaBeta += alpha * beta;
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					alphaX[c] += alpha * block.channels[c][i];
+					betaX[c] += beta * block.channels[c][i];
+				}
+			}
+			float determinant = alpha2 * beta2 - alphaBeta * alphaBeta;
+			if (fabsf(determinant) < FLT_EPSILON)
+			{
+				return false;
+			}
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				start[c] = std::min(std::max((alphaX[c] * beta2 - betaX[c] * alphaBeta) / determinant, 0.0f), 255.0f);
+				end[c] = std::min(std::max((betaX[c] * alpha2 - alphaX[c] * alphaBeta) / determinant, 0.0f), 255.0f);
+			}
+			return true;
+		}
+
+		inline uint32_t quantize(float value, uint32_t maxValue)
+		{
+			return static_cast<uint32_t>(std::min(std::max(value * maxValue / 255.0f + 0.5f, 0.0f), static_cast<float>(maxValue)));
+		}
+
+		// Expand 4, 5 or 6 bit values to 8 bits by replicating the high bits
+		inline float expand4(uint32_t value) { return static_cast<float>((value << 4) | value); }
+		inline float expand5(uint32_t value) { return static_cast<float>((value << 3) | (value >> 2)); }
+		inline float expand6(uint32_t value) { return static_cast<float>((value << 2) | (value >> 4)); }
+
+		/** @brief Writes values to a block starting at the least significant bit of the first byte (BC7) */
+		struct BitWriter
+		{
+			uint8_t *data;
+			uint32_t position;
+
+			void write(uint32_t value, uint32_t bits)
+			{
+				for (uint32_t bit = 0; bit < bits; bit++)
+				{
+					if ((value >> bit) & 1)
+					{
+						data[position >> 3] |= static_cast<uint8_t>(1 << (position & 7));
+					}
+					position++;
+				}
+			}
+		};
+
+		// Quantize the endpoints to RGB565 and fit the indices, returns the error
+		inline float fitColorEndpoints(const Block &block, const float start[4], const float end[4], uint16_t &color0, uint16_t &color1, uint8_t indices[16])
+		{
+			static const float weights[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+			uint32_t q0[3] = { quantize(start[0], 31), quantize(start[1], 63), quantize(start[2], 31) };
+			uint32_t q1[3] = { quantize(end[0], 31), quantize(end[1], 63), quantize(end[2], 31) };
+			color0 = static_cast<uint16_t>((q0[0] << 11) | (q0[1] << 5) | q0[2]);
+			color1 = static_cast<uint16_t>((q1[0] << 11) | (q1[1] << 5) | q1[2]);
+			// The first color must be the larger one to select the four color mode
+			if (color0 < color1)
+			{
+				std::swap(color0, color1);
+				std::swap(q0, q1);
+			}
+			float palette[4][4];
+			palette[0][0] = expand5(q0[0]); palette[0][1] = expand6(q0[1]); palette[0][2] = expand5(q0[2]);
+			palette[1][0] = expand5(q1[0]); palette[1][1] = expand6(q1[1]); palette[1][2] = expand5(q1[2]);
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+				palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+			}
+			for (uint32_t entry = 0; entry < 4; entry++)
+			{
+				palette[entry][3] = 0.0f;
+			}
+			if (color0 == color1)
+			{
+				memset(indices, 0, 16);
+				float error = 0.0f;
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					for (uint32_t c = 0; c < 3; c++)
+					{
+						float d = block.channels[c][i] - palette[0][c];
+						error += d * d;
+					}
+				}
+				return error;
+			}
+			return fitIndices(block, palette, 4, weights, indices);
+		}
+
+		/** @brief Encode the RGB channels of a block into a BC1 block in four color mode (also the color part of BC3) */
+		inline void encodeBC1(const Block &block, uint8_t *output)
+		{
+			static const float weights[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+			// Interpolation weight of the second endpoint for each index
+			static const float indexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+			float start[4], end[4];
+			fitAxis(block, weights, start, end);
+			uint16_t color0, color1;
+			uint8_t indices[16];
+			float error = fitColorEndpoints(block, start, end, color0, color1, indices);
+			uint16_t refinedColor0, refinedColor1;
+			uint8_t refinedIndices[16];
+			if ((error > 0.0f) && refineEndpoints(block, indices, indexWeights, start, end) && (fitColorEndpoints(block, start, end, refinedColor0, refinedColor1, refinedIndices) < error))
+			{
+				color0 = refinedColor0;
+				color1 = refinedColor1;
+				memcpy(indices, refinedIndices, sizeof(indices));
+			}
+			uint32_t bits = 0;
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				bits |= static_cast<uint32_t>(indices[i]) << (i * 2);
+			}
+			output[0] = static_cast<uint8_t>(color0 & 0xFF);
+			output[1] = static_cast<uint8_t>(color0 >> 8);
+			output[2] = static_cast<uint8_t>(color1 & 0xFF);
+			output[3] = static_cast<uint8_t>(color1 >> 8);
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				output[4 + i] = static_cast<uint8_t>(bits >> (i * 8));
+			}
+		}
+
+		/** @brief Encode one channel of a block into a BC4 block (also the alpha part of BC3 and the channels of BC5) */
+		inline void encodeBC4(const Block &block, uint32_t channel, uint8_t *output)
+		{
+			float min = FLT_MAX;
+			float max = -FLT_MAX;
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				min = std::min(min, block.channels[channel][i]);
+				max = std::max(max, block.channels[channel][i]);
+			}
+			uint32_t value0 = quantize(max, 255);
+			uint32_t value1 = quantize(min, 255);
+			uint8_t indices[16] = {};
+			if (value0 > value1)
+			{
+				// Eight value mode: the endpoints followed by six interpolated values
+				float palette[8][4] = {};
+				palette[0][channel] = static_cast<float>(value0);
+				palette[1][channel] = static_cast<float>(value1);
+				for (uint32_t entry = 2; entry < 8; entry++)
+				{
+					palette[entry][channel] = ((8 - entry) * palette[0][channel] + (entry - 1) * palette[1][channel]) / 7.0f;
+				}
+				float weights[4] = {};
+				weights[channel] = 1.0f;
+				fitIndices(block, palette, 8, weights, indices);
+			}
+			output[0] = static_cast<uint8_t>(value0);
+			output[1] = static_cast<uint8_t>(value1);
+			uint64_t bits = 0;
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				bits |= static_cast<uint64_t>(indices[i]) << (i * 3);
+			}
+			for (uint32_t i = 0; i < 6; i++)
+			{
+				output[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+			}
+		}
+
+		/** @brief Encode a block into a BC3 block */
+		inline void encodeBC3(const Block &block, uint8_t *output)
+		{
+			encodeBC4(block, 3, output);
+			encodeBC1(block, output + 8);
+		}
+
+		/** @brief Encode the red and green channels of a block into a BC5 block */
+		inline void encodeBC5(const Block &block, uint8_t *output)
+		{
+			encodeBC4(block, 0, output);
+			encodeBC4(block, 1, output + 8);
+		}
+
+		// Quantize an endpoint to seven bits per channel and a shared p-bit, returns the endpoint expanded to eight bits
+		inline void quantizeBC7Endpoint(const float endpoint[4], uint32_t quantized[4], uint32_t &pBit, float expanded[4])
+		{
+			float bestError = FLT_MAX;
+			for (uint32_t p = 0; p < 2; p++)
+			{
+				uint32_t q[4];
+				float error = 0.0f;
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					q[c] = static_cast<uint32_t>(std::min(std::max((endpoint[c] - p) / 2.0f + 0.5f, 0.0f), 127.0f));
+					float d = static_cast<float>((q[c] << 1) | p) - endpoint[c];
+					error += d * d;
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					pBit = p;
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						quantized[c] = q[c];
+						expanded[c] = static_cast<float>((q[c] << 1) | p);
+					}
+				}
+			}
+		}
+
+		struct BC7Endpoints
+		{
+			uint32_t quantized[2][4];
+			uint32_t pBits[2];
+			uint8_t indices[16];
+		};
+
+		inline float fitBC7Endpoints(const Block &block, const float start[4], const float end[4], BC7Endpoints &endpoints)
+		{
+			static const float weights[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			static const uint32_t interpolation[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+			float expanded[2][4];
+			quantizeBC7Endpoint(start, endpoints.quantized[0], endpoints.pBits[0], expanded[0]);
+			quantizeBC7Endpoint(end, endpoints.quantized[1], endpoints.pBits[1], expanded[1]);
+			float palette[16][4];
+			for (uint32_t entry = 0; entry < 16; entry++)
+			{
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					uint32_t e0 = static_cast<uint32_t>(expanded[0][c]);
+					uint32_t e1 = static_cast<uint32_t>(expanded[1][c]);
+					palette[entry][c] = static_cast<float>((e0 * (64 - interpolation[entry]) + e1 * interpolation[entry] + 32) >> 6);
+				}
+			}
+			return fitIndices(block, palette, 16, weights, endpoints.indices);
+		}
+
+		/** @brief Encode a block into a BC7 mode 6 block (RGBA endpoints with a p-bit each and four bit indices) */
+		inline void encodeBC7(const Block &block, uint8_t *output)
+		{
+			static const float weights[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			static const float indexWeights[16] = {
+				0.0f / 64.0f, 4.0f / 64.0f, 9.0f / 64.0f, 13.0f / 64.0f, 17.0f / 64.0f, 21.0f / 64.0f, 26.0f / 64.0f, 30.0f / 64.0f,
+				34.0f / 64.0f, 38.0f / 64.0f, 43.0f / 64.0f, 47.0f / 64.0f, 51.0f / 64.0f, 55.0f / 64.0f, 60.0f / 64.0f, 64.0f / 64.0f };
+			float start[4], end[4];
+			fitAxis(block, weights, start, end);
+			BC7Endpoints endpoints;
+			float error = fitBC7Endpoints(block, start, end, endpoints);
+			BC7Endpoints refined;
+			if ((error > 0.0f) && refineEndpoints(block, endpoints.indices, indexWeights, start, end) && (fitBC7Endpoints(block, start, end, refined) < error))
+			{
+				endpoints = refined;
+			}
+			// The most significant bit of the first index is implicitly zero
+			if (endpoints.indices[0] >= 8)
+			{
+				std::swap(endpoints.quantized[0], endpoints.quantized[1]);
+				std::swap(endpoints.pBits[0], endpoints.pBits[1]);
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					endpoints.indices[i] = 15 - endpoints.indices[i];
+				}
+			}
+			memset(output, 0, 16);
+			BitWriter writer = { output, 0 };
+			writer.write(1 << 6, 7);
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				writer.write(endpoints.quantized[0][c], 7);
+				writer.write(endpoints.quantized[1][c], 7);
+			}
+			writer.write(endpoints.pBits[0], 1);
+			writer.write(endpoints.pBits[1], 1);
+			writer.write(endpoints.indices[0], 3);
+			for (uint32_t i = 1; i < 16; i++)
+			{
+				writer.write(endpoints.indices[i], 4);
+			}
+		}
+
+		/** @brief Write a 64 bit value in big endian byte order, as used by ETC2 and EAC blocks */
+		inline void writeBigEndian(uint64_t value, uint8_t *output)
+		{
+			for (uint32_t i = 0; i < 8; i++)
+			{
+				output[i] = static_cast<uint8_t>(value >> (56 - i * 8));
+			}
+		}
+
+		// Find the modifier table with the lowest error for the pixels of a sub block, the pixel indices are stored in ETC order (column major)
+		inline float fitEtcSubBlock(const Block &block, const uint32_t pixels[8], const float base[3], uint32_t &table, uint32_t indices[8])
+		{
+			static const int32_t modifiers[8][4] = {
+				{ 2, 8, -2, -8 }, { 5, 17, -5, -17 }, { 9, 29, -9, -29 }, { 13, 42, -13, -42 },
+				{ 18, 60, -18, -60 }, { 24, 80, -24, -80 }, { 33, 106, -33, -106 }, { 47, 183, -47, -183 } };
+			float bestError = FLT_MAX;
+			for (uint32_t t = 0; t < 8; t++)
+			{
+				float error = 0.0f;
+				uint32_t tableIndices[8];
+				for (uint32_t p = 0; p < 8; p++)
+				{
+					float bestPixelError = FLT_MAX;
+					for (uint32_t m = 0; m < 4; m++)
+					{
+						float pixelError = 0.0f;
+						for (uint32_t c = 0; c < 3; c++)
+						{
+							float d = std::min(std::max(base[c] + modifiers[t][m], 0.0f), 255.0f) - block.channels[c][pixels[p]];
+							pixelError += d * d;
+						}
+						if (pixelError < bestPixelError)
+						{
+							bestPixelError = pixelError;
+							tableIndices[p] = m;
+						}
+					}
+					error += bestPixelError;
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					table = t;
+					memcpy(indices, tableIndices, sizeof(tableIndices));
+				}
+			}
+			return bestError;
+		}
+
+		/** @brief Encode the RGB channels of a block into an ETC2 RGB8 block, using the ETC1 compatible individual and differential modes */
+		inline void encodeETC2(const Block &block, uint8_t *output)
+		{
+			uint64_t bestBits = 0;
+			float bestError = FLT_MAX;
+			for (uint32_t flip = 0; flip < 2; flip++)
+			{
+				// Not flipped the sub blocks are the left and right 2x4 halves, flipped they are the top and bottom 4x2 halves
+				uint32_t pixels[2][8];
+				float average[2][3] = {};
+				for (uint32_t subBlock = 0; subBlock < 2; subBlock++)
+				{
+					uint32_t count = 0;
+					for (uint32_t y = 0; y < 4; y++)
+					{
+						for (uint32_t x = 0; x < 4; x++)
+						{
+							if (((flip ? y : x) >> 1) == subBlock)
+							{
+								pixels[subBlock][count++] = y * 4 + x;
+								for (uint32_t c = 0; c < 3; c++)
+								{
+									average[subBlock][c] += block.channels[c][y * 4 + x] / 8.0f;
+								}
+							}
+						}
+					}
+				}
+				for (uint32_t differential = 0; differential < 2; differential++)
+				{
+					uint32_t quantized[2][3];
+					float base[2][3];
+					bool valid = true;
+					for (uint32_t subBlock = 0; subBlock < 2; subBlock++)
+					{
+						for (uint32_t c = 0; c < 3; c++)
+						{
+							quantized[subBlock][c] = quantize(average[subBlock][c], differential ? 31 : 15);
+							base[subBlock][c] = differential ? expand5(quantized[subBlock][c]) : expand4(quantized[subBlock][c]);
+						}
+					}
+					if (differential)
+					{
+						// The second color is stored as a three bit signed offset to the first one
+						for (uint32_t c = 0; c < 3; c++)
+						{
+							int32_t delta = static_cast<int32_t>(quantized[1][c]) - static_cast<int32_t>(quantized[0][c]);
+							valid = valid && (delta >= -4) && (delta <= 3);
+						}
+					}
+					if (!valid)
+					{
+						continue;
+					}
+					uint32_t tables[2];
+					uint32_t indices[2][8];
+					float error = fitEtcSubBlock(block, pixels[0], base[0], tables[0], indices[0]) + fitEtcSubBlock(block, pixels[1], base[1], tables[1], indices[1]);
+					if (error >= bestError)
+					{
+						continue;
+					}
+					bestError = error;
+					uint64_t bits = 0;
+					for (uint32_t c = 0; c < 3; c++)
+					{
+						uint32_t shift = 56 - c * 8;
+						if (differential)
+						{
+							uint32_t delta = static_cast<uint32_t>(static_cast<int32_t>(quantized[1][c]) - static_cast<int32_t>(quantized[0][c])) & 7;
+							bits |= static_cast<uint64_t>((quantized[0][c] << 3) | delta) << shift;
+						}
+						else
+						{
+							bits |= static_cast<uint64_t>((quantized[0][c] << 4) | quantized[1][c]) << shift;
+						}
+					}
+					bits |= static_cast<uint64_t>(tables[0]) << 37;
+					bits |= static_cast<uint64_t>(tables[1]) << 34;
+					bits |= static_cast<uint64_t>(differential) << 33;
+					bits |= static_cast<uint64_t>(flip) << 32;
+					// Pixel indices are stored column major, the most significant bits of all pixels first
+					for (uint32_t subBlock = 0; subBlock < 2; subBlock++)
+					{
+						for (uint32_t p = 0; p < 8; p++)
+						{
+							uint32_t pixel = pixels[subBlock][p];
+							uint32_t bit = (pixel % 4) * 4 + pixel / 4;
+							bits |= static_cast<uint64_t>(indices[subBlock][p] >> 1) << (16 + bit);
+							bits |= static_cast<uint64_t>(indices[subBlock][p] & 1) << bit;
+						}
+					}
+					bestBits = bits;
+				}
+			}
+			writeBigEndian(bestBits, output);
+		}
+
+		/** @brief Encode the alpha channel of a block into an EAC block (the alpha part of ETC2 RGBA8) */
+		inline void encodeEAC(const Block &block, uint8_t *output)
+		{
+			static const int32_t modifiers[16][8] = {
+				{ -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 }, { -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+				{ -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 }, { -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+				{ -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 }, { -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+				{ -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 }, { -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 } };
+			float min = FLT_MAX;
+			float max = -FLT_MAX;
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				min = std::min(min, block.channels[3][i]);
+				max = std::max(max, block.channels[3][i]);
+			}
+			float bestError = FLT_MAX;
+			uint64_t bestBits = 0;
+			for (uint32_t table = 0; table < 16; table++)
+			{
+				int32_t range = modifiers[table][7] - modifiers[table][3];
+				// Only try the multipliers around the one that spans the range of the block
+				int32_t estimate = static_cast<int32_t>((max - min) / range + 0.5f);
+				for (int32_t multiplier = std::max(estimate - 1, 1); multiplier <= std::min(estimate + 1, 15); multiplier++)
+				{
+					float center = (modifiers[table][7] + modifiers[table][3]) * multiplier / 2.0f;
+					int32_t base = static_cast<int32_t>(std::min(std::max((min + max) / 2.0f - center + 0.5f, 0.0f), 255.0f));
+					float error = 0.0f;
+					uint64_t indexBits = 0;
+					for (uint32_t i = 0; i < 16; i++)
+					{
+						float bestPixelError = FLT_MAX;
+						uint32_t bestIndex = 0;
+						for (uint32_t index = 0; index < 8; index++)
+						{
+							float value = static_cast<float>(std::min(std::max(base + modifiers[table][index] * multiplier, 0), 255));
+							float d = value - block.channels[3][i];
+							if (d * d < bestPixelError)
+							{
+								bestPixelError = d * d;
+								bestIndex = index;
+							}
+						}
+						error += bestPixelError;
+						// Column major, the first pixel in the most significant bits
+						uint32_t position = (i % 4) * 4 + i / 4;
+						indexBits |= static_cast<uint64_t>(bestIndex) << (45 - position * 3);
+					}
+					if (error < bestError)
+					{
+						bestError = error;
+						bestBits = (static_cast<uint64_t>(base) << 56) | (static_cast<uint64_t>(multiplier) << 52) | (static_cast<uint64_t>(table) << 48) | indexBits;
+					}
+				}
+			}
+			writeBigEndian(bestBits, output);
+		}
+
+		/** @brief Encode a block into a block of the given format */
+		inline void encodeBlock(VkFormat format, const Block &block, uint8_t *output)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+				encodeBC1(block, output);
+				break;
+			case VK_FORMAT_BC3_UNORM_BLOCK:
+				encodeBC3(block, output);
+				break;
+			case VK_FORMAT_BC4_UNORM_BLOCK:
+				encodeBC4(block, 0, output);
+				break;
+			case VK_FORMAT_BC5_UNORM_BLOCK:
+				encodeBC5(block, output);
+				break;
+			case VK_FORMAT_BC7_UNORM_BLOCK:
+				encodeBC7(block, output);
+				break;
+			case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+				encodeETC2(block, output);
+				break;
+			case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+				encodeEAC(block, output);
+				encodeETC2(block, output + 8);
+				break;
+			default:
+				assert(false);
+			}
+		}
+
+		/** @brief Encode the block rows [begin, end) of an image */
+		inline void encodeRows(VkFormat format, const uint8_t *pixels, uint32_t width, uint32_t height, uint8_t *output, uint32_t begin, uint32_t end)
+		{
+			uint32_t blocksX = (width + 3) / 4;
+			uint32_t blockSize = getBlockSize(format);
+			Block block;
+			for (uint32_t blockY = begin; blockY < end; blockY++)
+			{
+				for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+				{
+					// Blocks at the right and bottom border repeat the last column and row of the image
+					for (uint32_t y = 0; y < 4; y++)
+					{
+						uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+						for (uint32_t x = 0; x < 4; x++)
+						{
+							uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+							const uint8_t *pixel = pixels + (static_cast<size_t>(sourceY) * width + sourceX) * 4;
+							for (uint32_t c = 0; c < 4; c++)
+							{
+								block.channels[c][y * 4 + x] = static_cast<float>(pixel[c]);
+							}
+						}
+					}
+					encodeBlock(format, block, output + (static_cast<size_t>(blockY) * blocksX + blockX) * blockSize);
+				}
+			}
+		}
+
+		struct EncodeJob
+		{
+			VkFormat format;
+			uint32_t width;
+			uint32_t height;
+			const uint8_t *pixels;
+			uint8_t *output;
+
+			void operator()(uint32_t begin, uint32_t end) const
+			{
+				encodeRows(format, pixels, width, height, output, begin, end);
+			}
+		};
+
+		/**
+		* Encode an RGBA8 image
+		*
+		* @param format Format to encode to, must be supported by the encoder (see isSupported)
+		* @param pixels Tightly packed RGBA8 pixels of the image
+		* @param width Width of the image in pixels
+		* @param height Height of the image in pixels
+		* @param output Receives the blocks, must be getEncodedSize bytes large
+		* @param (Optional) jobSystem Job system to encode the rows of blocks in parallel with, the calling thread helps out while waiting
+		*/
+		inline void encode(VkFormat format, const uint8_t *pixels, uint32_t width, uint32_t height, uint8_t *output, vks::JobSystem *jobSystem = nullptr)
+		{
+			assert(isSupported(format));
+			uint32_t blocksY = (height + 3) / 4;
+			EncodeJob job = { format, width, height, pixels, output };
+			if (jobSystem && (blocksY > 1))
+			{
+				// A few rows of blocks per job keep the scheduling overhead small compared to the encoding
+				jobSystem->wait(jobSystem->parallelFor(0, blocksY, 4, job));
+			}
+			else
+			{
+				job(0, blocksY);
+			}
+		}
+	}
+}
@@ -0,0 +1,472 @@
+/*
+* Vulkan texture file reader
+*
+* Reads KTX files through a read only memory mapping, so the image data is copied from the file straight into staging memory
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+
+#include <gli/gli.hpp>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#if defined(__ANDROID__)
+#include <android/asset_manager.h>
+#include "vulkanandroid.h"
+#endif
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace vks
+{
+	/**
+	* @brief Texture file whose image data is read without copying it into an intermediate heap buffer
+	*
+	* KTX files are memory mapped (on Android the asset is opened in buffer mode, which maps uncompressed assets), the header
+	* and the offsets of all mip levels, array layers and cube faces are parsed from the mapping. copyTo() then copies the
+	* image data directly from the mapping into staging memory. Other formats (e.g. DDS) and KTX files that can't be used
+	* as they are (big endian or 3D) are loaded through gli.
+	*
+	* @note The data pointers of the subresources are only valid while the file is open
+	*/
+	class TextureFile
+	{
+	public:
+		/** @brief Image data of a single mip level of an array layer or cube face */
+		struct Subresource
+		{
+			uint32_t level;
+			// Array layer, cube faces are stored as six consecutive layers
+			uint32_t layer;
+			uint32_t width;
+			uint32_t height;
+			const uint8_t *data;
+			VkDeviceSize size;
+			// Offset of the data in the staging memory written by copyTo(), aligned for buffer to image copies
+			VkDeviceSize stagingOffset;
+		};
+
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t levelCount = 0;
+		/** @brief Number of array layers including the faces of cube maps */
+		uint32_t layerCount = 0;
+		/** @brief Six for cube maps, one otherwise */
+		uint32_t faceCount = 0;
+		/** @brief OpenGL internal format stored in the header of KTX files, zero for files loaded through gli */
+		uint32_t glInternalFormat = 0;
+		std::vector<Subresource> subresources;
+		/** @brief Size of the staging memory required by copyTo() */
+		VkDeviceSize stagingSize = 0;
+
+	private:
+		// Offsets of buffer to image copies must be a multiple of four and of the texel (or compressed block) size
+		VkDeviceSize stagingAlignment = 16;
+
+		const uint8_t *mappedData = nullptr;
+		size_t mappedSize = 0;
+#if defined(_WIN32)
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = NULL;
+#elif defined(__ANDROID__)
+		AAsset *asset = nullptr;
+#endif
+		gli::texture fallback;
+
+		bool map(const std::string &filename)
+		{
+#if defined(_WIN32)
+			file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(file, &size) || (size.QuadPart == 0))
+			{
+				return false;
+			}
+			mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mapping == NULL)
+			{
+				return false;
+			}
+			mappedData = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			mappedSize = static_cast<size_t>(size.QuadPart);
+#else
+#if defined(__ANDROID__)
+			// Absolute paths point to files written by the example (e.g. cooked textures in internal storage), everything else is an asset of the apk
+			if (filename[0] != '/')
+			{
+				asset = AAssetManager_open(androidApp->activity->assetManager, filename.c_str(), AASSET_MODE_BUFFER);
+				if (!asset)
+				{
+					return false;
+				}
+				mappedData = static_cast<const uint8_t*>(AAsset_getBuffer(asset));
+				mappedSize = AAsset_getLength(asset);
+				return mappedData != nullptr;
+			}
+#endif
+			int fd = ::open(filename.c_str(), O_RDONLY);
+			if (fd < 0)
+			{
+				return false;
+			}
+			struct stat info;
+			if ((fstat(fd, &info) != 0) || (info.st_size == 0))
+			{
+				::close(fd);
+				return false;
+			}
+			void *data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			// The mapping keeps the file referenced
+			::close(fd);
+			if (data == MAP_FAILED)
+			{
+				return false;
+			}
+			// The data is read front to back exactly once
+			madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+			mappedData = static_cast<const uint8_t*>(data);
+			mappedSize = static_cast<size_t>(info.st_size);
+#endif
+			return mappedData != nullptr;
+		}
+
+		void unmap()
+		{
+#if defined(_WIN32)
+			if (mappedData)
+			{
+				UnmapViewOfFile(mappedData);
+			}
+			if (mapping != NULL)
+			{
+				CloseHandle(mapping);
+				mapping = NULL;
+			}
+			if (file != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(file);
+				file = INVALID_HANDLE_VALUE;
+			}
+#else
+#if defined(__ANDROID__)
+			if (asset)
+			{
+				AAsset_close(asset);
+				asset = nullptr;
+				mappedData = nullptr;
+			}
+#endif
+			if (mappedData)
+			{
+				munmap(const_cast<uint8_t*>(mappedData), mappedSize);
+			}
+#endif
+			mappedData = nullptr;
+			mappedSize = 0;
+		}
+
+		uint32_t readUint32(size_t offset)
+		{
+			uint32_t value;
+			memcpy(&value, mappedData + offset, sizeof(value));
+			return value;
+		}
+
+		// Parse the KTX 1.1 header and the image size fields that precede each mip level
+		bool parseKtx()
+		{
+			static const uint8_t identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+			const size_t headerSize = 64;
+			if ((mappedSize < headerSize) || (memcmp(mappedData, identifier, sizeof(identifier)) != 0))
+			{
+				return false;
+			}
+			// Files written with the other byte order would need their data swapped
+			if (readUint32(12) != 0x04030201)
+			{
+				return false;
+			}
+			uint32_t pixelWidth = readUint32(36);
+			uint32_t pixelHeight = std::max(readUint32(40), 1u);
+			uint32_t pixelDepth = readUint32(44);
+			uint32_t arrayElements = std::max(readUint32(48), 1u);
+			uint32_t faces = readUint32(52);
+			uint32_t levels = std::max(readUint32(56), 1u);
+			uint32_t keyValueBytes = readUint32(60);
+			if ((pixelWidth == 0) || (pixelDepth > 1) || ((faces != 1) && (faces != 6)))
+			{
+				return false;
+			}
+
+			glInternalFormat = readUint32(28);
+			width = pixelWidth;
+			height = pixelHeight;
+			levelCount = levels;
+			faceCount = faces;
+			layerCount = arrayElements * faces;
+			// imageSize is the size of a single face for cube maps that aren't arrays, faces are then padded to four bytes
+			bool singleCube = (faces == 6) && (readUint32(48) == 0);
+
+			size_t offset = headerSize + keyValueBytes;
+			stagingSize = 0;
+			subresources.clear();
+			for (uint32_t level = 0; level < levels; level++)
+			{
+				if (offset + 4 > mappedSize)
+				{
+					return false;
+				}
+				uint32_t imageSize = readUint32(offset);
+				offset += 4;
+				VkDeviceSize faceSize = singleCube ? imageSize : imageSize / layerCount;
+				for (uint32_t layer = 0; layer < layerCount; layer++)
+				{
+					if (offset + faceSize > mappedSize)
+					{
+						return false;
+					}
+					Subresource subresource;
+					subresource.level = level;
+					subresource.layer = layer;
+					subresource.width = std::max(pixelWidth >> level, 1u);
+					subresource.height = std::max(pixelHeight >> level, 1u);
+					subresource.data = mappedData + offset;
+					subresource.size = faceSize;
+					subresources.push_back(subresource);
+					offset += static_cast<size_t>(faceSize);
+					if (singleCube)
+					{
+						offset = (offset + 3) & ~static_cast<size_t>(3);
+					}
+				}
+				// Mip padding
+				offset = (offset + 3) & ~static_cast<size_t>(3);
+			}
+			return true;
+		}
+
+		bool loadFallback(const std::string &filename)
+		{
+#if defined(__ANDROID__)
+			AAsset* fallbackAsset = AAssetManager_open(androidApp->activity->assetManager, filename.c_str(), AASSET_MODE_STREAMING);
+			if (!fallbackAsset)
+			{
+				return false;
+			}
+			size_t size = AAsset_getLength(fallbackAsset);
+			std::vector<char> fileData(size);
+			AAsset_read(fallbackAsset, fileData.data(), size);
+			AAsset_close(fallbackAsset);
+			fallback = gli::load(fileData.data(), size);
+#else
+			fallback = gli::load(filename);
+#endif
+			if (fallback.empty())
+			{
+				return false;
+			}
+			width = static_cast<uint32_t>(fallback.extent().x);
+			height = static_cast<uint32_t>(fallback.extent().y);
+			levelCount = static_cast<uint32_t>(fallback.levels());
+			faceCount = static_cast<uint32_t>(fallback.faces());
+			layerCount = static_cast<uint32_t>(fallback.layers() * fallback.faces());
+			subresources.clear();
+			for (uint32_t layer = 0; layer < fallback.layers(); layer++)
+			{
+				for (uint32_t face = 0; face < faceCount; face++)
+				{
+					for (uint32_t level = 0; level < levelCount; level++)
+					{
+						Subresource subresource;
+						subresource.level = level;
+						subresource.layer = layer * faceCount + face;
+						subresource.width = static_cast<uint32_t>(fallback.extent(level).x);
+						subresource.height = static_cast<uint32_t>(fallback.extent(level).y);
+						subresource.data = static_cast<const uint8_t*>(fallback.data(layer, face, level));
+						subresource.size = fallback.size(level);
+						subresources.push_back(subresource);
+					}
+				}
+			}
+			return true;
+		}
+
+	public:
+		TextureFile() {}
+		TextureFile(const TextureFile&) = delete;
+		TextureFile& operator=(const TextureFile&) = delete;
+
+		~TextureFile()
+		{
+			close();
+		}
+
+		/**
+		* Open a texture file
+		*
+		* @param filename File to open (.ktx is read through a memory mapping, other formats supported by gli are loaded into memory)
+		* @param (Optional) format Vulkan format the image data is uploaded with, staging offsets are aligned to its texel (or block) size (defaults to 16 byte alignment)
+		*
+		* @return True if the file has been opened and contains image data
+		*/
+		bool open(const std::string &filename, VkFormat format = VK_FORMAT_UNDEFINED)
+		{
+			close();
+			stagingAlignment = vks::tools::getBufferImageCopyAlignment(format);
+			bool ktx = (filename.size() > 4) && (filename.compare(filename.size() - 4, 4, ".ktx") == 0);
+			bool opened = false;
+			if (ktx && map(filename))
+			{
+				opened = parseKtx();
+			}
+			if (!opened)
+			{
+				unmap();
+				opened = loadFallback(filename);
+			}
+			if (!opened)
+			{
+				return false;
+			}
+			stagingSize = 0;
+			for (auto &subresource : subresources)
+			{
+				subresource.stagingOffset = (stagingSize + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+				stagingSize = subresource.stagingOffset + subresource.size;
+			}
+			return true;
+		}
+
+		/** @brief Release the mapping (or the fallback image data) */
+		void close()
+		{
+			unmap();
+			fallback = gli::texture();
+			glInternalFormat = 0;
+			subresources.clear();
+			stagingSize = 0;
+		}
+
+		/** @brief Returns the subresource of the given mip level and layer, null if the file doesn't contain it */
+		const Subresource* getSubresource(uint32_t level, uint32_t layer) const
+		{
+			for (auto &subresource : subresources)
+			{
+				if ((subresource.level == level) && (subresource.layer == layer))
+				{
+					return &subresource;
+				}
+			}
+			return nullptr;
+		}
+
+		/**
+		* Get the buffer to image copy regions for the staging memory written by copyTo()
+		*
+		* @param (Optional) maxLayerCount Only return regions for the first layers (e.g. one for 2D textures)
+		*/
+		std::vector<VkBufferImageCopy> getCopyRegions(uint32_t maxLayerCount = UINT32_MAX) const
+		{
+			std::vector<VkBufferImageCopy> regions;
+			for (auto &subresource : subresources)
+			{
+				if (subresource.layer >= maxLayerCount)
+				{
+					continue;
+				}
+				VkBufferImageCopy region = {};
+				region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				region.imageSubresource.mipLevel = subresource.level;
+				region.imageSubresource.baseArrayLayer = subresource.layer;
+				region.imageSubresource.layerCount = 1;
+				region.imageExtent.width = subresource.width;
+				region.imageExtent.height = subresource.height;
+				region.imageExtent.depth = 1;
+				region.bufferOffset = subresource.stagingOffset;
+				regions.push_back(region);
+			}
+			return regions;
+		}
+
+		/**
+		* Get the buffer to image copy regions for a range of mip levels, so the levels can be uploaded separately (e.g. smallest first)
+		*
+		* @param baseLevel First mip level of the range
+		* @param levelCount Number of mip levels in the range
+		* @param regions Receives the copy regions, buffer offsets are relative to the staging memory written by copyLevelsTo()
+		* @param (Optional) maxLayerCount Only return regions for the first layers (e.g. one for 2D textures)
+		*
+		* @return Size of the staging memory required by copyLevelsTo()
+		*/
+		VkDeviceSize getLevelCopyRegions(uint32_t baseLevel, uint32_t levelCount, std::vector<VkBufferImageCopy> &regions, uint32_t maxLayerCount = UINT32_MAX) const
+		{
+			regions.clear();
+			VkDeviceSize size = 0;
+			for (auto &subresource : subresources)
+			{
+				if ((subresource.level < baseLevel) || (subresource.level >= baseLevel + levelCount) || (subresource.layer >= maxLayerCount))
+				{
+					continue;
+				}
+				VkBufferImageCopy region = {};
+				region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				region.imageSubresource.mipLevel = subresource.level;
+				region.imageSubresource.baseArrayLayer = subresource.layer;
+				region.imageSubresource.layerCount = 1;
+				region.imageExtent.width = subresource.width;
+				region.imageExtent.height = subresource.height;
+				region.imageExtent.depth = 1;
+				region.bufferOffset = (size + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+				size = region.bufferOffset + subresource.size;
+				regions.push_back(region);
+			}
+			return size;
+		}
+
+		/** @brief Copy the image data of a range of mip levels into staging memory laid out as returned by getLevelCopyRegions() */
+		void copyLevelsTo(uint8_t *staging, uint32_t baseLevel, uint32_t levelCount, uint32_t maxLayerCount = UINT32_MAX) const
+		{
+			VkDeviceSize offset = 0;
+			for (auto &subresource : subresources)
+			{
+				if ((subresource.level < baseLevel) || (subresource.level >= baseLevel + levelCount) || (subresource.layer >= maxLayerCount))
+				{
+					continue;
+				}
+				offset = (offset + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+				memcpy(staging + offset, subresource.data, static_cast<size_t>(subresource.size));
+				offset += subresource.size;
+			}
+		}
+
+		/** @brief Copy the image data of all subresources from the file into staging memory of at least stagingSize bytes */
+		void copyTo(uint8_t *staging) const
+		{
+			for (auto &subresource : subresources)
+			{
+				memcpy(staging + subresource.stagingOffset, subresource.data, static_cast<size_t>(subresource.size));
+			}
+		}
+	};
+}
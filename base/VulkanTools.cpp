@@ -8,6 +8,13 @@
 
 #include "VulkanTools.h"
 
+#include <sstream>
+#include <thread>
+#include <functional>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
 namespace vks
 {
 	namespace tools
@@ -87,6 +94,104 @@ namespace vks
 			return false;
 		}
 
+		uint32_t getFormatBlockSize(VkFormat format)
+		{
+			// The core formats are ordered by their components, so the sizes are looked up by range
+			if (format == VK_FORMAT_UNDEFINED)
+				return 0;
+			if (format <= VK_FORMAT_R4G4_UNORM_PACK8)
+				return 1;
+			if (format <= VK_FORMAT_A1R5G5B5_UNORM_PACK16)
+				return 2;
+			if (format <= VK_FORMAT_R8_SRGB)
+				return 1;
+			if (format <= VK_FORMAT_R8G8_SRGB)
+				return 2;
+			if (format <= VK_FORMAT_B8G8R8_SRGB)
+				return 3;
+			if (format <= VK_FORMAT_A2B10G10R10_SINT_PACK32)
+				return 4;
+			if (format <= VK_FORMAT_R16_SFLOAT)
+				return 2;
+			if (format <= VK_FORMAT_R16G16_SFLOAT)
+				return 4;
+			if (format <= VK_FORMAT_R16G16B16_SFLOAT)
+				return 6;
+			if (format <= VK_FORMAT_R16G16B16A16_SFLOAT)
+				return 8;
+			if (format <= VK_FORMAT_R32_SFLOAT)
+				return 4;
+			if (format <= VK_FORMAT_R32G32_SFLOAT)
+				return 8;
+			if (format <= VK_FORMAT_R32G32B32_SFLOAT)
+				return 12;
+			if (format <= VK_FORMAT_R32G32B32A32_SFLOAT)
+				return 16;
+			if (format <= VK_FORMAT_R64_SFLOAT)
+				return 8;
+			if (format <= VK_FORMAT_R64G64_SFLOAT)
+				return 16;
+			if (format <= VK_FORMAT_R64G64B64_SFLOAT)
+				return 24;
+			if (format <= VK_FORMAT_R64G64B64A64_SFLOAT)
+				return 32;
+			switch (format)
+			{
+			case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+			case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+			case VK_FORMAT_X8_D24_UNORM_PACK32:
+			case VK_FORMAT_D32_SFLOAT:
+			case VK_FORMAT_D24_UNORM_S8_UINT:
+				return 4;
+			case VK_FORMAT_D16_UNORM:
+				return 2;
+			case VK_FORMAT_S8_UINT:
+				return 1;
+			case VK_FORMAT_D16_UNORM_S8_UINT:
+				return 3;
+			case VK_FORMAT_D32_SFLOAT_S8_UINT:
+				return 8;
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			case VK_FORMAT_BC4_UNORM_BLOCK:
+			case VK_FORMAT_BC4_SNORM_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+			case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+			case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+			case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+				return 8;
+			default:
+				break;
+			}
+			// All remaining block compressed core formats (BC2/3/5/6H/7, ETC2 RGBA, EAC RG, ASTC) use 16 byte blocks
+			if (format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK)
+				return 16;
+			return 0;
+		}
+
+		VkDeviceSize getBufferImageCopyAlignment(VkFormat format)
+		{
+			VkDeviceSize alignment = 16;
+			VkDeviceSize blockSize = getFormatBlockSize(format);
+			if (blockSize > 0)
+			{
+				// Least common multiple
+				VkDeviceSize a = alignment, b = blockSize;
+				while (b != 0)
+				{
+					VkDeviceSize t = a % b;
+					a = b;
+					b = t;
+				}
+				alignment = alignment / a * blockSize;
+			}
+			return alignment;
+		}
+
 		// Create an image memory barrier for changing the layout of
 		// an image and put it into an active command buffer
 		// See chapter 11.4 "Image Layout" for details
@@ -350,6 +455,18 @@ namespace vks
 		}
 #endif
 
+		std::string getTemporaryFilename(const std::string &filename)
+		{
+#if defined(_WIN32)
+			unsigned long processId = GetCurrentProcessId();
+#else
+			unsigned long processId = static_cast<unsigned long>(getpid());
+#endif
+			std::stringstream ss;
+			ss << filename << "." << processId << "_" << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp";
+			return ss.str();
+		}
+
 		VkShaderModule loadShaderGLSL(const char *fileName, VkDevice device, VkShaderStageFlagBits stage)
 		{
 			std::string shaderSrc = readTextFile(fileName);
@@ -72,6 +72,13 @@ namespace vks
 		// Returns false if none of the depth formats in the list is supported by the device
 		VkBool32 getSupportedDepthFormat(VkPhysicalDevice physicalDevice, VkFormat *depthFormat);
 
+		// Returns the size in bytes of a texel (or a compressed block) of the format, 0 for formats not covered (e.g. multi-planar)
+		uint32_t getFormatBlockSize(VkFormat format);
+
+		// Returns the alignment for buffer offsets of buffer to image copies of the format
+		// This is the least common multiple of 16 and the texel (or block) size, so formats with 6 or 12 byte texels (e.g. RGB16, RGB32F) stay aligned
+		VkDeviceSize getBufferImageCopyAlignment(VkFormat format);
+
 		// Put an image memory barrier for setting an image layout on the sub resource into the given command buffer
 		void setImageLayout(
 			VkCommandBuffer cmdbuffer,
@@ -114,6 +121,10 @@ namespace vks
 		VkShaderModule loadShader(const char *fileName, VkDevice device, VkShaderStageFlagBits stage);
 #endif
 
+		// Name of a temporary file next to the given file that is unique to the calling process and thread
+		// Written cache files are renamed over the final file, so concurrent writers never see each other's partial files
+		std::string getTemporaryFilename(const std::string &filename);
+
 		// Load a GLSL shader (text)
 		// Note: GLSL support requires vendor-specific extensions to be enabled and is not a core-feature of Vulkan
 		VkShaderModule loadShaderGLSL(const char *fileName, VkDevice device, VkShaderStageFlagBits stage);
@@ -0,0 +1,749 @@
+/*
+* Vulkan upload queue class
+*
+* Batches buffer and image uploads through a persistently mapped staging ring buffer
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <functional>
+#include <assert.h>
+#include <string.h>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+#include "VulkanMemoryAllocator.hpp"
+
+namespace vks
+{
+	/** @brief Identifies the batch an upload has been recorded into, can be used to check for or wait on its completion */
+	struct UploadToken
+	{
+		/** @brief Batch id, zero means there is nothing to wait for */
+		uint64_t batch = 0;
+	};
+
+	/**
+	* @brief Records uploads into batches that are submitted at once instead of waiting on the queue for every single copy
+	*
+	* Data is copied into a persistently mapped staging ring buffer. Each submitted batch is tracked by a fence and
+	* the ring space it used is reclaimed once the fence has signaled. Uploads that are larger than the ring get a
+	* temporary staging buffer that is released along with their batch.
+	*
+	* If the device has a separate transfer queue family, batches are executed on that queue. Otherwise the copies are executed on the graphics queue.
+	* Resources that are used on a different queue family than the one the batch is executed on (by default the graphics queue family,
+	* uploads can name another one, e.g. the compute family) have their ownership transferred: released at the end of the batch and
+	* acquired by a command buffer submitted to a queue of the destination family after waiting on a semaphore.
+	* Images are copied in whole mip levels, so the transfer queue's minImageTransferGranularity is always satisfied.
+	*
+	* @note Batches also submit to the graphics queue. Submissions are guarded by the queue mutex passed to create, other threads
+	* submitting to the same queues (e.g. the frame's command buffers) must hold it too
+	*/
+	class UploadQueue
+	{
+	private:
+		// Ownership acquisition of a batch's resources on another queue family
+		struct Acquire
+		{
+			uint32_t queueFamily;
+			VkCommandBuffer cmd = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+			VkSemaphore semaphore = VK_NULL_HANDLE;
+			// Set if resources of the current batch are transferred to this family
+			bool used = false;
+			std::vector<VkBufferMemoryBarrier> bufferBarriers;
+			std::vector<VkImageMemoryBarrier> imageBarriers;
+		};
+
+		// Queue and command pool of a destination queue family
+		struct QueueFamily
+		{
+			uint32_t index;
+			VkQueue queue;
+			VkCommandPool commandPool;
+		};
+
+		struct Batch
+		{
+			uint64_t id = 0;
+			VkCommandBuffer transferCmd = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+			// Set if the batch holds staging ring space, ringEnd is the ring position after its last allocation
+			bool usesRing = false;
+			VkDeviceSize ringEnd = 0;
+			// Staging buffers for uploads that don't fit into the ring
+			std::vector<std::pair<VkBuffer, vks::Allocation>> temporaryBuffers;
+			// Layout transitions of images used on the transfer queue family, recorded at the end of the batch
+			std::vector<VkImageMemoryBarrier> imageBarriers;
+			// One per destination queue family the batch has ever transferred resources to
+			std::vector<Acquire> acquires;
+		};
+
+		VkDevice device = VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		vks::MemoryAllocator *allocator = nullptr;
+
+		VkQueue transferQueue = VK_NULL_HANDLE;
+		uint32_t transferQueueFamily = 0;
+		uint32_t graphicsQueueFamily = 0;
+		VkCommandPool transferCommandPool = VK_NULL_HANDLE;
+		// Destination queue families other than the transfer queue family, created on first use
+		std::vector<QueueFamily> queueFamilies;
+
+		VkBuffer ringBuffer = VK_NULL_HANDLE;
+		vks::Allocation ringAllocation;
+		VkDeviceSize ringSize = 0;
+		VkDeviceSize ringHead = 0;
+		VkDeviceSize ringTail = 0;
+
+		Batch *currentBatch = nullptr;
+		std::deque<Batch*> pendingBatches;
+		std::vector<Batch*> freeBatches;
+		uint64_t nextBatchId = 1;
+		uint64_t completedBatchId = 0;
+
+		std::mutex mutex;
+		// Shared with other users of the queues, may be null
+		std::mutex *queueMutex = nullptr;
+
+		void queueSubmit(VkQueue queue, const VkSubmitInfo &submitInfo, VkFence fence)
+		{
+			if (queueMutex)
+			{
+				std::lock_guard<std::mutex> lock(*queueMutex);
+				VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, fence));
+			}
+			else
+			{
+				VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, fence));
+			}
+		}
+
+		uint32_t getMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties)
+		{
+			for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+			{
+				if ((typeBits & (1 << i)) && ((memoryProperties.memoryTypes[i].propertyFlags & properties) == properties))
+				{
+					return i;
+				}
+			}
+			vks::tools::exitFatal("Could not find a host visible memory type for upload staging", "Fatal error");
+			return 0;
+		}
+
+		VkResult createStagingBuffer(VkDeviceSize size, VkBuffer *buffer, vks::Allocation *allocation)
+		{
+			VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, size);
+			VK_CHECK_RESULT(vkCreateBuffer(device, &bufferCreateInfo, nullptr, buffer));
+			VkMemoryRequirements memReqs;
+			vkGetBufferMemoryRequirements(device, *buffer, &memReqs);
+			// Coherent memory, so host writes don't need to be flushed
+			uint32_t memoryTypeIndex = getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			VK_CHECK_RESULT(allocator->allocate(memReqs, memoryTypeIndex, true, allocation));
+			return vkBindBufferMemory(device, *buffer, allocation->memory, allocation->offset);
+		}
+
+		UploadToken makeToken(uint64_t batchId)
+		{
+			UploadToken token;
+			token.batch = batchId;
+			return token;
+		}
+
+		QueueFamily& getQueueFamily(uint32_t index)
+		{
+			for (auto& queueFamily : queueFamilies)
+			{
+				if (queueFamily.index == index)
+				{
+					return queueFamily;
+				}
+			}
+			QueueFamily queueFamily;
+			queueFamily.index = index;
+			vkGetDeviceQueue(device, index, 0, &queueFamily.queue);
+			// Command buffers are reused once their batch has completed
+			VkCommandPoolCreateInfo cmdPoolInfo = {};
+			cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+			cmdPoolInfo.queueFamilyIndex = index;
+			VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &queueFamily.commandPool));
+			queueFamilies.push_back(queueFamily);
+			return queueFamilies.back();
+		}
+
+		// Returns the acquisition of the current batch for a destination queue family that differs from the transfer queue family
+		Acquire& getAcquire(Batch *batch, uint32_t queueFamily)
+		{
+			for (auto& acquire : batch->acquires)
+			{
+				if (acquire.queueFamily == queueFamily)
+				{
+					acquire.used = true;
+					return acquire;
+				}
+			}
+			Acquire acquire;
+			acquire.queueFamily = queueFamily;
+			VkCommandBufferAllocateInfo cmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(getQueueFamily(queueFamily).commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &acquire.cmd));
+			VkFenceCreateInfo fenceInfo = vks::initializers::fenceCreateInfo(VK_FLAGS_NONE);
+			VK_CHECK_RESULT(vkCreateFence(device, &fenceInfo, nullptr, &acquire.fence));
+			VkSemaphoreCreateInfo semaphoreInfo = vks::initializers::semaphoreCreateInfo();
+			VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &acquire.semaphore));
+			acquire.used = true;
+			batch->acquires.push_back(acquire);
+			return batch->acquires.back();
+		}
+
+		// Default destination is the graphics queue family
+		uint32_t getDstQueueFamily(uint32_t dstQueueFamily)
+		{
+			return (dstQueueFamily == VK_QUEUE_FAMILY_IGNORED) ? graphicsQueueFamily : dstQueueFamily;
+		}
+
+		// Returns true if all submissions of a batch have finished executing
+		bool batchComplete(Batch *batch)
+		{
+			if (vkGetFenceStatus(device, batch->fence) != VK_SUCCESS)
+			{
+				return false;
+			}
+			for (auto& acquire : batch->acquires)
+			{
+				if (acquire.used && (vkGetFenceStatus(device, acquire.fence) != VK_SUCCESS))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void waitBatch(Batch *batch)
+		{
+			std::vector<VkFence> fences = { batch->fence };
+			for (auto& acquire : batch->acquires)
+			{
+				if (acquire.used)
+				{
+					fences.push_back(acquire.fence);
+				}
+			}
+			VK_CHECK_RESULT(vkWaitForFences(device, static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, UINT64_MAX));
+		}
+
+		Batch* getBatch()
+		{
+			if (currentBatch)
+			{
+				return currentBatch;
+			}
+			Batch *batch;
+			if (!freeBatches.empty())
+			{
+				batch = freeBatches.back();
+				freeBatches.pop_back();
+			}
+			else
+			{
+				batch = new Batch();
+				VkCommandBufferAllocateInfo cmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(transferCommandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+				VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &batch->transferCmd));
+				VkFenceCreateInfo fenceInfo = vks::initializers::fenceCreateInfo(VK_FLAGS_NONE);
+				VK_CHECK_RESULT(vkCreateFence(device, &fenceInfo, nullptr, &batch->fence));
+			}
+			batch->id = nextBatchId++;
+			batch->usesRing = false;
+			VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
+			cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			VK_CHECK_RESULT(vkBeginCommandBuffer(batch->transferCmd, &cmdBufInfo));
+			currentBatch = batch;
+			return batch;
+		}
+
+		bool ringEmpty()
+		{
+			if (currentBatch && currentBatch->usesRing)
+			{
+				return false;
+			}
+			for (auto batch : pendingBatches)
+			{
+				if (batch->usesRing)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Try to find space in the ring, the used range runs from tail to head and may wrap around
+		bool ringFits(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize *offset)
+		{
+			if (ringEmpty())
+			{
+				ringHead = ringTail = 0;
+			}
+			VkDeviceSize alignedHead = (ringHead + alignment - 1) / alignment * alignment;
+			if (ringHead >= ringTail)
+			{
+				if (alignedHead + size <= ringSize)
+				{
+					*offset = alignedHead;
+					return true;
+				}
+				// Wrap around, head must stay below tail so a full ring can't be confused with an empty one
+				if (size < ringTail)
+				{
+					*offset = 0;
+					return true;
+				}
+				return false;
+			}
+			if (alignedHead + size < ringTail)
+			{
+				*offset = alignedHead;
+				return true;
+			}
+			return false;
+		}
+
+		// Returns a pointer to staging memory for the upload and the buffer and offset to copy from
+		void* allocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkBuffer *buffer, VkDeviceSize *offset)
+		{
+			if (size > ringSize)
+			{
+				VkBuffer stagingBuffer;
+				vks::Allocation stagingAllocation;
+				VK_CHECK_RESULT(createStagingBuffer(size, &stagingBuffer, &stagingAllocation));
+				getBatch()->temporaryBuffers.push_back(std::make_pair(stagingBuffer, stagingAllocation));
+				*buffer = stagingBuffer;
+				*offset = 0;
+				return stagingAllocation.mapped;
+			}
+			while (!ringFits(size, alignment, offset))
+			{
+				// Reclaim space by waiting for the oldest batch, if no submitted batch holds ring space the current batch has to be submitted first
+				bool pendingRingSpace = false;
+				for (auto batch : pendingBatches)
+				{
+					pendingRingSpace |= batch->usesRing;
+				}
+				if (!pendingRingSpace)
+				{
+					submitBatch();
+				}
+				waitBatch(pendingBatches.front());
+				retireBatches();
+			}
+			Batch *batch = getBatch();
+			ringHead = *offset + size;
+			batch->usesRing = true;
+			batch->ringEnd = ringHead;
+			*buffer = ringBuffer;
+			return static_cast<uint8_t*>(ringAllocation.mapped) + *offset;
+		}
+
+		void submitBatch()
+		{
+			Batch *batch = currentBatch;
+			if (!batch)
+			{
+				return;
+			}
+			currentBatch = nullptr;
+
+			// Make the copies visible to later commands on the transfer queue family, transition its images and
+			// release the resources used on other queue families
+			std::vector<VkBufferMemoryBarrier> bufferBarriers;
+			std::vector<VkImageMemoryBarrier> imageBarriers;
+			for (auto& barrier : batch->imageBarriers)
+			{
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+				imageBarriers.push_back(barrier);
+			}
+			std::vector<VkSemaphore> signalSemaphores;
+			for (auto& acquire : batch->acquires)
+			{
+				if (!acquire.used)
+				{
+					continue;
+				}
+				for (auto barrier : acquire.bufferBarriers)
+				{
+					barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+					barrier.dstAccessMask = 0;
+					bufferBarriers.push_back(barrier);
+				}
+				for (auto barrier : acquire.imageBarriers)
+				{
+					barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+					barrier.dstAccessMask = 0;
+					imageBarriers.push_back(barrier);
+				}
+				signalSemaphores.push_back(acquire.semaphore);
+			}
+			recordBarriers(batch->transferCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, true, bufferBarriers, imageBarriers);
+			VK_CHECK_RESULT(vkEndCommandBuffer(batch->transferCmd));
+
+			VkSubmitInfo submitInfo = vks::initializers::submitInfo();
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &batch->transferCmd;
+			submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+			submitInfo.pSignalSemaphores = signalSemaphores.data();
+			queueSubmit(transferQueue, submitInfo, batch->fence);
+
+			// Acquire the released resources on their queue families with matching barriers
+			for (auto& acquire : batch->acquires)
+			{
+				if (!acquire.used)
+				{
+					continue;
+				}
+				VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
+				cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+				VK_CHECK_RESULT(vkBeginCommandBuffer(acquire.cmd, &cmdBufInfo));
+				for (auto& barrier : acquire.bufferBarriers)
+				{
+					barrier.srcAccessMask = 0;
+					barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+				}
+				for (auto& barrier : acquire.imageBarriers)
+				{
+					barrier.srcAccessMask = 0;
+					barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+				}
+				recordBarriers(acquire.cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, false, acquire.bufferBarriers, acquire.imageBarriers);
+				VK_CHECK_RESULT(vkEndCommandBuffer(acquire.cmd));
+
+				VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+				VkSubmitInfo acquireSubmitInfo = vks::initializers::submitInfo();
+				acquireSubmitInfo.waitSemaphoreCount = 1;
+				acquireSubmitInfo.pWaitSemaphores = &acquire.semaphore;
+				acquireSubmitInfo.pWaitDstStageMask = &waitStageMask;
+				acquireSubmitInfo.commandBufferCount = 1;
+				acquireSubmitInfo.pCommandBuffers = &acquire.cmd;
+				queueSubmit(getQueueFamily(acquire.queueFamily).queue, acquireSubmitInfo, acquire.fence);
+				acquire.bufferBarriers.clear();
+				acquire.imageBarriers.clear();
+			}
+
+			batch->imageBarriers.clear();
+			pendingBatches.push_back(batch);
+		}
+
+		void recordBarriers(VkCommandBuffer cmdBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, bool memoryBarrier, const std::vector<VkBufferMemoryBarrier> &bufferBarriers, const std::vector<VkImageMemoryBarrier> &imageBarriers)
+		{
+			VkMemoryBarrier barrier = vks::initializers::memoryBarrier();
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+			vkCmdPipelineBarrier(
+				cmdBuffer,
+				srcStageMask,
+				dstStageMask,
+				0,
+				memoryBarrier ? 1 : 0, &barrier,
+				static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+				static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+		}
+
+		// Release the resources of all batches that have finished executing
+		void retireBatches()
+		{
+			while (!pendingBatches.empty())
+			{
+				Batch *batch = pendingBatches.front();
+				if (!batchComplete(batch))
+				{
+					break;
+				}
+				pendingBatches.pop_front();
+				VK_CHECK_RESULT(vkResetFences(device, 1, &batch->fence));
+				for (auto& acquire : batch->acquires)
+				{
+					if (acquire.used)
+					{
+						VK_CHECK_RESULT(vkResetFences(device, 1, &acquire.fence));
+						acquire.used = false;
+					}
+				}
+				if (batch->usesRing)
+				{
+					ringTail = batch->ringEnd;
+				}
+				for (auto& temporaryBuffer : batch->temporaryBuffers)
+				{
+					vkDestroyBuffer(device, temporaryBuffer.first, nullptr);
+					allocator->free(temporaryBuffer.second);
+				}
+				batch->temporaryBuffers.clear();
+				completedBatchId = batch->id;
+				freeBatches.push_back(batch);
+			}
+		}
+
+		// Transfer the ownership of a buffer written by the current batch to the queue family it's used on (if that differs from the transfer queue family)
+		void transferOwnership(Batch *batch, VkBuffer buffer, uint32_t dstQueueFamily)
+		{
+			dstQueueFamily = getDstQueueFamily(dstQueueFamily);
+			if (dstQueueFamily == transferQueueFamily)
+			{
+				return;
+			}
+			VkBufferMemoryBarrier barrier = vks::initializers::bufferMemoryBarrier();
+			barrier.srcQueueFamilyIndex = transferQueueFamily;
+			barrier.dstQueueFamilyIndex = dstQueueFamily;
+			barrier.buffer = buffer;
+			barrier.offset = 0;
+			barrier.size = VK_WHOLE_SIZE;
+			getAcquire(batch, dstQueueFamily).bufferBarriers.push_back(barrier);
+		}
+
+	public:
+		/**
+		* Set up the upload queue
+		*
+		* @param physicalDevice Physical device (memory types)
+		* @param device Logical device
+		* @param allocator Memory allocator the staging ring is allocated from
+		* @param graphicsQueueFamily Queue family index the uploaded resources are used on by default
+		* @param transferQueueFamily Queue family index uploads are executed on, ownership of uploaded resources used on other queue families is transferred
+		* @param ringSize (Optional) Size of the staging ring buffer in bytes (defaults to 32 MB)
+		* @param queueMutex (Optional) Mutex locked around all queue submissions, required if other threads submit to the same queues
+		*/
+		void create(VkPhysicalDevice physicalDevice, VkDevice device, vks::MemoryAllocator *allocator, uint32_t graphicsQueueFamily, uint32_t transferQueueFamily, VkDeviceSize ringSize = 32 * 1024 * 1024, std::mutex *queueMutex = nullptr)
+		{
+			this->device = device;
+			this->queueMutex = queueMutex;
+			this->allocator = allocator;
+			this->graphicsQueueFamily = graphicsQueueFamily;
+			this->transferQueueFamily = transferQueueFamily;
+			this->ringSize = ringSize;
+			vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+			vkGetDeviceQueue(device, transferQueueFamily, 0, &transferQueue);
+
+			// Command buffers are reused once their batch has completed
+			VkCommandPoolCreateInfo cmdPoolInfo = {};
+			cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+			cmdPoolInfo.queueFamilyIndex = transferQueueFamily;
+			VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &transferCommandPool));
+
+			VK_CHECK_RESULT(createStagingBuffer(ringSize, &ringBuffer, &ringAllocation));
+		}
+
+		/** @brief Wait for all uploads and release all resources */
+		void destroy()
+		{
+			if (device == VK_NULL_HANDLE)
+			{
+				return;
+			}
+			flush();
+			for (auto batch : freeBatches)
+			{
+				vkDestroyFence(device, batch->fence, nullptr);
+				for (auto& acquire : batch->acquires)
+				{
+					vkDestroyFence(device, acquire.fence, nullptr);
+					vkDestroySemaphore(device, acquire.semaphore, nullptr);
+				}
+				delete batch;
+			}
+			freeBatches.clear();
+			vkDestroyCommandPool(device, transferCommandPool, nullptr);
+			for (auto& queueFamily : queueFamilies)
+			{
+				vkDestroyCommandPool(device, queueFamily.commandPool, nullptr);
+			}
+			queueFamilies.clear();
+			vkDestroyBuffer(device, ringBuffer, nullptr);
+			allocator->free(ringAllocation);
+			device = VK_NULL_HANDLE;
+		}
+
+		/**
+		* Upload data to a buffer
+		*
+		* @param buffer Destination buffer (must have been created with VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+		* @param data Pointer to the data to upload, the data is copied so it can be released after this call returns
+		* @param size Size of the data in bytes
+		* @param (Optional) dstOffset Byte offset into the destination buffer
+		* @param (Optional) dstQueueFamily Queue family the buffer is used on (defaults to the graphics queue family)
+		*
+		* @return Token of the batch the upload has been recorded into
+		*/
+		UploadToken uploadBuffer(VkBuffer buffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset = 0, uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			VkBuffer srcBuffer;
+			VkBufferCopy copyRegion = {};
+			void *staging = allocateStaging(size, 16, &srcBuffer, &copyRegion.srcOffset);
+			memcpy(staging, data, size);
+			copyRegion.dstOffset = dstOffset;
+			copyRegion.size = size;
+			Batch *batch = getBatch();
+			vkCmdCopyBuffer(batch->transferCmd, srcBuffer, buffer, 1, &copyRegion);
+			transferOwnership(batch, buffer, dstQueueFamily);
+			return makeToken(batch->id);
+		}
+
+		/**
+		* Copy data between two buffers as part of the current batch
+		*
+		* @param src Source buffer (must have been created with VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+		* @param dst Destination buffer (must have been created with VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+		* @param copyRegion Region to copy
+		* @param (Optional) dstQueueFamily Queue family the destination buffer is used on (defaults to the graphics queue family)
+		*
+		* @note The source buffer must be kept alive until the returned token has completed
+		*
+		* @return Token of the batch the copy has been recorded into
+		*/
+		UploadToken copyBuffer(VkBuffer src, VkBuffer dst, VkBufferCopy copyRegion, uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			Batch *batch = getBatch();
+			vkCmdCopyBuffer(batch->transferCmd, src, dst, 1, &copyRegion);
+			transferOwnership(batch, dst, dstQueueFamily);
+			return makeToken(batch->id);
+		}
+
+		/**
+		* Upload data to an optimal tiled image
+		*
+		* @param image Destination image (must have been created with VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+		* @param format Format of the image, the staging memory is aligned to its texel (or compressed block) size
+		* @param data Pointer to the data to upload, the data is copied so it can be released after this call returns
+		* @param size Size of the data in bytes
+		* @param regions Copy regions, buffer offsets are relative to data
+		* @param subresourceRange Subresources written by the copy regions, their previous contents are discarded
+		* @param imageLayout Layout the subresources are transitioned to after the copy
+		* @param (Optional) dstQueueFamily Queue family the image is used on (defaults to the graphics queue family)
+		*
+		* @return Token of the batch the upload has been recorded into
+		*/
+		UploadToken uploadImage(VkImage image, VkFormat format, const void *data, VkDeviceSize size, std::vector<VkBufferImageCopy> regions, VkImageSubresourceRange subresourceRange, VkImageLayout imageLayout, uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED)
+		{
+			return uploadImage(image, format, size, regions, subresourceRange, imageLayout, [data, size](uint8_t *staging) { memcpy(staging, data, static_cast<size_t>(size)); }, dstQueueFamily);
+		}
+
+		/**
+		* Upload data to an optimal tiled image, the data is written directly into the staging memory by a callback
+		*
+		* @param image Destination image (must have been created with VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+		* @param format Format of the image, the staging memory is aligned to its texel (or compressed block) size
+		* @param size Size of the staging memory in bytes
+		* @param regions Copy regions, buffer offsets are relative to the start of the staging memory
+		* @param subresourceRange Subresources written by the copy regions, their previous contents are discarded
+		* @param imageLayout Layout the subresources are transitioned to after the copy
+		* @param write Called with a pointer to the staging memory, must fill it before returning (e.g. straight from a memory mapped file)
+		* @param (Optional) dstQueueFamily Queue family the image is used on (defaults to the graphics queue family)
+		*
+		* @return Token of the batch the upload has been recorded into
+		*/
+		UploadToken uploadImage(VkImage image, VkFormat format, VkDeviceSize size, std::vector<VkBufferImageCopy> regions, VkImageSubresourceRange subresourceRange, VkImageLayout imageLayout, const std::function<void(uint8_t*)> &write, uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			VkBuffer srcBuffer;
+			VkDeviceSize srcOffset;
+			// Buffer offsets of image copies must be a multiple of the texel (or compressed block) size and of four
+			void *staging = allocateStaging(size, vks::tools::getBufferImageCopyAlignment(format), &srcBuffer, &srcOffset);
+			write(static_cast<uint8_t*>(staging));
+			for (auto& region : regions)
+			{
+				region.bufferOffset += srcOffset;
+			}
+			Batch *batch = getBatch();
+			vks::tools::insertImageMemoryBarrier(
+				batch->transferCmd,
+				image,
+				0,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				subresourceRange);
+			vkCmdCopyBufferToImage(batch->transferCmd, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+			// The transition to the final layout is recorded with the other barriers at the end of the batch
+			VkImageMemoryBarrier barrier = vks::initializers::imageMemoryBarrier();
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = imageLayout;
+			barrier.image = image;
+			barrier.subresourceRange = subresourceRange;
+			dstQueueFamily = getDstQueueFamily(dstQueueFamily);
+			if (dstQueueFamily != transferQueueFamily)
+			{
+				// The layout transition is part of the ownership transfer
+				barrier.srcQueueFamilyIndex = transferQueueFamily;
+				barrier.dstQueueFamilyIndex = dstQueueFamily;
+				getAcquire(batch, dstQueueFamily).imageBarriers.push_back(barrier);
+			}
+			else
+			{
+				batch->imageBarriers.push_back(barrier);
+			}
+			return makeToken(batch->id);
+		}
+
+		/**
+		* Submit all uploads recorded since the last submit
+		*
+		* @return Token of the submitted batch (a token that is already complete if there was nothing to submit)
+		*/
+		UploadToken submit()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			submitBatch();
+			retireBatches();
+			return makeToken(nextBatchId - 1);
+		}
+
+		/** @brief Token covering all uploads recorded so far, including those of the batch that hasn't been submitted yet (does not submit) */
+		UploadToken recordedToken()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return makeToken(currentBatch ? currentBatch->id : nextBatchId - 1);
+		}
+
+		/** @brief Returns true if all uploads of the token's batch have finished executing (does not submit or wait) */
+		bool isComplete(UploadToken token)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			retireBatches();
+			return token.batch <= completedBatchId;
+		}
+
+		/** @brief Wait until all uploads of the token's batch have finished executing, submits the current batch if the token belongs to it */
+		void wait(UploadToken token)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (currentBatch && (token.batch >= currentBatch->id))
+			{
+				submitBatch();
+			}
+			while (!pendingBatches.empty() && (pendingBatches.front()->id <= token.batch))
+			{
+				waitBatch(pendingBatches.front());
+				retireBatches();
+			}
+		}
+
+		/** @brief Submit all recorded uploads and wait until they have finished executing */
+		void flush()
+		{
+			wait(submit());
+		}
+	};
+}
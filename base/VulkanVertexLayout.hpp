@@ -0,0 +1,582 @@
+/*
+* Vertex layouts and vertex writers
+*
+* Describes the components of a vertex at runtime (VertexLayout) or at compile time (VertexFormat) and converts source vertex data into that layout
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "vulkan/vulkan.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define VKS_VERTEX_WRITER_SSE
+#include <emmintrin.h>
+#endif
+
+namespace vks
+{
+	/** @brief Vertex layout components */
+	typedef enum Component {
+		VERTEX_COMPONENT_POSITION = 0x0,
+		VERTEX_COMPONENT_NORMAL = 0x1,
+		VERTEX_COMPONENT_COLOR = 0x2,
+		VERTEX_COMPONENT_UV = 0x3,
+		VERTEX_COMPONENT_TANGENT = 0x4,
+		VERTEX_COMPONENT_BITANGENT = 0x5,
+		VERTEX_COMPONENT_DUMMY_FLOAT = 0x6,
+		VERTEX_COMPONENT_DUMMY_VEC4 = 0x7,
+		// Quantized components, see componentFormat() for the matching vertex input formats
+		// Position as four half floats (w = 1)
+		VERTEX_COMPONENT_POSITION_HALF = 0x8,
+		// Position as four snorm16 values (w = 1) relative to the bounds of the part, needs to be dequantized with the part's scale and offset
+		VERTEX_COMPONENT_POSITION_SNORM16 = 0x9,
+		// Octahedral encoded unit vectors as two snorm16 values, need to be decoded in the shader
+		VERTEX_COMPONENT_NORMAL_OCTAHEDRAL = 0xA,
+		VERTEX_COMPONENT_TANGENT_OCTAHEDRAL = 0xB,
+		// Texture coordinates as two unorm16 values, only for texture coordinates inside of [0..1]
+		VERTEX_COMPONENT_UV_UNORM16 = 0xC,
+		// Color as four unorm8 values (alpha = 1)
+		VERTEX_COMPONENT_COLOR_UNORM8 = 0xD
+	} Component;
+
+	/** @brief Size in bytes of a vertex component */
+	inline constexpr uint32_t componentSize(Component component)
+	{
+		return (component == VERTEX_COMPONENT_UV) ? 2 * sizeof(float) :
+			(component == VERTEX_COMPONENT_DUMMY_FLOAT) ? sizeof(float) :
+			(component == VERTEX_COMPONENT_DUMMY_VEC4) ? 4 * sizeof(float) :
+			((component == VERTEX_COMPONENT_POSITION_HALF) || (component == VERTEX_COMPONENT_POSITION_SNORM16)) ? 4 * sizeof(uint16_t) :
+			((component == VERTEX_COMPONENT_NORMAL_OCTAHEDRAL) || (component == VERTEX_COMPONENT_TANGENT_OCTAHEDRAL) || (component == VERTEX_COMPONENT_UV_UNORM16)) ? 2 * sizeof(uint16_t) :
+			(component == VERTEX_COMPONENT_COLOR_UNORM8) ? 4 * sizeof(uint8_t) :
+			// All components except the ones listed above are made up of 3 floats
+			3 * sizeof(float);
+	}
+
+	/** @brief Vertex input attribute format of a vertex component */
+	inline VkFormat componentFormat(Component component)
+	{
+		switch (component)
+		{
+		case VERTEX_COMPONENT_UV:
+			return VK_FORMAT_R32G32_SFLOAT;
+		case VERTEX_COMPONENT_DUMMY_FLOAT:
+			return VK_FORMAT_R32_SFLOAT;
+		case VERTEX_COMPONENT_DUMMY_VEC4:
+			return VK_FORMAT_R32G32B32A32_SFLOAT;
+		case VERTEX_COMPONENT_POSITION_HALF:
+			return VK_FORMAT_R16G16B16A16_SFLOAT;
+		case VERTEX_COMPONENT_POSITION_SNORM16:
+			return VK_FORMAT_R16G16B16A16_SNORM;
+		case VERTEX_COMPONENT_NORMAL_OCTAHEDRAL:
+		case VERTEX_COMPONENT_TANGENT_OCTAHEDRAL:
+			return VK_FORMAT_R16G16_SNORM;
+		case VERTEX_COMPONENT_UV_UNORM16:
+			return VK_FORMAT_R16G16_UNORM;
+		case VERTEX_COMPONENT_COLOR_UNORM8:
+			return VK_FORMAT_R8G8B8A8_UNORM;
+		default:
+			return VK_FORMAT_R32G32B32_SFLOAT;
+		}
+	}
+
+	/** @brief Stores vertex layout components for model loading and Vulkan vertex input and atribute bindings  */
+	struct VertexLayout {
+	private:
+		uint32_t vertexStride = 0;
+		std::vector<uint32_t> offsets;
+	public:
+		/** @brief Components used to generate vertices from (must not be changed after construction) */
+		std::vector<Component> components;
+
+		VertexLayout(std::vector<Component> components)
+		{
+			this->components = std::move(components);
+			// Offsets and stride are calculated once instead of on every call
+			offsets.reserve(this->components.size());
+			for (auto& component : this->components)
+			{
+				offsets.push_back(vertexStride);
+				vertexStride += componentSize(component);
+			}
+		}
+
+		/** @brief Size of a single vertex in bytes */
+		uint32_t stride() const
+		{
+			return vertexStride;
+		}
+
+		/** @brief Offset in bytes of a component inside of the vertex */
+		uint32_t offset(uint32_t index) const
+		{
+			return offsets[index];
+		}
+
+		/** @brief Vertex input attribute format of a component */
+		VkFormat format(uint32_t index) const
+		{
+			return componentFormat(components[index]);
+		}
+	};
+
+	namespace vertexwriter
+	{
+		/**
+		* @brief Source data for a range of vertices
+		* @note Vectors are tightly packed arrays of 3 floats (e.g. aiVector3D), arrays that are nullptr are written as zeros
+		*/
+		struct VertexSource
+		{
+			uint32_t count = 0;
+			const float *positions = nullptr;
+			const float *normals = nullptr;
+			// Texture coordinates are stored as 3 floats, only the first two are used
+			const float *texCoords = nullptr;
+			const float *tangents = nullptr;
+			const float *bitangents = nullptr;
+			// Color applied to all vertices
+			glm::vec3 color = glm::vec3(0.0f);
+			// Positions are transformed by position * scale + center
+			glm::vec3 scale = glm::vec3(1.0f);
+			glm::vec3 center = glm::vec3(0.0f);
+			glm::vec2 uvscale = glm::vec2(1.0f);
+			// Snorm16 positions store (position - quantizationOffset) / quantizationScale
+			glm::vec3 quantizationScale = glm::vec3(1.0f);
+			glm::vec3 quantizationOffset = glm::vec3(0.0f);
+		};
+
+		/**
+		* Write count vectors of 3 floats from src to dst transformed by v * mul + add
+		*
+		* @param dst Destination of the first vector
+		* @param stride Distance in bytes between two vectors in dst
+		*/
+		inline void transformVec3(const float *src, uint32_t count, glm::vec3 mul, glm::vec3 add, uint8_t *dst, uint32_t stride)
+		{
+			uint32_t i = 0;
+#if defined(VKS_VERTEX_WRITER_SSE)
+			// Four source vectors are exactly three SSE registers, the factors are rotated to match the components in each register
+			const __m128 mul0 = _mm_setr_ps(mul.x, mul.y, mul.z, mul.x);
+			const __m128 mul1 = _mm_setr_ps(mul.y, mul.z, mul.x, mul.y);
+			const __m128 mul2 = _mm_setr_ps(mul.z, mul.x, mul.y, mul.z);
+			const __m128 add0 = _mm_setr_ps(add.x, add.y, add.z, add.x);
+			const __m128 add1 = _mm_setr_ps(add.y, add.z, add.x, add.y);
+			const __m128 add2 = _mm_setr_ps(add.z, add.x, add.y, add.z);
+			float transformed[12];
+			for (; i + 4 <= count; i += 4)
+			{
+				const float *s = src + i * 3;
+				_mm_storeu_ps(transformed + 0, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s + 0), mul0), add0));
+				_mm_storeu_ps(transformed + 4, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s + 4), mul1), add1));
+				_mm_storeu_ps(transformed + 8, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s + 8), mul2), add2));
+				memcpy(dst + (i + 0) * stride, transformed + 0, 3 * sizeof(float));
+				memcpy(dst + (i + 1) * stride, transformed + 3, 3 * sizeof(float));
+				memcpy(dst + (i + 2) * stride, transformed + 6, 3 * sizeof(float));
+				memcpy(dst + (i + 3) * stride, transformed + 9, 3 * sizeof(float));
+			}
+#endif
+			for (; i < count; i++)
+			{
+				const float v[3] = { src[i * 3 + 0] * mul.x + add.x, src[i * 3 + 1] * mul.y + add.y, src[i * 3 + 2] * mul.z + add.z };
+				memcpy(dst + i * stride, v, sizeof(v));
+			}
+		}
+
+		/** @brief Write the same values to count vertices */
+		inline void fill(const float *values, uint32_t valueCount, uint32_t count, uint8_t *dst, uint32_t stride)
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				memcpy(dst + i * stride, values, valueCount * sizeof(float));
+			}
+		}
+
+		/** @brief Encode a unit vector with octahedral mapping into two snorm16 values */
+		inline uint32_t encodeOctahedral(glm::vec3 v)
+		{
+			float length = fabsf(v.x) + fabsf(v.y) + fabsf(v.z);
+			if (length == 0.0f)
+			{
+				return glm::packSnorm2x16(glm::vec2(0.0f));
+			}
+			glm::vec2 p = glm::vec2(v.x, v.y) / length;
+			if (v.z < 0.0f)
+			{
+				// Fold the lower hemisphere over the diagonals
+				glm::vec2 sign = glm::vec2((p.x >= 0.0f) ? 1.0f : -1.0f, (p.y >= 0.0f) ? 1.0f : -1.0f);
+				p = (glm::vec2(1.0f) - glm::abs(glm::vec2(p.y, p.x))) * sign;
+			}
+			return glm::packSnorm2x16(p);
+		}
+
+		/** @brief Decode an octahedral mapped unit vector, the shader needs to do the same */
+		inline glm::vec3 decodeOctahedral(uint32_t packed)
+		{
+			glm::vec2 p = glm::unpackSnorm2x16(packed);
+			glm::vec3 v = glm::vec3(p.x, p.y, 1.0f - fabsf(p.x) - fabsf(p.y));
+			float t = std::max(-v.z, 0.0f);
+			v.x += (v.x >= 0.0f) ? -t : t;
+			v.y += (v.y >= 0.0f) ? -t : t;
+			return glm::normalize(v);
+		}
+
+		/**
+		* Write count vectors of 3 floats from src to dst transformed by v * mul + add and converted by a packing function
+		*
+		* @param pack Converts a transformed vector into the packed value of type T that is written to dst
+		*/
+		template<typename T, typename Pack>
+		inline void packVec3(const float *src, uint32_t count, glm::vec3 mul, glm::vec3 add, uint8_t *dst, uint32_t stride, Pack pack)
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				T value = pack(glm::vec3(src[i * 3 + 0], src[i * 3 + 1], src[i * 3 + 2]) * mul + add);
+				memcpy(dst + i * stride, &value, sizeof(T));
+			}
+		}
+
+		/** @brief Writes a single component for all vertices of a source, specialized for each component */
+		template<Component C>
+		struct ComponentWriter;
+
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_POSITION>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				// Flip y to match Vulkan's coordinate system
+				transformVec3(source.positions, source.count, source.scale * glm::vec3(1.0f, -1.0f, 1.0f), source.center, dst, stride);
+			}
+		};
+
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_NORMAL>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				if (!source.normals)
+				{
+					const float zero[3] = {};
+					fill(zero, 3, source.count, dst, stride);
+					return;
+				}
+				transformVec3(source.normals, source.count, glm::vec3(1.0f, -1.0f, 1.0f), glm::vec3(0.0f), dst, stride);
+			}
+		};
+
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_COLOR>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				fill(&source.color.x, 3, source.count, dst, stride);
+			}
+		};
+
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_UV>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				if (!source.texCoords)
+				{
+					const float zero[2] = {};
+					fill(zero, 2, source.count, dst, stride);
+					return;
+				}
+				for (uint32_t i = 0; i < source.count; i++)
+				{
+					const float uv[2] = { source.texCoords[i * 3 + 0] * source.uvscale.s, source.texCoords[i * 3 + 1] * source.uvscale.t };
+					memcpy(dst + i * stride, uv, sizeof(uv));
+				}
+			}
+		};
+
+		// Tangents and bitangents are copied as they are
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_TANGENT>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				if (!source.tangents)
+				{
+					const float zero[3] = {};
+					fill(zero, 3, source.count, dst, stride);
+					return;
+				}
+				for (uint32_t i = 0; i < source.count; i++)
+				{
+					memcpy(dst + i * stride, source.tangents + i * 3, 3 * sizeof(float));
+				}
+			}
+		};
+
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_BITANGENT>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				if (!source.bitangents)
+				{
+					const float zero[3] = {};
+					fill(zero, 3, source.count, dst, stride);
+					return;
+				}
+				for (uint32_t i = 0; i < source.count; i++)
+				{
+					memcpy(dst + i * stride, source.bitangents + i * 3, 3 * sizeof(float));
+				}
+			}
+		};
+
+		// Dummy components for padding
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_DUMMY_FLOAT>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				const float zero[1] = {};
+				fill(zero, 1, source.count, dst, stride);
+			}
+		};
+
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_DUMMY_VEC4>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				const float zero[4] = {};
+				fill(zero, 4, source.count, dst, stride);
+			}
+		};
+
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_POSITION_HALF>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				packVec3<uint64_t>(source.positions, source.count, source.scale * glm::vec3(1.0f, -1.0f, 1.0f), source.center, dst, stride, [](glm::vec3 v) { return glm::packHalf4x16(glm::vec4(v, 1.0f)); });
+			}
+		};
+
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_POSITION_SNORM16>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				// Position transform and quantization are combined into one scale and offset
+				glm::vec3 mul = source.scale * glm::vec3(1.0f, -1.0f, 1.0f) / source.quantizationScale;
+				glm::vec3 add = (source.center - source.quantizationOffset) / source.quantizationScale;
+				packVec3<uint64_t>(source.positions, source.count, mul, add, dst, stride, [](glm::vec3 v) { return glm::packSnorm4x16(glm::vec4(v, 1.0f)); });
+			}
+		};
+
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_NORMAL_OCTAHEDRAL>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				if (!source.normals)
+				{
+					const uint32_t zero = encodeOctahedral(glm::vec3(0.0f));
+					for (uint32_t i = 0; i < source.count; i++)
+					{
+						memcpy(dst + i * stride, &zero, sizeof(zero));
+					}
+					return;
+				}
+				packVec3<uint32_t>(source.normals, source.count, glm::vec3(1.0f, -1.0f, 1.0f), glm::vec3(0.0f), dst, stride, encodeOctahedral);
+			}
+		};
+
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_TANGENT_OCTAHEDRAL>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				if (!source.tangents)
+				{
+					const uint32_t zero = encodeOctahedral(glm::vec3(0.0f));
+					for (uint32_t i = 0; i < source.count; i++)
+					{
+						memcpy(dst + i * stride, &zero, sizeof(zero));
+					}
+					return;
+				}
+				packVec3<uint32_t>(source.tangents, source.count, glm::vec3(1.0f), glm::vec3(0.0f), dst, stride, encodeOctahedral);
+			}
+		};
+
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_UV_UNORM16>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				for (uint32_t i = 0; i < source.count; i++)
+				{
+					glm::vec2 uv = source.texCoords ? glm::vec2(source.texCoords[i * 3 + 0], source.texCoords[i * 3 + 1]) * source.uvscale : glm::vec2(0.0f);
+					uint32_t value = glm::packUnorm2x16(uv);
+					memcpy(dst + i * stride, &value, sizeof(value));
+				}
+			}
+		};
+
+		template<>
+		struct ComponentWriter<VERTEX_COMPONENT_COLOR_UNORM8>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				uint32_t value = glm::packUnorm4x8(glm::vec4(source.color, 1.0f));
+				for (uint32_t i = 0; i < source.count; i++)
+				{
+					memcpy(dst + i * stride, &value, sizeof(value));
+				}
+			}
+		};
+
+		/**
+		* Write all vertices of a source in a runtime vertex layout
+		*
+		* @param layout Vertex layout
+		* @param source Source vertex data
+		* @param dst Destination, must be at least source.count * layout.stride() bytes
+		*
+		* @note The layout is only evaluated once per component, each component is then written for all vertices by a loop without branches
+		*/
+		inline void write(const VertexLayout &layout, const VertexSource &source, uint8_t *dst)
+		{
+			const uint32_t stride = layout.stride();
+			for (uint32_t i = 0; i < static_cast<uint32_t>(layout.components.size()); i++)
+			{
+				uint8_t *componentDst = dst + layout.offset(i);
+				switch (layout.components[i])
+				{
+				case VERTEX_COMPONENT_POSITION:
+					ComponentWriter<VERTEX_COMPONENT_POSITION>::write(source, componentDst, stride);
+					break;
+				case VERTEX_COMPONENT_NORMAL:
+					ComponentWriter<VERTEX_COMPONENT_NORMAL>::write(source, componentDst, stride);
+					break;
+				case VERTEX_COMPONENT_COLOR:
+					ComponentWriter<VERTEX_COMPONENT_COLOR>::write(source, componentDst, stride);
+					break;
+				case VERTEX_COMPONENT_UV:
+					ComponentWriter<VERTEX_COMPONENT_UV>::write(source, componentDst, stride);
+					break;
+				case VERTEX_COMPONENT_TANGENT:
+					ComponentWriter<VERTEX_COMPONENT_TANGENT>::write(source, componentDst, stride);
+					break;
+				case VERTEX_COMPONENT_BITANGENT:
+					ComponentWriter<VERTEX_COMPONENT_BITANGENT>::write(source, componentDst, stride);
+					break;
+				case VERTEX_COMPONENT_DUMMY_FLOAT:
+					ComponentWriter<VERTEX_COMPONENT_DUMMY_FLOAT>::write(source, componentDst, stride);
+					break;
+				case VERTEX_COMPONENT_DUMMY_VEC4:
+					ComponentWriter<VERTEX_COMPONENT_DUMMY_VEC4>::write(source, componentDst, stride);
+					break;
+				case VERTEX_COMPONENT_POSITION_HALF:
+					ComponentWriter<VERTEX_COMPONENT_POSITION_HALF>::write(source, componentDst, stride);
+					break;
+				case VERTEX_COMPONENT_POSITION_SNORM16:
+					ComponentWriter<VERTEX_COMPONENT_POSITION_SNORM16>::write(source, componentDst, stride);
+					break;
+				case VERTEX_COMPONENT_NORMAL_OCTAHEDRAL:
+					ComponentWriter<VERTEX_COMPONENT_NORMAL_OCTAHEDRAL>::write(source, componentDst, stride);
+					break;
+				case VERTEX_COMPONENT_TANGENT_OCTAHEDRAL:
+					ComponentWriter<VERTEX_COMPONENT_TANGENT_OCTAHEDRAL>::write(source, componentDst, stride);
+					break;
+				case VERTEX_COMPONENT_UV_UNORM16:
+					ComponentWriter<VERTEX_COMPONENT_UV_UNORM16>::write(source, componentDst, stride);
+					break;
+				case VERTEX_COMPONENT_COLOR_UNORM8:
+					ComponentWriter<VERTEX_COMPONENT_COLOR_UNORM8>::write(source, componentDst, stride);
+					break;
+				}
+			}
+		}
+
+		// Unrolls the components of a compile time format, offsets are template arguments
+		template<uint32_t Offset, Component... C>
+		struct FormatWriter;
+
+		template<uint32_t Offset>
+		struct FormatWriter<Offset>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride) {}
+		};
+
+		template<uint32_t Offset, Component First, Component... Rest>
+		struct FormatWriter<Offset, First, Rest...>
+		{
+			static void write(const VertexSource &source, uint8_t *dst, uint32_t stride)
+			{
+				ComponentWriter<First>::write(source, dst + Offset, stride);
+				FormatWriter<Offset + componentSize(First), Rest...>::write(source, dst, stride);
+			}
+		};
+
+		template<Component... C>
+		struct FormatStride;
+
+		template<>
+		struct FormatStride<>
+		{
+			static const uint32_t value = 0;
+		};
+
+		template<Component First, Component... Rest>
+		struct FormatStride<First, Rest...>
+		{
+			static const uint32_t value = componentSize(First) + FormatStride<Rest...>::value;
+		};
+	}
+
+	/**
+	* @brief Compile time vertex layout
+	*
+	* Stride and component offsets are known at compile time, so e.g. the size of a matching C++ vertex struct can be checked with a static_assert:
+	* @code
+	* typedef vks::VertexFormat<vks::VERTEX_COMPONENT_POSITION, vks::VERTEX_COMPONENT_NORMAL, vks::VERTEX_COMPONENT_UV> VertexFormat;
+	* static_assert(sizeof(Vertex) == VertexFormat::stride, "Vertex struct doesn't match the vertex format");
+	* vks::VertexLayout vertexLayout = VertexFormat::layout();
+	* @endcode
+	*/
+	template<Component... C>
+	struct VertexFormat
+	{
+		/** @brief Size of a single vertex in bytes */
+		static const uint32_t stride = vertexwriter::FormatStride<C...>::value;
+
+		/** @brief Runtime layout with the same components, e.g. for loading models */
+		static VertexLayout layout()
+		{
+			return VertexLayout({ C... });
+		}
+
+		/**
+		* Write all vertices of a source in this format
+		*
+		* @param source Source vertex data
+		* @param dst Destination, must be at least source.count * stride bytes
+		*/
+		static void write(const vertexwriter::VertexSource &source, uint8_t *dst)
+		{
+			vertexwriter::FormatWriter<0, C...>::write(source, dst, stride);
+		}
+	};
+}
@@ -0,0 +1,263 @@
+/*
+* Benchmark class
+*
+* Renders a fixed number of frames with a deterministic timer and exports frame time statistics
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <chrono>
+
+namespace vks
+{
+	/**
+	* @brief Runs an example's render function for a fixed number of frames and collects frame times
+	* @note Frame times are measured with a high performance clock, but the example's animation timer is advanced by a fixed step so that all runs render the same content
+	*/
+	class Benchmark
+	{
+	public:
+		/** @brief Frame time statistics in milliseconds */
+		struct Statistics
+		{
+			uint32_t frames = 0;
+			double min = 0.0;
+			double max = 0.0;
+			double mean = 0.0;
+			double median = 0.0;
+			double p95 = 0.0;
+			double p99 = 0.0;
+		};
+
+		/** @brief Set to true to run the benchmark instead of the regular render loop (-benchmark) */
+		bool active = false;
+		/** @brief Number of frames rendered before measuring starts (-benchwarmup) */
+		uint32_t warmupFrames = 50;
+		/** @brief Number of measured frames (-benchframes) */
+		uint32_t frameCount = 500;
+		/** @brief Fixed time step in seconds passed to the example as the frame time */
+		float frameTime = 1.0f / 60.0f;
+		/** @brief File the results are written to, the extension selects the format (.csv or .json) (-benchfile) */
+		std::string filename = "benchmark.csv";
+		/** @brief Measured frame times in milliseconds */
+		std::vector<double> frameTimes;
+		/** @brief Optional average GPU times in milliseconds of named passes, exported along with the frame times */
+		std::vector<std::pair<std::string, double>> gpuTimes;
+
+		/**
+		* Render the warmup and measured frames
+		*
+		* @param renderFunc Function called once per frame, responsible for rendering and advancing the timers
+		* @param measureStartFunc (Optional) Function called after the warmup, right before the first measured frame
+		* @param eventFunc (Optional) Function called before each frame to process window system events, outside of the measured time, returns false to stop the run
+		*
+		* @note Without processing events a windowed run is flagged as not responding and may get throttled by the compositor
+		*/
+		void run(std::function<void()> renderFunc, std::function<void()> measureStartFunc = nullptr, std::function<bool()> eventFunc = nullptr)
+		{
+			frameTimes.clear();
+			frameTimes.reserve(frameCount);
+			for (uint32_t i = 0; i < warmupFrames; i++)
+			{
+				if (eventFunc && !eventFunc())
+				{
+					return;
+				}
+				renderFunc();
+			}
+			if (measureStartFunc)
+			{
+				measureStartFunc();
+			}
+			for (uint32_t i = 0; i < frameCount; i++)
+			{
+				if (eventFunc && !eventFunc())
+				{
+					return;
+				}
+				auto tStart = std::chrono::high_resolution_clock::now();
+				renderFunc();
+				auto tEnd = std::chrono::high_resolution_clock::now();
+				frameTimes.push_back(std::chrono::duration<double, std::milli>(tEnd - tStart).count());
+			}
+		}
+
+		/** @brief Calculate min/max/mean/median and percentiles of the measured frame times */
+		Statistics getStatistics()
+		{
+			Statistics stats;
+			if (frameTimes.empty())
+			{
+				return stats;
+			}
+			std::vector<double> sorted(frameTimes);
+			std::sort(sorted.begin(), sorted.end());
+			stats.frames = static_cast<uint32_t>(sorted.size());
+			stats.min = sorted.front();
+			stats.max = sorted.back();
+			double sum = 0.0;
+			for (auto t : sorted)
+			{
+				sum += t;
+			}
+			stats.mean = sum / sorted.size();
+			size_t mid = sorted.size() / 2;
+			stats.median = (sorted.size() % 2 == 0) ? (sorted[mid - 1] + sorted[mid]) * 0.5 : sorted[mid];
+			stats.p95 = percentile(sorted, 95.0);
+			stats.p99 = percentile(sorted, 99.0);
+			return stats;
+		}
+
+		/**
+		* Write the frame time statistics to the benchmark file
+		*
+		* @param exampleName Name of the example that has been benchmarked
+		* @param deviceName Name of the physical device used for rendering
+		*
+		* @note CSV files get one row appended per run so results of several examples can be collected in a single file
+		*/
+		void saveResults(std::string exampleName, std::string deviceName)
+		{
+			Statistics stats = getStatistics();
+			std::cout << "Benchmark results for \"" << exampleName << "\" on \"" << deviceName << "\" (" << stats.frames << " frames)" << std::endl;
+			std::cout << std::fixed << std::setprecision(3);
+			std::cout << "\tmin " << stats.min << " ms, max " << stats.max << " ms, mean " << stats.mean << " ms" << std::endl;
+			std::cout << "\tmedian " << stats.median << " ms, p95 " << stats.p95 << " ms, p99 " << stats.p99 << " ms" << std::endl;
+			for (auto& gpuTime : gpuTimes)
+			{
+				std::cout << "\tGPU " << gpuTime.first << ": " << gpuTime.second << " ms" << std::endl;
+			}
+
+			bool json = (filename.size() >= 5) && (filename.substr(filename.size() - 5) == ".json");
+			if (json)
+			{
+				std::ofstream file(filename);
+				if (!file.is_open())
+				{
+					std::cerr << "Could not write benchmark results to \"" << filename << "\"" << std::endl;
+					return;
+				}
+				file << std::fixed << std::setprecision(4);
+				file << "{" << std::endl;
+				file << "\t\"example\": \"" << escapeJson(exampleName) << "\"," << std::endl;
+				file << "\t\"device\": \"" << escapeJson(deviceName) << "\"," << std::endl;
+				file << "\t\"warmupframes\": " << warmupFrames << "," << std::endl;
+				file << "\t\"frames\": " << stats.frames << "," << std::endl;
+				file << "\t\"frametime\": {" << std::endl;
+				file << "\t\t\"min\": " << stats.min << "," << std::endl;
+				file << "\t\t\"max\": " << stats.max << "," << std::endl;
+				file << "\t\t\"mean\": " << stats.mean << "," << std::endl;
+				file << "\t\t\"median\": " << stats.median << "," << std::endl;
+				file << "\t\t\"p95\": " << stats.p95 << "," << std::endl;
+				file << "\t\t\"p99\": " << stats.p99 << std::endl;
+				file << "\t}";
+				if (!gpuTimes.empty())
+				{
+					file << "," << std::endl;
+					file << "\t\"gputime\": {" << std::endl;
+					for (size_t i = 0; i < gpuTimes.size(); i++)
+					{
+						file << "\t\t\"" << escapeJson(gpuTimes[i].first) << "\": " << gpuTimes[i].second << ((i < gpuTimes.size() - 1) ? "," : "") << std::endl;
+					}
+					file << "\t}";
+				}
+				file << std::endl;
+				file << "}" << std::endl;
+			}
+			else
+			{
+				bool writeHeader;
+				{
+					std::ifstream existing(filename);
+					writeHeader = !existing.good() || (existing.peek() == std::ifstream::traits_type::eof());
+				}
+				std::ofstream file(filename, std::ios::app);
+				if (!file.is_open())
+				{
+					std::cerr << "Could not write benchmark results to \"" << filename << "\"" << std::endl;
+					return;
+				}
+				if (writeHeader)
+				{
+					file << "example,device,warmupframes,frames,min_ms,max_ms,mean_ms,median_ms,p95_ms,p99_ms,gpu_ms" << std::endl;
+				}
+				file << std::fixed << std::setprecision(4);
+				file << escapeCsv(exampleName) << "," << escapeCsv(deviceName) << "," << warmupFrames << "," << stats.frames << ",";
+				file << stats.min << "," << stats.max << "," << stats.mean << "," << stats.median << "," << stats.p95 << "," << stats.p99 << ",";
+				// Per pass GPU times differ between examples, so they're stored as a single "name=ms;..." column
+				std::ostringstream gpuColumn;
+				gpuColumn << std::fixed << std::setprecision(4);
+				for (size_t i = 0; i < gpuTimes.size(); i++)
+				{
+					gpuColumn << (i > 0 ? ";" : "") << gpuTimes[i].first << "=" << gpuTimes[i].second;
+				}
+				file << escapeCsv(gpuColumn.str()) << std::endl;
+			}
+			std::cout << "Benchmark results written to \"" << filename << "\"" << std::endl;
+		}
+
+	private:
+		// Escape a string for use inside of a JSON string literal
+		std::string escapeJson(const std::string& str)
+		{
+			std::ostringstream escaped;
+			for (char c : str)
+			{
+				switch (c)
+				{
+				case '"': escaped << "\\\""; break;
+				case '\\': escaped << "\\\\"; break;
+				case '\n': escaped << "\\n"; break;
+				case '\r': escaped << "\\r"; break;
+				case '\t': escaped << "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20)
+					{
+						escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+					}
+					else
+					{
+						escaped << c;
+					}
+				}
+			}
+			return escaped.str();
+		}
+
+		// Quote a CSV field, embedded quotes are doubled
+		std::string escapeCsv(const std::string& str)
+		{
+			std::string escaped = "\"";
+			for (char c : str)
+			{
+				if (c == '"')
+				{
+					escaped += '"';
+				}
+				escaped += c;
+			}
+			return escaped + "\"";
+		}
+
+		// Nearest rank percentile of an already sorted list
+		double percentile(const std::vector<double>& sorted, double p)
+		{
+			size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+			rank = std::max<size_t>(rank, 1);
+			return sorted[std::min(rank, sorted.size()) - 1];
+		}
+	};
+}
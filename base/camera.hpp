@@ -80,6 +80,11 @@ public:
 		matrices.perspective = glm::perspective(glm::radians(fov), aspect, znear, zfar);
 	}
 
+	float getFov()
+	{
+		return fov;
+	}
+
 	void setPosition(glm::vec3 position)
 	{
 		this->position = position;
@@ -6,10 +6,19 @@
 * This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
 */
 
+#pragma once
+
 #include <array>
+#include <vector>
 #include <math.h>
+#include <string.h>
 #include <glm/glm.hpp>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define VKS_FRUSTUM_SSE
+#include <emmintrin.h>
+#endif
+
 namespace vks
 {
 	class Frustum
@@ -68,5 +77,73 @@ namespace vks
 			}
 			return true;
 		}
+
+		bool checkBox(glm::vec3 min, glm::vec3 max)
+		{
+			for (uint32_t i = 0; i < planes.size(); i++)
+			{
+				// Corner of the box furthest along the plane normal
+				glm::vec3 p(planes[i].x >= 0.0f ? max.x : min.x, planes[i].y >= 0.0f ? max.y : min.y, planes[i].z >= 0.0f ? max.z : min.z);
+				if ((planes[i].x * p.x) + (planes[i].y * p.y) + (planes[i].z * p.z) + planes[i].w < 0.0f)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/**
+		* Test a batch of bounding spheres against the frustum
+		*
+		* @param spheres Pointer to the first sphere (xyz = center, w = radius), in the space the frustum has been built in
+		* @param count Number of spheres
+		* @param stride Distance in bytes between two spheres, allows reading the spheres straight from arrays of larger structures
+		* @param visible Receives the indices of all spheres inside of or intersecting the frustum
+		*
+		* @note Build the frustum from projection * view * model to test spheres in model space
+		*/
+		void cullSpheres(const glm::vec4 *spheres, uint32_t count, uint32_t stride, std::vector<uint32_t> &visible)
+		{
+			visible.clear();
+			const uint8_t *data = reinterpret_cast<const uint8_t*>(spheres);
+			uint32_t i = 0;
+#if defined(VKS_FRUSTUM_SSE)
+			// Four spheres at a time, transposed so each register holds one component of all four
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 x = _mm_loadu_ps(reinterpret_cast<const float*>(data + static_cast<size_t>(i + 0) * stride));
+				__m128 y = _mm_loadu_ps(reinterpret_cast<const float*>(data + static_cast<size_t>(i + 1) * stride));
+				__m128 z = _mm_loadu_ps(reinterpret_cast<const float*>(data + static_cast<size_t>(i + 2) * stride));
+				__m128 r = _mm_loadu_ps(reinterpret_cast<const float*>(data + static_cast<size_t>(i + 3) * stride));
+				_MM_TRANSPOSE4_PS(x, y, z, r);
+				__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (uint32_t p = 0; p < planes.size(); p++)
+				{
+					// Same summation order and comparison as checkSphere, so spheres touching a plane (distance == -radius) are culled by both paths
+					__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(planes[p].x)), _mm_mul_ps(y, _mm_set1_ps(planes[p].y))),
+						_mm_mul_ps(z, _mm_set1_ps(planes[p].z))), _mm_set1_ps(planes[p].w));
+					inside = _mm_and_ps(inside, _mm_cmpnle_ps(distance, negativeRadius));
+				}
+				int mask = _mm_movemask_ps(inside);
+				for (uint32_t k = 0; k < 4; k++)
+				{
+					if (mask & (1 << k))
+					{
+						visible.push_back(i + k);
+					}
+				}
+			}
+#endif
+			for (; i < count; i++)
+			{
+				glm::vec4 sphere;
+				memcpy(&sphere, data + static_cast<size_t>(i) * stride, sizeof(sphere));
+				if (checkSphere(glm::vec3(sphere), sphere.w))
+				{
+					visible.push_back(i);
+				}
+			}
+		}
 	};
 }
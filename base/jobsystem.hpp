@@ -0,0 +1,701 @@
+/*
+* Work stealing job system
+*
+* Each thread owns a lock-free Chase-Lev deque it pushes and pops jobs at the bottom of, idle threads steal from the top of other threads' deques
+* Jobs store their function inline, support dependencies on other jobs and can be split into child jobs (see parallelFor)
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <initializer_list>
+#include <assert.h>
+
+namespace vks
+{
+	/**
+	* @brief Job scheduled on a job system
+	* @note Jobs are allocated in blocks and reused, they are never accessed directly by users of the job system
+	*/
+	struct Job
+	{
+		/** @brief Maximum size in bytes of the function object stored in a job */
+		static const uint32_t storageSize = 64;
+		/** @brief Maximum number of jobs a single job can depend on */
+		static const uint32_t maxDependencies = 4;
+
+		// Links a job into the list of jobs waiting on another job to finish
+		struct Edge
+		{
+			Job *dependent;
+			Edge *next;
+		};
+
+		std::aligned_storage<storageSize, 16>::type storage;
+		void(*invoke)(Job*) = nullptr;
+		void(*destroy)(Job*) = nullptr;
+		// Parent job that finishes only once all of its children have finished
+		Job *parent = nullptr;
+		// Next job in a free list
+		Job *next = nullptr;
+		// The job itself plus all of its unfinished children
+		std::atomic<int32_t> unfinished;
+		// Unfinished dependencies plus one for the submission
+		std::atomic<int32_t> pendingDependencies;
+		// Incremented every time the job is reused, so handles to earlier uses of the job report them as finished
+		std::atomic<uint32_t> generation;
+		std::atomic<bool> finished;
+		// Protects finished and dependents
+		std::atomic_flag lock;
+		Edge *dependents = nullptr;
+		Edge edges[maxDependencies];
+		uint32_t edgeCount = 0;
+		// Index of the thread context that allocated the job and gets it back once finished
+		uint32_t owner = 0;
+
+		Job() : unfinished(0), pendingDependencies(0), generation(0), finished(true)
+		{
+			lock.clear();
+		}
+
+		void acquireLock()
+		{
+			while (lock.test_and_set(std::memory_order_acquire)) {}
+		}
+
+		void releaseLock()
+		{
+			lock.clear(std::memory_order_release);
+		}
+	};
+
+	/** @brief Handle to a scheduled job that can be waited on or used as a dependency, stays valid after the job has finished */
+	struct JobHandle
+	{
+		Job *job = nullptr;
+		uint32_t generation = 0;
+	};
+
+	/**
+	* @brief Lock-free single producer, multiple consumer deque after Chase and Lev ("Dynamic Circular Work-Stealing Deque")
+	* @note Uses the C11 memory orderings from Lê et al. "Correct and Efficient Work-Stealing for Weak Memory Models" with a fixed capacity
+	*/
+	class WorkStealingDeque
+	{
+	private:
+		std::atomic<int64_t> top;
+		// Keep the ends of the deque on separate cache lines, the owner only touches bottom in the common case
+		char padding[64];
+		std::atomic<int64_t> bottom;
+		std::unique_ptr<std::atomic<Job*>[]> buffer;
+		int64_t capacity;
+
+	public:
+		WorkStealingDeque(uint32_t capacity) : top(0), bottom(0), capacity(capacity)
+		{
+			assert((capacity & (capacity - 1)) == 0);
+			buffer.reset(new std::atomic<Job*>[capacity]);
+		}
+
+		/** @brief Push a job to the bottom of the deque, must only be called by the owning thread. Returns false if the deque is full */
+		bool push(Job *job)
+		{
+			int64_t b = bottom.load(std::memory_order_relaxed);
+			int64_t t = top.load(std::memory_order_acquire);
+			if (b - t >= capacity)
+			{
+				return false;
+			}
+			buffer[b & (capacity - 1)].store(job, std::memory_order_relaxed);
+			bottom.store(b + 1, std::memory_order_release);
+			return true;
+		}
+
+		/** @brief Pop the most recently pushed job, must only be called by the owning thread */
+		Job* pop()
+		{
+			int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+			if (t > b)
+			{
+				// Empty
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+			Job *job = buffer[b & (capacity - 1)].load(std::memory_order_relaxed);
+			if (t == b)
+			{
+				// Last job, race against thieves for it
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					job = nullptr;
+				}
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return job;
+		}
+
+		/** @brief Steal the oldest job, may be called from any thread. Returns nullptr if the deque is empty or another thread won the race */
+		Job* steal()
+		{
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t b = bottom.load(std::memory_order_acquire);
+			if (t >= b)
+			{
+				return nullptr;
+			}
+			Job *job = buffer[t & (capacity - 1)].load(std::memory_order_relaxed);
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return nullptr;
+			}
+			return job;
+		}
+
+		bool empty()
+		{
+			return top.load(std::memory_order_seq_cst) >= bottom.load(std::memory_order_seq_cst);
+		}
+	};
+
+	/**
+	* @brief Work stealing job scheduler
+	*
+	* Jobs are pushed to the deque of the calling thread and executed by the worker threads, idle workers steal jobs from the other threads.
+	* Threads that wait on a job help executing jobs until it has finished. Threads that aren't workers get their own deque on first use.
+	*
+	* @note Job functions are stored inline in the job (up to Job::storageSize bytes), so scheduling a job does not allocate memory once enough jobs have been allocated
+	*/
+	class JobSystem
+	{
+	private:
+		static const uint32_t maxContexts = 256;
+		static const uint32_t dequeCapacity = 4096;
+		static const uint32_t jobBlockSize = 64;
+		// Number of unsuccessful attempts to find work before a worker goes to sleep
+		static const uint32_t idleSpinCount = 64;
+
+		// Per thread state
+		struct Context
+		{
+			uint32_t index;
+			std::thread::id threadId;
+			WorkStealingDeque deque;
+			// Job currently executed by this thread, parent for jobs spawned by parallelFor
+			Job *current = nullptr;
+			// Free jobs only accessed by the owning thread
+			Job *freeList = nullptr;
+			// Finished jobs returned by other threads, taken over as a whole by the owning thread
+			std::atomic<Job*> returned;
+			std::vector<std::unique_ptr<Job[]>> blocks;
+			uint32_t random;
+
+			Context(uint32_t index) : index(index), deque(dequeCapacity), returned(nullptr), random(index * 2654435761u + 1) {}
+		};
+
+		struct ThreadCache
+		{
+			uint64_t system;
+			uint32_t context;
+		};
+
+		// Calls the function object of a job
+		template<typename F>
+		static void invokeFunction(Job *job)
+		{
+			(*reinterpret_cast<F*>(&job->storage))();
+		}
+
+		// Destroys the function object of a job once the job and all of its children have finished
+		template<typename F>
+		static void destroyFunction(Job *job)
+		{
+			reinterpret_cast<F*>(&job->storage)->~F();
+		}
+
+		// Splits a range into child jobs until it's below the granularity
+		template<typename F>
+		struct RangeJob
+		{
+			JobSystem *system;
+			const F *function;
+			uint32_t begin;
+			uint32_t end;
+			uint32_t granularity;
+
+			void operator()()
+			{
+				while (end - begin > granularity)
+				{
+					uint32_t middle = begin + (end - begin) / 2;
+					RangeJob right = { system, function, middle, end, granularity };
+					system->spawnChild(right);
+					end = middle;
+				}
+				(*function)(begin, end);
+			}
+		};
+
+		// Owns the function of a parallel for, it's only destroyed after all range jobs (children of this job) have finished
+		template<typename F>
+		struct ParallelForJob
+		{
+			JobSystem *system;
+			F function;
+			uint32_t begin;
+			uint32_t end;
+			uint32_t granularity;
+
+			void operator()()
+			{
+				RangeJob<F> range = { system, &function, begin, end, granularity };
+				range();
+			}
+		};
+
+		uint64_t id;
+		std::unique_ptr<Context> contexts[maxContexts];
+		std::atomic<uint32_t> contextCount;
+		std::mutex contextMutex;
+		std::vector<std::thread> workers;
+		std::atomic<bool> stopping;
+		std::atomic<uint32_t> sleepingWorkers;
+		std::mutex sleepMutex;
+		std::condition_variable sleepCondition;
+		// Jobs that have been created but not yet finished
+		std::atomic<int64_t> pendingJobs;
+
+		static ThreadCache& threadCache()
+		{
+			static thread_local ThreadCache cache = { 0, 0 };
+			return cache;
+		}
+
+		static uint64_t nextSystemId()
+		{
+			static std::atomic<uint64_t> systemId(0);
+			return ++systemId;
+		}
+
+		Context& getContext()
+		{
+			ThreadCache &cache = threadCache();
+			if (cache.system == id)
+			{
+				return *contexts[cache.context];
+			}
+			std::thread::id self = std::this_thread::get_id();
+			std::lock_guard<std::mutex> lock(contextMutex);
+			uint32_t count = contextCount.load(std::memory_order_relaxed);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (contexts[i]->threadId == self)
+				{
+					cache.system = id;
+					cache.context = i;
+					return *contexts[i];
+				}
+			}
+			assert(count < maxContexts);
+			contexts[count].reset(new Context(count));
+			contexts[count]->threadId = self;
+			contextCount.store(count + 1, std::memory_order_release);
+			cache.system = id;
+			cache.context = count;
+			return *contexts[count];
+		}
+
+		Job* allocateJob(Context &context)
+		{
+			if (!context.freeList)
+			{
+				context.freeList = context.returned.exchange(nullptr, std::memory_order_acquire);
+			}
+			if (!context.freeList)
+			{
+				Job *block = new Job[jobBlockSize];
+				for (uint32_t i = 0; i < jobBlockSize; i++)
+				{
+					block[i].owner = context.index;
+					block[i].next = (i < jobBlockSize - 1) ? &block[i + 1] : nullptr;
+				}
+				context.blocks.push_back(std::unique_ptr<Job[]>(block));
+				context.freeList = block;
+			}
+			Job *job = context.freeList;
+			context.freeList = job->next;
+			// Reset under the lock so a thread adding a dependency on an earlier use of this job sees either the old or the new generation
+			job->acquireLock();
+			job->generation.fetch_add(1, std::memory_order_relaxed);
+			job->finished.store(false, std::memory_order_relaxed);
+			job->dependents = nullptr;
+			job->releaseLock();
+			job->edgeCount = 0;
+			job->next = nullptr;
+			return job;
+		}
+
+		void releaseJob(Job *job)
+		{
+			Context &owner = *contexts[job->owner];
+			Job *head = owner.returned.load(std::memory_order_relaxed);
+			do
+			{
+				job->next = head;
+			} while (!owner.returned.compare_exchange_weak(head, job, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		template<typename F>
+		Job* createJob(Context &context, F &&function, Job *parent)
+		{
+			typedef typename std::decay<F>::type Function;
+			static_assert(sizeof(Function) <= Job::storageSize, "Job function is too large, capture data by reference or pointer");
+			static_assert(std::alignment_of<Function>::value <= 16, "Job function alignment is too large");
+			Job *job = allocateJob(context);
+			new (&job->storage) Function(std::forward<F>(function));
+			job->invoke = &invokeFunction<Function>;
+			job->destroy = &destroyFunction<Function>;
+			job->parent = parent;
+			if (parent)
+			{
+				parent->unfinished.fetch_add(1, std::memory_order_relaxed);
+			}
+			job->unfinished.store(1, std::memory_order_relaxed);
+			job->pendingDependencies.store(1, std::memory_order_relaxed);
+			pendingJobs.fetch_add(1, std::memory_order_relaxed);
+			return job;
+		}
+
+		// Registers job to run after dependency has finished, does nothing if it already has
+		void addDependency(Job *job, const JobHandle &dependency)
+		{
+			if (!dependency.job)
+			{
+				return;
+			}
+			Job *other = dependency.job;
+			other->acquireLock();
+			if ((other->generation.load(std::memory_order_relaxed) == dependency.generation) && !other->finished.load(std::memory_order_relaxed))
+			{
+				assert(job->edgeCount < Job::maxDependencies);
+				Job::Edge &edge = job->edges[job->edgeCount++];
+				edge.dependent = job;
+				edge.next = other->dependents;
+				other->dependents = &edge;
+				job->pendingDependencies.fetch_add(1, std::memory_order_relaxed);
+			}
+			other->releaseLock();
+		}
+
+		JobHandle submit(Context &context, Job *job, const JobHandle *dependencies, size_t dependencyCount)
+		{
+			JobHandle handle;
+			handle.job = job;
+			handle.generation = job->generation.load(std::memory_order_relaxed);
+			for (size_t i = 0; i < dependencyCount; i++)
+			{
+				addDependency(job, dependencies[i]);
+			}
+			if (job->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				schedule(context, job);
+			}
+			return handle;
+		}
+
+		void schedule(Context &context, Job *job)
+		{
+			if (!context.deque.push(job))
+			{
+				// Deque is full, run the job right away
+				execute(context, job);
+				return;
+			}
+			// Wake up a sleeping worker (see workerLoop for the other half of this handshake)
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (sleepingWorkers.load(std::memory_order_seq_cst) > 0)
+			{
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				sleepCondition.notify_one();
+			}
+		}
+
+		void execute(Context &context, Job *job)
+		{
+			Job *previous = context.current;
+			context.current = job;
+			job->invoke(job);
+			context.current = previous;
+			finish(context, job);
+		}
+
+		void finish(Context &context, Job *job)
+		{
+			if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			{
+				return;
+			}
+			job->destroy(job);
+			job->acquireLock();
+			job->finished.store(true, std::memory_order_release);
+			Job::Edge *edge = job->dependents;
+			job->dependents = nullptr;
+			job->releaseLock();
+			Job *parent = job->parent;
+			releaseJob(job);
+			pendingJobs.fetch_sub(1, std::memory_order_release);
+			while (edge)
+			{
+				// Read the link first, the dependent may finish and be reused as soon as it has been scheduled
+				Job::Edge *next = edge->next;
+				Job *dependent = edge->dependent;
+				if (dependent->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					schedule(context, dependent);
+				}
+				edge = next;
+			}
+			if (parent)
+			{
+				finish(context, parent);
+			}
+		}
+
+		Job* steal(Context &context)
+		{
+			uint32_t count = contextCount.load(std::memory_order_acquire);
+			// xorshift to pick a random victim, so thieves don't all hit the same deque
+			context.random ^= context.random << 13;
+			context.random ^= context.random >> 17;
+			context.random ^= context.random << 5;
+			uint32_t start = context.random % count;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				uint32_t victim = (start + i) % count;
+				if (victim == context.index)
+				{
+					continue;
+				}
+				Job *job = contexts[victim]->deque.steal();
+				if (job)
+				{
+					return job;
+				}
+			}
+			return nullptr;
+		}
+
+		bool hasQueuedJobs()
+		{
+			uint32_t count = contextCount.load(std::memory_order_acquire);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (!contexts[i]->deque.empty())
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Execute a single job from the own deque or stolen from another thread, returns false if no job was found
+		bool executeOne(Context &context)
+		{
+			Job *job = context.deque.pop();
+			if (!job)
+			{
+				job = steal(context);
+			}
+			if (!job)
+			{
+				return false;
+			}
+			execute(context, job);
+			return true;
+		}
+
+		void workerLoop(uint32_t index)
+		{
+			ThreadCache &cache = threadCache();
+			cache.system = id;
+			cache.context = index;
+			Context &context = *contexts[index];
+			uint32_t idle = 0;
+			while (!stopping.load(std::memory_order_acquire))
+			{
+				if (executeOne(context))
+				{
+					idle = 0;
+					continue;
+				}
+				if (++idle < idleSpinCount)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+				// Announce that we're going to sleep before the final check for work, schedule() checks the sleeper count after pushing
+				std::unique_lock<std::mutex> lock(sleepMutex);
+				sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+				if (!stopping.load(std::memory_order_relaxed) && !hasQueuedJobs())
+				{
+					sleepCondition.wait(lock);
+				}
+				sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+				idle = 0;
+			}
+		}
+
+		template<typename F>
+		void spawnChild(F &&function)
+		{
+			Context &context = getContext();
+			assert(context.current);
+			Job *job = createJob(context, std::forward<F>(function), context.current);
+			submit(context, job, nullptr, 0);
+		}
+
+	public:
+		/** @brief Start the given number of worker threads */
+		JobSystem(uint32_t workerCount) : id(nextSystemId()), contextCount(0), stopping(false), sleepingWorkers(0), pendingJobs(0)
+		{
+			assert(workerCount < maxContexts);
+			for (uint32_t i = 0; i < workerCount; i++)
+			{
+				contexts[i].reset(new Context(i));
+			}
+			contextCount.store(workerCount, std::memory_order_release);
+			for (uint32_t i = 0; i < workerCount; i++)
+			{
+				workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+			}
+		}
+
+		/** @brief Waits for all jobs to finish and stops the workers */
+		~JobSystem()
+		{
+			waitIdle();
+			{
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				stopping.store(true, std::memory_order_release);
+				sleepCondition.notify_all();
+			}
+			for (auto &worker : workers)
+			{
+				worker.join();
+			}
+		}
+
+		/** @brief Number of worker threads */
+		uint32_t getWorkerCount()
+		{
+			return static_cast<uint32_t>(workers.size());
+		}
+
+		/**
+		* Get the index of the calling thread
+		*
+		* @return Index of the thread in [0, getWorkerCount()) for workers, indices of other threads start at getWorkerCount()
+		*
+		* @note Can be used to select per thread data inside of jobs, e.g. command pools
+		*/
+		uint32_t getThreadIndex()
+		{
+			return getContext().index;
+		}
+
+		/**
+		* Schedule a job
+		*
+		* @param function Function object to execute, must fit into Job::storageSize bytes
+		* @param dependencies (Optional) Jobs that need to finish before this job is started (up to Job::maxDependencies)
+		*
+		* @return Handle to the job
+		*/
+		template<typename F>
+		JobHandle run(F &&function, std::initializer_list<JobHandle> dependencies = {})
+		{
+			return run(std::forward<F>(function), dependencies.begin(), dependencies.size());
+		}
+
+		/** @brief Schedule a job that runs after dependencyCount jobs in dependencies have finished */
+		template<typename F>
+		JobHandle run(F &&function, const JobHandle *dependencies, size_t dependencyCount)
+		{
+			Context &context = getContext();
+			Job *job = createJob(context, std::forward<F>(function), nullptr);
+			return submit(context, job, dependencies, dependencyCount);
+		}
+
+		/**
+		* Call a function for all sub ranges of [begin, end)
+		*
+		* @param begin First index of the range
+		* @param end Index after the last index of the range
+		* @param granularity Maximum number of indices passed to a single function call
+		* @param function Function object called with the first and the index after the last index of a sub range, must fit into Job::storageSize bytes
+		* @param dependencies (Optional) Jobs that need to finish before the range is processed
+		*
+		* @note The range is split in halves recursively, so idle threads can steal large parts of the range early on
+		*
+		* @return Handle to a job that finishes once the whole range has been processed
+		*/
+		template<typename F>
+		JobHandle parallelFor(uint32_t begin, uint32_t end, uint32_t granularity, F function, std::initializer_list<JobHandle> dependencies = {})
+		{
+			assert(granularity > 0);
+			ParallelForJob<F> job = { this, std::move(function), begin, end, granularity };
+			return run(std::move(job), dependencies);
+		}
+
+		/** @brief Returns true if the job has finished */
+		bool isDone(const JobHandle &handle)
+		{
+			if (!handle.job || handle.job->finished.load(std::memory_order_acquire))
+			{
+				return true;
+			}
+			return handle.job->generation.load(std::memory_order_acquire) != handle.generation;
+		}
+
+		/** @brief Wait for a job to finish, executes other jobs in the meantime */
+		void wait(const JobHandle &handle)
+		{
+			Context &context = getContext();
+			while (!isDone(handle))
+			{
+				if (!executeOne(context))
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		/** @brief Wait until all scheduled jobs have finished, executes jobs in the meantime */
+		void waitIdle()
+		{
+			Context &context = getContext();
+			while (pendingJobs.load(std::memory_order_acquire) > 0)
+			{
+				if (!executeOne(context))
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+	};
+}
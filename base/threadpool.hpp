@@ -1,16 +1,22 @@
 /*
 * Basic C++11 based thread pool with per-thread job queues
 *
+* Implemented on top of the work stealing job system (see jobsystem.hpp)
+*
 * Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
 *
 * This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
 */
 
+#pragma once
+
 #include <vector>
 #include <thread>
-#include <queue>
+#include <functional>
+#include <memory>
 #include <mutex>
-#include <condition_variable>
+
+#include "jobsystem.hpp"
 
 // make_unique is not available in C++11
 // Taken from Herb Sutter's blog (https://herbsutter.com/gotw/_102/)
@@ -22,88 +28,75 @@ std::unique_ptr<T> make_unique(Args&& ...args)
 
 namespace vks
 {
+	/**
+	* @brief Serial job queue
+	* @note Jobs added to the same thread are executed one after another in the order they have been added, but not necessarily on the same OS thread.
+	* Different threads run in parallel and idle workers steal their jobs, so a single long job doesn't stall the jobs of the other threads
+	*/
 	class Thread
 	{
 	private:
-		bool destroying = false;
-		std::thread worker;
-		std::queue<std::function<void()>> jobQueue;
-		std::mutex queueMutex;
-		std::condition_variable condition;
+		JobSystem *jobSystem;
+		// Last job added to this thread, the next job depends on it
+		JobHandle lastJob;
+		// Guards lastJob, so jobs can be added from multiple threads
+		// Recursive as the job system runs a job right away if the deque is full, and that job may add jobs to this thread
+		std::recursive_mutex lastJobMutex;
 
-		// Loop through all remaining jobs
-		void queueLoop()
+		struct FunctionJob
 		{
-			while (true)
-			{
-				std::function<void()> job;
-				{
-					std::unique_lock<std::mutex> lock(queueMutex);
-					condition.wait(lock, [this] { return !jobQueue.empty() || destroying; });
-					if (destroying)
-					{
-						break;
-					}
-					job = jobQueue.front();
-				}
+			std::function<void()> function;
 
-				job();
-
-				{
-					std::lock_guard<std::mutex> lock(queueMutex);
-					jobQueue.pop();
-					condition.notify_one();
-				}
+			void operator()()
+			{
+				function();
 			}
-		}
+		};
 
 	public:
-		Thread()
-		{
-			worker = std::thread(&Thread::queueLoop, this);
-		}
+		Thread(JobSystem *jobSystem) : jobSystem(jobSystem) {}
 
 		~Thread()
 		{
-			if (worker.joinable())
-			{
-				wait();
-				queueMutex.lock();
-				destroying = true;
-				condition.notify_one();
-				queueMutex.unlock();
-				worker.join();
-			}
+			wait();
 		}
 
-		// Add a new job to the thread's queue
+		// Add a new job to the thread's queue, can be called from multiple threads
 		void addJob(std::function<void()> function)
 		{
-			std::lock_guard<std::mutex> lock(queueMutex);
-			jobQueue.push(std::move(function));
-			condition.notify_one();
+			FunctionJob job = { std::move(function) };
+			// Scheduling under the lock keeps jobs added by different threads in a single chain
+			std::lock_guard<std::recursive_mutex> lock(lastJobMutex);
+			lastJob = jobSystem->run(std::move(job), { lastJob });
 		}
 
 		// Wait until all work items have been finished
 		void wait()
 		{
-			std::unique_lock<std::mutex> lock(queueMutex);
-			condition.wait(lock, [this]() { return jobQueue.empty(); });
+			JobHandle job;
+			{
+				std::lock_guard<std::recursive_mutex> lock(lastJobMutex);
+				job = lastJob;
+			}
+			jobSystem->wait(job);
 		}
 	};
-	
+
 	class ThreadPool
 	{
 	public:
+		/** @brief Job system executing the jobs of all threads, can also be used directly (e.g. for parallelFor) */
+		std::unique_ptr<JobSystem> jobSystem;
 		std::vector<std::unique_ptr<Thread>> threads;
 
 		// Sets the number of threads to be allocted in this pool
 		void setThreadCount(uint32_t count)
 		{
 			threads.clear();
-			for (auto i = 0; i < count; i++)
+			jobSystem.reset(new JobSystem(count));
+			for (uint32_t i = 0; i < count; i++)
 			{
-				threads.push_back(make_unique<Thread>());
+				threads.push_back(make_unique<Thread>(jobSystem.get()));
 			}
 		}
 
@@ -117,4 +110,4 @@ namespace vks
 		}
 	};
 
-}
\ No newline at end of file
+}
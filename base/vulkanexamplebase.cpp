@@ -7,6 +7,7 @@
 */
 
 #include "vulkanexamplebase.h"
+#include <cerrno>
 
 std::vector<const char*> VulkanExampleBase::args;
 
@@ -20,31 +21,36 @@ VkResult VulkanExampleBase::createInstance(bool enableValidation)
 	appInfo.pEngineName = name.c_str();
 	appInfo.apiVersion = VK_API_VERSION_1_0;
 
-	std::vector<const char*> instanceExtensions = { VK_KHR_SURFACE_EXTENSION_NAME };
+	std::vector<const char*> instanceExtensions;
 
 	// Enable surface extensions depending on os
+	// Not required in headless mode, as no surface is created
+	if (!settings.headless)
+	{
+		instanceExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
 #if defined(_WIN32)
-	instanceExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+		instanceExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
 #elif defined(__ANDROID__)
-	instanceExtensions.push_back(VK_KHR_ANDROID_SURFACE_EXTENSION_NAME);
+		instanceExtensions.push_back(VK_KHR_ANDROID_SURFACE_EXTENSION_NAME);
 #elif defined(_DIRECT2DISPLAY)
-	instanceExtensions.push_back(VK_KHR_DISPLAY_EXTENSION_NAME);
+		instanceExtensions.push_back(VK_KHR_DISPLAY_EXTENSION_NAME);
 #elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
-	instanceExtensions.push_back(VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME);
+		instanceExtensions.push_back(VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME);
 #elif defined(__linux__)
-	instanceExtensions.push_back(VK_KHR_XCB_SURFACE_EXTENSION_NAME);
+		instanceExtensions.push_back(VK_KHR_XCB_SURFACE_EXTENSION_NAME);
 #endif
+	}
 
 	VkInstanceCreateInfo instanceCreateInfo = {};
 	instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 	instanceCreateInfo.pNext = NULL;
 	instanceCreateInfo.pApplicationInfo = &appInfo;
+	if (settings.validation)
+	{
+		instanceExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
+	}
 	if (instanceExtensions.size() > 0)
 	{
-		if (settings.validation)
-		{
-			instanceExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
-		}
 		instanceCreateInfo.enabledExtensionCount = (uint32_t)instanceExtensions.size();
 		instanceCreateInfo.ppEnabledExtensionNames = instanceExtensions.data();
 	}
@@ -77,6 +83,15 @@ const std::string VulkanExampleBase::getAssetPath()
 #endif
 }
 
+vks::ThreadPool &VulkanExampleBase::getThreadPool()
+{
+	if (!threadPool.jobSystem)
+	{
+		threadPool.setThreadCount(std::max(std::thread::hardware_concurrency(), 1u));
+	}
+	return threadPool;
+}
+
 bool VulkanExampleBase::checkCommandBuffers()
 {
 	for (auto& cmdBuffer : drawCmdBuffers)
@@ -105,6 +120,10 @@ void VulkanExampleBase::createCommandBuffers()
 
 void VulkanExampleBase::destroyCommandBuffers()
 {
+	for (auto& cmdBuffer : drawCmdBuffers)
+	{
+		gpuProfiler.release(cmdBuffer);
+	}
 	vkFreeCommandBuffers(device, cmdPool, static_cast<uint32_t>(drawCmdBuffers.size()), drawCmdBuffers.data());
 }
 
@@ -139,13 +158,19 @@ void VulkanExampleBase::flushCommandBuffer(VkCommandBuffer commandBuffer, VkQueu
 	
 	VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffer));
 
+	// The command buffer may use resources that have been staged but not yet uploaded
+	vulkanDevice->uploadQueue.flush();
+
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &commandBuffer;
 
-	VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
-	VK_CHECK_RESULT(vkQueueWaitIdle(queue));
+	{
+		std::lock_guard<std::mutex> lock(vulkanDevice->queueMutex);
+		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
+		VK_CHECK_RESULT(vkQueueWaitIdle(queue));
+	}
 
 	if (free)
 	{
@@ -155,20 +180,99 @@ void VulkanExampleBase::flushCommandBuffer(VkCommandBuffer commandBuffer, VkQueu
 
 void VulkanExampleBase::createPipelineCache()
 {
+	std::vector<uint8_t> cacheData;
+	pipelineCacheWarm = false;
+	if (settings.loadPipelineCache)
+	{
+		std::string error;
+		pipelineCacheWarm = vks::pipelinecache::load(getPipelineCacheFilename(), deviceProperties, cacheData, &error);
+		if (!pipelineCacheWarm)
+		{
+			std::cout << "Pipeline cache not loaded (" << error << "), starting with an empty cache" << std::endl;
+		}
+	}
+
 	VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
 	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-	VK_CHECK_RESULT(vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache));
+	pipelineCacheCreateInfo.initialDataSize = cacheData.size();
+	pipelineCacheCreateInfo.pInitialData = cacheData.data();
+	VkResult result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+	if ((result != VK_SUCCESS) && pipelineCacheWarm)
+	{
+		// The driver may still reject data that passed validation, fall back to an empty cache
+		std::cout << "Pipeline cache data rejected by the driver, starting with an empty cache" << std::endl;
+		pipelineCacheWarm = false;
+		pipelineCacheCreateInfo.initialDataSize = 0;
+		pipelineCacheCreateInfo.pInitialData = nullptr;
+		result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+	}
+	VK_CHECK_RESULT(result);
+}
+
+std::string VulkanExampleBase::getPipelineCacheFilename()
+{
+	std::stringstream ss;
+#if defined(__ANDROID__)
+	ss << androidApp->activity->internalDataPath << "/";
+#else
+	// Stored next to the mesh and texture caches in the asset directory
+	ss << getAssetPath();
+#endif
+	ss << getExecutableName(name) << "_" << std::hex << deviceProperties.vendorID << "_" << deviceProperties.deviceID << ".pipelinecache";
+	return ss.str();
+}
+
+void VulkanExampleBase::savePipelineCache()
+{
+	std::string filename = getPipelineCacheFilename();
+	if (!vks::pipelinecache::save(filename, deviceProperties, device, pipelineCache))
+	{
+		std::cerr << "Could not write pipeline cache to \"" << filename << "\"" << std::endl;
+	}
+}
+
+void VulkanExampleBase::prepareFinished()
+{
+	// Models and textures loaded in prepare() are uploaded in batches, make sure they have arrived before the first frame
+	// Examples may use them on other queues (e.g. compute), so this waits instead of only submitting
+	vulkanDevice->uploadQueue.flush();
+
+	auto tPrepareEnd = std::chrono::high_resolution_clock::now();
+	double startupTime = std::chrono::duration<double, std::milli>(tPrepareEnd - tPrepareStart).count();
+	std::cout << "Startup time: " << std::fixed << std::setprecision(2) << startupTime << " ms (" << (pipelineCacheWarm ? "warm" : "cold") << " pipeline cache)" << std::endl;
+}
+
+void VulkanExampleBase::createFrameUniformBuffers(std::vector<vks::Buffer> &buffers, VkDeviceSize size)
+{
+	buffers.resize(maxFramesInFlight);
+	for (auto& buffer : buffers)
+	{
+		VK_CHECK_RESULT(vulkanDevice->createBuffer(
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&buffer,
+			size));
+		// Keep mapped, the host only writes to the buffer of a frame once its fence has been signaled
+		VK_CHECK_RESULT(buffer.map());
+	}
 }
 
 void VulkanExampleBase::prepare()
 {
+	tPrepareStart = std::chrono::high_resolution_clock::now();
 	if (vulkanDevice->enableDebugMarkers)
 	{
 		vks::debugmarker::setup(device);
 	}
 	createCommandPool();
+	gpuProfiler.create(vulkanDevice);
 	setupSwapChain();
 	createCommandBuffers();
+	// One primary command buffer per frame in flight for examples that record their commands each frame
+	for (auto& frame : frameObjects)
+	{
+		frame.commandBuffer = createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, false);
+	}
 	setupDepthStencil();
 	setupRenderPass();
 	createPipelineCache();
@@ -188,7 +292,8 @@ void VulkanExampleBase::prepare()
 			depthFormat,
 			&width,
 			&height,
-			shaderStages
+			shaderStages,
+			swapChain.presentLayout
 			);
 		updateTextOverlay();
 	}
@@ -210,10 +315,162 @@ VkPipelineShaderStageCreateInfo VulkanExampleBase::loadShader(std::string fileNa
 	return shaderStage;
 }
 
+std::string VulkanExampleBase::getExecutableName(std::string defaultName)
+{
+	// Use the executable name to distinguish output of different examples
+	if (args.empty())
+	{
+		return defaultName;
+	}
+	std::string exeName = args[0];
+	size_t pos = exeName.find_last_of("/\\");
+	if (pos != std::string::npos)
+	{
+		exeName = exeName.substr(pos + 1);
+	}
+	pos = exeName.find_last_of('.');
+	if ((pos != std::string::npos) && (exeName.substr(pos) == ".exe"))
+	{
+		exeName = exeName.substr(0, pos);
+	}
+	return exeName;
+}
+
+bool VulkanExampleBase::handlePendingEvents()
+{
+#if defined(_WIN32)
+	MSG msg;
+	while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+	{
+		if (msg.message == WM_QUIT)
+		{
+			return false;
+		}
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+	}
+	return true;
+#elif defined(__ANDROID__) || defined(_DIRECT2DISPLAY)
+	return true;
+#elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
+	while (wl_display_prepare_read(display) != 0)
+		wl_display_dispatch_pending(display);
+	wl_display_flush(display);
+	wl_display_read_events(display);
+	wl_display_dispatch_pending(display);
+	return !quit;
+#elif defined(__linux__)
+	xcb_generic_event_t *event;
+	while ((event = xcb_poll_for_event(connection)))
+	{
+		handleEvent(event);
+		free(event);
+	}
+	return !quit;
+#else
+	return true;
+#endif
+}
+
 void VulkanExampleBase::renderLoop()
 {
 	destWidth = width;
 	destHeight = height;
+	// On Android the example is prepared from within the render loop once the window has been created
+	if (prepared)
+	{
+		prepareFinished();
+	}
+	if (benchmark.active)
+	{
+		// Render a fixed number of frames with a constant time step, so every run animates the same way
+		frameTimer = benchmark.frameTime;
+		benchmark.run([this] {
+			if (viewUpdated)
+			{
+				viewUpdated = false;
+				viewChanged();
+			}
+			render();
+			frameCounter++;
+			camera.update(frameTimer);
+			if (camera.moving())
+			{
+				viewUpdated = true;
+			}
+			if (!paused)
+			{
+				timer += timerSpeed * frameTimer;
+				if (timer > 1.0)
+				{
+					timer -= 1.0f;
+				}
+			}
+		}, [this] {
+			// Only average GPU times of the measured frames
+			gpuProfiler.resetStatistics();
+		}, [this] {
+			// Keep the window responsive, closing it stops the run
+			return settings.headless || handlePendingEvents();
+		});
+		vkDeviceWaitIdle(device);
+		gpuProfiler.resolve();
+		benchmark.gpuTimes.clear();
+		for (auto& timing : gpuProfiler.getTimings())
+		{
+			benchmark.gpuTimes.push_back(std::make_pair(timing.name, timing.ms));
+		}
+		benchmark.saveResults(getExecutableName(name), deviceProperties.deviceName);
+		return;
+	}
+	if (settings.headless)
+	{
+		// Render a fixed number of frames without window system interaction
+		// Selected frames are read back and written to disk
+		std::string captureName = getExecutableName("frame");
+		for (uint32_t frame = 0; frame < settings.headlessFrameCount; frame++)
+		{
+			auto tStart = std::chrono::high_resolution_clock::now();
+			if (viewUpdated)
+			{
+				viewUpdated = false;
+				viewChanged();
+			}
+			render();
+			if (std::find(settings.captureFrames.begin(), settings.captureFrames.end(), frame) != settings.captureFrames.end())
+			{
+				captureFrame(currentBuffer, captureName + "_" + std::to_string(frame) + ".ppm");
+			}
+			frameCounter++;
+			auto tEnd = std::chrono::high_resolution_clock::now();
+			auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+			frameTimer = (float)tDiff / 1000.0f;
+			camera.update(frameTimer);
+			if (camera.moving())
+			{
+				viewUpdated = true;
+			}
+			// Convert to clamped timer value
+			if (!paused)
+			{
+				timer += timerSpeed * frameTimer;
+				if (timer > 1.0)
+				{
+					timer -= 1.0f;
+				}
+			}
+			fpsTimer += (float)tDiff;
+			if (fpsTimer > 1000.0f)
+			{
+				lastFPS = frameCounter;
+				updateTextOverlay();
+				fpsTimer = 0.0f;
+				frameCounter = 0;
+			}
+		}
+		vkDeviceWaitIdle(device);
+		return;
+	}
 #if defined(_WIN32)
 	MSG msg;
 	while (TRUE)
@@ -521,11 +778,108 @@ void VulkanExampleBase::renderLoop()
 	vkDeviceWaitIdle(device);
 }
 
+void VulkanExampleBase::captureFrame(uint32_t imageIndex, std::string filename)
+{
+	// Only 8 bit per component formats with four components are supported
+	std::vector<VkFormat> formatsBGR = { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_B8G8R8A8_SNORM };
+	std::vector<VkFormat> formatsRGB = { VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R8G8B8A8_SNORM };
+	bool colorSwizzle = (std::find(formatsBGR.begin(), formatsBGR.end(), swapChain.colorFormat) != formatsBGR.end());
+	if (!colorSwizzle && (std::find(formatsRGB.begin(), formatsRGB.end(), swapChain.colorFormat) == formatsRGB.end()))
+	{
+		std::cerr << "Can't capture frame, unsupported color format!" << std::endl;
+		return;
+	}
+
+	// Make sure the frame has been finished
+	VK_CHECK_RESULT(vkQueueWaitIdle(queue));
+
+	VkImage srcImage = swapChain.images[imageIndex];
+
+	// Host visible buffer to copy the image contents to
+	vks::Buffer dstBuffer;
+	VK_CHECK_RESULT(vulkanDevice->createBuffer(
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		&dstBuffer,
+		width * height * 4));
+
+	VkCommandBuffer copyCmd = vulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
+	// Transition image from present to transfer source layout
+	vks::tools::insertImageMemoryBarrier(
+		copyCmd,
+		srcImage,
+		VK_ACCESS_MEMORY_READ_BIT,
+		VK_ACCESS_TRANSFER_READ_BIT,
+		swapChain.presentLayout,
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
+
+	VkBufferImageCopy copyRegion = {};
+	copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	copyRegion.imageSubresource.layerCount = 1;
+	copyRegion.imageExtent = { width, height, 1 };
+	vkCmdCopyImageToBuffer(copyCmd, srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dstBuffer.buffer, 1, &copyRegion);
+
+	// Transition back the image after the copy is done
+	vks::tools::insertImageMemoryBarrier(
+		copyCmd,
+		srcImage,
+		VK_ACCESS_TRANSFER_READ_BIT,
+		VK_ACCESS_MEMORY_READ_BIT,
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		swapChain.presentLayout,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
+
+	vulkanDevice->flushCommandBuffer(copyCmd, queue);
+
+	VK_CHECK_RESULT(dstBuffer.map());
+	const uint8_t *data = (const uint8_t*)dstBuffer.mapped;
+
+	std::ofstream file(filename, std::ios::out | std::ios::binary);
+	// ppm header
+	file << "P6\n" << width << "\n" << height << "\n" << 255 << "\n";
+	// ppm binary pixel data (rgb, alpha is dropped)
+	std::vector<uint8_t> row(width * 3);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			const uint8_t *pixel = data + (y * width + x) * 4;
+			row[x * 3 + 0] = colorSwizzle ? pixel[2] : pixel[0];
+			row[x * 3 + 1] = pixel[1];
+			row[x * 3 + 2] = colorSwizzle ? pixel[0] : pixel[2];
+		}
+		file.write((const char*)row.data(), row.size());
+	}
+	file.close();
+
+	std::cout << "Frame saved to \"" << filename << "\"" << std::endl;
+
+	dstBuffer.unmap();
+	dstBuffer.destroy();
+}
+
 void VulkanExampleBase::updateTextOverlay()
 {
 	if (!enableTextOverlay)
 		return;
 
+	// The overlay's vertex buffer and command buffers are shared by all frames in flight, so none of them may still be executing
+	if (maxFramesInFlight > 1)
+	{
+		std::vector<VkFence> fences;
+		for (auto& frame : frameObjects)
+		{
+			fences.push_back(frame.fence);
+		}
+		VK_CHECK_RESULT(vkWaitForFences(device, static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, UINT64_MAX));
+	}
+
 	textOverlay->beginTextUpdate();
 
 	textOverlay->addText(title, 5.0f, 5.0f, VulkanTextOverlay::alignLeft);
@@ -540,6 +894,16 @@ void VulkanExampleBase::updateTextOverlay()
 #endif
 	textOverlay->addText(deviceName, 5.0f, 45.0f, VulkanTextOverlay::alignLeft);
 
+	// GPU times of profiled passes, averaged since the last overlay update
+	std::vector<vks::GpuProfiler::Timing> gpuTimings = gpuProfiler.getTimings();
+	for (size_t i = 0; i < gpuTimings.size(); i++)
+	{
+		std::stringstream gpuTime;
+		gpuTime << gpuTimings[i].name << ": " << std::fixed << std::setprecision(3) << gpuTimings[i].ms << "ms";
+		textOverlay->addText(gpuTime.str(), (float)width - 5.0f, 5.0f + (float)i * 20.0f, VulkanTextOverlay::alignRight);
+	}
+	gpuProfiler.resetStatistics();
+
 	getOverlayText(textOverlay);
 
 	textOverlay->endTextUpdate();
@@ -552,14 +916,45 @@ void VulkanExampleBase::getOverlayText(VulkanTextOverlay *textOverlay)
 
 void VulkanExampleBase::prepareFrame()
 {
+	FrameObjects &frame = frameObjects[currentFrame];
+
+	// Wait until the GPU has finished the last submission that used this frame's resources
+	VK_CHECK_RESULT(vkWaitForFences(device, 1, &frame.fence, VK_TRUE, UINT64_MAX));
+
+	// Switch the default submit info over to this frame's semaphores (submitInfo points to the members of semaphores)
+	semaphores = frame.semaphores;
+
 	// Acquire the next image from the swap chaing
 	VK_CHECK_RESULT(swapChain.acquireNextImage(semaphores.presentComplete, &currentBuffer));
+
+	// The per swap chain image command buffers may still be in use by another frame in flight that rendered to the same image
+	if (imageFences.size() != swapChain.imageCount)
+	{
+		imageFences.assign(swapChain.imageCount, VK_NULL_HANDLE);
+	}
+	if ((imageFences[currentBuffer] != VK_NULL_HANDLE) && (imageFences[currentBuffer] != frame.fence))
+	{
+		VK_CHECK_RESULT(vkWaitForFences(device, 1, &imageFences[currentBuffer], VK_TRUE, UINT64_MAX));
+	}
+	imageFences[currentBuffer] = frame.fence;
+
+	// Pick up timestamps of command buffers that have finished executing (doesn't wait on the GPU)
+	gpuProfiler.frameFinished(currentFrame);
+	gpuProfiler.resolve();
+
+	// Submit uploads recorded since the last frame, so they're executed before this frame's command buffers
+	vulkanDevice->uploadQueue.submit();
+
+	VK_CHECK_RESULT(vkResetFences(device, 1, &frame.fence));
 }
 
 void VulkanExampleBase::submitFrame()
 {
 	bool submitTextOverlay = enableTextOverlay && textOverlay->visible;
 
+	// Assets streamed in the background may submit uploads to the same queue (see VulkanAssetStreamer.hpp)
+	std::unique_lock<std::mutex> queueLock(vulkanDevice->queueMutex);
+
 	if (submitTextOverlay)
 	{
 		// Wait for color attachment output to finish before rendering the text overlay
@@ -590,9 +985,27 @@ void VulkanExampleBase::submitFrame()
 		submitInfo.pSignalSemaphores = &semaphores.renderComplete;
 	}
 
+	// The swap chain locks the queue mutex itself
+	queueLock.unlock();
 	VK_CHECK_RESULT(swapChain.queuePresent(queue, currentBuffer, submitTextOverlay ? semaphores.textOverlayComplete : semaphores.renderComplete));
+	queueLock.lock();
 
-	VK_CHECK_RESULT(vkQueueWaitIdle(queue));
+	// Examples submit their command buffers without a fence, so an empty submission is used to signal the frame's fence 
+	// It is signaled once all work previously submitted to the queue has been finished
+	FrameObjects &frame = frameObjects[currentFrame];
+	VK_CHECK_RESULT(vkQueueSubmit(queue, 0, nullptr, frame.fence));
+	// The fence also covers the current draw command buffer, so the profiler can read its queries once it has been signaled
+	gpuProfiler.submitted(drawCmdBuffers[currentBuffer]);
+	gpuProfiler.frameSubmitted(currentFrame);
+	queueLock.unlock();
+
+	if (maxFramesInFlight == 1)
+	{
+		// Without frames in flight examples may update resources right after submitting, so wait for the frame to finish
+		VK_CHECK_RESULT(vkWaitForFences(device, 1, &frame.fence, VK_TRUE, UINT64_MAX));
+	}
+
+	currentFrame = (currentFrame + 1) % maxFramesInFlight;
 }
 
 VulkanExampleBase::VulkanExampleBase(bool enableValidation)
@@ -641,6 +1054,59 @@ VulkanExampleBase::VulkanExampleBase(bool enableValidation)
 			uint32_t h = strtol(args[i + 1], &endptr, 10);
 			if (endptr != args[i + 1]) { height = h; };
 		}
+		if (args[i] == std::string("-headless"))
+		{
+			settings.headless = true;
+		}
+		if ((args[i] == std::string("-frames")) && (i + 1 < args.size()))
+		{
+			char* endptr;
+			uint32_t frames = strtol(args[i + 1], &endptr, 10);
+			if (endptr != args[i + 1]) { settings.headlessFrameCount = frames; };
+		}
+		if (args[i] == std::string("-benchmark"))
+		{
+			benchmark.active = true;
+		}
+		if ((args[i] == std::string("-benchwarmup")) && (i + 1 < args.size()))
+		{
+			char* endptr;
+			uint32_t frames = strtol(args[i + 1], &endptr, 10);
+			if (endptr != args[i + 1]) { benchmark.warmupFrames = frames; };
+		}
+		if ((args[i] == std::string("-benchframes")) && (i + 1 < args.size()))
+		{
+			char* endptr;
+			uint32_t frames = strtol(args[i + 1], &endptr, 10);
+			if (endptr != args[i + 1]) { benchmark.frameCount = frames; };
+		}
+		if ((args[i] == std::string("-benchfile")) && (i + 1 < args.size()))
+		{
+			benchmark.filename = args[i + 1];
+		}
+		if (args[i] == std::string("-nopipelinecache"))
+		{
+			settings.loadPipelineCache = false;
+		}
+		if ((args[i] == std::string("-captureframes")) && (i + 1 < args.size()))
+		{
+			// Comma separated list of frame indices
+			std::stringstream ss(args[i + 1]);
+			std::string frame;
+			while (std::getline(ss, frame, ','))
+			{
+				char* endptr;
+				errno = 0;
+				long long index = strtoll(frame.c_str(), &endptr, 10);
+				// Reject empty entries, trailing characters and indices that don't fit into the frame counter
+				if ((endptr == frame.c_str()) || (*endptr != '\0') || (errno == ERANGE) || (index < 0) || (index > static_cast<long long>(UINT32_MAX)))
+				{
+					std::cerr << "Invalid frame index \"" << frame << "\" passed to -captureframes, ignoring it" << std::endl;
+					continue;
+				}
+				settings.captureFrames.push_back(static_cast<uint32_t>(index));
+			}
+		}
 	}
 	
 #if defined(__ANDROID__)
@@ -650,9 +1116,15 @@ VulkanExampleBase::VulkanExampleBase(bool enableValidation)
 #elif defined(_DIRECT2DISPLAY)
 
 #elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
-	initWaylandConnection();
+	if (!settings.headless)
+	{
+		initWaylandConnection();
+	}
 #elif defined(__linux__)
-	initxcbConnection();
+	if (!settings.headless)
+	{
+		initxcbConnection();
+	}
 #endif
 
 #if defined(_WIN32)
@@ -674,6 +1146,14 @@ VulkanExampleBase::~VulkanExampleBase()
 		vkDestroyDescriptorPool(device, descriptorPool, nullptr);
 	}
 	destroyCommandBuffers();
+	gpuProfiler.destroy();
+	for (auto& frame : frameObjects)
+	{
+		if (frame.commandBuffer != VK_NULL_HANDLE)
+		{
+			vkFreeCommandBuffers(device, cmdPool, 1, &frame.commandBuffer);
+		}
+	}
 	vkDestroyRenderPass(device, renderPass, nullptr);
 	for (uint32_t i = 0; i < frameBuffers.size(); i++)
 	{
@@ -688,13 +1168,18 @@ VulkanExampleBase::~VulkanExampleBase()
 	vkDestroyImage(device, depthStencil.image, nullptr);
 	vkFreeMemory(device, depthStencil.mem, nullptr);
 
+	savePipelineCache();
 	vkDestroyPipelineCache(device, pipelineCache, nullptr);
 
 	vkDestroyCommandPool(device, cmdPool, nullptr);
 
-	vkDestroySemaphore(device, semaphores.presentComplete, nullptr);
-	vkDestroySemaphore(device, semaphores.renderComplete, nullptr);
-	vkDestroySemaphore(device, semaphores.textOverlayComplete, nullptr);
+	for (auto& frame : frameObjects)
+	{
+		vkDestroySemaphore(device, frame.semaphores.presentComplete, nullptr);
+		vkDestroySemaphore(device, frame.semaphores.renderComplete, nullptr);
+		vkDestroySemaphore(device, frame.semaphores.textOverlayComplete, nullptr);
+		vkDestroyFence(device, frame.fence, nullptr);
+	}
 
 	if (enableTextOverlay)
 	{
@@ -713,6 +1198,10 @@ VulkanExampleBase::~VulkanExampleBase()
 #if defined(_DIRECT2DISPLAY)
 
 #elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
+	if (settings.headless)
+	{
+		return;
+	}
 	wl_shell_surface_destroy(shell_surface);
 	wl_surface_destroy(surface);
 	if (keyboard)
@@ -728,8 +1217,11 @@ VulkanExampleBase::~VulkanExampleBase()
 #if defined(__ANDROID__)
 	// todo : android cleanup (if required)
 #else
-	xcb_destroy_window(connection, window);
-	xcb_disconnect(connection);
+	if (!settings.headless)
+	{
+		xcb_destroy_window(connection, window);
+		xcb_disconnect(connection);
+	}
 #endif
 #endif
 }
@@ -842,7 +1334,8 @@ void VulkanExampleBase::initVulkan()
 	// This is handled by a separate class that gets a logical device representation
 	// and encapsulates functions related to a device
 	vulkanDevice = new vks::VulkanDevice(physicalDevice);
-	VkResult res = vulkanDevice->createLogicalDevice(enabledFeatures, enabledExtensions);
+	// Headless mode doesn't create a swapchain, so VK_KHR_swapchain (which depends on the surface extensions) isn't enabled
+	VkResult res = vulkanDevice->createLogicalDevice(enabledFeatures, enabledExtensions, !settings.headless);
 	if (res != VK_SUCCESS) {
 		vks::tools::exitFatal("Could not create Vulkan device: \n" + vks::tools::errorString(res), "Fatal error");
 	}
@@ -855,23 +1348,37 @@ void VulkanExampleBase::initVulkan()
 	VkBool32 validDepthFormat = vks::tools::getSupportedDepthFormat(physicalDevice, &depthFormat);
 	assert(validDepthFormat);
 
+	swapChain.headless = settings.headless;
+	swapChain.queueMutex = &vulkanDevice->queueMutex;
 	swapChain.connect(instance, physicalDevice, device);
 
 	// Create synchronization objects
+	// Each frame in flight gets it's own set, so the host can prepare a frame while the GPU still works on the previous ones
+	assert(maxFramesInFlight > 0);
+	frameObjects.resize(maxFramesInFlight);
 	VkSemaphoreCreateInfo semaphoreCreateInfo = vks::initializers::semaphoreCreateInfo();
-	// Create a semaphore used to synchronize image presentation
-	// Ensures that the image is displayed before we start submitting new commands to the queu
-	VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &semaphores.presentComplete));
-	// Create a semaphore used to synchronize command submission
-	// Ensures that the image is not presented until all commands have been sumbitted and executed
-	VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &semaphores.renderComplete));
-	// Create a semaphore used to synchronize command submission
-	// Ensures that the image is not presented until all commands for the text overlay have been sumbitted and executed
-	// Will be inserted after the render complete semaphore if the text overlay is enabled
-	VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &semaphores.textOverlayComplete));
+	// Fences are created in signaled state so the first wait for each frame returns immediately
+	VkFenceCreateInfo fenceCreateInfo = vks::initializers::fenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
+	for (auto& frame : frameObjects)
+	{
+		// Create a semaphore used to synchronize image presentation
+		// Ensures that the image is displayed before we start submitting new commands to the queu
+		VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &frame.semaphores.presentComplete));
+		// Create a semaphore used to synchronize command submission
+		// Ensures that the image is not presented until all commands have been sumbitted and executed
+		VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &frame.semaphores.renderComplete));
+		// Create a semaphore used to synchronize command submission
+		// Ensures that the image is not presented until all commands for the text overlay have been sumbitted and executed
+		// Will be inserted after the render complete semaphore if the text overlay is enabled
+		VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &frame.semaphores.textOverlayComplete));
+		// Create a fence used to check if the GPU has finished all work for this frame
+		VK_CHECK_RESULT(vkCreateFence(device, &fenceCreateInfo, nullptr, &frame.fence));
+		frame.commandBuffer = VK_NULL_HANDLE;
+	}
+	semaphores = frameObjects[0].semaphores;
 
 	// Set up submit info structure
-	// Semaphores will stay the same during application lifetime
+	// The semaphore pointers stay the same during application lifetime, their handles are switched to the current frame's in prepareFrame
 	// Command buffer submission info is set by each example
 	submitInfo = vks::initializers::submitInfo();
 	submitInfo.pWaitDstStageMask = &submitPipelineStages;
@@ -1285,6 +1792,7 @@ void VulkanExampleBase::handleAppCommand(android_app * app, int32_t cmd)
 			vulkanExample->initSwapchain();
 			vulkanExample->prepare();
 			assert(vulkanExample->prepared);
+			vulkanExample->prepareFinished();
 		}
 		else
 		{
@@ -1950,7 +2458,7 @@ void VulkanExampleBase::setupRenderPass()
 	attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	attachments[0].finalLayout = swapChain.presentLayout;
 	// Depth attachment
 	attachments[1].format = depthFormat;
 	attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
@@ -2075,6 +2583,12 @@ void VulkanExampleBase::windowResized()
 
 void VulkanExampleBase::initSwapchain()
 {
+	if (settings.headless)
+	{
+		// Offscreen images replace the surface based swap chain
+		swapChain.initHeadless(queue, vulkanDevice->queueFamilyIndices.graphics, &vulkanDevice->memoryAllocator);
+		return;
+	}
 #if defined(_WIN32)
 	swapChain.initSurface(windowInstance, window);
 #elif defined(__ANDROID__)	
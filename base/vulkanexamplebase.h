@@ -47,6 +47,11 @@
 #include "VulkanSwapChain.hpp"
 #include "VulkanTextOverlay.hpp"
 #include "camera.hpp"
+#include "benchmark.hpp"
+#include "VulkanGpuProfiler.hpp"
+#include "VulkanPipelineCache.hpp"
+#include "VulkanPipelineBatch.hpp"
+#include "threadpool.hpp"
 
 class VulkanExampleBase
 {
@@ -55,6 +60,8 @@ private:
 	float fpsTimer = 0.0f;
 	// Get window title with example name, device, et.
 	std::string getWindowTitle();
+	// Get the executable name without path and extension
+	std::string getExecutableName(std::string defaultName);
 	/** brief Indicates that the view (position, rotation) has changed and */
 	bool viewUpdated = false;
 	// Destination dimensions for resizing the window
@@ -63,6 +70,18 @@ private:
 	bool resizing = false;
 	// Called if the window is resized and some resources have to be recreatesd
 	void windowResize();
+	// Start of the base class preparation, used to report the startup time
+	std::chrono::time_point<std::chrono::high_resolution_clock> tPrepareStart;
+	// True if the pipeline cache has been initialized with data from a previous run
+	bool pipelineCacheWarm = false;
+	// Get the name of the file the pipeline cache is stored in (per example and device)
+	std::string getPipelineCacheFilename();
+	// Write the pipeline cache data to disk
+	void savePipelineCache();
+	// Called once the example has been prepared, right before the first frame is rendered
+	void prepareFinished();
+	// Worker threads shared by the example, started on the first call to getThreadPool()
+	vks::ThreadPool threadPool;
 protected:
 	// Last frame time, measured using a high performance timer (if available)
 	float frameTimer = 1.0f;
@@ -119,7 +138,7 @@ protected:
 	// Wraps the swap chain to present images (framebuffers) to the windowing system
 	VulkanSwapChain swapChain;
 	// Synchronization semaphores
-	struct {
+	struct Semaphores {
 		// Swap chain image presentation
 		VkSemaphore presentComplete;
 		// Command buffer submission and execution
@@ -127,10 +146,32 @@ protected:
 		// Text overlay submission and execution
 		VkSemaphore textOverlayComplete;
 	} semaphores;
+	/**
+	* Number of frames the host may record while the GPU is still processing previous ones (set in the derived constructor)
+	*
+	* @note Defaults to 1, which waits for each frame to finish in submitFrame. Examples that set this higher must not update resources still in use by earlier frames (see currentFrame)
+	*/
+	uint32_t maxFramesInFlight = 1;
+	/** @brief Index of the frame in flight currently being prepared (0..maxFramesInFlight-1), used to select per-frame resources */
+	uint32_t currentFrame = 0;
+	/** @brief Synchronization primitives and command buffer owned by a single frame in flight */
+	struct FrameObjects {
+		Semaphores semaphores;
+		// Signaled once all submissions of this frame have finished executing
+		VkFence fence;
+		// Primary command buffer for examples that record their commands each frame
+		VkCommandBuffer commandBuffer;
+	};
+	std::vector<FrameObjects> frameObjects;
+	// Fence of the frame that last rendered to each of the swap chain images
+	std::vector<VkFence> imageFences;
 	// Simple texture loader
 	//vks::tools::VulkanTextureLoader *textureLoader = nullptr;
 	// Returns the base asset path (for shaders, models, textures) depending on the os
 	const std::string getAssetPath();
+	// Returns the worker threads shared by the example (one thread per core), e.g. to compile a vks::PipelineBatch
+	// The threads are only started on the first call, so examples that don't use them don't pay for them
+	vks::ThreadPool &getThreadPool();
 public: 
 	bool prepared = false;
 	uint32_t width = 1280;
@@ -144,8 +185,21 @@ public:
 		bool fullscreen = false;
 		/** @brief Set to true if v-sync will be forced for the swapchain */
 		bool vsync = false;
+		/** @brief Set to true to render to offscreen images instead of a window (-headless) */
+		bool headless = false;
+		/** @brief Number of frames rendered in headless mode before the render loop exits (-frames) */
+		uint32_t headlessFrameCount = 100;
+		/** @brief Indices of frames that are written to disk in headless mode (-captureframes, comma separated) */
+		std::vector<uint32_t> captureFrames;
+		/** @brief Set to false to start with an empty pipeline cache instead of the one saved by the last run (-nopipelinecache) */
+		bool loadPipelineCache = true;
 	} settings;
 
+	/** @brief Frame time benchmark, replaces the regular render loop if active (-benchmark) */
+	vks::Benchmark benchmark;
+	/** @brief Timestamp query profiler, examples can wrap passes in gpuProfiler.beginScope/endScope to show their GPU times */
+	vks::GpuProfiler gpuProfiler;
+
 	VkClearColorValue defaultClearColor = { { 0.025f, 0.025f, 0.025f, 1.0f } };
 
 	float zoom = 0;
@@ -356,9 +410,12 @@ public:
 	// Note : Waits for the queue to become idle
 	void flushCommandBuffer(VkCommandBuffer commandBuffer, VkQueue queue, bool free);
 
-	// Create a cache pool for rendering pipelines
+	// Create a cache pool for rendering pipelines, initialized with the data saved by the last run if available
 	void createPipelineCache();
 
+	// Create one host visible (and mapped) uniform buffer per frame in flight, select the current one with currentFrame
+	void createFrameUniformBuffers(std::vector<vks::Buffer> &buffers, VkDeviceSize size);
+
 	// Prepare commonly used Vulkan functions
 	virtual void prepare();
 
@@ -368,6 +425,19 @@ public:
 	// Start the main render loop
 	void renderLoop();
 
+	// Process pending window system events without blocking, returns false if the window has been closed
+	bool handlePendingEvents();
+
+	/**
+	* Read back a swap chain image and save it to disk as a binary ppm
+	*
+	* @param imageIndex Index of the swap chain image to save (must be in present src layout)
+	* @param filename Name of the file to write
+	*
+	* @note Waits for the queue to become idle
+	*/
+	void captureFrame(uint32_t imageIndex, std::string filename);
+
 	void updateTextOverlay();
 
 	// Called when the text overlay is updating
@@ -375,12 +445,14 @@ public:
 	virtual void getOverlayText(VulkanTextOverlay * textOverlay);
 
 	// Prepare the frame for workload submission
+	// - Waits until the resources of the current frame in flight are no longer used by the GPU
 	// - Acquires the next image from the swap chain 
 	// - Sets the default wait and signal semaphores
 	void prepareFrame();
 
 	// Submit the frames' workload 
 	// - Submits the text overlay (if enabled)
+	// - Signals the fence of the current frame and advances to the next frame in flight
 	void submitFrame();
 
 };
@@ -403,7 +475,10 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 	for (size_t i = 0; i < __argc; i++) { VulkanExample::args.push_back(__argv[i]); };  			\
 	vulkanExample = new VulkanExample();															\
 	vulkanExample->initVulkan();																	\
-	vulkanExample->setupWindow(hInstance, WndProc);													\
+	if (!vulkanExample->settings.headless)															\
+	{																								\
+		vulkanExample->setupWindow(hInstance, WndProc);												\
+	}																								\
 	vulkanExample->initSwapchain();																	\
 	vulkanExample->prepare();																		\
 	vulkanExample->renderLoop();																	\
@@ -452,7 +527,10 @@ int main(const int argc, const char *argv[])													    \
 	for (size_t i = 0; i < argc; i++) { VulkanExample::args.push_back(argv[i]); };  				\
 	vulkanExample = new VulkanExample();															\
 	vulkanExample->initVulkan();																	\
-	vulkanExample->setupWindow();					 												\
+	if (!vulkanExample->settings.headless)															\
+	{																								\
+		vulkanExample->setupWindow();																\
+	}																								\
 	vulkanExample->initSwapchain();																	\
 	vulkanExample->prepare();																		\
 	vulkanExample->renderLoop();																	\
@@ -475,7 +553,10 @@ int main(const int argc, const char *argv[])													    \
 	for (size_t i = 0; i < argc; i++) { VulkanExample::args.push_back(argv[i]); };  				\
 	vulkanExample = new VulkanExample();															\
 	vulkanExample->initVulkan();																	\
-	vulkanExample->setupWindow();					 												\
+	if (!vulkanExample->settings.headless)															\
+	{																								\
+		vulkanExample->setupWindow();																\
+	}																								\
 	vulkanExample->initSwapchain();																	\
 	vulkanExample->prepare();																		\
 	vulkanExample->renderLoop();																	\
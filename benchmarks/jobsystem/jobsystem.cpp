@@ -0,0 +1,348 @@
+/*
+* Job system micro benchmark
+*
+* Compares the work stealing job system (and the thread pool implemented on top of it) with the previous thread pool using one mutex protected job queue per thread
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <random>
+#include <algorithm>
+
+#include "threadpool.hpp"
+
+// Previous thread pool implementation, jobs are bound to the thread they have been added to
+namespace legacy
+{
+	class Thread
+	{
+	private:
+		bool destroying = false;
+		std::thread worker;
+		std::queue<std::function<void()>> jobQueue;
+		std::mutex queueMutex;
+		std::condition_variable condition;
+
+		void queueLoop()
+		{
+			while (true)
+			{
+				std::function<void()> job;
+				{
+					std::unique_lock<std::mutex> lock(queueMutex);
+					condition.wait(lock, [this] { return !jobQueue.empty() || destroying; });
+					if (destroying)
+					{
+						break;
+					}
+					job = jobQueue.front();
+				}
+
+				job();
+
+				{
+					std::lock_guard<std::mutex> lock(queueMutex);
+					jobQueue.pop();
+					condition.notify_one();
+				}
+			}
+		}
+
+	public:
+		Thread()
+		{
+			worker = std::thread(&Thread::queueLoop, this);
+		}
+
+		~Thread()
+		{
+			if (worker.joinable())
+			{
+				wait();
+				queueMutex.lock();
+				destroying = true;
+				condition.notify_one();
+				queueMutex.unlock();
+				worker.join();
+			}
+		}
+
+		void addJob(std::function<void()> function)
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			jobQueue.push(std::move(function));
+			condition.notify_one();
+		}
+
+		void wait()
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			condition.wait(lock, [this]() { return jobQueue.empty(); });
+		}
+	};
+
+	class ThreadPool
+	{
+	public:
+		std::vector<std::unique_ptr<Thread>> threads;
+
+		void setThreadCount(uint32_t count)
+		{
+			threads.clear();
+			for (uint32_t i = 0; i < count; i++)
+			{
+				threads.push_back(make_unique<Thread>());
+			}
+		}
+
+		void wait()
+		{
+			for (auto &thread : threads)
+			{
+				thread->wait();
+			}
+		}
+	};
+}
+
+// Keeps the compiler from removing the simulated work
+std::atomic<uint64_t> sink(0);
+
+// Simulated work of the given number of iterations
+void work(uint32_t iterations)
+{
+	uint64_t value = iterations;
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+	}
+	sink.fetch_add(value & 1, std::memory_order_relaxed);
+}
+
+// Runs a function a number of times and returns the average duration in milliseconds
+double measure(uint32_t runs, std::function<void()> function)
+{
+	// Warm up
+	function();
+	auto tStart = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < runs; i++)
+	{
+		function();
+	}
+	auto tEnd = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(tEnd - tStart).count() / runs;
+}
+
+void printResult(const std::string &name, double legacyTime, double threadPoolTime, double jobSystemTime)
+{
+	std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3);
+	std::cout << std::setw(12) << legacyTime << std::setw(14) << threadPoolTime << std::setw(14) << jobSystemTime << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	uint32_t runs = 20;
+	for (int i = 1; i < argc - 1; i++)
+	{
+		std::string arg(argv[i]);
+		if (arg == "-threads")
+		{
+			threadCount = std::max(std::stoi(argv[i + 1]), 1);
+		}
+		if (arg == "-runs")
+		{
+			runs = std::max(std::stoi(argv[i + 1]), 1);
+		}
+	}
+
+	legacy::ThreadPool legacyPool;
+	legacyPool.setThreadCount(threadCount);
+	vks::ThreadPool threadPool;
+	threadPool.setThreadCount(threadCount);
+	vks::JobSystem &jobSystem = *threadPool.jobSystem;
+
+	std::cout << "Threads: " << threadCount << ", runs: " << runs << std::endl;
+	std::cout << "Average time per run in ms" << std::endl;
+	std::cout << std::left << std::setw(24) << "Test" << std::right << std::setw(12) << "legacy" << std::setw(14) << "threadpool" << std::setw(14) << "jobsystem" << std::endl;
+
+	// Many small jobs, measures the scheduling overhead
+	{
+		const uint32_t jobCount = 100000;
+		const uint32_t iterations = 100;
+		double legacyTime = measure(runs, [&]
+		{
+			for (uint32_t i = 0; i < jobCount; i++)
+			{
+				legacyPool.threads[i % threadCount]->addJob([=] { work(iterations); });
+			}
+			legacyPool.wait();
+		});
+		double threadPoolTime = measure(runs, [&]
+		{
+			for (uint32_t i = 0; i < jobCount; i++)
+			{
+				threadPool.threads[i % threadCount]->addJob([=] { work(iterations); });
+			}
+			threadPool.wait();
+		});
+		double jobSystemTime = measure(runs, [&]
+		{
+			vks::JobHandle job = jobSystem.parallelFor(0, jobCount, 64, [=](uint32_t first, uint32_t last)
+			{
+				for (uint32_t i = first; i < last; i++)
+				{
+					work(iterations);
+				}
+			});
+			jobSystem.wait(job);
+		});
+		printResult("small jobs", legacyTime, threadPoolTime, jobSystemTime);
+	}
+
+	// Independent jobs with very different costs distributed round robin, like objects with different complexity
+	{
+		const uint32_t jobCount = 4096;
+		std::vector<uint32_t> costs(jobCount);
+		std::mt19937 random(42);
+		std::uniform_int_distribution<uint32_t> distribution(0, 99);
+		for (auto &cost : costs)
+		{
+			// Roughly every 20th job is 50 times as expensive
+			cost = (distribution(random) < 5) ? 100000 : 2000;
+		}
+		double legacyTime = measure(runs, [&]
+		{
+			for (uint32_t i = 0; i < jobCount; i++)
+			{
+				uint32_t cost = costs[i];
+				legacyPool.threads[i % threadCount]->addJob([=] { work(cost); });
+			}
+			legacyPool.wait();
+		});
+		double threadPoolTime = measure(runs, [&]
+		{
+			for (uint32_t i = 0; i < jobCount; i++)
+			{
+				uint32_t cost = costs[i];
+				threadPool.threads[i % threadCount]->addJob([=] { work(cost); });
+			}
+			threadPool.wait();
+		});
+		const uint32_t *costData = costs.data();
+		double jobSystemTime = measure(runs, [&]
+		{
+			vks::JobHandle job = jobSystem.parallelFor(0, jobCount, 1, [=](uint32_t first, uint32_t last)
+			{
+				for (uint32_t i = first; i < last; i++)
+				{
+					work(costData[i]);
+				}
+			});
+			jobSystem.wait(job);
+		});
+		printResult("imbalanced jobs", legacyTime, threadPoolTime, jobSystemTime);
+	}
+
+	// One thread gets all the expensive jobs, jobs of a thread stay serialized but aren't bound to a worker anymore
+	{
+		const uint32_t jobsPerThread = 256;
+		double legacyTime = measure(runs, [&]
+		{
+			for (uint32_t t = 0; t < threadCount; t++)
+			{
+				for (uint32_t i = 0; i < jobsPerThread; i++)
+				{
+					uint32_t cost = (t == 0) ? 20000 : 2000;
+					legacyPool.threads[t]->addJob([=] { work(cost); });
+				}
+			}
+			legacyPool.wait();
+		});
+		double threadPoolTime = measure(runs, [&]
+		{
+			for (uint32_t t = 0; t < threadCount; t++)
+			{
+				for (uint32_t i = 0; i < jobsPerThread; i++)
+				{
+					uint32_t cost = (t == 0) ? 20000 : 2000;
+					threadPool.threads[t]->addJob([=] { work(cost); });
+				}
+			}
+			threadPool.wait();
+		});
+		double jobSystemTime = measure(runs, [&]
+		{
+			vks::JobHandle job = jobSystem.parallelFor(0, threadCount * jobsPerThread, 16, [=](uint32_t first, uint32_t last)
+			{
+				for (uint32_t i = first; i < last; i++)
+				{
+					work((i < jobsPerThread) ? 20000 : 2000);
+				}
+			});
+			jobSystem.wait(job);
+		});
+		printResult("one slow thread", legacyTime, threadPoolTime, jobSystemTime);
+	}
+
+	// Chains of dependent jobs
+	{
+		const uint32_t chainCount = 64;
+		const uint32_t chainLength = 256;
+		double legacyTime = measure(runs, [&]
+		{
+			// Jobs of a legacy thread run in order, so a chain is bound to a single thread
+			for (uint32_t c = 0; c < chainCount; c++)
+			{
+				for (uint32_t i = 0; i < chainLength; i++)
+				{
+					legacyPool.threads[c % threadCount]->addJob([] { work(500); });
+				}
+			}
+			legacyPool.wait();
+		});
+		double threadPoolTime = measure(runs, [&]
+		{
+			for (uint32_t c = 0; c < chainCount; c++)
+			{
+				for (uint32_t i = 0; i < chainLength; i++)
+				{
+					threadPool.threads[c % threadCount]->addJob([] { work(500); });
+				}
+			}
+			threadPool.wait();
+		});
+		double jobSystemTime = measure(runs, [&]
+		{
+			std::vector<vks::JobHandle> chains(chainCount);
+			for (uint32_t i = 0; i < chainLength; i++)
+			{
+				for (uint32_t c = 0; c < chainCount; c++)
+				{
+					chains[c] = jobSystem.run([] { work(500); }, { chains[c] });
+				}
+			}
+			for (auto &chain : chains)
+			{
+				jobSystem.wait(chain);
+			}
+		});
+		printResult("dependency chains", legacyTime, threadPoolTime, jobSystemTime);
+	}
+
+	std::cout << "(" << sink.load() << ")" << std::endl;
+	return 0;
+}
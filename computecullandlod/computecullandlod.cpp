@@ -61,6 +61,11 @@ public:
 		vks::Model lodObject;
 	} models;
 
+	// Levels of detail are switched once the simplification error of the next level covers less than this many pixels on screen
+	float lodPixelError = 2.0f;
+	// Scale the instances are drawn with
+	const float instanceScale = 2.0f;
+
 	// Per-instance data block
 	struct InstanceData {
 		glm::vec3 pos;
@@ -198,7 +203,7 @@ public:
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &models.lodObject.vertices.buffer, offsets);
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], INSTANCE_BUFFER_BIND_ID, 1, &instanceBuffer.buffer, offsets);
 			
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.lodObject.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.lodObject.indices.buffer, 0, models.lodObject.indexType);
 
 			if (vulkanDevice->features.multiDrawIndirect)
 			{
@@ -221,7 +226,9 @@ public:
 
 	void loadAssets()
 	{
-		models.lodObject.loadFromFile(getAssetPath() + "models/suzanne_lods.dae", vertexLayout, 0.1f, vulkanDevice, queue);
+		// The levels of detail are generated from the full detail model while loading it
+		models.lodObject.lodCount = MAX_LOD_LEVEL + 1;
+		models.lodObject.loadFromFile(getAssetPath() + "models/suzanne.obj", vertexLayout, 0.01f, vulkanDevice, queue);
 	}
 
 	void setupVertexDescriptions()
@@ -484,8 +491,6 @@ public:
 	{
 		objectCount = OBJECT_COUNT * OBJECT_COUNT * OBJECT_COUNT;
 
-		vks::Buffer stagingBuffer;
-
 		std::vector<InstanceData> instanceData(objectCount);
 		indirectCommands.resize(objectCount);
 
@@ -506,22 +511,14 @@ public:
 
 		indirectStats.drawCount = static_cast<uint32_t>(indirectCommands.size());
 
-		VK_CHECK_RESULT(vulkanDevice->createBuffer(
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			&stagingBuffer,
-			indirectCommands.size() * sizeof(VkDrawIndexedIndirectCommand),
-			indirectCommands.data()));
-
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			&indirectCommandsBuffer,
-			stagingBuffer.size));
+			indirectCommands.size() * sizeof(VkDrawIndexedIndirectCommand)));
 
-		vulkanDevice->copyBuffer(&stagingBuffer, &indirectCommandsBuffer, queue);
-
-		stagingBuffer.destroy();
+		// Upload through the device's staging ring, the copy is batched with the other uploads
+		vulkanDevice->uploadQueue.uploadBuffer(indirectCommandsBuffer.buffer, indirectCommands.data(), indirectCommandsBuffer.size, 0, vulkanDevice->queueFamilyIndices.compute);
 
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
@@ -541,64 +538,27 @@ public:
 				{
 					uint32_t index = x + y * OBJECT_COUNT + z * OBJECT_COUNT * OBJECT_COUNT;
 					instanceData[index].pos = glm::vec3((float)x, (float)y, (float)z) - glm::vec3((float)OBJECT_COUNT / 2.0f);
-					instanceData[index].scale = 2.0f;
+					instanceData[index].scale = instanceScale;
 				}
 			}
 		}
 
-		VK_CHECK_RESULT(vulkanDevice->createBuffer(
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			&stagingBuffer,
-			instanceData.size() * sizeof(InstanceData),
-			instanceData.data()));
-
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			&instanceBuffer,
-			stagingBuffer.size));
-
-		vulkanDevice->copyBuffer(&stagingBuffer, &instanceBuffer, queue);
+			instanceData.size() * sizeof(InstanceData)));
 
-		stagingBuffer.destroy();
+		// Upload through the device's staging ring, the copy is batched with the other uploads
+		vulkanDevice->uploadQueue.uploadBuffer(instanceBuffer.buffer, instanceData.data(), instanceBuffer.size, 0, vulkanDevice->queueFamilyIndices.compute);
 
 		// Shader storage buffer containing index offsets and counts for the LODs
-		struct LOD
-		{
-			uint32_t firstIndex;
-			uint32_t indexCount;
-			float distance;
-			float _pad0;
-		};
-		std::vector<LOD> LODLevels;
-		uint32_t n = 0;
-		for (auto modelPart : models.lodObject.parts)
-		{
-			LOD lod;
-			lod.firstIndex = modelPart.indexBase;			// First index for this LOD
-			lod.indexCount = modelPart.indexCount;			// Index count for this LOD
-			lod.distance = 5.0f + n * 5.0f;					// Starting distance (to viewer) for this LOD
-			n++;
-			LODLevels.push_back(lod);
-		}
-
-		VK_CHECK_RESULT(vulkanDevice->createBuffer(
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			&stagingBuffer,
-			LODLevels.size() * sizeof(LOD),
-			LODLevels.data()));
-
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			&compute.lodLevelsBuffers,
-			stagingBuffer.size));
-
-		vulkanDevice->copyBuffer(&stagingBuffer, &compute.lodLevelsBuffers, queue);
-
-		stagingBuffer.destroy();
+			models.lodObject.lods.size() * sizeof(LOD)));
+		updateLodLevels();
 
 		// Scene uniform buffer
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
@@ -612,6 +572,33 @@ public:
 		updateUniformBuffer(true);
 	}
 
+	// Shader storage buffer layout of a LOD level
+	struct LOD
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float distance;
+		float _pad0;
+	};
+
+	// The LOD distances are derived from the screen space error of the levels, so they change with the viewport height
+	void updateLodLevels()
+	{
+		std::vector<LOD> LODLevels;
+		const uint32_t levelCount = static_cast<uint32_t>(models.lodObject.lods.size());
+		for (uint32_t i = 0; i < levelCount; i++)
+		{
+			LOD lod;
+			lod.firstIndex = models.lodObject.lods[i].indexBase;	// First index for this LOD
+			lod.indexCount = models.lodObject.lods[i].indexCount;	// Index count for this LOD
+			// This LOD is used up to the distance the next one becomes acceptable
+			lod.distance = (i + 1 < levelCount) ? models.lodObject.getLodDistance(i + 1, camera.getFov(), (float)height, lodPixelError, instanceScale) : FLT_MAX;
+			lod._pad0 = 0.0f;
+			LODLevels.push_back(lod);
+		}
+		vulkanDevice->uploadQueue.uploadBuffer(compute.lodLevelsBuffers.buffer, LODLevels.data(), LODLevels.size() * sizeof(LOD), 0, vulkanDevice->queueFamilyIndices.compute);
+	}
+
 	void prepareCompute()
 	{
 		// Create a compute capable device queue
@@ -721,7 +708,7 @@ public:
 		specializationEntry.offset = 0;
 		specializationEntry.size = sizeof(uint32_t);
 
-		uint32_t specializationData = static_cast<uint32_t>(models.lodObject.parts.size()) - 1;
+		uint32_t specializationData = static_cast<uint32_t>(models.lodObject.lods.size()) - 1;
 
 		VkSpecializationInfo specializationInfo;
 		specializationInfo.mapEntryCount = 1;
@@ -852,6 +839,13 @@ public:
 		updateUniformBuffer(true);
 	}
 
+	virtual void windowResized()
+	{
+		updateLodLevels();
+		// The compute queue doesn't wait for the upload queue
+		vulkanDevice->uploadQueue.flush();
+	}
+
 	virtual void keyPressed(uint32_t keyCode)
 	{
 		switch (keyCode)
@@ -21,9 +21,9 @@
 #include <vulkan/vulkan.h>
 #include "vulkanexamplebase.h"
 #include "VulkanBuffer.hpp"
-#include "VulkanFrameBuffer.hpp"
 #include "VulkanTexture.hpp"
 #include "VulkanModel.hpp"
+#include "VulkanRenderGraph.hpp"
 
 #define VERTEX_BUFFER_BIND_ID 0
 #define ENABLE_VALIDATION false
@@ -153,20 +153,17 @@ public:
 	VkDescriptorSet descriptorSet;
 	VkDescriptorSetLayout descriptorSetLayout;
 
-	struct
-	{
-		// Framebuffer resources for the deferred pass
-		vks::Framebuffer *deferred;
-		// Framebuffer resources for the shadow pass
-		vks::Framebuffer *shadow;
-	} frameBuffers;
-
+	// Offscreen passes rendering the layered shadow map and filling the G-Buffer
+	// The graph creates the attachments, render passes and framebuffers and puts the barriers between the passes
 	struct {
-		VkCommandBuffer deferred = VK_NULL_HANDLE;
-	} commandBuffers;
-
-	// Semaphore used to synchronize between offscreen and final scene rendering
-	VkSemaphore offscreenSemaphore = VK_NULL_HANDLE;
+		vks::RenderGraph graph;
+		vks::RenderGraph::Pass *shadowPass;
+		vks::RenderGraph::Pass *gBufferPass;
+		vks::RenderGraph::ResourceHandle shadowMap;
+		vks::RenderGraph::ResourceHandle position, normal, albedo, depth;
+		VkSampler shadowSampler;
+		VkSampler colorSampler;
+	} offscreen;
 
 	VulkanExample() : VulkanExampleBase(ENABLE_VALIDATION)
 	{
@@ -188,15 +185,10 @@ public:
 
 	~VulkanExample()
 	{
-		// Frame buffers
-		if (frameBuffers.deferred)
-		{
-			delete frameBuffers.deferred;
-		}
-		if (frameBuffers.shadow)
-		{
-			delete frameBuffers.shadow;
-		}
+		// Attachments, render passes and framebuffers
+		vulkanDevice->samplerCache.release(offscreen.shadowSampler);
+		vulkanDevice->samplerCache.release(offscreen.colorSampler);
+		offscreen.graph.destroy();
 
 		vkDestroyPipeline(device, pipelines.deferred, nullptr);
 		vkDestroyPipeline(device, pipelines.offscreen, nullptr);
@@ -219,15 +211,11 @@ public:
 		uniformBuffers.fsLights.destroy();
 		uniformBuffers.uboShadowGS.destroy();
 
-		vkFreeCommandBuffers(device, cmdPool, 1, &commandBuffers.deferred);
-
 		// Textures
 		textures.model.colorMap.destroy();
 		textures.model.normalMap.destroy();
 		textures.background.colorMap.destroy();
 		textures.background.normalMap.destroy();
-
-		vkDestroySemaphore(device, offscreenSemaphore, nullptr);
 	}
 
 	// Enable physical device features required for this example				
@@ -242,79 +230,104 @@ public:
 		}
 	}
 
-	// Prepare a layered shadow map with each layer containing depth from a light's point of view
-	// The shadow mapping pass uses geometry shader instancing to output the scene from the different
-	// light sources' point of view to the layers of the depth attachment in one single pass 
-	void shadowSetup()
+	// Create a sampler for the offscreen attachments
+	VkSampler createAttachmentSampler(VkFilter filter)
+	{
+		VkSamplerCreateInfo samplerInfo = vks::initializers::samplerCreateInfo();
+		samplerInfo.magFilter = filter;
+		samplerInfo.minFilter = filter;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = samplerInfo.addressModeU;
+		samplerInfo.addressModeW = samplerInfo.addressModeU;
+		samplerInfo.mipLodBias = 0.0f;
+		samplerInfo.maxAnisotropy = 0;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = 1.0f;
+		samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+		VkSampler sampler;
+		VK_CHECK_RESULT(vulkanDevice->samplerCache.acquire(samplerInfo, &sampler));
+		return sampler;
+	}
+
+	// Declare the offscreen passes
+	void prepareOffscreen()
 	{
-		frameBuffers.shadow = new vks::Framebuffer(vulkanDevice);
+		vks::RenderGraph &graph = offscreen.graph;
+		graph.create(vulkanDevice);
 
-		frameBuffers.shadow->width = SHADOWMAP_DIM;
-		frameBuffers.shadow->height = SHADOWMAP_DIM;
+		vks::RenderGraph::AttachmentInfo attachmentInfo;
 
-		// Create a layered depth attachment for rendering the depth maps from the lights' point of view
+		// Prepare a layered shadow map with each layer containing depth from a light's point of view
 		// Each layer corresponds to one of the lights
 		// The actual output to the separate layers is done in the geometry shader using shader instancing
 		// We will pass the matrices of the lights to the GS that selects the layer by the current invocation
-		vks::AttachmentCreateInfo attachmentInfo = {};
 		attachmentInfo.format = SHADOWMAP_FORMAT;
 		attachmentInfo.width = SHADOWMAP_DIM;
 		attachmentInfo.height = SHADOWMAP_DIM;
 		attachmentInfo.layerCount = LIGHT_COUNT;
-		attachmentInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-		frameBuffers.shadow->addAttachment(attachmentInfo);
-
-		// Create sampler to sample from to depth attachment 
-		// Used to sample in the fragment shader for shadowed rendering
-		VK_CHECK_RESULT(frameBuffers.shadow->createSampler(VK_FILTER_LINEAR, VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE));
-
-		// Create default renderpass for the framebuffer
-		VK_CHECK_RESULT(frameBuffers.shadow->createRenderPass());
-	}
-
-	// Prepare the framebuffer for offscreen rendering with multiple attachments used as render targets inside the fragment shaders
-	void deferredSetup()
-	{
-		frameBuffers.deferred = new vks::Framebuffer(vulkanDevice);
-
-		frameBuffers.deferred->width = FB_DIM;
-		frameBuffers.deferred->height = FB_DIM;
+		offscreen.shadowMap = graph.addAttachment("shadowMap", attachmentInfo);
 
-		// Four attachments (3 color, 1 depth)
-		vks::AttachmentCreateInfo attachmentInfo = {};
+		// G-Buffer with three color attachments and depth
 		attachmentInfo.width = FB_DIM;
 		attachmentInfo.height = FB_DIM;
 		attachmentInfo.layerCount = 1;
-		attachmentInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-
-		// Color attachments
-		// Attachment 0: (World space) Positions
+		// (World space) Positions
 		attachmentInfo.format = VK_FORMAT_R16G16B16A16_SFLOAT;
-		frameBuffers.deferred->addAttachment(attachmentInfo);
-
-		// Attachment 1: (World space) Normals
+		offscreen.position = graph.addAttachment("position", attachmentInfo);
+		// (World space) Normals
 		attachmentInfo.format = VK_FORMAT_R16G16B16A16_SFLOAT;
-		frameBuffers.deferred->addAttachment(attachmentInfo);
-
-		// Attachment 2: Albedo (color)
+		offscreen.normal = graph.addAttachment("normal", attachmentInfo);
+		// Albedo (color)
 		attachmentInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-		frameBuffers.deferred->addAttachment(attachmentInfo);
-
-		// Depth attachment
-		// Find a suitable depth format
+		offscreen.albedo = graph.addAttachment("albedo", attachmentInfo);
+		// Depth, only used inside of the G-Buffer pass
 		VkFormat attDepthFormat;
 		VkBool32 validDepthFormat = vks::tools::getSupportedDepthFormat(physicalDevice, &attDepthFormat);
 		assert(validDepthFormat);
-
 		attachmentInfo.format = attDepthFormat;
-		attachmentInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-		frameBuffers.deferred->addAttachment(attachmentInfo);
+		offscreen.depth = graph.addAttachment("depth", attachmentInfo);
+
+		// First pass: Shadow map generation
+		// The shadow mapping pass uses geometry shader instancing to output the scene from the different
+		// light sources' point of view to the layers of the depth attachment in one single pass 
+		offscreen.shadowPass = &graph.addPass("Shadow map");
+		offscreen.shadowPass->setDepthStencilOutput(offscreen.shadowMap);
+		offscreen.shadowPass->record = [this](VkCommandBuffer commandBuffer)
+		{
+			// Set depth bias (aka "Polygon offset")
+			vkCmdSetDepthBias(
+				commandBuffer,
+				depthBiasConstant,
+				0.0f,
+				depthBiasSlope);
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.shadowpass);
+			renderScene(commandBuffer, true);
+		};
 
-		// Create sampler to sample from the color attachments
-		VK_CHECK_RESULT(frameBuffers.deferred->createSampler(VK_FILTER_NEAREST, VK_FILTER_NEAREST, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE));
+		// Second pass: Fill the G-Buffer with multiple render targets
+		offscreen.gBufferPass = &graph.addPass("G-Buffer fill");
+		offscreen.gBufferPass->addColorOutput(offscreen.position);
+		offscreen.gBufferPass->addColorOutput(offscreen.normal);
+		offscreen.gBufferPass->addColorOutput(offscreen.albedo);
+		offscreen.gBufferPass->setDepthStencilOutput(offscreen.depth);
+		offscreen.gBufferPass->record = [this](VkCommandBuffer commandBuffer)
+		{
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.offscreen);
+			renderScene(commandBuffer, false);
+		};
 
-		// Create default renderpass for the framebuffer
-		VK_CHECK_RESULT(frameBuffers.deferred->createRenderPass());
+		// The composition samples the G-Buffer and the shadow map
+		graph.addExternalRead(offscreen.shadowMap);
+		graph.addExternalRead(offscreen.position);
+		graph.addExternalRead(offscreen.normal);
+		graph.addExternalRead(offscreen.albedo);
+		graph.compile(width, height);
+		graph.printStats();
+
+		// Samplers for the shadow map and the color attachments
+		offscreen.shadowSampler = createAttachmentSampler(VK_FILTER_LINEAR);
+		offscreen.colorSampler = createAttachmentSampler(VK_FILTER_NEAREST);
 	}
 
 	// Put render commands for the scene into the given command buffer
@@ -325,98 +338,16 @@ public:
 		// Background
 		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.offscreen, 0, 1, shadow ? &descriptorSets.shadow : &descriptorSets.background, 0, NULL);
 		vkCmdBindVertexBuffers(cmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &models.background.vertices.buffer, offsets);
-		vkCmdBindIndexBuffer(cmdBuffer, models.background.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindIndexBuffer(cmdBuffer, models.background.indices.buffer, 0, models.background.indexType);
 		vkCmdDrawIndexed(cmdBuffer, models.background.indexCount, 1, 0, 0, 0);
 
 		// Objects
 		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.offscreen, 0, 1, shadow ? &descriptorSets.shadow : &descriptorSets.model, 0, NULL);
 		vkCmdBindVertexBuffers(cmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &models.model.vertices.buffer, offsets);
-		vkCmdBindIndexBuffer(cmdBuffer, models.model.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindIndexBuffer(cmdBuffer, models.model.indices.buffer, 0, models.model.indexType);
 		vkCmdDrawIndexed(cmdBuffer, models.model.indexCount, 3, 0, 0, 0);
 	}
 
-	// Build a secondary command buffer for rendering the scene values to the offscreen frame buffer attachments
-	void buildDeferredCommandBuffer()
-	{
-		if (commandBuffers.deferred == VK_NULL_HANDLE)
-		{
-			commandBuffers.deferred = VulkanExampleBase::createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, false);
-		}
-
-		// Create a semaphore used to synchronize offscreen rendering and usage
-		VkSemaphoreCreateInfo semaphoreCreateInfo = vks::initializers::semaphoreCreateInfo();
-		VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &offscreenSemaphore));
-
-		VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
-
-		VkRenderPassBeginInfo renderPassBeginInfo = vks::initializers::renderPassBeginInfo();
-		std::array<VkClearValue, 4> clearValues = {};
-		VkViewport viewport;
-		VkRect2D scissor;
-
-		// First pass: Shadow map generation
-		// -------------------------------------------------------------------------------------------------------
-	
-		clearValues[0].depthStencil = { 1.0f, 0 };
-
-		renderPassBeginInfo.renderPass = frameBuffers.shadow->renderPass;
-		renderPassBeginInfo.framebuffer = frameBuffers.shadow->framebuffer;
-		renderPassBeginInfo.renderArea.extent.width = frameBuffers.shadow->width;
-		renderPassBeginInfo.renderArea.extent.height = frameBuffers.shadow->height;
-		renderPassBeginInfo.clearValueCount = 1;
-		renderPassBeginInfo.pClearValues = clearValues.data();
-
-		VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffers.deferred, &cmdBufInfo));
-
-		viewport = vks::initializers::viewport((float)frameBuffers.shadow->width, (float)frameBuffers.shadow->height, 0.0f, 1.0f);
-		vkCmdSetViewport(commandBuffers.deferred, 0, 1, &viewport);
-
-		scissor = vks::initializers::rect2D(frameBuffers.shadow->width, frameBuffers.shadow->height, 0, 0);
-		vkCmdSetScissor(commandBuffers.deferred, 0, 1, &scissor);
-
-		// Set depth bias (aka "Polygon offset")
-		vkCmdSetDepthBias(
-			commandBuffers.deferred,
-			depthBiasConstant,
-			0.0f,
-			depthBiasSlope);
-
-		vkCmdBeginRenderPass(commandBuffers.deferred, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-		vkCmdBindPipeline(commandBuffers.deferred, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.shadowpass);
-		renderScene(commandBuffers.deferred, true);
-		vkCmdEndRenderPass(commandBuffers.deferred);
-
-		// Second pass: Deferred calculations
-		// -------------------------------------------------------------------------------------------------------
-
-		// Clear values for all attachments written in the fragment sahder
-		clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
-		clearValues[1].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
-		clearValues[2].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
-		clearValues[3].depthStencil = { 1.0f, 0 };
-
-		renderPassBeginInfo.renderPass = frameBuffers.deferred->renderPass;
-		renderPassBeginInfo.framebuffer = frameBuffers.deferred->framebuffer;
-		renderPassBeginInfo.renderArea.extent.width = frameBuffers.deferred->width;
-		renderPassBeginInfo.renderArea.extent.height = frameBuffers.deferred->height;
-		renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-		renderPassBeginInfo.pClearValues = clearValues.data();
-
-		vkCmdBeginRenderPass(commandBuffers.deferred, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-		viewport = vks::initializers::viewport((float)frameBuffers.deferred->width, (float)frameBuffers.deferred->height, 0.0f, 1.0f);
-		vkCmdSetViewport(commandBuffers.deferred, 0, 1, &viewport);
-
-		scissor = vks::initializers::rect2D(frameBuffers.deferred->width, frameBuffers.deferred->height, 0, 0);
-		vkCmdSetScissor(commandBuffers.deferred, 0, 1, &scissor);
-
-		vkCmdBindPipeline(commandBuffers.deferred, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.offscreen);
-		renderScene(commandBuffers.deferred, false);
-		vkCmdEndRenderPass(commandBuffers.deferred);
-
-		VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffers.deferred));
-	}
-
 	void loadAssets()
 	{
 		models.model.loadFromFile(getAssetPath() + "models/armor/armor.dae", vertexLayout, 1.0f, vulkanDevice, queue);
@@ -487,6 +418,9 @@ public:
 
 			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
 
+			// Shadow map and G-Buffer passes, including the barriers that make their results available to the composition
+			offscreen.graph.execute(drawCmdBuffers[i]);
+
 			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 			VkViewport viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
@@ -501,7 +435,7 @@ public:
 			// Final composition as full screen quad
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.deferred);
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &models.quad.vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.quad.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.quad.indices.buffer, 0, models.quad.indexType);
 			vkCmdDrawIndexed(drawCmdBuffers[i], 6, 1, 0, 0, 0);
 
 			if (debugDisplay)
@@ -538,9 +472,8 @@ public:
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&models.quad.vertices,
 			vertexBuffer.size() * sizeof(Vertex),
-			&models.quad.vertices.buffer,
-			&models.quad.vertices.memory,
 			vertexBuffer.data()));
 
 		// Setup indices
@@ -558,9 +491,8 @@ public:
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&models.quad.indices,
 			indexBuffer.size() * sizeof(uint32_t),
-			&models.quad.indices.buffer,
-			&models.quad.indices.memory,
 			indexBuffer.data()));
 
 		models.quad.device = device;
@@ -707,30 +639,11 @@ public:
 
 		VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet));
 
-		// Image descriptors for the offscreen color attachments
-		VkDescriptorImageInfo texDescriptorPosition =
-			vks::initializers::descriptorImageInfo(
-				frameBuffers.deferred->sampler,
-				frameBuffers.deferred->attachments[0].view,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-		VkDescriptorImageInfo texDescriptorNormal =
-			vks::initializers::descriptorImageInfo(
-				frameBuffers.deferred->sampler,
-				frameBuffers.deferred->attachments[1].view,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-		VkDescriptorImageInfo texDescriptorAlbedo =
-			vks::initializers::descriptorImageInfo(
-				frameBuffers.deferred->sampler,
-				frameBuffers.deferred->attachments[2].view,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-		VkDescriptorImageInfo texDescriptorShadowMap =
-			vks::initializers::descriptorImageInfo(
-				frameBuffers.shadow->sampler,
-				frameBuffers.shadow->attachments[0].view,
-				VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+		// Image descriptors for the offscreen attachments
+		VkDescriptorImageInfo texDescriptorPosition = offscreen.graph.getDescriptor(offscreen.position, offscreen.colorSampler);
+		VkDescriptorImageInfo texDescriptorNormal = offscreen.graph.getDescriptor(offscreen.normal, offscreen.colorSampler);
+		VkDescriptorImageInfo texDescriptorAlbedo = offscreen.graph.getDescriptor(offscreen.albedo, offscreen.colorSampler);
+		VkDescriptorImageInfo texDescriptorShadowMap = offscreen.graph.getDescriptor(offscreen.shadowMap, offscreen.shadowSampler);
 
 		writeDescriptorSets = {
 			// Binding 0: Vertex shader uniform buffer
@@ -923,7 +836,7 @@ public:
 		shaderStages[1] = loadShader(getAssetPath() + "shaders/deferredshadows/mrt.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
 
 		// Separate render pass
-		pipelineCreateInfo.renderPass = frameBuffers.deferred->renderPass;
+		pipelineCreateInfo.renderPass = offscreen.gBufferPass->getRenderPass();
 
 		// Separate layout
 		pipelineCreateInfo.layout = pipelineLayouts.offscreen;
@@ -970,7 +883,7 @@ public:
 				static_cast<uint32_t>(dynamicStateEnables.size()),
 				0);
 		// Reset blend attachment state
-		pipelineCreateInfo.renderPass = frameBuffers.shadow->renderPass;
+		pipelineCreateInfo.renderPass = offscreen.shadowPass->getRenderPass();
 		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipelines.shadowpass));
 	}
 
@@ -1096,28 +1009,9 @@ public:
 	{
 		VulkanExampleBase::prepareFrame();
 
-		// Offscreen rendering
-
-		// Wait for swap chain presentation to finish
-		submitInfo.pWaitSemaphores = &semaphores.presentComplete;
-		// Signal ready with offscreen semaphore
-		submitInfo.pSignalSemaphores = &offscreenSemaphore;
-
-		// Submit work
-
-		// Shadow map pass
+		// The offscreen passes are recorded into the same command buffer as the composition, so the
+		// graph's barriers order them and no additional semaphore is required
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffers.deferred;
-		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
-
-		// Scene rendering
-
-		// Wait for offscreen semaphore
-		submitInfo.pWaitSemaphores = &offscreenSemaphore;
-		// Signal ready with render complete semaphpre
-		submitInfo.pSignalSemaphores = &semaphores.renderComplete;
-
-		// Submit work
 		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
 		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
 
@@ -1130,8 +1024,7 @@ public:
 		loadAssets();
 		generateQuads();
 		setupVertexDescriptions();
-		deferredSetup();
-		shadowSetup();
+		prepareOffscreen();
 		initLights();
 		prepareUniformBuffers();
 		setupDescriptorSetLayout();
@@ -1139,7 +1032,6 @@ public:
 		setupDescriptorPool();
 		setupDescriptorSet();
 		buildCommandBuffers();
-		buildDeferredCommandBuffer();
 		prepared = true;
 	}
 
@@ -24,6 +24,7 @@
 #include "VulkanBuffer.hpp"
 #include "VulkanModel.hpp"
 #include "VulkanTexture.hpp"
+#include "VulkanRenderGraph.hpp"
 
 #define ENABLE_VALIDATION false
 
@@ -90,37 +91,17 @@ public:
 		VkDescriptorSetLayout bloomFilter;
 	} descriptorSetLayouts;
 
-	// Framebuffer for offscreen rendering
-	struct FrameBufferAttachment {
-		VkImage image;
-		VkDeviceMemory mem;
-		VkImageView view;
-		VkFormat format;
-		void destroy(VkDevice device)
-		{
-			vkDestroyImageView(device, view, nullptr);
-			vkDestroyImage(device, image, nullptr);
-			vkFreeMemory(device, mem, nullptr);
-		}
-	};
-	struct FrameBuffer {
-		int32_t width, height;
-		VkFramebuffer frameBuffer;
-		FrameBufferAttachment color[2];
-		FrameBufferAttachment depth;
-		VkRenderPass renderPass;
-		VkSampler sampler;
-		VkCommandBuffer cmdBuffer = VK_NULL_HANDLE;
-		VkSemaphore semaphore = VK_NULL_HANDLE;
-	} offscreen;
-
+	// Offscreen passes rendering the scene into floating point attachments and applying the first (vertical) bloom blur
+	// The graph creates the attachments, render passes and framebuffers and puts the barriers between the passes
 	struct {
-		int32_t width, height;
-		VkFramebuffer frameBuffer;
-		FrameBufferAttachment color[1];
-		VkRenderPass renderPass;
+		vks::RenderGraph graph;
+		vks::RenderGraph::Pass *scenePass;
+		vks::RenderGraph::Pass *bloomFilterPass;
+		vks::RenderGraph::ResourceHandle color[2];
+		vks::RenderGraph::ResourceHandle depth;
+		vks::RenderGraph::ResourceHandle bloomFilter;
 		VkSampler sampler;
-	} filterPass;
+	} offscreen;
 
 	VulkanExample() : VulkanExampleBase(ENABLE_VALIDATION)
 	{
@@ -148,22 +129,8 @@ public:
 		vkDestroyDescriptorSetLayout(device, descriptorSetLayouts.composition, nullptr);
 		vkDestroyDescriptorSetLayout(device, descriptorSetLayouts.bloomFilter, nullptr);
 
-		vkDestroySemaphore(device, offscreen.semaphore, nullptr);
-
-		vkDestroyRenderPass(device, offscreen.renderPass, nullptr);
-		vkDestroyRenderPass(device, filterPass.renderPass, nullptr);
-
-		vkDestroyFramebuffer(device, offscreen.frameBuffer, nullptr);
-		vkDestroyFramebuffer(device, filterPass.frameBuffer, nullptr);
-
-		vkDestroySampler(device, offscreen.sampler, nullptr);
-		vkDestroySampler(device, filterPass.sampler, nullptr);
-
-		offscreen.depth.destroy(device);
-		offscreen.color[0].destroy(device);
-		offscreen.color[1].destroy(device);
-
-		filterPass.color[0].destroy(device);
+		vulkanDevice->samplerCache.release(offscreen.sampler);
+		offscreen.graph.destroy();
 
 		for (auto& model : models.objects) {
 			model.destroy();
@@ -182,7 +149,6 @@ public:
 			createCommandBuffers();
 		}
 		buildCommandBuffers();
-		buildDeferredCommandBuffer();
 	}
 
 	void buildCommandBuffers()
@@ -203,34 +169,16 @@ public:
 
 		VkViewport viewport;
 		VkRect2D scissor;
-		VkDeviceSize offsets[1] = { 0 };
 
 		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i)
 		{
 
 			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
 
-			// Bloom filter
-			renderPassBeginInfo.framebuffer = filterPass.frameBuffer;
-			renderPassBeginInfo.renderPass = filterPass.renderPass;
-			renderPassBeginInfo.clearValueCount = 1;
-			renderPassBeginInfo.renderArea.extent.width = filterPass.width;
-			renderPassBeginInfo.renderArea.extent.height = filterPass.height;
-
-			viewport = vks::initializers::viewport((float)filterPass.width, (float)filterPass.height, 0.0f, 1.0f);
-			scissor = vks::initializers::rect2D(filterPass.width, filterPass.height, 0, 0);
-
-			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-			vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
-			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
-
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.bloomFilter, 0, 1, &descriptorSets.bloomFilter, 0, NULL);
+			gpuProfiler.reset(drawCmdBuffers[i]);
 
-			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.bloom[1]);
-			vkCmdDraw(drawCmdBuffers[i], 3, 1, 0, 0);
-
-			vkCmdEndRenderPass(drawCmdBuffers[i]);
+			// Scene and bloom filter passes, including the barriers that make their results available to the composition
+			offscreen.graph.execute(drawCmdBuffers[i]);
 
 			viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
 			scissor = vks::initializers::rect2D(width, height, 0, 0);
@@ -242,6 +190,7 @@ public:
 			renderPassBeginInfo.renderArea.extent.width = width;
 			renderPassBeginInfo.renderArea.extent.height = height;
 
+			gpuProfiler.beginScope(drawCmdBuffers[i], "Composition");
 			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 			vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
@@ -261,340 +210,96 @@ public:
 			}
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
+			gpuProfiler.endScope(drawCmdBuffers[i]);
 
 			VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
 		}
 	}
 
-	void createAttachment(VkFormat format, VkImageUsageFlagBits usage, FrameBufferAttachment *attachment)
-	{
-		VkImageAspectFlags aspectMask = 0;
-		VkImageLayout imageLayout;
-
-		attachment->format = format;
-
-		if (usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
-		{
-			aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-		}
-		if (usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
-		{
-			aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
-			imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-		}
-
-		assert(aspectMask > 0);
-
-		VkImageCreateInfo image = vks::initializers::imageCreateInfo();
-		image.imageType = VK_IMAGE_TYPE_2D;
-		image.format = format;
-		image.extent.width = offscreen.width;
-		image.extent.height = offscreen.height;
-		image.extent.depth = 1;
-		image.mipLevels = 1;
-		image.arrayLayers = 1;
-		image.samples = VK_SAMPLE_COUNT_1_BIT;
-		image.tiling = VK_IMAGE_TILING_OPTIMAL;
-		image.usage = usage | VK_IMAGE_USAGE_SAMPLED_BIT;
-
-		VkMemoryAllocateInfo memAlloc = vks::initializers::memoryAllocateInfo();
-		VkMemoryRequirements memReqs;
-
-		VK_CHECK_RESULT(vkCreateImage(device, &image, nullptr, &attachment->image));
-		vkGetImageMemoryRequirements(device, attachment->image, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		memAlloc.memoryTypeIndex = vulkanDevice->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-		VK_CHECK_RESULT(vkAllocateMemory(device, &memAlloc, nullptr, &attachment->mem));
-		VK_CHECK_RESULT(vkBindImageMemory(device, attachment->image, attachment->mem, 0));
-
-		VkImageViewCreateInfo imageView = vks::initializers::imageViewCreateInfo();
-		imageView.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		imageView.format = format;
-		imageView.subresourceRange = {};
-		imageView.subresourceRange.aspectMask = aspectMask;
-		imageView.subresourceRange.baseMipLevel = 0;
-		imageView.subresourceRange.levelCount = 1;
-		imageView.subresourceRange.baseArrayLayer = 0;
-		imageView.subresourceRange.layerCount = 1;
-		imageView.image = attachment->image;
-		VK_CHECK_RESULT(vkCreateImageView(device, &imageView, nullptr, &attachment->view));
-	}
-
-	// Prepare a new framebuffer and attachments for offscreen rendering (G-Buffer)
-	void prepareoffscreenfer()
+	// Declare the offscreen passes
+	void prepareOffscreen()
 	{
+		vks::RenderGraph &graph = offscreen.graph;
+		graph.create(vulkanDevice);
+
+		// All attachments are sized relative to the window
+		vks::RenderGraph::AttachmentInfo attachmentInfo;
+
+		// Two floating point color buffers, the scene and its bright parts
+		attachmentInfo.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+		offscreen.color[0] = graph.addAttachment("color", attachmentInfo);
+		offscreen.color[1] = graph.addAttachment("bright", attachmentInfo);
+		// Vertically blurred bright parts
+		offscreen.bloomFilter = graph.addAttachment("bloomFilter", attachmentInfo);
+		// The depth attachment is only used inside of the scene pass, so it's lazily allocated (if supported) or shares its memory with the bloom filter target
+		attachmentInfo.format = depthFormat;
+		offscreen.depth = graph.addAttachment("depth", attachmentInfo);
+
+		// First pass: Render the scene into both color attachments
+		offscreen.scenePass = &graph.addPass("Scene");
+		offscreen.scenePass->addColorOutput(offscreen.color[0], { { 0.0f, 0.0f, 0.0f, 0.0f } });
+		offscreen.scenePass->addColorOutput(offscreen.color[1], { { 0.0f, 0.0f, 0.0f, 0.0f } });
+		offscreen.scenePass->setDepthStencilOutput(offscreen.depth);
+		offscreen.scenePass->record = [this](VkCommandBuffer commandBuffer)
 		{
-			offscreen.width = width;
-			offscreen.height = height;
-
-			// Color attachments
+			gpuProfiler.beginScope(commandBuffer, "Scene");
+			VkDeviceSize offsets[1] = { 0 };
 
-			// Two floating point color buffers
-			createAttachment(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, &offscreen.color[0]);
-			createAttachment(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, &offscreen.color[1]);
-			// Depth attachment
-			createAttachment(depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, &offscreen.depth);
-
-			// Set up separate renderpass with references to the colorand depth attachments
-			std::array<VkAttachmentDescription, 3> attachmentDescs = {};
-
-			// Init attachment properties
-			for (uint32_t i = 0; i < 3; ++i)
+			// Skybox
+			if (displaySkybox)
 			{
-				attachmentDescs[i].samples = VK_SAMPLE_COUNT_1_BIT;
-				attachmentDescs[i].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-				attachmentDescs[i].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-				attachmentDescs[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-				attachmentDescs[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-				if (i == 2)
-				{
-					attachmentDescs[i].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-					attachmentDescs[i].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-				}
-				else
-				{
-					attachmentDescs[i].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-					attachmentDescs[i].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				}
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.models, 0, 1, &descriptorSets.skybox, 0, NULL);
+				vkCmdBindVertexBuffers(commandBuffer, 0, 1, &models.skybox.vertices.buffer, offsets);
+				vkCmdBindIndexBuffer(commandBuffer, models.skybox.indices.buffer, 0, models.skybox.indexType);
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.skybox);
+				vkCmdDrawIndexed(commandBuffer, models.skybox.indexCount, 1, 0, 0, 0);
 			}
 
-			// Formats
-			attachmentDescs[0].format = offscreen.color[0].format;
-			attachmentDescs[1].format = offscreen.color[1].format;
-			attachmentDescs[2].format = offscreen.depth.format;
-
-			std::vector<VkAttachmentReference> colorReferences;
-			colorReferences.push_back({ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
-			colorReferences.push_back({ 1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
-
-			VkAttachmentReference depthReference = {};
-			depthReference.attachment = 2;
-			depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-			VkSubpassDescription subpass = {};
-			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-			subpass.pColorAttachments = colorReferences.data();
-			subpass.colorAttachmentCount = 2;
-			subpass.pDepthStencilAttachment = &depthReference;
-
-			// Use subpass dependencies for attachment layput transitions
-			std::array<VkSubpassDependency, 2> dependencies;
-
-			dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-			dependencies[0].dstSubpass = 0;
-			dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-			dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-			dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-			dependencies[1].srcSubpass = 0;
-			dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-			dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-			dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-			dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-			VkRenderPassCreateInfo renderPassInfo = {};
-			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-			renderPassInfo.pAttachments = attachmentDescs.data();
-			renderPassInfo.attachmentCount = static_cast<uint32_t>(attachmentDescs.size());
-			renderPassInfo.subpassCount = 1;
-			renderPassInfo.pSubpasses = &subpass;
-			renderPassInfo.dependencyCount = 2;
-			renderPassInfo.pDependencies = dependencies.data();
-
-			VK_CHECK_RESULT(vkCreateRenderPass(device, &renderPassInfo, nullptr, &offscreen.renderPass));
-
-			std::array<VkImageView, 3> attachments;
-			attachments[0] = offscreen.color[0].view;
-			attachments[1] = offscreen.color[1].view;
-			attachments[2] = offscreen.depth.view;
-
-			VkFramebufferCreateInfo fbufCreateInfo = {};
-			fbufCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-			fbufCreateInfo.pNext = NULL;
-			fbufCreateInfo.renderPass = offscreen.renderPass;
-			fbufCreateInfo.pAttachments = attachments.data();
-			fbufCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-			fbufCreateInfo.width = offscreen.width;
-			fbufCreateInfo.height = offscreen.height;
-			fbufCreateInfo.layers = 1;
-			VK_CHECK_RESULT(vkCreateFramebuffer(device, &fbufCreateInfo, nullptr, &offscreen.frameBuffer));
-
-			// Create sampler to sample from the color attachments
-			VkSamplerCreateInfo sampler = vks::initializers::samplerCreateInfo();
-			sampler.magFilter = VK_FILTER_NEAREST;
-			sampler.minFilter = VK_FILTER_NEAREST;
-			sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-			sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			sampler.addressModeV = sampler.addressModeU;
-			sampler.addressModeW = sampler.addressModeU;
-			sampler.mipLodBias = 0.0f;
-			sampler.maxAnisotropy = 0;
-			sampler.minLod = 0.0f;
-			sampler.maxLod = 1.0f;
-			sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-			VK_CHECK_RESULT(vkCreateSampler(device, &sampler, nullptr, &offscreen.sampler));
-		}
-
-		// Bloom separable filter pass
-		{
-			filterPass.width = width;
-			filterPass.height = height;
-
-			// Color attachments
-
-			// Two floating point color buffers
-			createAttachment(VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, &filterPass.color[0]);
-
-			// Set up separate renderpass with references to the colorand depth attachments
-			std::array<VkAttachmentDescription, 1> attachmentDescs = {};
-
-			// Init attachment properties
-			attachmentDescs[0].samples = VK_SAMPLE_COUNT_1_BIT;
-			attachmentDescs[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			attachmentDescs[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-			attachmentDescs[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-			attachmentDescs[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			attachmentDescs[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			attachmentDescs[0].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			attachmentDescs[0].format = filterPass.color[0].format;
-
-			std::vector<VkAttachmentReference> colorReferences;
-			colorReferences.push_back({ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
-
-			VkSubpassDescription subpass = {};
-			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-			subpass.pColorAttachments = colorReferences.data();
-			subpass.colorAttachmentCount = 1;
-
-			// Use subpass dependencies for attachment layput transitions
-			std::array<VkSubpassDependency, 2> dependencies;
-
-			dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-			dependencies[0].dstSubpass = 0;
-			dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-			dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-			dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-			dependencies[1].srcSubpass = 0;
-			dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-			dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-			dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-			dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-			VkRenderPassCreateInfo renderPassInfo = {};
-			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-			renderPassInfo.pAttachments = attachmentDescs.data();
-			renderPassInfo.attachmentCount = static_cast<uint32_t>(attachmentDescs.size());
-			renderPassInfo.subpassCount = 1;
-			renderPassInfo.pSubpasses = &subpass;
-			renderPassInfo.dependencyCount = 2;
-			renderPassInfo.pDependencies = dependencies.data();
-
-			VK_CHECK_RESULT(vkCreateRenderPass(device, &renderPassInfo, nullptr, &filterPass.renderPass));
-
-			std::array<VkImageView, 1> attachments;
-			attachments[0] = filterPass.color[0].view;
-
-			VkFramebufferCreateInfo fbufCreateInfo = {};
-			fbufCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-			fbufCreateInfo.pNext = NULL;
-			fbufCreateInfo.renderPass = filterPass.renderPass;
-			fbufCreateInfo.pAttachments = attachments.data();
-			fbufCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-			fbufCreateInfo.width = filterPass.width;
-			fbufCreateInfo.height = filterPass.height;
-			fbufCreateInfo.layers = 1;
-			VK_CHECK_RESULT(vkCreateFramebuffer(device, &fbufCreateInfo, nullptr, &filterPass.frameBuffer));
-
-			// Create sampler to sample from the color attachments
-			VkSamplerCreateInfo sampler = vks::initializers::samplerCreateInfo();
-			sampler.magFilter = VK_FILTER_NEAREST;
-			sampler.minFilter = VK_FILTER_NEAREST;
-			sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-			sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			sampler.addressModeV = sampler.addressModeU;
-			sampler.addressModeW = sampler.addressModeU;
-			sampler.mipLodBias = 0.0f;
-			sampler.maxAnisotropy = 0;
-			sampler.minLod = 0.0f;
-			sampler.maxLod = 1.0f;
-			sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-			VK_CHECK_RESULT(vkCreateSampler(device, &sampler, nullptr, &filterPass.sampler));
-		}
-	}
-
-	// Build command buffer for rendering the scene to the offscreen frame buffer attachments
-	void buildDeferredCommandBuffer()
-	{
-		if (offscreen.cmdBuffer == VK_NULL_HANDLE)
-		{
-			offscreen.cmdBuffer = VulkanExampleBase::createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, false);
-		}
-
-		// Create a semaphore used to synchronize offscreen rendering and usage
-		if (offscreen.semaphore == VK_NULL_HANDLE)
-		{
-			VkSemaphoreCreateInfo semaphoreCreateInfo = vks::initializers::semaphoreCreateInfo();
-			VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &offscreen.semaphore));
-		}
-
-		VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
-
-		// Clear values for all attachments written in the fragment sahder
-		std::array<VkClearValue, 3> clearValues;
-		clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
-		clearValues[1].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
-		clearValues[2].depthStencil = { 1.0f, 0 };
-
-		VkRenderPassBeginInfo renderPassBeginInfo = vks::initializers::renderPassBeginInfo();
-		renderPassBeginInfo.renderPass = offscreen.renderPass;
-		renderPassBeginInfo.framebuffer = offscreen.frameBuffer;
-		renderPassBeginInfo.renderArea.extent.width = offscreen.width;
-		renderPassBeginInfo.renderArea.extent.height = offscreen.height;
-		renderPassBeginInfo.clearValueCount = 3;
-		renderPassBeginInfo.pClearValues = clearValues.data();
-
-		VK_CHECK_RESULT(vkBeginCommandBuffer(offscreen.cmdBuffer, &cmdBufInfo));
-
-		vkCmdBeginRenderPass(offscreen.cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-		VkViewport viewport = vks::initializers::viewport((float)offscreen.width, (float)offscreen.height, 0.0f, 1.0f);
-		vkCmdSetViewport(offscreen.cmdBuffer, 0, 1, &viewport);
-
-		VkRect2D scissor = vks::initializers::rect2D(offscreen.width, offscreen.height, 0, 0);
-		vkCmdSetScissor(offscreen.cmdBuffer, 0, 1, &scissor);
-
-		VkDeviceSize offsets[1] = { 0 };
+			// 3D object
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.models, 0, 1, &descriptorSets.object, 0, NULL);
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &models.objects[models.objectIndex].vertices.buffer, offsets);
+			vkCmdBindIndexBuffer(commandBuffer, models.objects[models.objectIndex].indices.buffer, 0, models.objects[models.objectIndex].indexType);
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.reflect);
+			vkCmdDrawIndexed(commandBuffer, models.objects[models.objectIndex].indexCount, 1, 0, 0, 0);
+			gpuProfiler.endScope(commandBuffer);
+		};
 
-		// Skybox
-		if (displaySkybox)
+		// Second pass: Vertical blur of the bright parts, the horizontal blur is applied when rendering on top of the scene
+		offscreen.bloomFilterPass = &graph.addPass("Bloom filter");
+		// The filter's descriptor set also contains the scene color, so it has to be readable too
+		offscreen.bloomFilterPass->addTextureInput(offscreen.color[0]);
+		offscreen.bloomFilterPass->addTextureInput(offscreen.color[1]);
+		offscreen.bloomFilterPass->addColorOutput(offscreen.bloomFilter, { { 0.0f, 0.0f, 0.0f, 0.0f } });
+		offscreen.bloomFilterPass->record = [this](VkCommandBuffer commandBuffer)
 		{
-			vkCmdBindDescriptorSets(offscreen.cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.models, 0, 1, &descriptorSets.skybox, 0, NULL);
-			vkCmdBindVertexBuffers(offscreen.cmdBuffer, 0, 1, &models.skybox.vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(offscreen.cmdBuffer, models.skybox.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
-			vkCmdBindPipeline(offscreen.cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.skybox);
-			vkCmdDrawIndexed(offscreen.cmdBuffer, models.skybox.indexCount, 1, 0, 0, 0);
-		}
-
-		// 3D object
-		vkCmdBindDescriptorSets(offscreen.cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.models, 0, 1, &descriptorSets.object, 0, NULL);
-		vkCmdBindVertexBuffers(offscreen.cmdBuffer, 0, 1, &models.objects[models.objectIndex].vertices.buffer, offsets);
-		vkCmdBindIndexBuffer(offscreen.cmdBuffer, models.objects[models.objectIndex].indices.buffer, 0, VK_INDEX_TYPE_UINT32);
-		vkCmdBindPipeline(offscreen.cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.reflect);
-		vkCmdDrawIndexed(offscreen.cmdBuffer, models.objects[models.objectIndex].indexCount, 1, 0, 0, 0);
-
-		vkCmdEndRenderPass(offscreen.cmdBuffer);
+			gpuProfiler.beginScope(commandBuffer, "Bloom filter");
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayouts.bloomFilter, 0, 1, &descriptorSets.bloomFilter, 0, NULL);
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.bloom[1]);
+			vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+			gpuProfiler.endScope(commandBuffer);
+		};
 
-		VK_CHECK_RESULT(vkEndCommandBuffer(offscreen.cmdBuffer));
+		// The composition samples the scene and the vertically blurred bright parts
+		// The bright parts are an intermediate of the graph and aren't kept after the bloom filter
+		graph.addExternalRead(offscreen.color[0]);
+		graph.addExternalRead(offscreen.bloomFilter);
+		graph.compile(width, height);
+		graph.printStats();
+
+		// Create sampler to sample from the color attachments
+		VkSamplerCreateInfo sampler = vks::initializers::samplerCreateInfo();
+		sampler.magFilter = VK_FILTER_NEAREST;
+		sampler.minFilter = VK_FILTER_NEAREST;
+		sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler.addressModeV = sampler.addressModeU;
+		sampler.addressModeW = sampler.addressModeU;
+		sampler.mipLodBias = 0.0f;
+		sampler.maxAnisotropy = 0;
+		sampler.minLod = 0.0f;
+		sampler.maxLod = 1.0f;
+		sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+		VK_CHECK_RESULT(vulkanDevice->samplerCache.acquire(sampler, &offscreen.sampler));
 	}
 
 	void loadAssets()
@@ -613,7 +318,7 @@ public:
 		textures.envmap.loadFromFile(getAssetPath() + "textures/hdr_uffizi_bc6uf.DDS", VK_FORMAT_BC6H_UFLOAT_BLOCK, vulkanDevice, queue);
 
 		// Custom sampler with clamping adress mode
-		vkDestroySampler(device, textures.envmap.sampler, nullptr);
+		vulkanDevice->samplerCache.release(textures.envmap.sampler);
 		VkSamplerCreateInfo sampler{};
 		sampler.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
 		sampler.magFilter = VK_FILTER_LINEAR;
@@ -627,7 +332,7 @@ public:
 		sampler.anisotropyEnable = VK_TRUE;
 		sampler.maxAnisotropy = vulkanDevice->properties.limits.maxSamplerAnisotropy;
 		sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-		VK_CHECK_RESULT(vkCreateSampler(vulkanDevice->logicalDevice, &sampler, nullptr, &textures.envmap.sampler));
+		VK_CHECK_RESULT(vulkanDevice->samplerCache.acquire(sampler, &textures.envmap.sampler));
 		textures.envmap.descriptor.sampler = textures.envmap.sampler;
 	}
 
@@ -721,8 +426,8 @@ public:
 		VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSets.bloomFilter));
 
 		std::vector<VkDescriptorImageInfo> colorDescriptors = {
-			vks::initializers::descriptorImageInfo(offscreen.sampler, offscreen.color[0].view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
-			vks::initializers::descriptorImageInfo(offscreen.sampler, offscreen.color[1].view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+			offscreen.graph.getDescriptor(offscreen.color[0], offscreen.sampler),
+			offscreen.graph.getDescriptor(offscreen.color[1], offscreen.sampler),
 		};
 
 		writeDescriptorSets = {
@@ -736,8 +441,8 @@ public:
 		VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSets.composition));
 
 		colorDescriptors = {
-			vks::initializers::descriptorImageInfo(offscreen.sampler, offscreen.color[0].view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
-			vks::initializers::descriptorImageInfo(offscreen.sampler, filterPass.color[0].view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+			offscreen.graph.getDescriptor(offscreen.color[0], offscreen.sampler),
+			offscreen.graph.getDescriptor(offscreen.bloomFilter, offscreen.sampler),
 		};
 
 		writeDescriptorSets = {
@@ -749,6 +454,9 @@ public:
 
 	void preparePipelines()
 	{
+		// Pipelines are collected in a batch and compiled in parallel at the end of this function
+		vks::PipelineBatch pipelineBatch(device);
+
 		VkPipelineInputAssemblyStateCreateInfo inputAssemblyState =
 			vks::initializers::pipelineInputAssemblyStateCreateInfo(
 				VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
@@ -837,7 +545,7 @@ public:
 		rasterizationState.cullMode = VK_CULL_MODE_NONE;
 		colorBlendState.attachmentCount = 1;
 		colorBlendState.pAttachments = blendAttachmentStates.data();
-		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipelines.composition));
+		pipelineBatch.add(pipelineCreateInfo, &pipelines.composition);
 
 		// Bloom pass
 		shaderStages[0] = loadShader(getAssetPath() + "shaders/hdr/bloom.vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
@@ -858,12 +566,12 @@ public:
 		specializationInfo = vks::initializers::specializationInfo(1, specializationMapEntries.data(), sizeof(dir), &dir);
 		shaderStages[1].pSpecializationInfo = &specializationInfo;
 
-		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipelines.bloom[0]));
+		pipelineBatch.add(pipelineCreateInfo, &pipelines.bloom[0]);
 
 		// Second blur pass (into separate framebuffer)
-		pipelineCreateInfo.renderPass = filterPass.renderPass;
+		pipelineCreateInfo.renderPass = offscreen.bloomFilterPass->getRenderPass();
 		dir = 0;
-		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipelines.bloom[1]));
+		pipelineBatch.add(pipelineCreateInfo, &pipelines.bloom[1]);
 
 		// Object rendering pipelines 
 
@@ -892,7 +600,7 @@ public:
 		// Skybox pipeline (background cube)
 		blendAttachmentState.blendEnable = VK_FALSE;
 		pipelineCreateInfo.layout = pipelineLayouts.models;
-		pipelineCreateInfo.renderPass = offscreen.renderPass;
+		pipelineCreateInfo.renderPass = offscreen.scenePass->getRenderPass();
 		colorBlendState.attachmentCount = 2;
 		colorBlendState.pAttachments = blendAttachmentStates.data();
 
@@ -906,7 +614,7 @@ public:
 		shaderStages[0].pSpecializationInfo = &specializationInfo;
 		shaderStages[1].pSpecializationInfo = &specializationInfo;
 
-		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipelines.skybox));
+		pipelineBatch.add(pipelineCreateInfo, &pipelines.skybox);
 
 		// Object rendering pipeline
 		shadertype = 1;
@@ -916,7 +624,9 @@ public:
 		depthStencilState.depthTestEnable = VK_TRUE;
 		// Flip cull mode
 		rasterizationState.cullMode = VK_CULL_MODE_NONE;
-		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipelines.reflect));
+		pipelineBatch.add(pipelineCreateInfo, &pipelines.reflect);
+
+		pipelineBatch.build(pipelineCache, getThreadPool());
 	}
 
 	// Prepare and initialize uniform buffer containing shader uniforms
@@ -960,14 +670,9 @@ public:
 	{
 		VulkanExampleBase::prepareFrame();
 
-		submitInfo.pWaitSemaphores = &semaphores.presentComplete;
-		submitInfo.pSignalSemaphores = &offscreen.semaphore;
+		// The offscreen passes are recorded into the same command buffer as the composition, so the
+		// graph's barriers order them and no additional semaphore is required
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &offscreen.cmdBuffer;
-		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
-
-		submitInfo.pWaitSemaphores = &offscreen.semaphore;
-		submitInfo.pSignalSemaphores = &semaphores.renderComplete;
 		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
 		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
 
@@ -979,13 +684,12 @@ public:
 		VulkanExampleBase::prepare();
 		loadAssets();
 		prepareUniformBuffers();
-		prepareoffscreenfer();
+		prepareOffscreen();
 		setupDescriptorSetLayout();
 		preparePipelines();
 		setupDescriptorPool();
 		setupDescriptorSets();
 		buildCommandBuffers();
-		buildDeferredCommandBuffer();
 		prepared = true;
 	}
 
@@ -199,7 +199,7 @@ public:
 			// Binding point 1 : Instance data buffer
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], INSTANCE_BUFFER_BIND_ID, 1, &instanceBuffer.buffer, offsets);
 			
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.plants.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.plants.indices.buffer, 0, models.plants.indexType);
 
 			// If the multi draw feature is supported:
 			// One draw call for an arbitrary number of ojects
@@ -220,12 +220,12 @@ public:
 			// Ground
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.ground);
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &models.ground.vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.ground.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.ground.indices.buffer, 0, models.ground.indexType);
 			vkCmdDrawIndexed(drawCmdBuffers[i], models.ground.indexCount, 1, 0, 0, 0);
 			// Skysphere
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.skysphere);
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &models.skysphere.vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.skysphere.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.skysphere.indices.buffer, 0, models.skysphere.indexType);
 			vkCmdDrawIndexed(drawCmdBuffers[i], models.skysphere.indexCount, 1, 0, 0, 0);
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
@@ -556,23 +556,14 @@ public:
 			objectCount += indirectCmd.instanceCount;
 		}
 
-		vks::Buffer stagingBuffer;
-		VK_CHECK_RESULT(vulkanDevice->createBuffer(
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			&stagingBuffer,
-			indirectCommands.size() * sizeof(VkDrawIndexedIndirectCommand),
-			indirectCommands.data()));
-
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			&indirectCommandsBuffer,
-			stagingBuffer.size));
-
-		vulkanDevice->copyBuffer(&stagingBuffer, &indirectCommandsBuffer, queue);
+			indirectCommands.size() * sizeof(VkDrawIndexedIndirectCommand)));
 
-		stagingBuffer.destroy();
+		// Upload through the device's staging ring, the copy is batched with the other uploads
+		vulkanDevice->uploadQueue.uploadBuffer(indirectCommandsBuffer.buffer, indirectCommands.data(), indirectCommandsBuffer.size);
 	}
 
 	// Prepare (and stage) a buffer containing instanced data for the mesh draws
@@ -594,23 +585,14 @@ public:
 			instanceData[i].texIndex = i / OBJECT_INSTANCE_COUNT;
 		}
 
-		vks::Buffer stagingBuffer;
-		VK_CHECK_RESULT(vulkanDevice->createBuffer(
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			&stagingBuffer,
-			instanceData.size() * sizeof(InstanceData),
-			instanceData.data()));
-
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			&instanceBuffer,
-			stagingBuffer.size));
-
-		vulkanDevice->copyBuffer(&stagingBuffer, &instanceBuffer, queue);
+			instanceData.size() * sizeof(InstanceData)));
 
-		stagingBuffer.destroy();
+		// Upload through the device's staging ring, the copy is batched with the other uploads
+		vulkanDevice->uploadQueue.uploadBuffer(instanceBuffer.buffer, instanceData.data(), instanceBuffer.size);
 	}
 
 	void prepareUniformBuffers()
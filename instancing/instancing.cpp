@@ -61,7 +61,7 @@ public:
 	// Contains the instanced data
 	struct InstanceBuffer {
 		VkBuffer buffer = VK_NULL_HANDLE;
-		VkDeviceMemory memory = VK_NULL_HANDLE;
+		vks::Allocation allocation;
 		size_t size = 0;
 		VkDescriptorBufferInfo descriptor;
 	} instanceBuffer;
@@ -110,7 +110,7 @@ public:
 		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 		vkDestroyBuffer(device, instanceBuffer.buffer, nullptr);
-		vkFreeMemory(device, instanceBuffer.memory, nullptr);
+		instanceBuffer.allocation.free();
 		models.rock.destroy();
 		models.planet.destroy();
 		textures.rocks.destroy();
@@ -159,7 +159,7 @@ public:
 			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets.planet, 0, NULL);
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.planet);
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &models.planet.vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.planet.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.planet.indices.buffer, 0, models.planet.indexType);
 			vkCmdDrawIndexed(drawCmdBuffers[i], models.planet.indexCount, 1, 0, 0, 0);
 
 			// Instanced rocks
@@ -170,7 +170,7 @@ public:
 			// Binding point 1 : Instance data buffer
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], INSTANCE_BUFFER_BIND_ID, 1, &instanceBuffer.buffer, offsets);
 
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.rock.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.rock.indices.buffer, 0, models.rock.indexType);
 
 			// Render instances
 			vkCmdDrawIndexed(drawCmdBuffers[i], models.rock.indexCount, INSTANCE_COUNT, 0, 0, 0);
@@ -465,7 +465,7 @@ public:
 		// This results in better performance
 
 		struct {
-			VkDeviceMemory memory;
+			vks::Allocation allocation;
 			VkBuffer buffer;
 		} stagingBuffer;
 
@@ -474,7 +474,7 @@ public:
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 			instanceBuffer.size,
 			&stagingBuffer.buffer,
-			&stagingBuffer.memory,
+			&stagingBuffer.allocation,
 			instanceData.data()));
 
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
@@ -482,7 +482,7 @@ public:
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			instanceBuffer.size,
 			&instanceBuffer.buffer,
-			&instanceBuffer.memory));
+			&instanceBuffer.allocation));
 
 		// Copy to staging buffer
 		VkCommandBuffer copyCmd = VulkanExampleBase::createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
@@ -504,7 +504,7 @@ public:
 
 		// Destroy staging resources
 		vkDestroyBuffer(device, stagingBuffer.buffer, nullptr);
-		vkFreeMemory(device, stagingBuffer.memory, nullptr);
+		stagingBuffer.allocation.free();
 	}
 
 	void prepareUniformBuffers()
@@ -59,20 +59,20 @@ public:
 	struct Model {
 		struct {
 			VkBuffer buffer;
-			VkDeviceMemory memory;
+			vks::Allocation allocation;
 		} vertices;
 		struct {
 			int count;
 			VkBuffer buffer;
-			VkDeviceMemory memory;
+			vks::Allocation allocation;
 		} indices;
 		// Destroys all Vulkan resources created for this model
 		void destroy(VkDevice device)
 		{
 			vkDestroyBuffer(device, vertices.buffer, nullptr);
-			vkFreeMemory(device, vertices.memory, nullptr);
+			vertices.allocation.free();
 			vkDestroyBuffer(device, indices.buffer, nullptr);
-			vkFreeMemory(device, indices.memory, nullptr);
+			indices.allocation.free();
 		};
 	} model;
 
@@ -275,7 +275,7 @@ public:
 		{
 			struct {
 				VkBuffer buffer;
-				VkDeviceMemory memory;
+				vks::Allocation allocation;
 			} vertexStaging, indexStaging;
 
 			// Create staging buffers
@@ -285,7 +285,7 @@ public:
 				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 				vertexBufferSize,
 				&vertexStaging.buffer,
-				&vertexStaging.memory,
+				&vertexStaging.allocation,
 				vertexBuffer.data()));
 			// Index data
 			VK_CHECK_RESULT(vulkanDevice->createBuffer(
@@ -293,7 +293,7 @@ public:
 				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 				indexBufferSize,
 				&indexStaging.buffer,
-				&indexStaging.memory,
+				&indexStaging.allocation,
 				indexBuffer.data()));
 
 			// Create device local buffers
@@ -303,14 +303,14 @@ public:
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 				vertexBufferSize,
 				&model.vertices.buffer,
-				&model.vertices.memory));
+				&model.vertices.allocation));
 			// Index buffer
 			VK_CHECK_RESULT(vulkanDevice->createBuffer(
 				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 				indexBufferSize,
 				&model.indices.buffer,
-				&model.indices.memory));
+				&model.indices.allocation));
 
 			// Copy from staging buffers
 			VkCommandBuffer copyCmd = VulkanExampleBase::createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
@@ -336,9 +336,9 @@ public:
 			VulkanExampleBase::flushCommandBuffer(copyCmd, queue, true);
 
 			vkDestroyBuffer(device, vertexStaging.buffer, nullptr);
-			vkFreeMemory(device, vertexStaging.memory, nullptr);
+			vertexStaging.allocation.free();
 			vkDestroyBuffer(device, indexStaging.buffer, nullptr);
-			vkFreeMemory(device, indexStaging.memory, nullptr);
+			indexStaging.allocation.free();
 		}
 		else
 		{
@@ -348,7 +348,7 @@ public:
 				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
 				vertexBufferSize,
 				&model.vertices.buffer,
-				&model.vertices.memory,
+				&model.vertices.allocation,
 				vertexBuffer.data()));
 			// Index buffer
 			VK_CHECK_RESULT(vulkanDevice->createBuffer(
@@ -356,7 +356,7 @@ public:
 				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
 				indexBufferSize,
 				&model.indices.buffer,
-				&model.indices.memory,
+				&model.indices.allocation,
 				indexBuffer.data()));
 		}
 	}
@@ -64,8 +64,8 @@ public:
 
 	VkPipelineLayout pipelineLayout;
 
-	VkCommandBuffer primaryCommandBuffer;
-	VkCommandBuffer secondaryCommandBuffer;
+	// Secondary command buffer for the star sphere (one per frame in flight)
+	std::vector<VkCommandBuffer> secondaryCommandBuffers;
 
 	// Number of animated objects to be renderer
 	// by using threads and secondary command buffers
@@ -96,7 +96,7 @@ public:
 
 	struct ThreadData {
 		VkCommandPool commandPool;
-		// One command buffer per render object
+		// One command buffer per render object and frame in flight
 		std::vector<VkCommandBuffer> commandBuffer;
 		// One push constant block per render object
 		std::vector<ThreadPushConstantBlock> pushConstBlock;
@@ -107,13 +107,9 @@ public:
 
 	vks::ThreadPool threadPool;
 
-	// Fence to wait for all command buffers to finish before
-	// presenting to the swap chain
-	VkFence renderFence = {};
-
-	// Max. dimension of the ufo mesh for use as the sphere
-	// radius for frustum culling
-	float objectSphereDim;
+	// Radius of a sphere around the ufo mesh's origin that contains all of its parts
+	// Used for frustum culling
+	float objectSphereRadius;
 
 	// View frustum for culling invisible objects
 	vks::Frustum frustum;
@@ -126,6 +122,9 @@ public:
 		rotation = { 0.0f, 37.5f, 0.0f };
 		enableTextOverlay = true;
 		title = "Vulkan Example - Multi threaded rendering";
+		// Command buffers are recorded each frame, so the host can already work on 
+		// the next frame while the GPU is still busy with the previous one
+		maxFramesInFlight = 2;
 		// Get number of max. concurrrent threads
 		numThreads = std::thread::hardware_concurrency();
 		assert(numThreads > 0);
@@ -150,8 +149,7 @@ public:
 
 		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 
-		vkFreeCommandBuffers(device, cmdPool, 1, &primaryCommandBuffer);
-		vkFreeCommandBuffers(device, cmdPool, 1, &secondaryCommandBuffer);
+		vkFreeCommandBuffers(device, cmdPool, secondaryCommandBuffers.size(), secondaryCommandBuffers.data());
 
 		models.ufo.destroy();
 		models.skysphere.destroy();
@@ -161,8 +159,6 @@ public:
 			vkFreeCommandBuffers(device, thread.commandPool, thread.commandBuffer.size(), thread.commandBuffer.data());
 			vkDestroyCommandPool(device, thread.commandPool, nullptr);
 		}
-
-		vkDestroyFence(device, renderFence, nullptr);
 	}
 
 	float rnd(float range)
@@ -175,17 +171,16 @@ public:
 	{
 		// Since this demo updates the command buffers on each frame
 		// we don't use the per-framebuffer command buffers from the
-		// base class, and create a single primary command buffer instead
+		// base class, and use the per-frame primary command buffers instead
+
+		// Create a secondary command buffer for rendering the star sphere for each frame in flight
+		secondaryCommandBuffers.resize(maxFramesInFlight);
 		VkCommandBufferAllocateInfo cmdBufAllocateInfo =
 			vks::initializers::commandBufferAllocateInfo(
 				cmdPool,
-				VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-				1);
-		VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &primaryCommandBuffer));
-
-		// Create a secondary command buffer for rendering the star sphere
-		cmdBufAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
-		VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &secondaryCommandBuffer));
+				VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+				secondaryCommandBuffers.size());
+		VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, secondaryCommandBuffers.data()));
 		
 		threadData.resize(numThreads);
 
@@ -207,7 +202,8 @@ public:
 			VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &thread->commandPool));
 
 			// One secondary command buffer per object that is updated by this thread
-			thread->commandBuffer.resize(numObjectsPerThread);
+			// Each frame in flight uses a separate set, as the previous frame's may still be executing
+			thread->commandBuffer.resize(numObjectsPerThread * maxFramesInFlight);
 			// Generate secondary command buffers for each thread
 			VkCommandBufferAllocateInfo secondaryCmdBufAllocateInfo =
 				vks::initializers::commandBufferAllocateInfo(
@@ -244,7 +240,7 @@ public:
 		ObjectData *objectData = &thread->objectData[cmdBufferIndex];
 
 		// Check visibility against view frustum
-		objectData->visible = frustum.checkSphere(objectData->pos, objectSphereDim * 0.5f); 
+		objectData->visible = frustum.checkSphere(objectData->pos, objectSphereRadius * objectData->scale);
 
 		if (!objectData->visible)
 		{
@@ -255,7 +251,7 @@ public:
 		commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
 		commandBufferBeginInfo.pInheritanceInfo = &inheritanceInfo;
 
-		VkCommandBuffer cmdBuffer = thread->commandBuffer[cmdBufferIndex];
+		VkCommandBuffer cmdBuffer = thread->commandBuffer[currentFrame * numObjectsPerThread + cmdBufferIndex];
 
 		VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuffer, &commandBufferBeginInfo));
 
@@ -298,7 +294,7 @@ public:
 
 		VkDeviceSize offsets[1] = { 0 };
 		vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &models.ufo.vertices.buffer, offsets);
-		vkCmdBindIndexBuffer(cmdBuffer, models.ufo.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindIndexBuffer(cmdBuffer, models.ufo.indices.buffer, 0, models.ufo.indexType);
 		vkCmdDrawIndexed(cmdBuffer, models.ufo.indexCount, 1, 0, 0, 0);
 
 		VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
@@ -306,6 +302,8 @@ public:
 
 	void updateSecondaryCommandBuffer(VkCommandBufferInheritanceInfo inheritanceInfo)
 	{
+		VkCommandBuffer secondaryCommandBuffer = secondaryCommandBuffers[currentFrame];
+
 		// Secondary command buffer for the sky sphere
 		VkCommandBufferBeginInfo commandBufferBeginInfo = vks::initializers::commandBufferBeginInfo();
 		commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
@@ -338,7 +336,7 @@ public:
 
 		VkDeviceSize offsets[1] = { 0 };
 		vkCmdBindVertexBuffers(secondaryCommandBuffer, 0, 1, &models.skysphere.vertices.buffer, offsets);
-		vkCmdBindIndexBuffer(secondaryCommandBuffer, models.skysphere.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindIndexBuffer(secondaryCommandBuffer, models.skysphere.indices.buffer, 0, models.skysphere.indexType);
 		vkCmdDrawIndexed(secondaryCommandBuffer, models.skysphere.indexCount, 1, 0, 0, 0);
 
 		VK_CHECK_RESULT(vkEndCommandBuffer(secondaryCommandBuffer));
@@ -349,6 +347,8 @@ public:
 	// lat submitted to the queue for rendering
 	void updateCommandBuffers(VkFramebuffer frameBuffer)
 	{
+		VkCommandBuffer primaryCommandBuffer = frameObjects[currentFrame].commandBuffer;
+
 		VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
 
 		VkClearValue clearValues[2];
@@ -385,18 +385,21 @@ public:
 
 		// Secondary command buffer with star background sphere
 		updateSecondaryCommandBuffer(inheritanceInfo);
-		commandBuffers.push_back(secondaryCommandBuffer);
+		commandBuffers.push_back(secondaryCommandBuffers[currentFrame]);
 
-		// Add a job to the thread's queue for each object to be rendered
-		for (uint32_t t = 0; t < numThreads; t++)
+		// Record the objects of each thread in a single job, as the command pool of a thread must not be used concurrently
+		// The jobs aren't bound to a worker, idle workers steal them so a slow worker doesn't stall the whole frame
+		vks::JobHandle recordJob = threadPool.jobSystem->parallelFor(0, numThreads, 1, [this, &inheritanceInfo](uint32_t first, uint32_t last)
 		{
-			for (uint32_t i = 0; i < numObjectsPerThread; i++)
+			for (uint32_t t = first; t < last; t++)
 			{
-				threadPool.threads[t]->addJob([=] { threadRenderCode(t, i, inheritanceInfo); });
+				for (uint32_t i = 0; i < numObjectsPerThread; i++)
+				{
+					threadRenderCode(t, i, inheritanceInfo);
+				}
 			}
-		}
-			
-		threadPool.wait();
+		});
+		threadPool.jobSystem->wait(recordJob);
 
 		// Only submit if object is within the current view frustum
 		for (uint32_t t = 0; t < numThreads; t++)
@@ -405,7 +408,7 @@ public:
 			{
 				if (threadData[t].objectData[i].visible)
 				{
-					commandBuffers.push_back(threadData[t].commandBuffer[i]);
+					commandBuffers.push_back(threadData[t].commandBuffer[currentFrame * numObjectsPerThread + i]);
 				}
 			}
 		}
@@ -422,7 +425,11 @@ public:
 	{
 		models.ufo.loadFromFile(getAssetPath() + "models/retroufo_red_lowpoly.dae", vertexLayout, 0.12f, vulkanDevice, queue);
 		models.skysphere.loadFromFile(getAssetPath() + "models/sphere.obj", vertexLayout, 1.0f, vulkanDevice, queue);
-		objectSphereDim = std::max(std::max(models.ufo.dim.size.x, models.ufo.dim.size.y), models.ufo.dim.size.z);
+		objectSphereRadius = 0.0f;
+		for (auto &partBounds : models.ufo.bounds)
+		{
+			objectSphereRadius = std::max(objectSphereRadius, glm::length(glm::vec3(partBounds.sphere)) + partBounds.sphere.w);
+		}
 	}
 
 	void setupVertexDescriptions()
@@ -582,23 +589,15 @@ public:
 
 	void draw()
 	{
+		// Waits for the fence of the current frame in flight, so it's command buffers can be safely rerecorded
 		VulkanExampleBase::prepareFrame();
 
 		updateCommandBuffers(frameBuffers[currentBuffer]);
 
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &primaryCommandBuffer;
+		submitInfo.pCommandBuffers = &frameObjects[currentFrame].commandBuffer;
 
-		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, renderFence));
-
-		// Wait for fence to signal that all command buffers are ready
-		VkResult fenceRes;
-		do
-		{
-			fenceRes = vkWaitForFences(device, 1, &renderFence, VK_TRUE, 100000000);
-		} while (fenceRes == VK_TIMEOUT);
-		VK_CHECK_RESULT(fenceRes);
-		vkResetFences(device, 1, &renderFence);
+		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
 
 		VulkanExampleBase::submitFrame();
 	}
@@ -606,9 +605,6 @@ public:
 	void prepare()
 	{
 		VulkanExampleBase::prepare();
-		// Create a fence for synchronization
-		VkFenceCreateInfo fenceCreateInfo = vks::initializers::fenceCreateInfo(VK_FLAGS_NONE);
-		vkCreateFence(device, &fenceCreateInfo, NULL, &renderFence);
 		loadMeshes();
 		setupVertexDescriptions();
 		setupPipelineLayout();
@@ -81,7 +81,7 @@ public:
 
 	struct {
 		VkBuffer buffer;
-		VkDeviceMemory memory;
+		vks::Allocation allocation;
 		// Store the mapped address of the particle data for reuse
 		void *mappedMemory;
 		// Size of the particle buffer in bytes
@@ -150,9 +150,8 @@ public:
 		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 
-		vkUnmapMemory(device, particles.memory);
 		vkDestroyBuffer(device, particles.buffer, nullptr);
-		vkFreeMemory(device, particles.memory, nullptr);
+		particles.allocation.free();
 
 		uniformBuffers.environment.destroy();
 		uniformBuffers.fire.destroy();
@@ -201,7 +200,7 @@ public:
 			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets.environment, 0, NULL);
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.environment);
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &models.environment.vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.environment.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.environment.indices.buffer, 0, models.environment.indexType);
 			vkCmdDrawIndexed(drawCmdBuffers[i], models.environment.indexCount, 1, 0, 0, 0);
 
 			// Particle system (no index buffer)
@@ -288,11 +287,11 @@ public:
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 			particles.size,
 			&particles.buffer,
-			&particles.memory,
+			&particles.allocation,
 			particleBuffer.data()));
 
-		// Map the memory and store the pointer for reuse
-		VK_CHECK_RESULT(vkMapMemory(device, particles.memory, 0, particles.size, 0, &particles.mappedMemory));
+		// Host visible allocations stay mapped, store the pointer for reuse
+		particles.mappedMemory = particles.allocation.mapped;
 	}
 
 	void updateParticles()
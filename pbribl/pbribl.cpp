@@ -4,6 +4,8 @@
 * Copyright (C) 2017 by Sascha Willems - www.saschawillems.de
 *
 * This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*
+* The models and cube maps are streamed in the background, rendering starts with a placeholder environment right away
 */
 
 #include <stdio.h>
@@ -24,6 +26,8 @@
 #include "VulkanBuffer.hpp"
 #include "VulkanTexture.hpp"
 #include "VulkanModel.hpp"
+#include "VulkanAssetLoader.hpp"
+#include "VulkanAssetStreamer.hpp"
 
 #define VERTEX_BUFFER_BIND_ID 0
 #define ENABLE_VALIDATION false
@@ -45,6 +49,11 @@ class VulkanExample : public VulkanExampleBase
 public:
 	bool displaySkybox = true;
 
+	// Stream the assets in the background and start rendering with placeholders right away
+	// Disabled for benchmarks, so the measured frames always show the full scene
+	bool streamAssets = true;
+	vks::AssetStreamer streamer;
+
 	struct Textures {
 		vks::TextureCubeMap radianceMap;
 		vks::TextureCubeMap irradianceMap;
@@ -128,6 +137,9 @@ public:
 
 	~VulkanExample()
 	{
+		// Hands over all assets that are still in flight, so they're destroyed below
+		streamer.destroy();
+
 		vkDestroyPipeline(device, pipelines.skybox, nullptr);
 		vkDestroyPipeline(device, pipelines.pbr, nullptr);
 
@@ -191,19 +203,26 @@ public:
 			VkDeviceSize offsets[1] = { 0 };
 
 			// Skybox
-			if (displaySkybox)
+			// Streamed models that haven't arrived yet are skipped
+			if (displaySkybox && (models.skybox.indexCount > 0))
 			{
 				vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets.skybox, 0, NULL);
 				vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &models.skybox.vertices.buffer, offsets);
-				vkCmdBindIndexBuffer(drawCmdBuffers[i], models.skybox.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+				vkCmdBindIndexBuffer(drawCmdBuffers[i], models.skybox.indices.buffer, 0, models.skybox.indexType);
 				vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.skybox);
 				vkCmdDrawIndexed(drawCmdBuffers[i], models.skybox.indexCount, 1, 0, 0, 0);
 			}
 
 			// Objects
+			if (models.objects[models.objectIndex].indexCount == 0)
+			{
+				vkCmdEndRenderPass(drawCmdBuffers[i]);
+				VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
+				continue;
+			}
 			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets.object, 0, NULL);
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &models.objects[models.objectIndex].vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.objects[models.objectIndex].indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.objects[models.objectIndex].indices.buffer, 0, models.objects[models.objectIndex].indexType);
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.pbr);
 
 			Material mat = materials[materialIndex];
@@ -241,19 +260,67 @@ public:
 
 	void loadAssets()
 	{
-		// Skybox
-		models.skybox.loadFromFile(getAssetPath() + "models/cube.obj", vertexLayout, 1.0f, vulkanDevice, queue);
-		// Objects
 		std::vector<std::string> filenames = { "geosphere.obj", "teapot.dae", "torusknot.obj", "venus.fbx" };
-		for (auto file : filenames) {
-			vks::Model model;
-			model.loadFromFile(getAssetPath() + "models/" + file, vertexLayout, OBJ_DIM * (file == "venus.fbx" ? 3.0f : 1.0f), vulkanDevice, queue);
-			models.objects.push_back(model);
+		// Every load writes to its own element, so the vector is sized up front
+		models.objects.resize(filenames.size());
+
+		streamAssets = streamAssets && !benchmark.active;
+		if (streamAssets)
+		{
+			startStreaming(filenames);
+			return;
 		}
+
+		// All assets are loaded in parallel on the thread pool, the largest ones are added first
+		vks::AssetLoader assets;
 		// Radiance and irradiance cube maps for image-based-lighting
 		// HDR images from http://www.hdrlabs.com/sibl/archive.html, converted to radiance and irradiance maps with https://github.com/dariomanesku/cmft
-		textures.radianceMap.loadFromFile(getAssetPath() + "textures/hamarikyu_bridge_radiance_cube.ktx", VK_FORMAT_R16G16B16A16_SFLOAT, vulkanDevice, queue);
-		textures.irradianceMap.loadFromFile(getAssetPath() + "textures/hamarikyu_bridge_irradiance_cube.ktx", VK_FORMAT_R16G16B16A16_SFLOAT, vulkanDevice, queue);
+		assets.add([this] { textures.radianceMap.loadFromFile(getAssetPath() + "textures/hamarikyu_bridge_radiance_cube.ktx", VK_FORMAT_R16G16B16A16_SFLOAT, vulkanDevice, queue); });
+		assets.add([this] { textures.irradianceMap.loadFromFile(getAssetPath() + "textures/hamarikyu_bridge_irradiance_cube.ktx", VK_FORMAT_R16G16B16A16_SFLOAT, vulkanDevice, queue); });
+		// Objects
+		for (size_t i = 0; i < filenames.size(); i++) {
+			std::string file = filenames[i];
+			vks::Model *model = &models.objects[i];
+			assets.add([this, file, model] {
+				model->optimize = true;
+				model->loadFromFile(getAssetPath() + "models/" + file, vertexLayout, OBJ_DIM * (file == "venus.fbx" ? 3.0f : 1.0f), vulkanDevice, queue);
+			});
+		}
+		// Skybox
+		assets.add([this] { models.skybox.loadFromFile(getAssetPath() + "models/cube.obj", vertexLayout, 1.0f, vulkanDevice, queue); });
+		assets.load(getThreadPool());
+	}
+
+	// Starts loading all assets in the background
+	// Until they have arrived the cube maps are replaced by a placeholder and the models aren't drawn
+	void startStreaming(const std::vector<std::string> &filenames)
+	{
+		streamer.create(vulkanDevice, queue, getThreadPool());
+		textures.radianceMap = streamer.placeholderCube;
+		textures.irradianceMap = streamer.placeholderCube;
+
+		// Every load writes to an object of its own that is moved into place on the render thread
+		// The cube maps arrive progressively, their small mip levels first, and are copied into place whenever more detailed levels have become visible
+		std::shared_ptr<vks::TextureCubeMap> radianceMap(new vks::TextureCubeMap);
+		streamer.addTexture(radianceMap, getAssetPath() + "textures/hamarikyu_bridge_radiance_cube.ktx", VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_VIEW_TYPE_CUBE,
+			[this, radianceMap] { textures.radianceMap = *radianceMap; });
+		std::shared_ptr<vks::TextureCubeMap> irradianceMap(new vks::TextureCubeMap);
+		streamer.addTexture(irradianceMap, getAssetPath() + "textures/hamarikyu_bridge_irradiance_cube.ktx", VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_VIEW_TYPE_CUBE,
+			[this, irradianceMap] { textures.irradianceMap = *irradianceMap; });
+		for (size_t i = 0; i < filenames.size(); i++) {
+			std::string file = filenames[i];
+			std::shared_ptr<vks::Model> model(new vks::Model);
+			streamer.add(
+				[this, file, model] {
+					model->optimize = true;
+					model->loadFromFile(getAssetPath() + "models/" + file, vertexLayout, OBJ_DIM * (file == "venus.fbx" ? 3.0f : 1.0f), vulkanDevice, queue);
+				},
+				[this, i, model] { models.objects[i] = *model; });
+		}
+		std::shared_ptr<vks::Model> skybox(new vks::Model);
+		streamer.add(
+			[this, skybox] { skybox->loadFromFile(getAssetPath() + "models/cube.obj", vertexLayout, 1.0f, vulkanDevice, queue); },
+			[this, skybox] { models.skybox = *skybox; });
 	}
 
 	void setupDescriptorSetLayout()
@@ -304,7 +371,15 @@ public:
 
 		// 3D object descriptor set
 		VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSets.object));
+		// Sky box descriptor set
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSets.skybox));
 
+		updateDescriptorSets();
+	}
+
+	// Also called when streamed textures have arrived
+	void updateDescriptorSets()
+	{
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
 			vks::initializers::writeDescriptorSet(descriptorSets.object, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &uniformBuffers.object.descriptor),
 			vks::initializers::writeDescriptorSet(descriptorSets.object, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &uniformBuffers.params.descriptor),
@@ -313,9 +388,6 @@ public:
 		};
 		vkUpdateDescriptorSets(device, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, NULL);
 
-		// Sky box descriptor set
-		VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSets.skybox));
-
 		writeDescriptorSets = {
 			vks::initializers::writeDescriptorSet(descriptorSets.skybox, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &uniformBuffers.skybox.descriptor),
 			vks::initializers::writeDescriptorSet(descriptorSets.skybox, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &uniformBuffers.params.descriptor),
@@ -460,11 +532,23 @@ public:
 
 	void draw()
 	{
+		// Streamed assets are moved into place between frames
+		if (streamer.update())
+		{
+			updateDescriptorSets();
+			buildCommandBuffers();
+			updateTextOverlay();
+		}
+
 		VulkanExampleBase::prepareFrame();
 
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
-		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
+		{
+			// Streaming loads may submit uploads to the same queue
+			std::lock_guard<std::mutex> lock(vulkanDevice->queueMutex);
+			VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
+		}
 
 		VulkanExampleBase::submitFrame();
 	}
@@ -572,6 +656,9 @@ public:
 #else
 		textOverlay->addText("Base material: " + materials[materialIndex].name + " (+/-)", 5.0f, 85.0f, VulkanTextOverlay::alignLeft);
 		textOverlay->addText("Exposure = " + std::to_string(uboParams.exposure) + " (F3/F4)", 5.0f, 100.0f, VulkanTextOverlay::alignLeft);
+		if (!streamer.finished()) {
+			textOverlay->addText("Streaming assets: " + std::to_string(streamer.appliedCount) + " of " + std::to_string(streamer.requestCount), 5.0f, 115.0f, VulkanTextOverlay::alignLeft);
+		}
 		//textOverlay->addText("\"F2\" to toggle skybox", 5.0f, 85.0f, VulkanTextOverlay::alignLeft);
 		//textOverlay->addText("\"space\" to toggle object", 5.0f, 100.0f, VulkanTextOverlay::alignLeft);
 #endif
@@ -40,7 +40,8 @@ public:
 		vks::Model cube;
 	} models;
 
-	vks::Buffer uniformBuffer;
+	// One uniform buffer per frame in flight, selected with currentFrame
+	std::vector<vks::Buffer> uniformBuffers;
 
 	// Same uniform buffer layout as shader
 	struct UBOVS {
@@ -50,7 +51,7 @@ public:
 	} uboVS;
 
 	VkPipelineLayout pipelineLayout;
-	VkDescriptorSet descriptorSet;
+	std::vector<VkDescriptorSet> descriptorSets;
 	VkDescriptorSetLayout descriptorSetLayout;
 
 	struct {
@@ -65,6 +66,8 @@ public:
 		rotation = glm::vec3(-25.0f, 15.0f, 0.0f);
 		enableTextOverlay = true;
 		title = "Vulkan Example - Pipeline state objects";
+		// Let the host prepare the next frame while the GPU renders the current one
+		maxFramesInFlight = 2;
 	}
 
 	~VulkanExample()
@@ -82,7 +85,10 @@ public:
 		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 
 		models.cube.destroy();
-		uniformBuffer.destroy();
+		for (auto& uniformBuffer : uniformBuffers)
+		{
+			uniformBuffer.destroy();
+		}
 	}
 
 	// Enable physical device features required for this example				
@@ -98,8 +104,12 @@ public:
 		};
 	}
 
-	void buildCommandBuffers()
-	{		 
+	// Record the command buffer of the current frame in flight
+	// Recorded every frame so it binds the descriptor set (and uniform buffer) of that frame
+	void buildCommandBuffer()
+	{
+		VkCommandBuffer cmdBuffer = frameObjects[currentFrame].commandBuffer;
+
 		VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
 
 		VkClearValue clearValues[2];
@@ -115,57 +125,54 @@ public:
 		renderPassBeginInfo.clearValueCount = 2;
 		renderPassBeginInfo.pClearValues = clearValues;
 
-		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i)
-		{
-			// Set target frame buffer
-			renderPassBeginInfo.framebuffer = frameBuffers[i];
-
-			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+		// Set target frame buffer
+		renderPassBeginInfo.framebuffer = frameBuffers[currentBuffer];
 
-			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo));
 
-			VkViewport viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
-			vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
+		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-			VkRect2D scissor = vks::initializers::rect2D(width, height,	0, 0);
-			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
+		VkViewport viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
+		vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
 
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
+		VkRect2D scissor = vks::initializers::rect2D(width, height,	0, 0);
+		vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
 
-			VkDeviceSize offsets[1] = { 0 };
-			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &models.cube.vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.cube.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentFrame], 0, NULL);
 
-			// Left : Solid colored 
-			viewport.width = (float)width / 3.0;
-			vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
-			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.phong);
-			
-			vkCmdDrawIndexed(drawCmdBuffers[i], models.cube.indexCount, 1, 0, 0, 0);
+		VkDeviceSize offsets[1] = { 0 };
+		vkCmdBindVertexBuffers(cmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &models.cube.vertices.buffer, offsets);
+		vkCmdBindIndexBuffer(cmdBuffer, models.cube.indices.buffer, 0, models.cube.indexType);
 
-			// Center : Toon
-			viewport.x = (float)width / 3.0;
-			vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
-			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.toon);
-			// Line width > 1.0f only if wide lines feature is supported
-			if (deviceFeatures.wideLines) {
-				vkCmdSetLineWidth(drawCmdBuffers[i], 2.0f);
-			}
-			vkCmdDrawIndexed(drawCmdBuffers[i], models.cube.indexCount, 1, 0, 0, 0);
+		// Left : Solid colored 
+		viewport.width = (float)width / 3.0;
+		vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.phong);
+		
+		vkCmdDrawIndexed(cmdBuffer, models.cube.indexCount, 1, 0, 0, 0);
+
+		// Center : Toon
+		viewport.x = (float)width / 3.0;
+		vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.toon);
+		// Line width > 1.0f only if wide lines feature is supported
+		if (deviceFeatures.wideLines) {
+			vkCmdSetLineWidth(cmdBuffer, 2.0f);
+		}
+		vkCmdDrawIndexed(cmdBuffer, models.cube.indexCount, 1, 0, 0, 0);
 
-			if (deviceFeatures.fillModeNonSolid)
-			{
-				// Right : Wireframe 
-				viewport.x = (float)width / 3.0 + (float)width / 3.0;
-				vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
-				vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.wireframe);
-				vkCmdDrawIndexed(drawCmdBuffers[i], models.cube.indexCount, 1, 0, 0, 0);
-			}
+		if (deviceFeatures.fillModeNonSolid)
+		{
+			// Right : Wireframe 
+			viewport.x = (float)width / 3.0 + (float)width / 3.0;
+			vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+			vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.wireframe);
+			vkCmdDrawIndexed(cmdBuffer, models.cube.indexCount, 1, 0, 0, 0);
+		}
 
-			vkCmdEndRenderPass(drawCmdBuffers[i]);
+		vkCmdEndRenderPass(cmdBuffer);
 
-			VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
-		}
+		VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
 	}
 
 	void loadAssets()
@@ -177,14 +184,14 @@ public:
 	{
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1)
+			vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, maxFramesInFlight)
 		};
 
 		VkDescriptorPoolCreateInfo descriptorPoolInfo =
 			vks::initializers::descriptorPoolCreateInfo(
 				poolSizes.size(),
 				poolSizes.data(),
-				2);
+				maxFramesInFlight);
 
 		VK_CHECK_RESULT(vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &descriptorPool));
 	}
@@ -217,25 +224,30 @@ public:
 
 	void setupDescriptorSet()
 	{
-		VkDescriptorSetAllocateInfo allocInfo =
-			vks::initializers::descriptorSetAllocateInfo(
-				descriptorPool,
-				&descriptorSetLayout,
-				1);
-
-		VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet));
-
-		std::vector<VkWriteDescriptorSet> writeDescriptorSets =
+		// Each frame in flight gets its own descriptor set pointing to its uniform buffer
+		descriptorSets.resize(maxFramesInFlight);
+		for (uint32_t i = 0; i < maxFramesInFlight; i++)
 		{
-			// Binding 0 : Vertex shader uniform buffer
-			vks::initializers::writeDescriptorSet(
-				descriptorSet,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-				0,
-				&uniformBuffer.descriptor)
-		};
+			VkDescriptorSetAllocateInfo allocInfo =
+				vks::initializers::descriptorSetAllocateInfo(
+					descriptorPool,
+					&descriptorSetLayout,
+					1);
+
+			VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSets[i]));
 
-		vkUpdateDescriptorSets(device, writeDescriptorSets.size(), writeDescriptorSets.data(), 0, NULL);
+			std::vector<VkWriteDescriptorSet> writeDescriptorSets =
+			{
+				// Binding 0 : Vertex shader uniform buffer
+				vks::initializers::writeDescriptorSet(
+					descriptorSets[i],
+					VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+					0,
+					&uniformBuffers[i].descriptor)
+			};
+
+			vkUpdateDescriptorSets(device, writeDescriptorSets.size(), writeDescriptorSets.data(), 0, NULL);
+		}
 	}
 
 	void preparePipelines()
@@ -359,22 +371,16 @@ public:
 		}
 	}
 
-	// Prepare and initialize uniform buffer containing shader uniforms
+	// Prepare and initialize uniform buffers containing shader uniforms
 	void prepareUniformBuffers()
 	{
-		// Create the vertex shader uniform buffer block
-		VK_CHECK_RESULT(vulkanDevice->createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			&uniformBuffer,
-			sizeof(uboVS)));
-
-		// Map persistent
-		VK_CHECK_RESULT(uniformBuffer.map());
+		// Create the vertex shader uniform buffer blocks (persistently mapped), one for each frame in flight
+		createFrameUniformBuffers(uniformBuffers, sizeof(uboVS));
 
 		updateUniformBuffers();
 	}
 
+	// The uniform data is copied to the current frame's uniform buffer in draw()
 	void updateUniformBuffers()
 	{
 		uboVS.projection = glm::perspective(glm::radians(60.0f), (float)(width / 3.0f) / (float)height, 0.1f, 256.0f);
@@ -385,16 +391,18 @@ public:
 		uboVS.modelView = glm::rotate(uboVS.modelView, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
 		uboVS.modelView = glm::rotate(uboVS.modelView, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
 		uboVS.modelView = glm::rotate(uboVS.modelView, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-
-		memcpy(uniformBuffer.mapped, &uboVS, sizeof(uboVS));
 	}
 
 	void draw()
 	{
+		// Waits for the fence of the current frame in flight, so its uniform buffer and command buffer can be updated
 		VulkanExampleBase::prepareFrame();
 
+		memcpy(uniformBuffers[currentFrame].mapped, &uboVS, sizeof(uboVS));
+		buildCommandBuffer();
+
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
+		submitInfo.pCommandBuffers = &frameObjects[currentFrame].commandBuffer;
 		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
 
 		VulkanExampleBase::submitFrame();
@@ -409,7 +417,6 @@ public:
 		preparePipelines();
 		setupDescriptorPool();
 		setupDescriptorSet();
-		buildCommandBuffers();
 		prepared = true;
 	}
 
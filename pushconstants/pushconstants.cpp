@@ -35,11 +35,12 @@ public:
 	} vertices;
 
 	// Vertex layout for the models
+	// Positions, texture coordinates and colors are quantized (28 instead of 44 bytes per vertex), the vertex input converts them back to floats
 	vks::VertexLayout vertexLayout = vks::VertexLayout({
-		vks::VERTEX_COMPONENT_POSITION,
+		vks::VERTEX_COMPONENT_POSITION_HALF,
 		vks::VERTEX_COMPONENT_NORMAL,
-		vks::VERTEX_COMPONENT_UV,
-		vks::VERTEX_COMPONENT_COLOR,
+		vks::VERTEX_COMPONENT_UV_UNORM16,
+		vks::VERTEX_COMPONENT_COLOR_UNORM8,
 	});
 
 	struct {
@@ -164,7 +165,7 @@ public:
 
 			VkDeviceSize offsets[1] = { 0 };
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &models.scene.vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.scene.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.scene.indices.buffer, 0, models.scene.indexType);
 
 			vkCmdDrawIndexed(drawCmdBuffers[i], models.scene.indexCount, 1, 0, 0, 0);
 
@@ -176,6 +177,7 @@ public:
 
 	void loadAssets()
 	{
+		models.scene.optimize = true;
 		models.scene.loadFromFile(getAssetPath() + "models/samplescene.dae", vertexLayout, 0.35f, vulkanDevice, queue);
 	}
 
@@ -191,35 +193,17 @@ public:
 
 		// Attribute descriptions
 		// Describes memory layout and shader positions
+		// Formats and offsets are taken from the vertex layout
 		vertices.attributeDescriptions.resize(4);
-		// Location 0 : Position
-		vertices.attributeDescriptions[0] =
-			vks::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				0,
-				VK_FORMAT_R32G32B32_SFLOAT,
-				0);
-		// Location 1 : Normal
-		vertices.attributeDescriptions[1] =
-			vks::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				1,
-				VK_FORMAT_R32G32B32_SFLOAT,
-				sizeof(float) * 3);
-		// Location 2 : Texture coordinates
-		vertices.attributeDescriptions[2] =
-			vks::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				2,
-				VK_FORMAT_R32G32_SFLOAT,
-				sizeof(float) * 6);
-		// Location 3 : Color
-		vertices.attributeDescriptions[3] =
-			vks::initializers::vertexInputAttributeDescription(
-				VERTEX_BUFFER_BIND_ID,
-				3,
-				VK_FORMAT_R32G32B32_SFLOAT,
-				sizeof(float) * 8);
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			vertices.attributeDescriptions[i] =
+				vks::initializers::vertexInputAttributeDescription(
+					VERTEX_BUFFER_BIND_ID,
+					i,
+					vertexLayout.format(i),
+					vertexLayout.offset(i));
+		}
 
 		vertices.inputState = vks::initializers::pipelineVertexInputStateCreateInfo();
 		vertices.inputState.vertexBindingDescriptionCount = vertices.bindingDescriptions.size();
@@ -11,6 +11,12 @@
 * The example loads a scene made up of multiple parts into one vertex and index buffer to only
 * have one (big) memory allocation. In Vulkan it's advised to keep number of memory allocations
 * down and try to allocate large blocks of memory at once instead of having many small allocations.
+* Indices are stored relative to the first vertex of each part, so 16 bit indices are used for all parts.
+* Meshes with more than 64K vertices are split into multiple parts.
+*
+* Each part stores a bounding box and sphere, parts outside of the view frustum are not drawn.
+*
+* The meshes and the material textures are loaded in parallel on the workers of the example's thread pool.
 *
 * Every part has a separate material and multiple descriptor sets (set = x layout qualifier in GLSL)
 * are used to bind a uniform buffer with global matrices and the part's material's sampler at once.
@@ -43,6 +49,11 @@
 #include "VulkanTexture.hpp"
 #include "VulkanDevice.hpp"
 #include "VulkanBuffer.hpp"
+#include "VulkanAssetLoader.hpp"
+#include "VulkanTextureCooker.hpp"
+#include "VulkanIndexBuffer.hpp"
+#include "VulkanBounds.hpp"
+#include "frustum.hpp"
 
 #define VERTEX_BUFFER_BIND_ID 0
 #define ENABLE_VALIDATION false
@@ -84,10 +95,18 @@ struct SceneMaterial
 // Stores per-mesh Vulkan resources
 struct ScenePart
 {
+	// Index of first vertex in the scene buffer, indices are relative to this
+	uint32_t vertexBase;
 	// Index of first index in the scene buffer
 	uint32_t indexBase;
 	uint32_t indexCount;
 
+	// Bounding box and sphere of the part's vertices, used for frustum culling
+	vks::bounds::Bounds bounds;
+
+	// Index of the source mesh this part belongs to, meshes split into several index ranges share it
+	uint32_t sourceMesh;
+
 	// Pointer to the material used by this mesh
 	SceneMaterial *material;
 };
@@ -99,10 +118,14 @@ private:
 	vks::VulkanDevice *vulkanDevice;
 	VkQueue queue;
 
-	VkDescriptorPool descriptorPool;
+	// Pools grow with the number of materials, so there is no need to count descriptors up front
+	vks::DescriptorAllocator descriptorAllocator;
+	// Updates the material descriptor sets straight from the materials' texture descriptors
+	vks::DescriptorUpdateTemplate materialUpdateTemplate;
 
 	// We will be using separate descriptor sets (and bindings)
 	// for material and scene related uniforms
+	// Layouts are owned by the device's layout cache
 	struct
 	{
 		VkDescriptorSetLayout material;
@@ -117,10 +140,23 @@ private:
 
 	VkDescriptorSet descriptorSetScene;
 
+	// View frustum in model space for culling the parts
+	vks::Frustum frustum;
+
 	const aiScene* aScene;
 
+	// Load an uncompressed texture through a compressed copy cooked for the device (falls back to the uncompressed texture)
+	void loadCookedTexture(vks::Texture2D *texture, const std::string &filename, vks::JobSystem *jobSystem)
+	{
+		std::string loadFilename;
+		VkFormat format = vks::texturecooker::cookForDevice(vulkanDevice, jobSystem, filename, true, loadFilename);
+		texture->loadFromFile(loadFilename, format, vulkanDevice, queue);
+	}
+
 	// Get materials from the assimp scene and map to our scene structures
-	void loadMaterials()
+	// The material textures are added to the asset loader and loaded in parallel, textures without a
+	// pre-compressed variant for the device are block compressed on the job system
+	void loadMaterials(vks::AssetLoader &assets, vks::JobSystem *jobSystem)
 	{
 		materials.resize(aScene->mNumMaterials);
 
@@ -149,7 +185,7 @@ private:
 
 			// Textures
 			std::string texFormatSuffix;
-			VkFormat texFormat;
+			VkFormat texFormat = VK_FORMAT_UNDEFINED;
 			// Get supported compressed texture format
 			if (vulkanDevice->features.textureCompressionBC) {
 				texFormatSuffix = "_bc3_unorm";
@@ -163,9 +199,6 @@ private:
 				texFormatSuffix = "_etc2_unorm";
 				texFormat = VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
 			}
-			else {
-				vks::tools::exitFatal("Device does not support any compressed texture format!", "Error");
-			}
 
 			aiString texturefile;
 			// Diffuse
@@ -175,14 +208,29 @@ private:
 				std::cout << "  Diffuse: \"" << texturefile.C_Str() << "\"" << std::endl;
 				std::string fileName = std::string(texturefile.C_Str());
 				std::replace(fileName.begin(), fileName.end(), '\\', '/');
-				fileName.insert(fileName.find(".ktx"), texFormatSuffix);
-				materials[i].diffuse.loadFromFile(assetPath + fileName, texFormat, vulkanDevice, queue);
+				std::string variantFileName = fileName;
+				variantFileName.insert(variantFileName.find(".ktx"), texFormatSuffix);
+				vks::Texture2D *texture = &materials[i].diffuse;
+				if ((texFormat != VK_FORMAT_UNDEFINED) && vks::texturecooker::fileExists(assetPath + variantFileName))
+				{
+					assets.add([=] { texture->loadFromFile(assetPath + variantFileName, texFormat, vulkanDevice, queue); });
+				}
+				else if (vks::texturecooker::fileExists(assetPath + fileName))
+				{
+					// No pre-compressed variant for this device, cook one from the uncompressed texture
+					assets.add([=] { loadCookedTexture(texture, assetPath + fileName, jobSystem); });
+				}
+				else
+				{
+					vks::tools::exitFatal("Device does not support any compressed texture format of \"" + fileName + "\" and there is no uncompressed source to cook from!", "Error");
+				}
 			}
 			else
 			{
 				std::cout << "  Material has no diffuse, using dummy texture!" << std::endl;
 				// todo : separate pipeline and layout
-				materials[i].diffuse.loadFromFile(assetPath + "dummy_rgba_unorm.ktx", VK_FORMAT_R8G8B8A8_UNORM, vulkanDevice, queue);
+				vks::Texture2D *texture = &materials[i].diffuse;
+				assets.add([=] { loadCookedTexture(texture, assetPath + "dummy_rgba_unorm.ktx", jobSystem); });
 			}
 
 			// For scenes with multiple textures per material we would need to check for additional texture types, e.g.:
@@ -191,35 +239,22 @@ private:
 			// Assign pipeline
 			materials[i].pipeline = (materials[i].properties.opacity == 0.0f) ? &pipelines.solid : &pipelines.blending;
 		}
+	}
 
-		// Generate descriptor sets for the materials
-
-		// Descriptor pool
-		std::vector<VkDescriptorPoolSize> poolSizes;
-		poolSizes.push_back(vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, static_cast<uint32_t>(materials.size())));
-		poolSizes.push_back(vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, static_cast<uint32_t>(materials.size())));
-
-		VkDescriptorPoolCreateInfo descriptorPoolInfo =
-			vks::initializers::descriptorPoolCreateInfo(
-				static_cast<uint32_t>(poolSizes.size()),
-				poolSizes.data(),
-				static_cast<uint32_t>(materials.size()) + 1);
-
-		VK_CHECK_RESULT(vkCreateDescriptorPool(vulkanDevice->logicalDevice, &descriptorPoolInfo, nullptr, &descriptorPool));
+	// Generate descriptor sets for the materials, the textures must have been loaded
+	void setupMaterialDescriptors()
+	{
+		descriptorAllocator.create(vulkanDevice->logicalDevice);
 
 		// Descriptor set and pipeline layouts
 		std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings;
-		VkDescriptorSetLayoutCreateInfo descriptorLayout;
 
 		// Set 0: Scene matrices
 		setLayoutBindings.push_back(vks::initializers::descriptorSetLayoutBinding(
 			VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
 			VK_SHADER_STAGE_VERTEX_BIT,
 			0));
-		descriptorLayout = vks::initializers::descriptorSetLayoutCreateInfo(
-				setLayoutBindings.data(),
-				static_cast<uint32_t>(setLayoutBindings.size()));
-		VK_CHECK_RESULT(vkCreateDescriptorSetLayout(vulkanDevice->logicalDevice, &descriptorLayout, nullptr, &descriptorSetLayouts.scene));
+		VK_CHECK_RESULT(vulkanDevice->descriptorLayoutCache.get(setLayoutBindings, &descriptorSetLayouts.scene));
 
 		// Set 1: Material data
 		setLayoutBindings.clear();
@@ -227,7 +262,7 @@ private:
 			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 			VK_SHADER_STAGE_FRAGMENT_BIT,
 			0));
-		VK_CHECK_RESULT(vkCreateDescriptorSetLayout(vulkanDevice->logicalDevice, &descriptorLayout, nullptr, &descriptorSetLayouts.material));
+		VK_CHECK_RESULT(vulkanDevice->descriptorLayoutCache.get(setLayoutBindings, &descriptorSetLayouts.material));
 
 		// Setup pipeline layout
 		std::array<VkDescriptorSetLayout, 2> setLayouts = { descriptorSetLayouts.scene, descriptorSetLayouts.material };
@@ -243,39 +278,21 @@ private:
 
 		VK_CHECK_RESULT(vkCreatePipelineLayout(vulkanDevice->logicalDevice, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout));
 
+		// Binding 0: Diffuse texture, the template reads the descriptor of the material's texture
+		std::vector<VkDescriptorUpdateTemplateEntryKHR> templateEntries = {
+			vks::initializers::descriptorUpdateTemplateEntry(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0, 0)
+		};
+		VK_CHECK_RESULT(materialUpdateTemplate.create(vulkanDevice->logicalDevice, vulkanDevice->enableDescriptorUpdateTemplates, descriptorSetLayouts.material, templateEntries));
+
 		// Material descriptor sets
 		for (size_t i = 0; i < materials.size(); i++)
 		{
-			// Descriptor set
-			VkDescriptorSetAllocateInfo allocInfo =
-				vks::initializers::descriptorSetAllocateInfo(
-					descriptorPool,
-					&descriptorSetLayouts.material,
-					1);
-
-			VK_CHECK_RESULT(vkAllocateDescriptorSets(vulkanDevice->logicalDevice, &allocInfo, &materials[i].descriptorSet));
-
-			std::vector<VkWriteDescriptorSet> writeDescriptorSets;
-
-			// todo : only use image sampler descriptor set and use one scene ubo for matrices
-
-			// Binding 0: Diffuse texture
-			writeDescriptorSets.push_back(vks::initializers::writeDescriptorSet(
-				materials[i].descriptorSet,
-				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-				0,
-				&materials[i].diffuse.descriptor));
-
-			vkUpdateDescriptorSets(vulkanDevice->logicalDevice, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, NULL);
+			VK_CHECK_RESULT(descriptorAllocator.allocate(descriptorSetLayouts.material, &materials[i].descriptorSet));
+			materialUpdateTemplate.update(materials[i].descriptorSet, &materials[i].diffuse.descriptor);
 		}
 
 		// Scene descriptor set
-		VkDescriptorSetAllocateInfo allocInfo =
-			vks::initializers::descriptorSetAllocateInfo(
-				descriptorPool,
-				&descriptorSetLayouts.scene,
-				1);
-		VK_CHECK_RESULT(vkAllocateDescriptorSets(vulkanDevice->logicalDevice, &allocInfo, &descriptorSetScene));
+		VK_CHECK_RESULT(descriptorAllocator.allocate(descriptorSetLayouts.scene, &descriptorSetScene));
 
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets;
 		// Binding 0 : Vertex shader uniform buffer
@@ -286,61 +303,104 @@ private:
 			&uniformBuffer.descriptor));
 
 		vkUpdateDescriptorSets(vulkanDevice->logicalDevice, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, NULL);
+
+		vks::DescriptorAllocator::Stats stats = descriptorAllocator.getStats();
+		std::cout << "Allocated " << stats.setCount << " descriptor sets from " << stats.poolCount << " pools (update templates " << (materialUpdateTemplate.usesTemplate() ? "enabled" : "not supported") << ")" << std::endl;
 	}
 
 	// Load all meshes from the scene and generate the buffers for rendering them
-	void loadMeshes(VkCommandBuffer copyCmd)
+	// Runs on a worker of the thread pool, so the copy uses a command buffer from the device's per-thread command pool
+	void loadMeshes()
 	{
 		std::vector<Vertex> vertices;
 		std::vector<uint32_t> indices;
-		uint32_t indexBase = 0;
+		std::vector<Vertex> meshVertices;
+		std::vector<uint32_t> meshIndices;
 
-		meshes.resize(aScene->mNumMeshes);
-		for (uint32_t i = 0; i < meshes.size(); i++)
+		meshes.clear();
+		for (uint32_t i = 0; i < aScene->mNumMeshes; i++)
 		{
 			aiMesh *aMesh = aScene->mMeshes[i];
+			// Empty meshes don't get a part, so their bounds aren't computed from an empty vertex array
+			if (aMesh->mNumVertices == 0)
+			{
+				continue;
+			}
 
 			std::cout << "Mesh \"" << aMesh->mName.C_Str() << "\"" << std::endl;
 			std::cout << "	Material: \"" << materials[aMesh->mMaterialIndex].name << "\"" << std::endl;
 			std::cout << "	Faces: " << aMesh->mNumFaces << std::endl;
 
-			meshes[i].material = &materials[aMesh->mMaterialIndex];
-			meshes[i].indexBase = indexBase;
-			meshes[i].indexCount = aMesh->mNumFaces * 3;
-
 			// Vertices
 			bool hasUV = aMesh->HasTextureCoords(0);
 			bool hasColor = aMesh->HasVertexColors(0);
 			bool hasNormals = aMesh->HasNormals();
 
+			meshVertices.resize(aMesh->mNumVertices);
 			for (uint32_t v = 0; v < aMesh->mNumVertices; v++)
 			{
-				Vertex vertex;
+				Vertex &vertex = meshVertices[v];
 				vertex.pos = glm::make_vec3(&aMesh->mVertices[v].x);
 				vertex.pos.y = -vertex.pos.y;
 				vertex.uv = hasUV ? glm::make_vec2(&aMesh->mTextureCoords[0][v].x) : glm::vec2(0.0f);
 				vertex.normal = hasNormals ? glm::make_vec3(&aMesh->mNormals[v].x) : glm::vec3(0.0f);
 				vertex.normal.y = -vertex.normal.y;
 				vertex.color = hasColor ? glm::make_vec3(&aMesh->mColors[0][v].r) : glm::vec3(1.0f);
-				vertices.push_back(vertex);
 			}
 
 			// Indices
+			meshIndices.clear();
 			for (uint32_t f = 0; f < aMesh->mNumFaces; f++)
 			{
 				for (uint32_t j = 0; j < 3; j++)
 				{
-					indices.push_back(aMesh->mFaces[f].mIndices[j]);
+					meshIndices.push_back(aMesh->mFaces[f].mIndices[j]);
 				}
 			}
 
-			indexBase += aMesh->mNumFaces * 3;
+			ScenePart part;
+			part.material = &materials[aMesh->mMaterialIndex];
+			part.sourceMesh = sourceMeshCount++;
+
+			if (aMesh->mNumVertices <= vks::indexbuffer::maxShortVertexCount)
+			{
+				part.vertexBase = static_cast<uint32_t>(vertices.size());
+				part.indexBase = static_cast<uint32_t>(indices.size());
+				part.indexCount = static_cast<uint32_t>(meshIndices.size());
+				part.bounds = vks::bounds::compute(reinterpret_cast<const uint8_t*>(&meshVertices[0].pos), static_cast<uint32_t>(meshVertices.size()), sizeof(Vertex));
+				vertices.insert(vertices.end(), meshVertices.begin(), meshVertices.end());
+				indices.insert(indices.end(), meshIndices.begin(), meshIndices.end());
+				meshes.push_back(part);
+				continue;
+			}
+
+			// Split meshes that can't be addressed with 16 bit indices into multiple parts with the same material
+			std::vector<uint8_t> rangeVertices;
+			std::vector<uint32_t> rangeIndices;
+			std::vector<vks::indexbuffer::Range> ranges;
+			vks::indexbuffer::split(reinterpret_cast<const uint8_t*>(meshVertices.data()), sizeof(Vertex), meshIndices.data(), static_cast<uint32_t>(meshIndices.size()), rangeVertices, rangeIndices, ranges);
+			std::cout << "	Split into " << ranges.size() << " parts" << std::endl;
+			for (auto &range : ranges)
+			{
+				part.vertexBase = static_cast<uint32_t>(vertices.size()) + range.vertexBase;
+				part.indexBase = static_cast<uint32_t>(indices.size()) + range.indexBase;
+				part.indexCount = range.indexCount;
+				part.bounds = vks::bounds::compute(rangeVertices.data() + range.vertexBase * sizeof(Vertex), range.vertexCount, sizeof(Vertex));
+				meshes.push_back(part);
+			}
+			const Vertex *splitVertices = reinterpret_cast<const Vertex*>(rangeVertices.data());
+			vertices.insert(vertices.end(), splitVertices, splitVertices + rangeVertices.size() / sizeof(Vertex));
+			indices.insert(indices.end(), rangeIndices.begin(), rangeIndices.end());
 		}
 
+		// All indices are relative to the first vertex of their part
+		std::vector<uint8_t> packedIndices;
+		vks::indexbuffer::pack(indices.data(), indices.size(), VK_INDEX_TYPE_UINT16, packedIndices);
+
 		// Create buffers
 		// For better performance we only create one index and vertex buffer to keep number of memory allocations down
 		size_t vertexDataSize = vertices.size() * sizeof(Vertex);
-		size_t indexDataSize = indices.size() * sizeof(uint32_t);
+		size_t indexDataSize = packedIndices.size();
 		
 		vks::Buffer vertexStaging, indexStaging;
 
@@ -365,7 +425,7 @@ private:
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 			&indexStaging,
 			static_cast<uint32_t>(indexDataSize),
-			indices.data()));
+			packedIndices.data()));
 		// Target
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
@@ -374,8 +434,7 @@ private:
 			static_cast<uint32_t>(indexDataSize)));
 
 		// Copy
-		VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
-		VK_CHECK_RESULT(vkBeginCommandBuffer(copyCmd, &cmdBufInfo));
+		VkCommandBuffer copyCmd = vulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
 
 		VkBufferCopy copyRegion = {};
 
@@ -395,17 +454,8 @@ private:
 			1,
 			&copyRegion);
 
-		VK_CHECK_RESULT(vkEndCommandBuffer(copyCmd));
-
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &copyCmd;
-
-		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
-		VK_CHECK_RESULT(vkQueueWaitIdle(queue));
+		vulkanDevice->flushCommandBuffer(copyCmd, queue);
 
-		//todo: fence
 		vertexStaging.destroy();
 		indexStaging.destroy();
 	}
@@ -419,6 +469,8 @@ public:
 
 	std::vector<SceneMaterial> materials;
 	std::vector<ScenePart> meshes;
+	// Number of (non-empty) meshes in the source file, less than the number of parts if meshes have been split
+	uint32_t sourceMeshCount = 0;
 
 	// Shared ubo containing matrices used by all
 	// materials and meshes
@@ -440,9 +492,9 @@ public:
 	// Shared pipeline layout
 	VkPipelineLayout pipelineLayout;
 
-	// For displaying only a single part of the scene
-	bool renderSingleScenePart = false;
-	uint32_t scenePartIndex = 0;
+	// For displaying only a single mesh of the scene, selects the source mesh and draws all of its parts
+	bool renderSingleMesh = false;
+	uint32_t singleMeshIndex = 0;
 
 	// Default constructor
 	Scene(vks::VulkanDevice *vulkanDevice, VkQueue queue)
@@ -451,20 +503,12 @@ public:
 		this->queue = queue;
 
 		// Prepare uniform buffer for global matrices
-		VkMemoryRequirements memReqs;
-		VkMemoryAllocateInfo memAlloc = vks::initializers::memoryAllocateInfo();
-		VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(uniformData));
-		VK_CHECK_RESULT(vkCreateBuffer(vulkanDevice->logicalDevice, &bufferCreateInfo, nullptr, &uniformBuffer.buffer));
-		vkGetBufferMemoryRequirements(vulkanDevice->logicalDevice, uniformBuffer.buffer, &memReqs);
-		memAlloc.allocationSize = memReqs.size;
-		memAlloc.memoryTypeIndex = vulkanDevice->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		VK_CHECK_RESULT(vkAllocateMemory(vulkanDevice->logicalDevice, &memAlloc, nullptr, &uniformBuffer.memory));
-		VK_CHECK_RESULT(vkBindBufferMemory(vulkanDevice->logicalDevice, uniformBuffer.buffer, uniformBuffer.memory, 0));
-		VK_CHECK_RESULT(vkMapMemory(vulkanDevice->logicalDevice, uniformBuffer.memory, 0, sizeof(uniformData), 0, (void **)&uniformBuffer.mapped));
-		uniformBuffer.descriptor.offset = 0;
-		uniformBuffer.descriptor.buffer = uniformBuffer.buffer;
-		uniformBuffer.descriptor.range = sizeof(uniformData);
-		uniformBuffer.device = vulkanDevice->logicalDevice;
+		VK_CHECK_RESULT(vulkanDevice->createBuffer(
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&uniformBuffer,
+			sizeof(uniformData)));
+		VK_CHECK_RESULT(uniformBuffer.map());
 	}
 
 	// Default destructor
@@ -477,16 +521,16 @@ public:
 			material.diffuse.destroy();
 		}
 		vkDestroyPipelineLayout(vulkanDevice->logicalDevice, pipelineLayout, nullptr);
-		vkDestroyDescriptorSetLayout(vulkanDevice->logicalDevice, descriptorSetLayouts.material, nullptr);
-		vkDestroyDescriptorSetLayout(vulkanDevice->logicalDevice, descriptorSetLayouts.scene, nullptr);
-		vkDestroyDescriptorPool(vulkanDevice->logicalDevice, descriptorPool, nullptr);
+		materialUpdateTemplate.destroy();
+		descriptorAllocator.destroy();
 		vkDestroyPipeline(vulkanDevice->logicalDevice, pipelines.solid, nullptr);
 		vkDestroyPipeline(vulkanDevice->logicalDevice, pipelines.blending, nullptr);
 		vkDestroyPipeline(vulkanDevice->logicalDevice, pipelines.wireframe, nullptr);
 		uniformBuffer.destroy();
 	}
 
-	void load(std::string filename, VkCommandBuffer copyCmd)
+	// Loads the meshes and material textures of the scene in parallel on the workers of the thread pool
+	void load(std::string filename, vks::ThreadPool &threadPool)
 	{
 		Assimp::Importer Importer;
 
@@ -507,8 +551,13 @@ public:
 #endif
 		if (aScene)
 		{
-			loadMaterials();
-			loadMeshes(copyCmd);
+			vks::AssetLoader assets;
+			// The scene's geometry is the largest load, so it's started first
+			assets.add([this] { loadMeshes(); });
+			loadMaterials(assets, threadPool.jobSystem.get());
+			assets.load(threadPool);
+			std::cout << "Loaded " << assets.loadedCount << " assets on " << assets.workerCount << " threads in " << assets.loadTime << " ms" << std::endl;
+			setupMaterialDescriptors();
 		}
 		else
 		{
@@ -520,19 +569,42 @@ public:
 
 	}
 
-	// Renders the scene into an active command buffer
-	// In a real world application we would do some visibility culling in here
+	// Parts inside of the view frustum, updated by updateVisibility()
+	std::vector<uint32_t> visibleParts;
+
+	// Cull the parts against the view frustum
+	void updateVisibility(glm::mat4 viewProjection)
+	{
+		visibleParts.clear();
+		if (meshes.empty())
+		{
+			return;
+		}
+		frustum.update(viewProjection * uniformData.model);
+		// The spheres of all parts are tested in one batch, the boxes only for parts that passed
+		std::vector<uint32_t> sphereVisible;
+		frustum.cullSpheres(&meshes[0].bounds.sphere, static_cast<uint32_t>(meshes.size()), sizeof(ScenePart), sphereVisible);
+		for (auto i : sphereVisible)
+		{
+			if (frustum.checkBox(glm::vec3(meshes[i].bounds.min), glm::vec3(meshes[i].bounds.max)))
+			{
+				visibleParts.push_back(i);
+			}
+		}
+	}
+
+	// Renders the visible parts of the scene into an active command buffer
 	void render(VkCommandBuffer cmdBuffer, bool wireframe)
 	{
 		VkDeviceSize offsets[1] = { 0 };
 
 		// Bind scene vertex and index buffers
 		vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &vertexBuffer.buffer, offsets);
-		vkCmdBindIndexBuffer(cmdBuffer, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindIndexBuffer(cmdBuffer, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
 
-		for (size_t i = 0; i < meshes.size(); i++)
+		for (auto i : visibleParts)
 		{
-			if ((renderSingleScenePart) && (i != scenePartIndex))
+			if ((renderSingleMesh) && (meshes[i].sourceMesh != singleMeshIndex))
 				continue;
 
 			// todo : per material pipelines
@@ -561,8 +633,8 @@ public:
 				sizeof(SceneMaterialProperites),
 				&meshes[i].material->properties);
 
-			// Render from the global scene vertex buffer using the mesh index offset
-			vkCmdDrawIndexed(cmdBuffer, meshes[i].indexCount, 1, 0, meshes[i].indexBase, 0);
+			// Render from the global scene vertex and index buffers using the part's index and vertex offsets
+			vkCmdDrawIndexed(cmdBuffer, meshes[i].indexCount, 1, meshes[i].indexBase, meshes[i].vertexBase, 0);
 		}
 	}
 };
@@ -575,6 +647,9 @@ public:
 
 	Scene *scene = nullptr;
 
+	// Visible parts each command buffer has been recorded with, command buffers are re-recorded when the visible parts change
+	std::vector<std::vector<uint32_t>> recordedParts;
+
 	struct {
 		VkPipelineVertexInputStateCreateInfo inputState;
 		std::vector<VkVertexInputBindingDescription> bindingDescriptions;
@@ -617,7 +692,7 @@ public:
 		buildCommandBuffers();
 	}
 
-	void buildCommandBuffers()
+	void buildCommandBuffer(uint32_t i)
 	{
 		VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
 
@@ -634,26 +709,32 @@ public:
 		renderPassBeginInfo.renderArea.extent.height = height;
 		renderPassBeginInfo.clearValueCount = 2;
 		renderPassBeginInfo.pClearValues = clearValues;
+		renderPassBeginInfo.framebuffer = frameBuffers[i];
 
-		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i)
-		{
-			renderPassBeginInfo.framebuffer = frameBuffers[i];
+		VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
 
-			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+		vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		VkViewport viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
+		vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
 
-			VkViewport viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
-			vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
+		VkRect2D scissor = vks::initializers::rect2D(width, height, 0, 0);
+		vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
 
-			VkRect2D scissor = vks::initializers::rect2D(width, height, 0, 0);
-			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
+		scene->render(drawCmdBuffers[i], wireframe);
+		recordedParts[i] = scene->visibleParts;
 
-			scene->render(drawCmdBuffers[i], wireframe);
+		vkCmdEndRenderPass(drawCmdBuffers[i]);
 
-			vkCmdEndRenderPass(drawCmdBuffers[i]);
+		VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
+	}
 
-			VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
+	void buildCommandBuffers()
+	{
+		recordedParts.resize(drawCmdBuffers.size());
+		for (uint32_t i = 0; i < static_cast<uint32_t>(drawCmdBuffers.size()); ++i)
+		{
+			buildCommandBuffer(i);
 		}
 	}
 
@@ -811,12 +892,20 @@ public:
 		scene->uniformData.model = glm::mat4();
 
 		memcpy(scene->uniformBuffer.mapped, &scene->uniformData, sizeof(scene->uniformData));
+
+		scene->updateVisibility(camera.matrices.perspective * camera.matrices.view);
 	}
 
 	void draw()
 	{
 		VulkanExampleBase::prepareFrame();
 
+		// The command buffer for this image is no longer in use, re-record it if the visible parts have changed since it was recorded
+		if (recordedParts[currentBuffer] != scene->visibleParts)
+		{
+			buildCommandBuffer(currentBuffer);
+		}
+
 		// Command buffer to be sumitted to the queue
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
@@ -829,15 +918,17 @@ public:
 
 	void loadScene()
 	{
-		VkCommandBuffer copyCmd = VulkanExampleBase::createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, false);
 		scene = new Scene(vulkanDevice, queue);
 
 #if defined(__ANDROID__)
 		scene->assetManager = androidApp->activity->assetManager;
 #endif
 		scene->assetPath = getAssetPath() + "models/sibenik/";
-		scene->load(getAssetPath() + "models/sibenik/sibenik.dae", copyCmd);
-		vkFreeCommandBuffers(device, cmdPool, 1, &copyCmd);
+		scene->load(getAssetPath() + "models/sibenik/sibenik.dae", getThreadPool());
+		// All textures and buffers of the scene are sub-allocated from a few large memory blocks
+		vulkanDevice->memoryAllocator.printStats();
+		// Materials share the samplers of their textures
+		vulkanDevice->samplerCache.printStats();
 		updateUniformBuffers();
 	}
 
@@ -875,17 +966,17 @@ public:
 			}
 			break;
 		case KEY_P:
-			scene->renderSingleScenePart = !scene->renderSingleScenePart;
+			scene->renderSingleMesh = !scene->renderSingleMesh;
 			reBuildCommandBuffers();
 			updateTextOverlay();
 			break;
 		case KEY_KPADD:
-			scene->scenePartIndex = (scene->scenePartIndex < static_cast<uint32_t>(scene->meshes.size())) ? scene->scenePartIndex + 1 : 0;
+			scene->singleMeshIndex = (scene->singleMeshIndex + 1 < scene->sourceMeshCount) ? scene->singleMeshIndex + 1 : 0;
 			reBuildCommandBuffers();
 			updateTextOverlay();
 			break;
 		case KEY_KPSUB:
-			scene->scenePartIndex = (scene->scenePartIndex > 0) ? scene->scenePartIndex - 1 : static_cast<uint32_t>(scene->meshes.size()) - 1;
+			scene->singleMeshIndex = (scene->singleMeshIndex > 0) ? scene->singleMeshIndex - 1 : scene->sourceMeshCount - 1;
 			updateTextOverlay();
 			reBuildCommandBuffers();
 			break;
@@ -903,9 +994,9 @@ public:
 			textOverlay->addText("Press \"Button A\" to toggle wireframe", 5.0f, 85.0f, VulkanTextOverlay::alignLeft);
 #else
 			textOverlay->addText("Press \"space\" to toggle wireframe", 5.0f, 85.0f, VulkanTextOverlay::alignLeft);
-			if ((scene) && (scene->renderSingleScenePart))
+			if ((scene) && (scene->renderSingleMesh))
 			{
-				textOverlay->addText("Rendering mesh " + std::to_string(scene->scenePartIndex + 1) + " of " + std::to_string(static_cast<uint32_t>(scene->meshes.size())) + "(\"p\" to toggle)", 5.0f, 100.0f, VulkanTextOverlay::alignLeft);
+				textOverlay->addText("Rendering mesh " + std::to_string(scene->singleMeshIndex + 1) + " of " + std::to_string(scene->sourceMeshCount) + "(\"p\" to toggle)", 5.0f, 100.0f, VulkanTextOverlay::alignLeft);
 			}
 			else
 			{
@@ -913,6 +1004,10 @@ public:
 			}
 #endif
 		}
+		if (scene)
+		{
+			textOverlay->addText("Visible parts: " + std::to_string(scene->visibleParts.size()) + " of " + std::to_string(scene->meshes.size()), 5.0f, 115.0f, VulkanTextOverlay::alignLeft);
+		}
 	}
 };
 
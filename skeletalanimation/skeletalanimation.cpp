@@ -480,7 +480,7 @@ public:
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.texture);
 
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &models.floor.vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.floor.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.floor.indices.buffer, 0, models.floor.indexType);
 			vkCmdDrawIndexed(drawCmdBuffers[i], models.floor.indexCount, 1, 0, 0, 0);
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
@@ -579,7 +579,7 @@ public:
 
 		struct {
 			VkBuffer buffer;
-			VkDeviceMemory memory;
+			vks::Allocation allocation;
 		} vertexStaging, indexStaging;
 
 		// Create staging buffers
@@ -589,7 +589,7 @@ public:
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 			vertexBufferSize,
 			&vertexStaging.buffer,
-			&vertexStaging.memory,
+			&vertexStaging.allocation,
 			vertexBuffer.data()));
 		// Index data
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
@@ -597,7 +597,7 @@ public:
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 			indexBufferSize,
 			&indexStaging.buffer,
-			&indexStaging.memory,
+			&indexStaging.allocation,
 			indexBuffer.data()));
 
 		// Create device local buffers
@@ -638,9 +638,9 @@ public:
 		VulkanExampleBase::flushCommandBuffer(copyCmd, queue, true);
 
 		vkDestroyBuffer(device, vertexStaging.buffer, nullptr);
-		vkFreeMemory(device, vertexStaging.memory, nullptr);
+		vertexStaging.allocation.free();
 		vkDestroyBuffer(device, indexStaging.buffer, nullptr);
-		vkFreeMemory(device, indexStaging.memory, nullptr);
+		indexStaging.allocation.free();
 	}
 
 	void loadAssets()
@@ -22,6 +22,7 @@
 #include <vulkan/vulkan.h>
 #include "vulkanexamplebase.h"
 #include "VulkanTexture.hpp"
+#include "VulkanTextureCooker.hpp"
 #include "VulkanModel.hpp"
 #include "VulkanBuffer.hpp"
 
@@ -132,7 +133,7 @@ public:
 
 			VkDeviceSize offsets[1] = { 0 };
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &models.cube.vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.cube.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.cube.indices.buffer, 0, models.cube.indexType);
 
 			// Left
 			viewport.width = (float)width / 3.0f;
@@ -162,7 +163,10 @@ public:
 	void loadAssets()
 	{
 		models.cube.loadFromFile(getAssetPath() + "models/color_teapot_spheres.dae", vertexLayout, 0.1f, vulkanDevice, queue);
-		textures.colormap.loadFromFile(getAssetPath() + "textures/metalplate_nomips_rgba.ktx", VK_FORMAT_R8G8B8A8_UNORM, vulkanDevice, queue);
+		// The texture is only shipped uncompressed, a block compressed copy is cooked on the first run
+		std::string colormapFilename;
+		VkFormat colormapFormat = vks::texturecooker::cookForDevice(vulkanDevice, getThreadPool().jobSystem.get(), getAssetPath() + "textures/metalplate_nomips_rgba.ktx", false, colormapFilename);
+		textures.colormap.loadFromFile(colormapFilename, colormapFormat, vulkanDevice, queue);
 	}
 
 	void setupVertexDescriptions()
@@ -0,0 +1,145 @@
+/*
+* Frustum culling test
+*
+* Checks that the batched (SSE) and the scalar sphere tests of vks::Frustum classify spheres the same way,
+* including spheres that exactly touch a frustum plane from the outside (distance == -radius)
+*
+* Copyright (C) 2016 by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "frustum.hpp"
+
+// Spheres are read with a stride, so they are embedded into a larger structure like the scene parts of the examples
+struct Part
+{
+	glm::vec4 sphere;
+	uint32_t id;
+};
+
+int main()
+{
+	// Axis aligned box from -1 to 1, all planes are normalized so distances are exact
+	vks::Frustum frustum;
+	frustum.planes[vks::Frustum::LEFT] = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+	frustum.planes[vks::Frustum::RIGHT] = glm::vec4(-1.0f, 0.0f, 0.0f, 1.0f);
+	frustum.planes[vks::Frustum::TOP] = glm::vec4(0.0f, -1.0f, 0.0f, 1.0f);
+	frustum.planes[vks::Frustum::BOTTOM] = glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
+	frustum.planes[vks::Frustum::BACK] = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	frustum.planes[vks::Frustum::FRONT] = glm::vec4(0.0f, 0.0f, -1.0f, 1.0f);
+
+	struct Case
+	{
+		glm::vec4 sphere;
+		bool visible;
+	};
+	std::vector<Case> cases = {
+		{ glm::vec4(0.0f, 0.0f, 0.0f, 0.5f), true },
+		// Touching a plane from the outside, distance == -radius
+		{ glm::vec4(-2.0f, 0.0f, 0.0f, 1.0f), false },
+		{ glm::vec4(0.0f, 2.5f, 0.0f, 1.5f), false },
+		{ glm::vec4(0.0f, 0.0f, -3.0f, 2.0f), false },
+		// Intersecting a plane
+		{ glm::vec4(-1.5f, 0.0f, 0.0f, 1.0f), true },
+		{ glm::vec4(0.0f, 0.0f, 1.75f, 1.0f), true },
+		// Outside
+		{ glm::vec4(3.0f, 0.0f, 0.0f, 1.0f), false },
+		// Touching a plane from the inside
+		{ glm::vec4(0.5f, 0.0f, 0.0f, 0.5f), true },
+		// Tail that isn't a multiple of four, handled by the scalar path
+		{ glm::vec4(0.0f, -2.0f, 0.0f, 1.0f), false },
+	};
+
+	std::vector<Part> parts(cases.size());
+	for (size_t i = 0; i < cases.size(); i++)
+	{
+		parts[i].sphere = cases[i].sphere;
+		parts[i].id = static_cast<uint32_t>(i);
+	}
+
+	uint32_t failures = 0;
+
+	std::vector<uint32_t> expected;
+	for (uint32_t i = 0; i < cases.size(); i++)
+	{
+		bool scalar = frustum.checkSphere(glm::vec3(cases[i].sphere), cases[i].sphere.w);
+		if (scalar != cases[i].visible)
+		{
+			std::cerr << "checkSphere: sphere " << i << " classified as " << (scalar ? "visible" : "culled") << std::endl;
+			failures++;
+		}
+		if (cases[i].visible)
+		{
+			expected.push_back(i);
+		}
+	}
+
+	// Every start offset, so each sphere is tested in every lane of the batched path and in the scalar tail
+	for (uint32_t first = 0; first < parts.size(); first++)
+	{
+		std::vector<uint32_t> visible;
+		frustum.cullSpheres(&parts[first].sphere, static_cast<uint32_t>(parts.size()) - first, sizeof(Part), visible);
+		std::vector<uint32_t> expectedRange;
+		for (auto i : expected)
+		{
+			if (i >= first)
+			{
+				expectedRange.push_back(i - first);
+			}
+		}
+		if (visible != expectedRange)
+		{
+			std::cerr << "cullSpheres: wrong result for spheres " << first << " to " << parts.size() - 1 << ", visible:";
+			for (auto i : visible)
+			{
+				std::cerr << " " << i + first;
+			}
+			std::cerr << std::endl;
+			failures++;
+		}
+	}
+
+	// Perspective frustum with spheres placed so they touch one of the (tilted) planes, the result must match checkSphere
+	frustum.update(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 256.0f) * glm::lookAt(glm::vec3(1.0f, 2.0f, -5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<float> position(-64.0f, 64.0f);
+	std::uniform_int_distribution<int> plane(0, 5);
+	std::vector<glm::vec4> spheres;
+	for (uint32_t i = 0; i < 4096; i++)
+	{
+		glm::vec4 sphere(position(generator), position(generator), position(generator), 0.0f);
+		const glm::vec4 &p = frustum.planes[plane(generator)];
+		float distance = (p.x * sphere.x) + (p.y * sphere.y) + (p.z * sphere.z) + p.w;
+		sphere.w = fabsf(distance);
+		spheres.push_back(sphere);
+	}
+	std::vector<uint32_t> visible;
+	frustum.cullSpheres(spheres.data(), static_cast<uint32_t>(spheres.size()), sizeof(glm::vec4), visible);
+	std::vector<uint32_t> scalarVisible;
+	for (uint32_t i = 0; i < spheres.size(); i++)
+	{
+		if (frustum.checkSphere(glm::vec3(spheres[i]), spheres[i].w))
+		{
+			scalarVisible.push_back(i);
+		}
+	}
+	if (visible != scalarVisible)
+	{
+		std::cerr << "cullSpheres: " << visible.size() << " spheres visible, checkSphere: " << scalarVisible.size() << std::endl;
+		failures++;
+	}
+
+	if (failures > 0)
+	{
+		std::cerr << failures << " frustum test(s) failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All frustum tests passed" << std::endl;
+	return 0;
+}
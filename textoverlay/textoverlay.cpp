@@ -53,6 +53,7 @@ private:
 	VkQueue queue;
 	VkFormat colorFormat;
 	VkFormat depthFormat;
+	VkImageLayout finalLayout;
 
 	uint32_t *frameBufferWidth;
 	uint32_t *frameBufferHeight;
@@ -94,12 +95,14 @@ public:
 		VkFormat depthformat,
 		uint32_t *framebufferwidth,
 		uint32_t *framebufferheight,
-		std::vector<VkPipelineShaderStageCreateInfo> shaderstages)
+		std::vector<VkPipelineShaderStageCreateInfo> shaderstages,
+		VkImageLayout finallayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
 	{
 		this->vulkanDevice = vulkanDevice;
 		this->queue = queue;
 		this->colorFormat = colorformat;
 		this->depthFormat = depthformat;
+		this->finalLayout = finallayout;
 
 		this->frameBuffers.resize(framebuffers.size());
 		for (uint32_t i = 0; i < framebuffers.size(); i++)
@@ -471,7 +474,7 @@ public:
 		attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		attachments[0].finalLayout = finalLayout;
 
 		// Depth attachment
 		attachments[1].format = depthFormat;
@@ -793,7 +796,7 @@ public:
 
 			VkDeviceSize offsets[1] = { 0 };
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &models.cube.vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.cube.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], models.cube.indices.buffer, 0, models.cube.indexType);
 
 			// Background
 			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.background);
@@ -1146,7 +1149,8 @@ public:
 			depthFormat,
 			&width,
 			&height,
-			shaderStages
+			shaderStages,
+			swapChain.presentLayout
 			);
 		updateTextOverlay();
 	}
@@ -94,7 +94,7 @@ public:
 		vkDestroyImageView(device, textureArray.view, nullptr);
 		vkDestroyImage(device, textureArray.image, nullptr);
 		vkDestroySampler(device, textureArray.sampler, nullptr);
-		vkFreeMemory(device, textureArray.deviceMemory, nullptr);
+		textureArray.allocation.free();
 
 		vkDestroyPipeline(device, pipeline, nullptr);
 
@@ -234,11 +234,8 @@ public:
 
 		vkGetImageMemoryRequirements(device, textureArray.image, &memReqs);
 
-		memAllocInfo.allocationSize = memReqs.size;
-		memAllocInfo.memoryTypeIndex = vulkanDevice->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		VK_CHECK_RESULT(vkAllocateMemory(device, &memAllocInfo, nullptr, &textureArray.deviceMemory));
-		VK_CHECK_RESULT(vkBindImageMemory(device, textureArray.image, textureArray.deviceMemory, 0));
+		VK_CHECK_RESULT(vulkanDevice->allocateMemory(memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, &textureArray.allocation));
+		VK_CHECK_RESULT(vkBindImageMemory(device, textureArray.image, textureArray.allocation.memory, textureArray.allocation.offset));
 
 		VkCommandBuffer copyCmd = VulkanExampleBase::createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
 
@@ -637,12 +634,11 @@ public:
 		}
 
 		// Update instanced part of the uniform buffer
-		uint8_t *pData;
 		uint32_t dataOffset = sizeof(uboVS.matrices);
 		uint32_t dataSize = layerCount * sizeof(UboInstanceData);
-		VK_CHECK_RESULT(vkMapMemory(device, uniformBufferVS.memory, dataOffset, dataSize, 0, (void **)&pData));
-		memcpy(pData, uboVS.instance, dataSize);
-		vkUnmapMemory(device, uniformBufferVS.memory);
+		VK_CHECK_RESULT(uniformBufferVS.map(dataSize, dataOffset));
+		memcpy(uniformBufferVS.mapped, uboVS.instance, dataSize);
+		uniformBufferVS.unmap();
 
 		// Map persistent
 		VK_CHECK_RESULT(uniformBufferVS.map());
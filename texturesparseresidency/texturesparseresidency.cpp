@@ -11,7 +11,6 @@ todos:
 - check sparse binding support on queue
 - residencyNonResidentStrict
 - meta data
-- Run-time image data upload
 */
 
 #include <stdio.h>
@@ -20,8 +19,7 @@ todos:
 #include <assert.h>
 #include <vector>
 #include <algorithm>
-#include <random>
-#include <chrono>
+#include <list>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -56,48 +54,103 @@ struct VirtualTexturePage
 	uint32_t mipLevel;													// Mip level that this page belongs to
 	uint32_t layer;														// Array layer that this page belongs to
 	uint32_t index;	
+	uint32_t poolSlot;													// Slot of the page pool backing this page while it's resident
+	uint64_t lastRequested;												// Last frame in which the feedback pass requested this page
+	std::list<uint32_t>::iterator lruPosition;							// Position in the least recently used list while it's resident
 
 	VirtualTexturePage()
 	{
 		imageMemoryBind.memory = VK_NULL_HANDLE;						// Page initially not backed up by memory
+		poolSlot = UINT32_MAX;
+		lastRequested = 0;
 	}
 
-	// Allocate Vulkan memory for the virtual page
-	void allocate(VkDevice device, uint32_t memoryTypeIndex)
+	bool resident() const
 	{
-		if (imageMemoryBind.memory != VK_NULL_HANDLE)
-		{
-			//std::cout << "Page " << index << " already allocated" << std::endl;
-			return;
-		};
+		return imageMemoryBind.memory != VK_NULL_HANDLE;
+	}
+};
+
+// Page sized slots of a few large memory blocks, shared by all virtual textures
+// The capacity of the pool is the memory budget for resident pages, blocks are allocated once their slots are needed
+struct PagePool
+{
+	VkDevice device;
+	VkDeviceSize pageSize;
+	uint32_t memoryTypeIndex;
+	uint32_t pagesPerBlock;
+	uint32_t maxBlocks;
+	uint32_t usedCount = 0;
+	std::vector<VkDeviceMemory> blocks;
+	std::vector<uint32_t> freeSlots;
+
+	void create(VkDevice device, VkDeviceSize pageSize, uint32_t memoryTypeIndex, VkDeviceSize budget, VkDeviceSize blockSize)
+	{
+		this->device = device;
+		this->pageSize = pageSize;
+		this->memoryTypeIndex = memoryTypeIndex;
+		pagesPerBlock = std::max(static_cast<uint32_t>(blockSize / pageSize), 1u);
+		maxBlocks = std::max(static_cast<uint32_t>(budget / (pagesPerBlock * pageSize)), 1u);
+	}
 
-		imageMemoryBind = {};
+	uint32_t capacity() const
+	{
+		return maxBlocks * pagesPerBlock;
+	}
+
+	// Get a free slot, returns false if the budget is exhausted
+	bool allocate(uint32_t &slot)
+	{
+		if (freeSlots.empty())
+		{
+			if (blocks.size() >= maxBlocks)
+			{
+				return false;
+			}
+			VkMemoryAllocateInfo allocInfo = vks::initializers::memoryAllocateInfo();
+			allocInfo.allocationSize = pagesPerBlock * pageSize;
+			allocInfo.memoryTypeIndex = memoryTypeIndex;
+			VkDeviceMemory memory;
+			VK_CHECK_RESULT(vkAllocateMemory(device, &allocInfo, nullptr, &memory));
+			uint32_t firstSlot = static_cast<uint32_t>(blocks.size()) * pagesPerBlock;
+			blocks.push_back(memory);
+			// Hand out the slots of the new block front to back
+			for (uint32_t i = pagesPerBlock; i > 0; i--)
+			{
+				freeSlots.push_back(firstSlot + i - 1);
+			}
+		}
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+		usedCount++;
+		return true;
+	}
 
-		VkMemoryAllocateInfo allocInfo = vks::initializers::memoryAllocateInfo();
-		allocInfo.allocationSize = size;
-		allocInfo.memoryTypeIndex = memoryTypeIndex;
-		VK_CHECK_RESULT(vkAllocateMemory(device, &allocInfo, nullptr, &imageMemoryBind.memory));
+	void free(uint32_t slot)
+	{
+		freeSlots.push_back(slot);
+		usedCount--;
+	}
 
-		VkImageSubresource subResource{};
-		subResource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		subResource.mipLevel = mipLevel;
-		subResource.arrayLayer = layer;
+	VkDeviceMemory getMemory(uint32_t slot) const
+	{
+		return blocks[slot / pagesPerBlock];
+	}
 
-		// Sparse image memory binding
-		imageMemoryBind.subresource = subResource;
-		imageMemoryBind.extent = extent;
-		imageMemoryBind.offset = offset;
+	VkDeviceSize getOffset(uint32_t slot) const
+	{
+		return (slot % pagesPerBlock) * pageSize;
 	}
 
-	// Release Vulkan memory allocated for this page
-	void release(VkDevice device)
+	void destroy()
 	{
-		if (imageMemoryBind.memory != VK_NULL_HANDLE)
+		for (auto block : blocks)
 		{
-			vkFreeMemory(device, imageMemoryBind.memory, nullptr);
-			imageMemoryBind.memory = VK_NULL_HANDLE;
-			//std::cout << "Page " << index << " released" << std::endl;
+			vkFreeMemory(device, block, nullptr);
 		}
+		blocks.clear();
+		freeSlots.clear();
+		usedCount = 0;
 	}
 };
 
@@ -106,13 +159,19 @@ struct VirtualTexture
 {
 	VkDevice device;
 	VkImage image;														// Texture image handle
+	PagePool *pagePool;													// Pool the memory of resident pages is taken from
 	VkBindSparseInfo bindSparseInfo;									// Sparse queue binding information
 	std::vector<VirtualTexturePage> pages;								// Contains all virtual pages of the texture
-	std::vector<VkSparseImageMemoryBind> sparseImageMemoryBinds;		// Sparse image memory bindings of all memory-backed virtual tables
+	std::vector<VkSparseImageMemoryBind> sparseImageMemoryBinds;		// Sparse image memory bindings of pages whose residency changed since the last bind
 	std::vector<VkSparseMemoryBind>	opaqueMemoryBinds;					// Sparse paque memory bindings for the mip tail (if present)
 	VkSparseImageMemoryBindInfo imageMemoryBindInfo;					// Sparse image memory bind info 
 	VkSparseImageOpaqueMemoryBindInfo opaqueMemoryBindInfo;				// Sparse image opaque memory bind info (mip tail)
+	bool opaqueBindsPending = true;										// The mip tail is bound with the first bind
 	uint32_t mipTailStart;												// First mip level in mip tail
+	VkExtent3D pageGranularity;											// Extent of a (full) page
+	std::vector<uint32_t> mipFirstPage;									// Index of the first page of each mip level outside of the mip tail (first layer)
+	std::vector<glm::uvec2> mipPageCounts;								// Number of pages in x and y of each mip level outside of the mip tail
+	std::list<uint32_t> lru;											// Resident pages, most recently requested first
 	
 	VirtualTexturePage* addPage(VkOffset3D offset, VkExtent3D extent, const VkDeviceSize size, const uint32_t mipLevel, uint32_t layer)
 	{
@@ -129,22 +188,52 @@ struct VirtualTexture
 		return &pages.back();
 	}
 
-	// Call before sparse binding to update memory bind list etc.
-	void updateSparseBindInfo()
+	// Back a page with memory from the pool
+	// If the budget is exhausted the least recently used pages are evicted, as long as they haven't been requested during the last evictionDelay frames
+	bool makeResident(VirtualTexturePage &page, uint64_t frame, uint64_t evictionDelay)
 	{
-		// Update list of memory-backed sparse image memory binds
-		sparseImageMemoryBinds.resize(pages.size());
-		uint32_t index = 0;
-		for (auto page : pages)
+		uint32_t slot;
+		while (!pagePool->allocate(slot))
 		{
-			sparseImageMemoryBinds[index] = page.imageMemoryBind;
-			index++;
+			if (lru.empty() || (pages[lru.back()].lastRequested + evictionDelay > frame))
+			{
+				return false;
+			}
+			evict(pages[lru.back()]);
 		}
+		page.poolSlot = slot;
+		page.imageMemoryBind.memory = pagePool->getMemory(slot);
+		page.imageMemoryBind.memoryOffset = pagePool->getOffset(slot);
+		lru.push_front(page.index);
+		page.lruPosition = lru.begin();
+		sparseImageMemoryBinds.push_back(page.imageMemoryBind);
+		return true;
+	}
+
+	// Return the memory of a page to the pool, the page is unbound with the next bind
+	void evict(VirtualTexturePage &page)
+	{
+		pagePool->free(page.poolSlot);
+		page.poolSlot = UINT32_MAX;
+		page.imageMemoryBind.memory = VK_NULL_HANDLE;
+		page.imageMemoryBind.memoryOffset = 0;
+		lru.erase(page.lruPosition);
+		// Binding no memory makes the page non-resident
+		sparseImageMemoryBinds.push_back(page.imageMemoryBind);
+	}
+
+	// Move a resident page to the front of the least recently used list
+	void touch(VirtualTexturePage &page)
+	{
+		lru.splice(lru.begin(), lru, page.lruPosition);
+	}
+
+	// Call before sparse binding to update memory bind list etc.
+	// Only contains the pages whose residency changed since the last bind, clear sparseImageMemoryBinds after the bind has been queued
+	void updateSparseBindInfo()
+	{
 		// Update sparse bind info
 		bindSparseInfo = vks::initializers::bindSparseInfo();
-		// todo: Semaphore for queue submission
-		// bindSparseInfo.signalSemaphoreCount = 1;
-		// bindSparseInfo.pSignalSemaphores = &bindSparseSemaphore;
 
 		// Image memory binds
 		imageMemoryBindInfo.image = image;
@@ -155,19 +244,17 @@ struct VirtualTexture
 
 		// Opaque image memory binds (mip tail)
 		opaqueMemoryBindInfo.image = image;
-		opaqueMemoryBindInfo.bindCount = static_cast<uint32_t>(opaqueMemoryBinds.size());
+		opaqueMemoryBindInfo.bindCount = opaqueBindsPending ? static_cast<uint32_t>(opaqueMemoryBinds.size()) : 0;
 		opaqueMemoryBindInfo.pBinds = opaqueMemoryBinds.data();
 		bindSparseInfo.imageOpaqueBindCount = (opaqueMemoryBindInfo.bindCount > 0) ? 1 : 0;
 		bindSparseInfo.pImageOpaqueBinds = &opaqueMemoryBindInfo;
+		opaqueBindsPending = false;
 	}
 
 	// Release all Vulkan resources
+	// Page memory is owned by the page pool
 	void destroy()
 	{
-		for (auto page : pages)
-		{
-			page.release(device);
-		}
 		for (auto bind : opaqueMemoryBinds)
 		{
 			vkFreeMemory(device, bind.memory, nullptr);
@@ -175,9 +262,6 @@ struct VirtualTexture
 	}
 };
 
-uint32_t memoryTypeIndex;
-int32_t lastFilledMip = 0;
-
 class VulkanExample : public VulkanExampleBase
 {
 public:
@@ -224,8 +308,29 @@ public:
 	VkDescriptorSet descriptorSet;
 	VkDescriptorSetLayout descriptorSetLayout;
 
-	//todo: comment
-	VkSemaphore bindSparseSemaphore = VK_NULL_HANDLE;
+	// Memory budget for the resident pages of the virtual texture, taken from the page pool
+	const VkDeviceSize pageMemoryBudget = 128 * 1024 * 1024;
+	// Pages uploaded per frame at most, pages beyond that arrive in the following frames
+	const uint32_t maxPageUploadsPerFrame = 64;
+	// Grid step (in heightmap vertices) of the feedback pass
+	const uint32_t feedbackStride = 2;
+
+	PagePool pagePool;
+	uint64_t frameNumber = 0;
+	bool flushRequested = false;
+	std::vector<uint32_t> pageUploads;
+
+	// Binds and uploads of pages are queued per frame and chained with semaphores
+	struct {
+		std::vector<VkCommandBuffer> commandBuffers;
+		std::vector<VkSemaphore> bindComplete;
+		std::vector<VkSemaphore> uploadComplete;
+	} pageUpdates;
+
+	struct {
+		uint32_t requested = 0;
+		uint32_t uploaded = 0;
+	} pageStats;
 
 	VulkanExample() : VulkanExampleBase(ENABLE_VALIDATION)
 	{
@@ -256,8 +361,17 @@ public:
 			delete heightMap;
 
 		destroyTextureImage(texture);
+		pagePool.destroy();
 
-		vkDestroySemaphore(device, bindSparseSemaphore, nullptr);
+		for (uint32_t i = 0; i < pageUpdates.bindComplete.size(); i++)
+		{
+			vkDestroySemaphore(device, pageUpdates.bindComplete[i], nullptr);
+			vkDestroySemaphore(device, pageUpdates.uploadComplete[i], nullptr);
+		}
+		if (!pageUpdates.commandBuffers.empty())
+		{
+			vkFreeCommandBuffers(device, cmdPool, static_cast<uint32_t>(pageUpdates.commandBuffers.size()), pageUpdates.commandBuffers.data());
+		}
 
 		vkDestroyPipeline(device, pipelines.solid, nullptr);
 
@@ -386,8 +500,7 @@ public:
 			//todo:multiple reqs
 			texture.mipTailStart = reqs.imageMipTailFirstLod;
 		}
-		
-		lastFilledMip = texture.mipTailStart - 1;
+
 
 		// Get sparse image requirements for the color aspect
 		VkSparseImageMemoryRequirements sparseMemoryReq;
@@ -410,7 +523,12 @@ public:
 		// todo:
 		// Calculate number of required sparse memory bindings by alignment
 		assert((sparseImageMemoryReqs.size % sparseImageMemoryReqs.alignment) == 0);
-		memoryTypeIndex = vulkanDevice->getMemoryType(sparseImageMemoryReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		uint32_t memoryTypeIndex = vulkanDevice->getMemoryType(sparseImageMemoryReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		// Resident pages are backed by the memory of the page pool, allocated in blocks of 16 MB
+		pagePool.create(device, sparseImageMemoryReqs.alignment, memoryTypeIndex, pageMemoryBudget, 16 * 1024 * 1024);
+		texture.pagePool = &pagePool;
+		texture.pageGranularity = sparseMemoryReq.formatProperties.imageGranularity;
 
 		// Get sparse bindings
 		uint32_t sparseBindsCount = static_cast<uint32_t>(sparseImageMemoryReqs.size / sparseImageMemoryReqs.alignment);		
@@ -439,6 +557,11 @@ public:
 				// Aligned sizes by image granularity
 				VkExtent3D imageGranularity = sparseMemoryReq.formatProperties.imageGranularity;
 				glm::uvec3 sparseBindCounts = alignedDivision(extent, imageGranularity);
+				if (layer == 0)
+				{
+					texture.mipFirstPage.push_back(static_cast<uint32_t>(texture.pages.size()));
+					texture.mipPageCounts.push_back(glm::uvec2(sparseBindCounts.x, sparseBindCounts.y));
+				}
 				glm::uvec3 lastBlockExtent;
 				lastBlockExtent.x = (extent.width % imageGranularity.width) ? extent.width % imageGranularity.width : imageGranularity.width;
 				lastBlockExtent.y = (extent.height % imageGranularity.height) ? extent.height % imageGranularity.height : imageGranularity.height;
@@ -467,12 +590,6 @@ public:
 							VirtualTexturePage *newPage = texture.addPage(offset, extent, sparseImageMemoryReqs.alignment, mipLevel, layer);
 							newPage->imageMemoryBind.subresource = subResource;
 
-							if ((x % 2 == 1) || (y % 2 == 1))
-							{
-								// Allocate memory for this virtual page
-								//newPage->allocate(device, memoryTypeIndex);
-							}
-
 							index++;
 						}
 					}
@@ -524,18 +641,12 @@ public:
 			texture.opaqueMemoryBinds.push_back(sparseMemoryBind);
 		}
 
-		// Create signal semaphore for sparse binding
-		VkSemaphoreCreateInfo semaphoreCreateInfo = vks::initializers::semaphoreCreateInfo();
-		VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &bindSparseSemaphore));
+		std::cout << "\tPage memory budget: " << pagePool.capacity() << " pages" << std::endl;
 
-		// Prepare bind sparse info for reuse in queue submission
+		// Bind the mip tail, pages are bound on demand by updateResidency()
 		texture.updateSparseBindInfo();
-
-		// Bind to queue
-		// todo: in draw?
-		vkQueueBindSparse(queue, 1, &texture.bindSparseInfo, VK_NULL_HANDLE);
-		//todo: use sparse bind semaphore
-		vkQueueWaitIdle(queue);
+		VK_CHECK_RESULT(vkQueueBindSparse(queue, 1, &texture.bindSparseInfo, VK_NULL_HANDLE));
+		VK_CHECK_RESULT(vkQueueWaitIdle(queue));
 
 		// Create sampler
 		VkSamplerCreateInfo sampler = vks::initializers::samplerCreateInfo();
@@ -570,12 +681,12 @@ public:
 		VK_CHECK_RESULT(vkCreateImageView(device, &view, nullptr, &texture.view));
 
 		// Fill image descriptor image info that can be used during the descriptor set setup
-		texture.descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		// The image stays in the general layout, so pages can be uploaded while others are sampled
+		texture.descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 		texture.descriptor.imageView = texture.view;
 		texture.descriptor.sampler = texture.sampler;
 
-		// Fill smallest (non-tail) mip map leve
-		fillVirtualTexture(lastFilledMip);
+		initializeVirtualTexture();
 	}
 
 	// Free all Vulkan resources used a texture object
@@ -624,7 +735,7 @@ public:
 
 			VkDeviceSize offsets[1] = { 0 };
 			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &heightMap->vertexBuffer.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], heightMap->indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(drawCmdBuffers[i], heightMap->indexBuffer.buffer, 0, heightMap->indexType);
 			vkCmdDrawIndexed(drawCmdBuffers[i], heightMap->indexCount, 1, 0, 0, 0);
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
@@ -637,24 +748,29 @@ public:
 	{
 		VulkanExampleBase::prepareFrame();
 
-		// Sparse bindings
-//		vkQueueBindSparse(queue, 1, &bindSparseInfo, VK_NULL_HANDLE);
-		//todo: use sparse bind semaphore
-//		vkQueueWaitIdle(queue);
+		// Bind and upload the pages requested for the current view, the frame waits for them on the GPU
+		VkSemaphore pagesReady = updateResidency();
+
+		VkSemaphore waitSemaphores[2] = { semaphores.presentComplete, pagesReady };
+		VkPipelineStageFlags waitStages[2] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+		VkSubmitInfo frameSubmitInfo = submitInfo;
+		frameSubmitInfo.waitSemaphoreCount = (pagesReady != VK_NULL_HANDLE) ? 2 : 1;
+		frameSubmitInfo.pWaitSemaphores = waitSemaphores;
+		frameSubmitInfo.pWaitDstStageMask = waitStages;
 
 		// Command buffer to be sumitted to the queue
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
+		frameSubmitInfo.commandBufferCount = 1;
+		frameSubmitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
 
 		// Submit to queue
-		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
+		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &frameSubmitInfo, VK_NULL_HANDLE));
 
 		VulkanExampleBase::submitFrame();
 	}
 
 	void loadAssets()
 	{
-		textures.source.loadFromFile(getAssetPath() + "textures/ground_dry_bc3.ktx", VK_FORMAT_BC3_UNORM_BLOCK, vulkanDevice, queue, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+		textures.source.loadFromFile(getAssetPath() + "textures/ground_dry_bc3.ktx", VK_FORMAT_BC3_UNORM_BLOCK, vulkanDevice, queue, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
 	}
 
 	// Generate a terrain quad patch for feeding to the tessellation control shader
@@ -917,6 +1033,7 @@ public:
 		preparePipelines();
 		setupDescriptorPool();
 		setupDescriptorSet();
+		preparePageUpdates();
 		buildCommandBuffers();
 		prepared = true;
 	}
@@ -948,104 +1065,304 @@ public:
 		updateTextOverlay();
 	}
 
-	// Clear all pages of the virtual texture
-	// todo: just for testing
+	// Free all pages of the virtual texture with the next residency update
 	void flushVirtualTexture()
 	{
-		vkDeviceWaitIdle(device);
-		for (auto& page : texture.pages)
+		flushRequested = true;
+	}
+
+	// Add the blits that fill a page with the source texture, which repeats every page of the first mip level
+	void addPageBlits(const VirtualTexturePage &page, std::vector<VkImageBlit> &imageBlits)
+	{
+		// Current mip level scaling
+		uint32_t scale = texture.width / (texture.width >> page.mipLevel);
+
+		for (uint32_t x = 0; x < scale; x++)
 		{
-			page.release(device);
+			for (uint32_t y = 0; y < scale; y++)
+			{
+				// Image blit
+				VkImageBlit blit{};
+				// Source
+				blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				blit.srcSubresource.baseArrayLayer = 0;
+				blit.srcSubresource.layerCount = 1;
+				blit.srcSubresource.mipLevel = 0;
+				blit.srcOffsets[0] = { 0, 0, 0 };
+				blit.srcOffsets[1] = { static_cast<int32_t>(textures.source.width), static_cast<int32_t>(textures.source.height), 1 };
+				// Dest
+				blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				blit.dstSubresource.baseArrayLayer = page.layer;
+				blit.dstSubresource.layerCount = 1;
+				blit.dstSubresource.mipLevel = page.mipLevel;
+				blit.dstOffsets[0].x = static_cast<int32_t>(page.offset.x + x * texture.pageGranularity.width / scale);
+				blit.dstOffsets[0].y = static_cast<int32_t>(page.offset.y + y * texture.pageGranularity.height / scale);
+				blit.dstOffsets[0].z = 0;
+				blit.dstOffsets[1].x = static_cast<int32_t>(blit.dstOffsets[0].x + std::max(page.extent.width / scale, 1u));
+				blit.dstOffsets[1].y = static_cast<int32_t>(blit.dstOffsets[0].y + std::max(page.extent.height / scale, 1u));
+				blit.dstOffsets[1].z = 1;
+
+				imageBlits.push_back(blit);
+			}
 		}
-		texture.updateSparseBindInfo();
-		vkQueueBindSparse(queue, 1, &texture.bindSparseInfo, VK_NULL_HANDLE);
-		//todo: use sparse bind semaphore
-		vkQueueWaitIdle(queue);
-		lastFilledMip = texture.mipTailStart - 1;
 	}
 
-	// Fill a complete mip level
-	void fillVirtualTexture(int32_t &mipLevel)
+	// Transition the virtual texture to the general layout it's sampled and updated in and fill the (always resident) mip tail
+	void initializeVirtualTexture()
 	{
-		vkDeviceWaitIdle(device);
-		std::default_random_engine rndEngine(std::random_device{}());
-		std::uniform_real_distribution<float> rndDist(0.0f, 1.0f);
+		// The source texture is blitted from, so its upload has to be finished
+		vulkanDevice->uploadQueue.flush();
+
+		VkCommandBuffer copyCmd = vulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.levelCount = texture.mipLevels;
+		subresourceRange.layerCount = texture.layerCount;
+		// Layouts apply to the whole image, pages bound later on are in the general layout too
+		vks::tools::setImageLayout(copyCmd, texture.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, subresourceRange);
+
 		std::vector<VkImageBlit> imageBlits;
-		for (auto& page : texture.pages)
+		for (uint32_t mipLevel = texture.mipTailStart; mipLevel < texture.mipLevels; mipLevel++)
+		{
+			VkImageBlit blit{};
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.layerCount = 1;
+			blit.srcOffsets[1] = { static_cast<int32_t>(textures.source.width), static_cast<int32_t>(textures.source.height), 1 };
+			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.dstSubresource.layerCount = 1;
+			blit.dstSubresource.mipLevel = mipLevel;
+			blit.dstOffsets[1] = { static_cast<int32_t>(std::max(texture.width >> mipLevel, 1u)), static_cast<int32_t>(std::max(texture.height >> mipLevel, 1u)), 1 };
+			imageBlits.push_back(blit);
+		}
+		if (imageBlits.size() > 0)
+		{
+			vkCmdBlitImage(copyCmd, textures.source.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, texture.image, VK_IMAGE_LAYOUT_GENERAL, static_cast<uint32_t>(imageBlits.size()), imageBlits.data(), VK_FILTER_LINEAR);
+		}
+
+		vulkanDevice->flushCommandBuffer(copyCmd, queue);
+	}
+
+	// Create the command buffers and semaphores used to bind and upload pages, one set per frame in flight
+	void preparePageUpdates()
+	{
+		pageUpdates.commandBuffers.resize(maxFramesInFlight);
+		VkCommandBufferAllocateInfo cmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(cmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, maxFramesInFlight);
+		VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, pageUpdates.commandBuffers.data()));
+
+		VkSemaphoreCreateInfo semaphoreCreateInfo = vks::initializers::semaphoreCreateInfo();
+		pageUpdates.bindComplete.resize(maxFramesInFlight);
+		pageUpdates.uploadComplete.resize(maxFramesInFlight);
+		for (uint32_t i = 0; i < maxFramesInFlight; i++)
 		{
-			if ((page.mipLevel == mipLevel) && /*(rndDist(rndEngine) < 0.5f) &&*/ (page.imageMemoryBind.memory == VK_NULL_HANDLE))
+			VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &pageUpdates.bindComplete[i]));
+			VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &pageUpdates.uploadComplete[i]));
+		}
+	}
+
+	// Feedback pass: find the pages the current view samples
+	// The terrain is evaluated on a coarse grid of cells on the CPU. Each cell is projected to the screen and its texel to pixel ratio
+	// selects the mip level (like the derivatives used by the texture unit). All pages of that level overlapping the cell's uv range are
+	// requested, along with the pages of all coarser levels, so the shader's fallback to coarser levels always finds resident data.
+	void gatherPageRequests(std::vector<uint32_t> &requests)
+	{
+		const uint32_t patchSize = heightMap->patchSize;
+		const glm::mat4 mvp = uboVS.projection * uboVS.model;
+		const glm::vec2 viewport = glm::vec2((float)width, (float)height);
+
+		for (uint32_t y = 0; y + feedbackStride < patchSize; y += feedbackStride)
+		{
+			for (uint32_t x = 0; x + feedbackStride < patchSize; x += feedbackStride)
 			{
-				// Allocate page memory
-				page.allocate(device, memoryTypeIndex);
+				const vks::HeightMap::Vertex *corners[4] = {
+					&heightMap->vertices[x + y * patchSize],
+					&heightMap->vertices[(x + feedbackStride) + y * patchSize],
+					&heightMap->vertices[x + (y + feedbackStride) * patchSize],
+					&heightMap->vertices[(x + feedbackStride) + (y + feedbackStride) * patchSize] };
+
+				// Skip cells that are completely outside of one of the clip planes
+				glm::vec4 clip[4];
+				uint32_t outside[5] = {};
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					clip[i] = mvp * glm::vec4(corners[i]->pos, 1.0f);
+					outside[0] += (clip[i].x < -clip[i].w) ? 1 : 0;
+					outside[1] += (clip[i].x > clip[i].w) ? 1 : 0;
+					outside[2] += (clip[i].y < -clip[i].w) ? 1 : 0;
+					outside[3] += (clip[i].y > clip[i].w) ? 1 : 0;
+					outside[4] += (clip[i].w <= 0.0f) ? 1 : 0;
+				}
+				if ((outside[0] == 4) || (outside[1] == 4) || (outside[2] == 4) || (outside[3] == 4) || (outside[4] == 4))
+				{
+					continue;
+				}
 
-				// Current mip level scaling
-				uint32_t scale = texture.width / (texture.width >> page.mipLevel);
+				glm::vec2 uvMin = glm::min(glm::min(corners[0]->uv, corners[1]->uv), glm::min(corners[2]->uv, corners[3]->uv));
+				glm::vec2 uvMax = glm::max(glm::max(corners[0]->uv, corners[1]->uv), glm::max(corners[2]->uv, corners[3]->uv));
 
-				for (uint32_t x = 0; x < scale; x++)
+				// Cells crossing the camera plane are close to the viewer and use the first mip level
+				float lod = 0.0f;
+				if (outside[4] == 0)
 				{
-					for (uint32_t y = 0; y < scale; y++)
+					glm::vec2 screen[3];
+					for (uint32_t i = 0; i < 3; i++)
 					{
-						// Image blit
-						VkImageBlit blit{};
-						// Source
-						blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-						blit.srcSubresource.baseArrayLayer = 0;
-						blit.srcSubresource.layerCount = 1;
-						blit.srcSubresource.mipLevel = 0;
-						blit.srcOffsets[0] = { 0, 0, 0 };
-						blit.srcOffsets[1] = { static_cast<int32_t>(textures.source.width), static_cast<int32_t>(textures.source.height), 1 };
-						// Dest
-						blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-						blit.dstSubresource.baseArrayLayer = 0;
-						blit.dstSubresource.layerCount = 1;
-						blit.dstSubresource.mipLevel = page.mipLevel;
-						blit.dstOffsets[0].x = static_cast<int32_t>(page.offset.x + x * 128 / scale);
-						blit.dstOffsets[0].y = static_cast<int32_t>(page.offset.y + y * 128 / scale);
-						blit.dstOffsets[0].z = 0;
-						blit.dstOffsets[1].x = static_cast<int32_t>(blit.dstOffsets[0].x + page.extent.width / scale);
-						blit.dstOffsets[1].y = static_cast<int32_t>(blit.dstOffsets[0].y + page.extent.height / scale);
-						blit.dstOffsets[1].z = 1;
-
-						imageBlits.push_back(blit);
+						screen[i] = (glm::vec2(clip[i]) / clip[i].w * 0.5f + 0.5f) * viewport;
+					}
+					float texelsU = (corners[1]->uv.x - corners[0]->uv.x) * texture.width;
+					float texelsV = (corners[2]->uv.y - corners[0]->uv.y) * texture.height;
+					float pixelsU = std::max(glm::length(screen[1] - screen[0]), 1.0f);
+					float pixelsV = std::max(glm::length(screen[2] - screen[0]), 1.0f);
+					lod = log2f(std::max(std::max(texelsU / pixelsU, texelsV / pixelsV), 1.0f));
+				}
+				int32_t mipLevel = static_cast<int32_t>(lod + uboVS.lodBias);
+
+				// Levels inside of the mip tail are always resident
+				for (uint32_t level = static_cast<uint32_t>(std::max(mipLevel, 0)); level < texture.mipTailStart; level++)
+				{
+					glm::uvec2 pageCount = texture.mipPageCounts[level];
+					glm::vec2 levelExtent = glm::vec2((float)std::max(texture.width >> level, 1u), (float)std::max(texture.height >> level, 1u));
+					glm::vec2 granularity = glm::vec2((float)texture.pageGranularity.width, (float)texture.pageGranularity.height);
+					glm::uvec2 first = glm::uvec2(glm::clamp(uvMin * levelExtent / granularity, glm::vec2(0.0f), glm::vec2(pageCount - 1u)));
+					glm::uvec2 last = glm::uvec2(glm::clamp(uvMax * levelExtent / granularity, glm::vec2(0.0f), glm::vec2(pageCount - 1u)));
+					for (uint32_t pageY = first.y; pageY <= last.y; pageY++)
+					{
+						for (uint32_t pageX = first.x; pageX <= last.x; pageX++)
+						{
+							VirtualTexturePage &page = texture.pages[texture.mipFirstPage[level] + pageX + pageY * pageCount.x];
+							if (page.lastRequested != frameNumber)
+							{
+								page.lastRequested = frameNumber;
+								requests.push_back(page.index);
+							}
+						}
 					}
 				}
 			}
 		}
+	}
+
+	// Make the pages requested by the feedback pass resident and queue their binds and uploads
+	// Returns the semaphore the frame's submission has to wait on, VK_NULL_HANDLE if no page changed
+	VkSemaphore updateResidency()
+	{
+		frameNumber++;
+		pageStats.requested = 0;
+		pageStats.uploaded = 0;
+
+		if (flushRequested)
+		{
+			while (!texture.lru.empty())
+			{
+				texture.evict(texture.pages[texture.lru.back()]);
+			}
+			flushRequested = false;
+		}
+		else
+		{
+			std::vector<uint32_t> requests;
+			gatherPageRequests(requests);
+			pageStats.requested = static_cast<uint32_t>(requests.size());
+
+			// Mark all requested pages that are already resident as used first, so they aren't evicted for the missing ones
+			std::vector<uint32_t> missing;
+			for (auto index : requests)
+			{
+				VirtualTexturePage &page = texture.pages[index];
+				if (page.resident())
+				{
+					texture.touch(page);
+				}
+				else
+				{
+					missing.push_back(index);
+				}
+			}
+			// Coarser levels first, they are the fallback for the finer ones
+			std::sort(missing.begin(), missing.end(), [this](uint32_t a, uint32_t b) { return texture.pages[a].mipLevel > texture.pages[b].mipLevel; });
+			if (missing.size() > maxPageUploadsPerFrame)
+			{
+				missing.resize(maxPageUploadsPerFrame);
+			}
 
-		// Update sparse queue binding
+			// Pages requested by one of the frames in flight may still be sampled
+			const uint64_t evictionDelay = maxFramesInFlight + 1;
+			for (auto index : missing)
+			{
+				VirtualTexturePage &page = texture.pages[index];
+				if (!texture.makeResident(page, frameNumber, evictionDelay))
+				{
+					// Out of budget, the remaining pages fall back to coarser levels
+					break;
+				}
+				pageUploads.push_back(index);
+			}
+		}
+
+		if (texture.sparseImageMemoryBinds.empty())
+		{
+			return VK_NULL_HANDLE;
+		}
+
+		// Sparse binding operations aren't ordered with command buffer submissions, so the uploads wait for the binds on the GPU
+		// The binds of the next frame are queued after this frame has finished (the example renders with a single frame in flight)
+		VkSemaphore bindComplete = pageUpdates.bindComplete[currentFrame];
 		texture.updateSparseBindInfo();
-		vkQueueBindSparse(queue, 1, &texture.bindSparseInfo, VK_NULL_HANDLE);
-		//todo: use sparse bind semaphore
-		vkQueueWaitIdle(queue);
+		texture.bindSparseInfo.signalSemaphoreCount = 1;
+		texture.bindSparseInfo.pSignalSemaphores = &bindComplete;
+		VK_CHECK_RESULT(vkQueueBindSparse(queue, 1, &texture.bindSparseInfo, VK_NULL_HANDLE));
+		texture.sparseImageMemoryBinds.clear();
 
-		// Issue blit commands
-		if (imageBlits.size() > 0)
+		if (pageUploads.empty())
 		{
-			auto tStart = std::chrono::high_resolution_clock::now();
-
-			VkCommandBuffer copyCmd = vulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-			vkCmdBlitImage(
-				copyCmd,
-				textures.source.image,
-				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				texture.image,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				static_cast<uint32_t>(imageBlits.size()),
-				imageBlits.data(),
-				VK_FILTER_LINEAR
-			);
-
-			vulkanDevice->flushCommandBuffer(copyCmd, queue);
-
-			auto tEnd = std::chrono::high_resolution_clock::now();
-			auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
-			std::cout << "Image blits took " << tDiff << " ms" << std::endl;
+			// Only pages have been released
+			return bindComplete;
 		}
 
-		vkQueueWaitIdle(queue);
+		std::vector<VkImageBlit> imageBlits;
+		for (auto index : pageUploads)
+		{
+			addPageBlits(texture.pages[index], imageBlits);
+		}
+		pageStats.uploaded = static_cast<uint32_t>(pageUploads.size());
+		pageUploads.clear();
 
-		mipLevel--;
+		VkCommandBuffer uploadCmd = pageUpdates.commandBuffers[currentFrame];
+		VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
+		cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VK_CHECK_RESULT(vkBeginCommandBuffer(uploadCmd, &cmdBufInfo));
+		vkCmdBlitImage(
+			uploadCmd,
+			textures.source.image,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			texture.image,
+			VK_IMAGE_LAYOUT_GENERAL,
+			static_cast<uint32_t>(imageBlits.size()),
+			imageBlits.data(),
+			VK_FILTER_LINEAR);
+		// Make the new pages visible to the fragment shader
+		VkImageMemoryBarrier imageMemoryBarrier = vks::initializers::imageMemoryBarrier();
+		imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		imageMemoryBarrier.image = texture.image;
+		imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.mipLevels, 0, texture.layerCount };
+		vkCmdPipelineBarrier(uploadCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+		VK_CHECK_RESULT(vkEndCommandBuffer(uploadCmd));
+
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		VkSubmitInfo uploadSubmitInfo = vks::initializers::submitInfo();
+		uploadSubmitInfo.waitSemaphoreCount = 1;
+		uploadSubmitInfo.pWaitSemaphores = &bindComplete;
+		uploadSubmitInfo.pWaitDstStageMask = &waitStage;
+		uploadSubmitInfo.commandBufferCount = 1;
+		uploadSubmitInfo.pCommandBuffers = &uploadCmd;
+		uploadSubmitInfo.signalSemaphoreCount = 1;
+		uploadSubmitInfo.pSignalSemaphores = &pageUpdates.uploadComplete[currentFrame];
+		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &uploadSubmitInfo, VK_NULL_HANDLE));
+
+		return pageUpdates.uploadComplete[currentFrame];
 	}
 
 	virtual void keyPressed(uint32_t keyCode)
@@ -1063,12 +1380,6 @@ public:
 		case KEY_F:
 			flushVirtualTexture();
 			break;
-		case KEY_N:
-			if (lastFilledMip >= 0)
-			{
-				fillVirtualTexture(lastFilledMip);
-			}
-			break;
 		}
 	}
 
@@ -1082,8 +1393,9 @@ public:
 //		textOverlay->addText("LOD bias: " + ss.str() + " (Buttons L1/R1 to change)", 5.0f, 85.0f, VulkanTextOverlay::alignLeft);
 #else
 		//textOverlay->addText("LOD bias: " + ss.str() + " (numpad +/- to change)", 5.0f, 85.0f, VulkanTextOverlay::alignLeft);
-		textOverlay->addText("Resident pages: " + std::to_string(respages) + " / " + std::to_string(texture.pages.size()), 5.0f, 85.0f, VulkanTextOverlay::alignLeft);
-		textOverlay->addText("\"n\" to fill next mip level (" + std::to_string(lastFilledMip) + ")", 5.0f, 100.0f, VulkanTextOverlay::alignLeft);
+		textOverlay->addText("Resident pages: " + std::to_string(respages) + " / " + std::to_string(texture.pages.size()) + " (budget " + std::to_string(pagePool.capacity()) + ")", 5.0f, 85.0f, VulkanTextOverlay::alignLeft);
+		textOverlay->addText("Requested: " + std::to_string(pageStats.requested) + " uploaded: " + std::to_string(pageStats.uploaded), 5.0f, 100.0f, VulkanTextOverlay::alignLeft);
+		textOverlay->addText("\"f\" to flush the virtual texture", 5.0f, 115.0f, VulkanTextOverlay::alignLeft);
 #endif
 	}
 };
@@ -57,11 +57,16 @@ public:
 	} indices;
 
 	// Uniform buffer block object
-	struct {
+	struct UniformBuffer {
 		VkDeviceMemory memory;		
 		VkBuffer buffer;			
 		VkDescriptorBufferInfo descriptor;
-	}  uniformBufferVS;
+		// Pointer to the persistently mapped memory
+		uint8_t *mapped;
+	};
+	// The GPU may still read the uniform buffer of the previous frame while the host updates the next one
+	// So every frame in flight gets its own uniform buffer (selected with currentFrame)
+	std::vector<UniformBuffer> uniformBuffers;
 
 	// For simplicity we use the same uniform block layout as in the shader:
 	//
@@ -97,7 +102,8 @@ public:
 
 	// The descriptor set stores the resources bound to the binding points in a shader
 	// It connects the binding points of the different shaders with the buffers and images used for those bindings
-	VkDescriptorSet descriptorSet;
+	// One descriptor set per frame in flight, each pointing to the uniform buffer of that frame
+	std::vector<VkDescriptorSet> descriptorSets;
 
 
 	// Synchronization primitives
@@ -105,17 +111,22 @@ public:
 
 	// Semaphores
 	// Used to coordinate operations within the graphics queue and ensure correct command ordering
-	VkSemaphore presentCompleteSemaphore;
-	VkSemaphore renderCompleteSemaphore;
+	// One of each per frame in flight, as a semaphore may only be reused once the frame that signaled it has been waited upon
+	std::vector<VkSemaphore> presentCompleteSemaphores;
+	std::vector<VkSemaphore> renderCompleteSemaphores;
 
 	// Fences
 	// Used to check the completion of queue operations (e.g. command buffer execution)
+	// One per frame in flight, signaled once the GPU has finished the frame's command buffer
 	std::vector<VkFence> waitFences;
 
 	VulkanExample() : VulkanExampleBase(ENABLE_VALIDATION)
 	{
 		zoom = -2.5f;
 		title = "Vulkan Example - Basic indexed triangle";
+		// Number of frames the host may prepare while the GPU is still working on earlier ones
+		// With two frames in flight the CPU records frame n+1 while the GPU renders frame n
+		maxFramesInFlight = 2;
 		// Values not set here are initialized in the base class constructor
 	}
 
@@ -134,15 +145,17 @@ public:
 		vkDestroyBuffer(device, indices.buffer, nullptr);
 		vkFreeMemory(device, indices.memory, nullptr);
 
-		vkDestroyBuffer(device, uniformBufferVS.buffer, nullptr);
-		vkFreeMemory(device, uniformBufferVS.memory, nullptr);
-
-		vkDestroySemaphore(device, presentCompleteSemaphore, nullptr);
-		vkDestroySemaphore(device, renderCompleteSemaphore, nullptr);
+		for (auto& uniformBuffer : uniformBuffers)
+		{
+			vkDestroyBuffer(device, uniformBuffer.buffer, nullptr);
+			vkFreeMemory(device, uniformBuffer.memory, nullptr);
+		}
 
-		for (auto& fence : waitFences)
+		for (uint32_t i = 0; i < maxFramesInFlight; i++)
 		{
-			vkDestroyFence(device, fence, nullptr);
+			vkDestroySemaphore(device, presentCompleteSemaphores[i], nullptr);
+			vkDestroySemaphore(device, renderCompleteSemaphores[i], nullptr);
+			vkDestroyFence(device, waitFences[i], nullptr);
 		}
 	}
 
@@ -177,21 +190,22 @@ public:
 		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 		semaphoreCreateInfo.pNext = nullptr;
 
-		// Semaphore used to ensures that image presentation is complete before starting to submit again
-		VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &presentCompleteSemaphore));
-
-		// Semaphore used to ensures that all commands submitted have been finished before submitting the image to the queue
-		VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &renderCompleteSemaphore));
-
 		// Fences (Used to check draw command buffer completion)
 		VkFenceCreateInfo fenceCreateInfo = {};
 		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		// Create in signaled state so we don't wait on first render of each command buffer
+		// Create in signaled state so we don't wait on first render of each frame
 		fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-		waitFences.resize(drawCmdBuffers.size());
-		for (auto& fence : waitFences)
+
+		presentCompleteSemaphores.resize(maxFramesInFlight);
+		renderCompleteSemaphores.resize(maxFramesInFlight);
+		waitFences.resize(maxFramesInFlight);
+		for (uint32_t i = 0; i < maxFramesInFlight; i++)
 		{
-			VK_CHECK_RESULT(vkCreateFence(device, &fenceCreateInfo, nullptr, &fence));
+			// Semaphore used to ensures that image presentation is complete before starting to submit again
+			VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &presentCompleteSemaphores[i]));
+			// Semaphore used to ensures that all commands submitted have been finished before submitting the image to the queue
+			VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &renderCompleteSemaphores[i]));
+			VK_CHECK_RESULT(vkCreateFence(device, &fenceCreateInfo, nullptr, &waitFences[i]));
 		}
 	}
 
@@ -248,11 +262,16 @@ public:
 		vkFreeCommandBuffers(device, cmdPool, 1, &commandBuffer);
 	}
 
-	// Build separate command buffers for every framebuffer image
-	// Unlike in OpenGL all rendering commands are recorded once into command buffers that are then resubmitted to the queue
+	// Record the command buffer for the current frame in flight into the framebuffer of the acquired swap chain image
+	// Unlike in OpenGL all rendering commands are recorded into command buffers that are then submitted to the queue
 	// This allows to generate work upfront and from multiple threads, one of the biggest advantages of Vulkan
-	void buildCommandBuffers()
+	// Command buffers could also be recorded once and resubmitted every frame, but the descriptor set (and with it the uniform buffer)
+	// changes with the frame in flight, so this example records the current frame's command buffer each frame
+	void buildCommandBuffer()
 	{
+		// Command buffer of the current frame in flight (allocated by the base class)
+		VkCommandBuffer cmdBuffer = frameObjects[currentFrame].commandBuffer;
+
 		VkCommandBufferBeginInfo cmdBufInfo = {};
 		cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		cmdBufInfo.pNext = nullptr;
@@ -274,67 +293,70 @@ public:
 		renderPassBeginInfo.clearValueCount = 2;
 		renderPassBeginInfo.pClearValues = clearValues;
 	
-		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i)
-		{
-			// Set target frame buffer
-			renderPassBeginInfo.framebuffer = frameBuffers[i];
+		// Set target frame buffer
+		renderPassBeginInfo.framebuffer = frameBuffers[currentBuffer];
 
-			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+		VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo));
 
-			// Start the first sub pass specified in our default render pass setup by the base class
-			// This will clear the color and depth attachment
-			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		// Start the first sub pass specified in our default render pass setup by the base class
+		// This will clear the color and depth attachment
+		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-			// Update dynamic viewport state
-			VkViewport viewport = {};
-			viewport.height = (float)height;
-			viewport.width = (float)width;
-			viewport.minDepth = (float) 0.0f;
-			viewport.maxDepth = (float) 1.0f;
-			vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
+		// Update dynamic viewport state
+		VkViewport viewport = {};
+		viewport.height = (float)height;
+		viewport.width = (float)width;
+		viewport.minDepth = (float) 0.0f;
+		viewport.maxDepth = (float) 1.0f;
+		vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
 
-			// Update dynamic scissor state
-			VkRect2D scissor = {};
-			scissor.extent.width = width;
-			scissor.extent.height = height;
-			scissor.offset.x = 0;
-			scissor.offset.y = 0;
-			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
+		// Update dynamic scissor state
+		VkRect2D scissor = {};
+		scissor.extent.width = width;
+		scissor.extent.height = height;
+		scissor.offset.x = 0;
+		scissor.offset.y = 0;
+		vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
 
-			// Bind descriptor sets describing shader binding points
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+		// Bind descriptor sets describing shader binding points
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentFrame], 0, nullptr);
 
-			// Bind the rendering pipeline
-			// The pipeline (state object) contains all states of the rendering pipeline, binding it will set all the states specified at pipeline creation time
-			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		// Bind the rendering pipeline
+		// The pipeline (state object) contains all states of the rendering pipeline, binding it will set all the states specified at pipeline creation time
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
-			// Bind triangle vertex buffer (contains position and colors)
-			VkDeviceSize offsets[1] = { 0 };
-			vkCmdBindVertexBuffers(drawCmdBuffers[i], 0, 1, &vertices.buffer, offsets);
+		// Bind triangle vertex buffer (contains position and colors)
+		VkDeviceSize offsets[1] = { 0 };
+		vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &vertices.buffer, offsets);
 
-			// Bind triangle index buffer
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+		// Bind triangle index buffer
+		vkCmdBindIndexBuffer(cmdBuffer, indices.buffer, 0, VK_INDEX_TYPE_UINT32);
 
-			// Draw indexed triangle
-			vkCmdDrawIndexed(drawCmdBuffers[i], indices.count, 1, 0, 0, 1);
+		// Draw indexed triangle
+		vkCmdDrawIndexed(cmdBuffer, indices.count, 1, 0, 0, 1);
 
-			vkCmdEndRenderPass(drawCmdBuffers[i]);
+		vkCmdEndRenderPass(cmdBuffer);
 
-			// Ending the render pass will add an implicit barrier transitioning the frame buffer color attachment to 
-			// VK_IMAGE_LAYOUT_PRESENT_SRC_KHR for presenting it to the windowing system
+		// Ending the render pass will add an implicit barrier transitioning the acquired swap chain image (currentBuffer) to
+		// VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, it's presented once this frame's submission signals renderCompleteSemaphores[currentFrame]
 
-			VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
-		}
+		VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
 	}
 
 	void draw()
 	{
+		// Use a fence to wait until the GPU has finished the last frame that used this frame's resources (command buffer, uniform buffer, semaphores)
+		VK_CHECK_RESULT(vkWaitForFences(device, 1, &waitFences[currentFrame], VK_TRUE, UINT64_MAX));
+		VK_CHECK_RESULT(vkResetFences(device, 1, &waitFences[currentFrame]));
+
 		// Get next image in the swap chain (back/front buffer)
-		VK_CHECK_RESULT(swapChain.acquireNextImage(presentCompleteSemaphore, &currentBuffer));
+		VK_CHECK_RESULT(swapChain.acquireNextImage(presentCompleteSemaphores[currentFrame], &currentBuffer));
+
+		// Update the current frame's uniform buffer, the GPU is no longer reading from it
+		// Note: Since we requested a host coherent memory type for the uniform buffer, the write is instantly visible to the GPU
+		memcpy(uniformBuffers[currentFrame].mapped, &uboVS, sizeof(uboVS));
 
-		// Use a fence to wait until the command buffer has finished execution before using it again
-		VK_CHECK_RESULT(vkWaitForFences(device, 1, &waitFences[currentBuffer], VK_TRUE, UINT64_MAX));
-		VK_CHECK_RESULT(vkResetFences(device, 1, &waitFences[currentBuffer]));
+		buildCommandBuffer();
 
 		// Pipeline stage at which the queue submission will wait (via pWaitSemaphores)
 		VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
@@ -342,20 +364,23 @@ public:
 		VkSubmitInfo submitInfo = {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 		submitInfo.pWaitDstStageMask = &waitStageMask;									// Pointer to the list of pipeline stages that the semaphore waits will occur at
-		submitInfo.pWaitSemaphores = &presentCompleteSemaphore;							// Semaphore(s) to wait upon before the submitted command buffer starts executing
+		submitInfo.pWaitSemaphores = &presentCompleteSemaphores[currentFrame];			// Semaphore(s) to wait upon before the submitted command buffer starts executing
 		submitInfo.waitSemaphoreCount = 1;												// One wait semaphore																				
-		submitInfo.pSignalSemaphores = &renderCompleteSemaphore;						// Semaphore(s) to be signaled when command buffers have completed
+		submitInfo.pSignalSemaphores = &renderCompleteSemaphores[currentFrame];			// Semaphore(s) to be signaled when command buffers have completed
 		submitInfo.signalSemaphoreCount = 1;											// One signal semaphore
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];					// Command buffers(s) to execute in this batch (submission)
+		submitInfo.pCommandBuffers = &frameObjects[currentFrame].commandBuffer;			// Command buffers(s) to execute in this batch (submission)
 		submitInfo.commandBufferCount = 1;												// One command buffer
 
 		// Submit to the graphics queue passing a wait fence
-		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, waitFences[currentBuffer]));
+		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, waitFences[currentFrame]));
 		
 		// Present the current buffer to the swap chain
 		// Pass the semaphore signaled by the command buffer submission from the submit info as the wait semaphore for swap chain presentation
 		// This ensures that the image is not presented to the windowing system until all commands have been submitted
-		VK_CHECK_RESULT(swapChain.queuePresent(queue, currentBuffer, renderCompleteSemaphore));
+		VK_CHECK_RESULT(swapChain.queuePresent(queue, currentBuffer, renderCompleteSemaphores[currentFrame]));
+
+		// Advance to the next frame in flight, the host doesn't wait for the GPU to finish this one
+		currentFrame = (currentFrame + 1) % maxFramesInFlight;
 	}
 
 	// Prepare vertex and index buffers for an indexed triangle
@@ -537,9 +562,9 @@ public:
 	{
 		// We need to tell the API the number of max. requested descriptors per type
 		VkDescriptorPoolSize typeCounts[1];
-		// This example only uses one descriptor type (uniform buffer) and only requests one descriptor of this type
+		// This example only uses one descriptor type (uniform buffer) and requests one descriptor of this type per frame in flight
 		typeCounts[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		typeCounts[0].descriptorCount = 1;
+		typeCounts[0].descriptorCount = maxFramesInFlight;
 		// For additional types you need to add new entries in the type count list
 		// E.g. for two combined image samplers :
 		// typeCounts[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -553,7 +578,8 @@ public:
 		descriptorPoolInfo.poolSizeCount = 1;
 		descriptorPoolInfo.pPoolSizes = typeCounts;
 		// Set the max. number of descriptor sets that can be requested from this pool (requesting beyond this limit will result in an error)
-		descriptorPoolInfo.maxSets = 1;
+		// One descriptor set per frame in flight
+		descriptorPoolInfo.maxSets = maxFramesInFlight;
 
 		VK_CHECK_RESULT(vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &descriptorPool));
 	}
@@ -592,31 +618,35 @@ public:
 
 	void setupDescriptorSet()
 	{
-		// Allocate a new descriptor set from the global descriptor pool
-		VkDescriptorSetAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		allocInfo.descriptorPool = descriptorPool;
-		allocInfo.descriptorSetCount = 1;
-		allocInfo.pSetLayouts = &descriptorSetLayout;
-
-		VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet));
-
-		// Update the descriptor set determining the shader binding points
-		// For every binding point used in a shader there needs to be one
-		// descriptor set matching that binding point
-
-		VkWriteDescriptorSet writeDescriptorSet = {};
-
-		// Binding 0 : Uniform buffer
-		writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		writeDescriptorSet.dstSet = descriptorSet;
-		writeDescriptorSet.descriptorCount = 1;
-		writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		writeDescriptorSet.pBufferInfo = &uniformBufferVS.descriptor;
-		// Binds this uniform buffer to binding point 0
-		writeDescriptorSet.dstBinding = 0;
-
-		vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, nullptr);
+		descriptorSets.resize(maxFramesInFlight);
+		for (uint32_t i = 0; i < maxFramesInFlight; i++)
+		{
+			// Allocate a new descriptor set from the global descriptor pool
+			VkDescriptorSetAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocInfo.descriptorPool = descriptorPool;
+			allocInfo.descriptorSetCount = 1;
+			allocInfo.pSetLayouts = &descriptorSetLayout;
+
+			VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSets[i]));
+
+			// Update the descriptor set determining the shader binding points
+			// For every binding point used in a shader there needs to be one
+			// descriptor set matching that binding point
+
+			VkWriteDescriptorSet writeDescriptorSet = {};
+
+			// Binding 0 : Uniform buffer of this frame in flight
+			writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeDescriptorSet.dstSet = descriptorSets[i];
+			writeDescriptorSet.descriptorCount = 1;
+			writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			writeDescriptorSet.pBufferInfo = &uniformBuffers[i].descriptor;
+			// Binds this uniform buffer to binding point 0
+			writeDescriptorSet.dstBinding = 0;
+
+			vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, nullptr);
+		}
 	}
 
 	// Create the depth (and stencil) buffer attachments used by our framebuffers
@@ -711,7 +741,7 @@ public:
 		attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;					// We don't use stencil, so don't care for load
 		attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;				// Same for store
 		attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;						// Layout at render pass start. Initial doesn't matter, so we use undefined
-		attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;					// Layout to which the attachment is transitioned when the render pass is finished
+		attachments[0].finalLayout = swapChain.presentLayout;						// Layout to which the attachment is transitioned when the render pass is finished
 																						// As we want to present the color buffer to the swapchain, we transition to PRESENT_KHR	
 		// Depth attachment
 		attachments[1].format = depthFormat;											// A proper depth format is selected in the example base
@@ -1006,8 +1036,9 @@ public:
 
 	void prepareUniformBuffers()
 	{
-		// Prepare and initialize a uniform buffer block containing shader uniforms
+		// Prepare and initialize the uniform buffer blocks containing shader uniforms
 		// Single uniforms like in OpenGL are no longer present in Vulkan. All Shader uniforms are passed via uniform buffer blocks
+		// There is one uniform buffer per frame in flight, so the host never writes to a buffer the GPU may still be reading from
 		VkMemoryRequirements memReqs;
 
 		// Vertex shader uniform buffer block
@@ -1023,25 +1054,31 @@ public:
 		// This buffer will be used as a uniform buffer
 		bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
 
-		// Create a new buffer
-		VK_CHECK_RESULT(vkCreateBuffer(device, &bufferInfo, nullptr, &uniformBufferVS.buffer));
-		// Get memory requirements including size, alignment and memory type 
-		vkGetBufferMemoryRequirements(device, uniformBufferVS.buffer, &memReqs);
-		allocInfo.allocationSize = memReqs.size;
-		// Get the memory type index that supports host visibile memory access
-		// Most implementations offer multiple memory types and selecting the correct one to allocate memory from is crucial
-		// We also want the buffer to be host coherent so we don't have to flush (or sync after every update.
-		// Note: This may affect performance so you might not want to do this in a real world application that updates buffers on a regular base
-		allocInfo.memoryTypeIndex = getMemoryTypeIndex(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		// Allocate memory for the uniform buffer
-		VK_CHECK_RESULT(vkAllocateMemory(device, &allocInfo, nullptr, &(uniformBufferVS.memory)));
-		// Bind memory to buffer
-		VK_CHECK_RESULT(vkBindBufferMemory(device, uniformBufferVS.buffer, uniformBufferVS.memory, 0));
-		
-		// Store information in the uniform's descriptor that is used by the descriptor set
-		uniformBufferVS.descriptor.buffer = uniformBufferVS.buffer;
-		uniformBufferVS.descriptor.offset = 0;
-		uniformBufferVS.descriptor.range = sizeof(uboVS);
+		uniformBuffers.resize(maxFramesInFlight);
+		for (auto& uniformBuffer : uniformBuffers)
+		{
+			// Create a new buffer
+			VK_CHECK_RESULT(vkCreateBuffer(device, &bufferInfo, nullptr, &uniformBuffer.buffer));
+			// Get memory requirements including size, alignment and memory type 
+			vkGetBufferMemoryRequirements(device, uniformBuffer.buffer, &memReqs);
+			allocInfo.allocationSize = memReqs.size;
+			// Get the memory type index that supports host visibile memory access
+			// Most implementations offer multiple memory types and selecting the correct one to allocate memory from is crucial
+			// We also want the buffer to be host coherent so we don't have to flush (or sync after every update.
+			// Note: This may affect performance so you might not want to do this in a real world application that updates buffers on a regular base
+			allocInfo.memoryTypeIndex = getMemoryTypeIndex(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			// Allocate memory for the uniform buffer
+			VK_CHECK_RESULT(vkAllocateMemory(device, &allocInfo, nullptr, &(uniformBuffer.memory)));
+			// Bind memory to buffer
+			VK_CHECK_RESULT(vkBindBufferMemory(device, uniformBuffer.buffer, uniformBuffer.memory, 0));
+			// Map the buffer once and keep it mapped, it's updated every frame
+			VK_CHECK_RESULT(vkMapMemory(device, uniformBuffer.memory, 0, sizeof(uboVS), 0, (void **)&uniformBuffer.mapped));
+
+			// Store information in the uniform's descriptor that is used by the descriptor set
+			uniformBuffer.descriptor.buffer = uniformBuffer.buffer;
+			uniformBuffer.descriptor.offset = 0;
+			uniformBuffer.descriptor.range = sizeof(uboVS);
+		}
 
 		updateUniformBuffers();
 	}
@@ -1049,6 +1086,7 @@ public:
 	void updateUniformBuffers()
 	{
 		// Update matrices
+		// These are copied to the uniform buffer of the current frame in flight in draw()
 		uboVS.projectionMatrix = glm::perspective(glm::radians(60.0f), (float)width / (float)height, 0.1f, 256.0f);
 
 		uboVS.viewMatrix = glm::translate(glm::mat4(), glm::vec3(0.0f, 0.0f, zoom));
@@ -1057,14 +1095,6 @@ public:
 		uboVS.modelMatrix = glm::rotate(uboVS.modelMatrix, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
 		uboVS.modelMatrix = glm::rotate(uboVS.modelMatrix, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
 		uboVS.modelMatrix = glm::rotate(uboVS.modelMatrix, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-
-		// Map uniform buffer and update it
-		uint8_t *pData;
-		VK_CHECK_RESULT(vkMapMemory(device, uniformBufferVS.memory, 0, sizeof(uboVS), 0, (void **)&pData));
-		memcpy(pData, &uboVS, sizeof(uboVS));
-		// Unmap after data has been copied
-		// Note: Since we requested a host coherent memory type for the uniform buffer, the write is instantly visible to the GPU
-		vkUnmapMemory(device, uniformBufferVS.memory);
 	}
 
 	void prepare()
@@ -1077,7 +1107,6 @@ public:
 		preparePipelines();
 		setupDescriptorPool();
 		setupDescriptorSet();
-		buildCommandBuffers();
 		prepared = true;
 	}
 
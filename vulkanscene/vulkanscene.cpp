@@ -26,6 +26,7 @@
 #include "vulkanexamplebase.h"
 #include "VulkanTexture.hpp"
 #include "VulkanModel.hpp"
+#include "VulkanAssetLoader.hpp"
 
 #define VERTEX_BUFFER_BIND_ID 0
 #define ENABLE_VALIDATION false
@@ -52,7 +53,7 @@ public:
 			VkDeviceSize offsets[1] = { 0 };
 			vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *pipeline);
 			vkCmdBindVertexBuffers(cmdBuffer, VERTEX_BUFFER_BIND_ID, 1, &model.vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(cmdBuffer, model.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(cmdBuffer, model.indices.buffer, 0, model.indexType);
 			vkCmdDrawIndexed(cmdBuffer, model.indexCount, 1, 0, 0, 0);
 		}
 	};
@@ -119,21 +120,28 @@ public:
 
 	void loadAssets()
 	{
+		// All models and textures are loaded in parallel on the thread pool
+		vks::AssetLoader assets;
 		// Models
+		// Every load writes to its own element, so the vector is sized up front
 		std::vector<std::string> modelFiles = { "vulkanscenelogos.dae", "vulkanscenebackground.dae", "vulkanscenemodels.dae", "cube.obj" };
 		std::vector<VkPipeline*> modelPipelines = { &pipelines.logos, &pipelines.models, &pipelines.models, &pipelines.skybox };
+		demoModels.resize(modelFiles.size());
 		for (auto i = 0; i < modelFiles.size(); i++) {
-			DemoModel model;
-			model.pipeline = modelPipelines[i];
+			DemoModel *model = &demoModels[i];
+			model->pipeline = modelPipelines[i];
 			vks::ModelCreateInfo modelCreateInfo(glm::vec3(1.0f), glm::vec3(1.0f), glm::vec3(0.0f));
 			if (modelFiles[i] != "cube.obj") {
 				modelCreateInfo.center.y += 1.15f;
 			}
-			model.model.loadFromFile(getAssetPath() + "models/" + modelFiles[i], vertexLayout, &modelCreateInfo, vulkanDevice, queue);
-			demoModels.push_back(model);
+			std::string file = modelFiles[i];
+			assets.add([this, file, model, modelCreateInfo]() mutable {
+				model->model.loadFromFile(getAssetPath() + "models/" + file, vertexLayout, &modelCreateInfo, vulkanDevice, queue);
+			});
 		}
 		// Textures
-		textures.skybox.loadFromFile(getAssetPath() + "textures/cubemap_vulkan.ktx", VK_FORMAT_R8G8B8A8_UNORM, vulkanDevice, queue);
+		assets.add([this] { textures.skybox.loadFromFile(getAssetPath() + "textures/cubemap_vulkan.ktx", VK_FORMAT_R8G8B8A8_UNORM, vulkanDevice, queue); });
+		assets.load(getThreadPool());
 	}
 
 	void buildCommandBuffers()